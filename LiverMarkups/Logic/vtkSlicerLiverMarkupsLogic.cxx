@@ -40,9 +40,14 @@
 
 // Liver Markups MRML includes
 #include "vtkMRMLMarkupsBezierSurfaceNode.h"
+#include "vtkMRMLMarkupsContourNode.h"
+#include "vtkMRMLMarkupsMultiPatchBezierSurfaceNode.h"
 #include "vtkMRMLMarkupsSlicingContourNode.h"
 #include "vtkMRMLMarkupsDistanceContourNode.h"
 
+// Liver Markups VTKAlgorithms includes
+#include "vtkSurfaceContourExtractor.h"
+
 // MRML includes
 #include <vtkMRMLModelNode.h>
 #include <vtkMRMLScene.h>
@@ -52,10 +57,21 @@
 #include <vtkSlicerMarkupsLogic.h>
 
 // Markups MRML includes
+#include <vtkMRMLMarkupsClosedCurveNode.h>
+#include <vtkMRMLMarkupsCurveNode.h>
 #include <vtkMRMLMarkupsDisplayNode.h>
 
 // VTK includes
+#include <vtkCellArray.h>
+#include <vtkCollection.h>
+#include <vtkIdList.h>
+#include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+// STD includes
+#include <string>
 
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerLiverMarkupsLogic);
@@ -88,6 +104,7 @@ void vtkSlicerLiverMarkupsLogic::RegisterNodes()
   scene->RegisterNodeClass(vtkSmartPointer<vtkMRMLMarkupsSlicingContourNode>::New());
   scene->RegisterNodeClass(vtkSmartPointer<vtkMRMLMarkupsDistanceContourNode>::New());
   scene->RegisterNodeClass(vtkSmartPointer<vtkMRMLMarkupsBezierSurfaceNode>::New());
+  scene->RegisterNodeClass(vtkSmartPointer<vtkMRMLMarkupsMultiPatchBezierSurfaceNode>::New());
 }
 
 //---------------------------------------------------------------------------
@@ -137,6 +154,11 @@ void vtkSlicerLiverMarkupsLogic::ObserveMRMLScene()
                                                   bezierSurfaceNode->GetAddIcon(),
                                                   bezierSurfaceNode->GetMarkupType());
 
+    auto multiPatchBezierSurfaceNode= vtkSmartPointer<vtkMRMLMarkupsMultiPatchBezierSurfaceNode>::New();
+    selectionNode->AddNewPlaceNodeClassNameToList(multiPatchBezierSurfaceNode->GetClassName(),
+                                                  multiPatchBezierSurfaceNode->GetAddIcon(),
+                                                  multiPatchBezierSurfaceNode->GetMarkupType());
+
     // trigger an update on the mouse mode toolbar
     this->GetMRMLScene()->EndState(vtkMRMLScene::BatchProcessState);
     }
@@ -167,3 +189,89 @@ void vtkSlicerLiverMarkupsLogic::OnMRMLSceneNodeAdded(vtkMRMLNode* node)
   displayNode->PropertiesLabelVisibilityOff();
   displayNode->SetSnapMode(vtkMRMLMarkupsDisplayNode::SnapModeUnconstrained);
 }
+
+//---------------------------------------------------------------------------
+int vtkSlicerLiverMarkupsLogic::ExportContourToCurves(vtkMRMLMarkupsNode* contourNode, vtkCollection* curveNodes)
+{
+  vtkMRMLScene *scene = this->GetMRMLScene();
+  if (!scene || !contourNode)
+    {
+    vtkErrorMacro("ExportContourToCurves: invalid scene or contour node.");
+    return -1;
+    }
+
+  auto markupsContourNode = vtkMRMLMarkupsContourNode::SafeDownCast(contourNode);
+  if (!markupsContourNode)
+    {
+    vtkErrorMacro("ExportContourToCurves: " << contourNode->GetID() << " is not a contour node.");
+    return -1;
+    }
+
+  // Same contour as the representations of the contour node
+  vtkNew<vtkSurfaceContourExtractor> contourExtractor;
+  if (!markupsContourNode->UpdateContourExtractor(contourExtractor))
+    {
+    vtkErrorMacro("ExportContourToCurves: the contour needs a target model and two control points.");
+    return -1;
+    }
+  contourExtractor->Update();
+
+  // The contour is in the coordinates of the target
+  vtkMRMLModelNode* targetModelNode = markupsContourNode->GetTarget();
+  vtkPolyData* contour = contourExtractor->GetOutput();
+  vtkCellArray* lines = contour->GetLines();
+  if (!lines)
+    {
+    return 0;
+    }
+
+  auto contourDisplayNode = vtkMRMLMarkupsDisplayNode::SafeDownCast(contourNode->GetDisplayNode());
+  std::string curveName = std::string(contourNode->GetName() ? contourNode->GetName() : "") + "_Contour";
+
+  int numberOfCurves = 0;
+  vtkNew<vtkIdList> lineIds;
+  for (lines->InitTraversal(); lines->GetNextCell(lineIds);)
+    {
+    // Closed contours repeat their first point at the end
+    vtkIdType numberOfLinePoints = lineIds->GetNumberOfIds();
+    bool closed = numberOfLinePoints > 3 && lineIds->GetId(0) == lineIds->GetId(numberOfLinePoints - 1);
+    if (closed)
+      {
+      --numberOfLinePoints;
+      }
+
+    vtkNew<vtkPoints> curvePoints;
+    curvePoints->SetNumberOfPoints(numberOfLinePoints);
+    for (vtkIdType i = 0; i < numberOfLinePoints; ++i)
+      {
+      double curvePointPositionWorld[3] = {0.0, 0.0, 0.0};
+      targetModelNode->TransformPointToWorld(contour->GetPoint(lineIds->GetId(i)), curvePointPositionWorld);
+      curvePoints->SetPoint(i, curvePointPositionWorld);
+      }
+
+    auto curveNode = vtkMRMLMarkupsCurveNode::SafeDownCast(scene->AddNewNodeByClass(
+      closed ? "vtkMRMLMarkupsClosedCurveNode" : "vtkMRMLMarkupsCurveNode",
+      curveName));
+    if (!curveNode)
+      {
+      continue;
+      }
+    curveNode->CreateDefaultDisplayNodes();
+    curveNode->SetCurveTypeToLinear();
+    curveNode->SetControlPointPositionsWorld(curvePoints);
+
+    auto curveDisplayNode = vtkMRMLMarkupsDisplayNode::SafeDownCast(curveNode->GetDisplayNode());
+    if (contourDisplayNode && curveDisplayNode)
+      {
+      curveDisplayNode->SetSelectedColor(contourDisplayNode->GetSelectedColor());
+      }
+
+    if (curveNodes)
+      {
+      curveNodes->AddItem(curveNode);
+      }
+    ++numberOfCurves;
+    }
+
+  return numberOfCurves;
+}
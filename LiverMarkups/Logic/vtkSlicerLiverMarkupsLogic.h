@@ -44,6 +44,9 @@
 
 #include "vtkSlicerLiverMarkupsModuleLogicExport.h"
 
+class vtkCollection;
+class vtkMRMLMarkupsNode;
+
 class VTK_SLICER_LIVERMARKUPS_MODULE_LOGIC_EXPORT vtkSlicerLiverMarkupsLogic:
   public vtkSlicerMarkupsLogic
 {
@@ -52,6 +55,14 @@ public:
   vtkTypeMacro(vtkSlicerLiverMarkupsLogic, vtkSlicerMarkupsLogic);
   void PrintSelf(ostream& os, vtkIndent indent) override;
 
+  /// Exports the contour of a slicing or distance contour markups node on its
+  /// target model as markups curves (linear interpolation), a closed curve for
+  /// every closed contour and an open curve otherwise, in world coordinates
+  /// (the contour follows the transform of the target). The new curve nodes are
+  /// added to curveNodes if given. Returns the number of curves created or -1
+  /// if the contour could not be computed.
+  int ExportContourToCurves(vtkMRMLMarkupsNode* contourNode, vtkCollection* curveNodes=nullptr);
+
 protected:
   vtkSlicerLiverMarkupsLogic();
   ~vtkSlicerLiverMarkupsLogic() override;
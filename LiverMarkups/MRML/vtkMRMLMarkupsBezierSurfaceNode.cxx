@@ -46,6 +46,9 @@
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 
+// STD includes
+#include <algorithm>
+
 //--------------------------------------------------------------------------------
 vtkMRMLNodeNewMacro(vtkMRMLMarkupsBezierSurfaceNode);
 
@@ -53,6 +56,8 @@ vtkMRMLNodeNewMacro(vtkMRMLMarkupsBezierSurfaceNode);
 vtkMRMLMarkupsBezierSurfaceNode::vtkMRMLMarkupsBezierSurfaceNode()
   :Superclass()
 {
+  this->ControlPointGridSize[0] = 4;
+  this->ControlPointGridSize[1] = 4;
   this->MaximumNumberOfControlPoints = 16;
   this->RequiredNumberOfControlPoints = 16;
 }
@@ -61,4 +66,68 @@ vtkMRMLMarkupsBezierSurfaceNode::vtkMRMLMarkupsBezierSurfaceNode()
 void vtkMRMLMarkupsBezierSurfaceNode::PrintSelf(ostream& os, vtkIndent indent)
 {
   Superclass::PrintSelf(os,indent);
+  vtkMRMLPrintBeginMacro(os, indent);
+  vtkMRMLPrintVectorMacro(ControlPointGridSize, int, 2);
+  vtkMRMLPrintEndMacro();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLMarkupsBezierSurfaceNode::WriteXML(ostream& of, int nIndent)
+{
+  Superclass::WriteXML(of,nIndent);
+  vtkMRMLWriteXMLBeginMacro(of);
+  vtkMRMLWriteXMLVectorMacro(controlPointGridSize, ControlPointGridSize, int, 2);
+  vtkMRMLWriteXMLEndMacro();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLMarkupsBezierSurfaceNode::ReadXMLAttributes(const char** atts)
+{
+  MRMLNodeModifyBlocker blocker(this);
+  Superclass::ReadXMLAttributes(atts);
+  vtkMRMLReadXMLBeginMacro(atts);
+  vtkMRMLReadXMLVectorMacro(controlPointGridSize, ControlPointGridSize, int, 2);
+  vtkMRMLReadXMLEndMacro();
+
+  this->SetControlPointGridSize(this->ControlPointGridSize[0], this->ControlPointGridSize[1]);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLMarkupsBezierSurfaceNode::CopyContent(vtkMRMLNode* anode, bool deepCopy/*=true*/)
+{
+  MRMLNodeModifyBlocker blocker(this);
+  Superclass::CopyContent(anode, deepCopy);
+  vtkMRMLCopyBeginMacro(anode);
+  vtkMRMLCopyVectorMacro(ControlPointGridSize, int, 2);
+  vtkMRMLCopyEndMacro();
+
+  this->SetControlPointGridSize(this->ControlPointGridSize[0], this->ControlPointGridSize[1]);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLMarkupsBezierSurfaceNode::SetControlPointGridSize(int m, int n)
+{
+  // A Bézier surface needs at least 2 control points in each direction
+  m = std::max(m, 2);
+  n = std::max(n, 2);
+
+  MRMLNodeModifyBlocker blocker(this);
+
+  // Control points beyond the new grid no longer define the surface
+  for (int index=this->GetNumberOfControlPoints()-1; index>=m*n; index--)
+    {
+    this->RemoveNthControlPoint(index);
+    }
+
+  if (this->ControlPointGridSize[0] == m && this->ControlPointGridSize[1] == n &&
+      this->RequiredNumberOfControlPoints == m*n)
+    {
+    return;
+    }
+
+  this->ControlPointGridSize[0] = m;
+  this->ControlPointGridSize[1] = n;
+  this->MaximumNumberOfControlPoints = m*n;
+  this->RequiredNumberOfControlPoints = m*n;
+  this->Modified();
 }
@@ -77,8 +77,27 @@ public:
   /// Get markup short name
   const char* GetDefaultNodeNamePrefix() override {return "BS";}
 
+  /// Read node attributes from XML file
+  void ReadXMLAttributes( const char** atts) override;
+
+  /// Write this node's information to a MRML file in XML format.
+  void WriteXML(ostream& of, int indent) override;
+
   /// \sa vtkMRMLNode::CopyContent
-  vtkMRMLCopyContentDefaultMacro(vtkMRMLMarkupsBezierSurfaceNode);
+  vtkMRMLCopyContentMacro(vtkMRMLMarkupsBezierSurfaceNode);
+
+  /// Set the size (m x n) of the grid of control points defining the surface
+  /// (4x4, i.e. a bicubic patch, by default). The node requires exactly m*n
+  /// control points, where control point (i,j) has index i*n+j. Control
+  /// points beyond m*n are removed when the grid shrinks.
+  void SetControlPointGridSize(int m, int n);
+  void SetControlPointGridSize(int size[2])
+  {this->SetControlPointGridSize(size[0], size[1]);}
+  vtkGetVector2Macro(ControlPointGridSize, int);
+
+  /// Target parenchyma model split by the resection surface
+  vtkMRMLModelNode* GetTarget() const {return this->Target;}
+  void SetTarget(vtkMRMLModelNode* target) {this->Target = target; this->Modified();}
 
 protected:
   vtkMRMLMarkupsBezierSurfaceNode();
@@ -86,6 +105,7 @@ protected:
 
 private:
  vtkWeakPointer<vtkMRMLModelNode> Target;
+ int ControlPointGridSize[2];
 
 private:
  vtkMRMLMarkupsBezierSurfaceNode(const vtkMRMLMarkupsBezierSurfaceNode&);
@@ -0,0 +1,85 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (The Intervention Centre,
+  Oslo University Hospital) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#include "vtkMRMLMarkupsContourNode.h"
+
+// VTK includes
+#include <vtkPolyData.h>
+
+//--------------------------------------------------------------------------------
+vtkMRMLMarkupsContourNode::vtkMRMLMarkupsContourNode()
+  :Superclass(), Target(nullptr)
+{
+}
+
+//--------------------------------------------------------------------------------
+vtkMRMLMarkupsContourNode::~vtkMRMLMarkupsContourNode() = default;
+
+//----------------------------------------------------------------------------
+void vtkMRMLMarkupsContourNode::PrintSelf(ostream& os, vtkIndent indent)
+{
+  Superclass::PrintSelf(os,indent);
+
+  os << indent << "Target: "
+     << (this->Target && this->Target->GetID() ? this->Target->GetID() : "(none)") << "\n";
+}
+
+//----------------------------------------------------------------------------
+vtkPolyData* vtkMRMLMarkupsContourNode::GetControlPointPositionsInTarget(double point1Position[3],
+                                                                        double point2Position[3])
+{
+  auto targetPolyData = this->Target ? this->Target->GetPolyData() : nullptr;
+  if (!targetPolyData || targetPolyData->GetNumberOfPoints() == 0 ||
+      this->GetNumberOfControlPoints() != 2)
+    {
+    return nullptr;
+    }
+
+  // The contour is computed on the polydata of the target, so the control
+  // points are brought from world into its coordinates (either node may be
+  // transformed)
+  double point1PositionWorld[3] = {0.0, 0.0, 0.0};
+  double point2PositionWorld[3] = {0.0, 0.0, 0.0};
+  this->GetNthControlPointPositionWorld(0, point1PositionWorld);
+  this->GetNthControlPointPositionWorld(1, point2PositionWorld);
+  this->Target->TransformPointFromWorld(point1PositionWorld, point1Position);
+  this->Target->TransformPointFromWorld(point2PositionWorld, point2Position);
+
+  return targetPolyData;
+}
@@ -0,0 +1,93 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (The Intervention Centre,
+  Oslo University Hospital) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#ifndef __vtkmrmlmarkupscontournode_h_
+#define __vtkmrmlmarkupscontournode_h_
+
+#include "vtkSlicerLiverMarkupsModuleMRMLExport.h"
+
+// MRML includes
+#include <vtkMRMLMarkupsLineNode.h>
+#include <vtkMRMLModelNode.h>
+
+//VTK includes
+#include <vtkWeakPointer.h>
+
+//-----------------------------------------------------------------------------
+class vtkPolyData;
+class vtkSurfaceContourExtractor;
+
+//-----------------------------------------------------------------------------
+/// Base class of the contour markups: two control points defining a contour
+/// on a target model. The contour parameters are derived from the control
+/// points here only, so the 3D and 2D representations and the logic (export)
+/// all draw the same contour.
+class VTK_SLICER_LIVERMARKUPS_MODULE_MRML_EXPORT vtkMRMLMarkupsContourNode
+: public vtkMRMLMarkupsLineNode
+{
+public:
+  vtkTypeMacro(vtkMRMLMarkupsContourNode, vtkMRMLMarkupsLineNode);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  vtkMRMLModelNode* GetTarget() const {return this->Target;}
+  void SetTarget(vtkMRMLModelNode* target) {this->Target = target; this->Modified();}
+
+  /// Sets the polydata of the target as input of the contour extractor along
+  /// with the type and parameters of the contour, in the coordinates of the
+  /// target polydata (the extractor is not updated). Returns false if there
+  /// is no contour: no target surface or not two control points.
+  virtual bool UpdateContourExtractor(vtkSurfaceContourExtractor* contourExtractor) = 0;
+
+protected:
+  vtkMRMLMarkupsContourNode();
+  ~vtkMRMLMarkupsContourNode() override;
+
+  /// Positions of the two control points in the coordinates of the target
+  /// polydata, which is returned (nullptr if there is no contour)
+  vtkPolyData* GetControlPointPositionsInTarget(double point1Position[3], double point2Position[3]);
+
+private:
+ vtkWeakPointer<vtkMRMLModelNode> Target;
+
+private:
+ vtkMRMLMarkupsContourNode(const vtkMRMLMarkupsContourNode&);
+ void operator=(const vtkMRMLMarkupsContourNode&);
+};
+
+#endif //__vtkmrmlmarkupscontournode_h_
@@ -39,24 +39,154 @@
 
 #include "vtkMRMLMarkupsDistanceContourNode.h"
 
+// Liver Markups VTKAlgorithms includes
+#include "vtkSurfaceContourExtractor.h"
+#include "vtkSurfaceGeodesicDistance.h"
+
 // MRML includes
 #include <vtkMRMLScene.h>
 
 // VTK includes
+#include <vtkCellArray.h>
+#include <vtkFloatArray.h>
+#include <vtkMath.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
 
 //--------------------------------------------------------------------------------
 vtkMRMLNodeNewMacro(vtkMRMLMarkupsDistanceContourNode);
 
 //--------------------------------------------------------------------------------
 vtkMRMLMarkupsDistanceContourNode::vtkMRMLMarkupsDistanceContourNode()
-  :Superclass(), Target(nullptr)
+  :Superclass(), DistanceMeasure(Euclidean), GeodesicSurfaceTime(0)
 {
+  this->GeodesicDistance = vtkSmartPointer<vtkSurfaceGeodesicDistance>::New();
+  this->GeodesicDistances = vtkSmartPointer<vtkFloatArray>::New();
+  this->GeodesicDistances->SetName("GeodesicDistance");
+  this->GeodesicReferencePoint[0] = this->GeodesicReferencePoint[1] =
+    this->GeodesicReferencePoint[2] = VTK_DOUBLE_MAX;
 }
 
+//--------------------------------------------------------------------------------
+vtkMRMLMarkupsDistanceContourNode::~vtkMRMLMarkupsDistanceContourNode() = default;
+
 //----------------------------------------------------------------------------
 void vtkMRMLMarkupsDistanceContourNode::PrintSelf(ostream& os, vtkIndent indent)
 {
   Superclass::PrintSelf(os,indent);
+
+  os << indent << "Distance Measure: "
+     << (this->DistanceMeasure == Geodesic ? "Geodesic" : "Euclidean") << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLMarkupsDistanceContourNode::WriteXML(ostream& of, int nIndent)
+{
+  Superclass::WriteXML(of,nIndent);
+  vtkMRMLWriteXMLBeginMacro(of);
+  vtkMRMLWriteXMLIntMacro(distanceMeasure, DistanceMeasure);
+  vtkMRMLWriteXMLEndMacro();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLMarkupsDistanceContourNode::ReadXMLAttributes(const char** atts)
+{
+  MRMLNodeModifyBlocker blocker(this);
+  Superclass::ReadXMLAttributes(atts);
+  vtkMRMLReadXMLBeginMacro(atts);
+  vtkMRMLReadXMLIntMacro(distanceMeasure, DistanceMeasure);
+  vtkMRMLReadXMLEndMacro();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLMarkupsDistanceContourNode::CopyContent(vtkMRMLNode* anode, bool deepCopy/*=true*/)
+{
+  MRMLNodeModifyBlocker blocker(this);
+  Superclass::CopyContent(anode, deepCopy);
+  vtkMRMLCopyBeginMacro(anode);
+  vtkMRMLCopyIntMacro(DistanceMeasure);
+  vtkMRMLCopyEndMacro();
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLMarkupsDistanceContourNode::UpdateContourExtractor(vtkSurfaceContourExtractor* contourExtractor)
+{
+  double point1Position[3] = {0.0, 0.0, 0.0};
+  double point2Position[3] = {0.0, 0.0, 0.0};
+  auto targetPolyData = this->GetControlPointPositionsInTarget(point1Position, point2Position);
+  if (!targetPolyData || !contourExtractor)
+    {
+    return false;
+    }
+
+  if (contourExtractor->GetInput() != targetPolyData)
+    {
+    contourExtractor->SetInputData(targetPolyData);
+    }
+
+  if (this->DistanceMeasure == Geodesic)
+    {
+    if (!this->UpdateGeodesicDistances(targetPolyData, point2Position))
+      {
+      return false;
+      }
+    contourExtractor->SetContourTypeToScalars();
+    contourExtractor->SetContourScalars(this->GeodesicDistances);
+    contourExtractor->SetContourValue(
+      this->GeodesicDistance->GetDistance(point1Position, this->GeodesicDistances));
+    }
+  else
+    {
+    contourExtractor->SetContourTypeToSphere();
+    contourExtractor->SetContourScalars(nullptr);
+    contourExtractor->SetOrigin(point2Position);
+    contourExtractor->SetContourValue(
+      std::sqrt(vtkMath::Distance2BetweenPoints(point1Position, point2Position)));
+    }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLMarkupsDistanceContourNode::UpdateGeodesicDistances(vtkPolyData* surface, const double referencePoint[3])
+{
+  if (!surface || !surface->GetPoints())
+    {
+    return false;
+    }
+
+  // The modification time of the polydata also changes with its attributes
+  // (e.g. scalars) -> track the geometry only
+  vtkMTimeType surfaceTime = surface->GetPoints()->GetMTime();
+  if (surface->GetPolys())
+    {
+    surfaceTime = std::max(surfaceTime, surface->GetPolys()->GetMTime());
+    }
+
+  if (surface == this->GeodesicSurface &&
+      surfaceTime == this->GeodesicSurfaceTime &&
+      referencePoint[0] == this->GeodesicReferencePoint[0] &&
+      referencePoint[1] == this->GeodesicReferencePoint[1] &&
+      referencePoint[2] == this->GeodesicReferencePoint[2])
+    {
+    return true;
+    }
+
+  this->GeodesicDistance->SetSurface(surface);
+  if (!this->GeodesicDistance->ComputeDistances(referencePoint, this->GeodesicDistances))
+    {
+    this->GeodesicSurface = nullptr;
+    return false;
+    }
+
+  this->GeodesicSurface = surface;
+  this->GeodesicSurfaceTime = surfaceTime;
+  std::copy(referencePoint, referencePoint + 3, this->GeodesicReferencePoint);
+  return true;
 }
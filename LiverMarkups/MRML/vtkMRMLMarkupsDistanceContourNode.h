@@ -42,20 +42,24 @@
 
 #include "vtkSlicerLiverMarkupsModuleMRMLExport.h"
 
-// MRML includes
-#include <vtkMRMLMarkupsLineNode.h>
-#include <vtkMRMLModelNode.h>
+// Liver Markups MRML includes
+#include "vtkMRMLMarkupsContourNode.h"
 
 //VTK includes
+#include <vtkSmartPointer.h>
 #include <vtkWeakPointer.h>
 
+//-----------------------------------------------------------------------------
+class vtkFloatArray;
+class vtkSurfaceGeodesicDistance;
+
 //-----------------------------------------------------------------------------
 class VTK_SLICER_LIVERMARKUPS_MODULE_MRML_EXPORT vtkMRMLMarkupsDistanceContourNode
-: public vtkMRMLMarkupsLineNode
+: public vtkMRMLMarkupsContourNode
 {
 public:
   static vtkMRMLMarkupsDistanceContourNode* New();
-  vtkTypeMacro(vtkMRMLMarkupsDistanceContourNode, vtkMRMLMarkupsLineNode);
+  vtkTypeMacro(vtkMRMLMarkupsDistanceContourNode, vtkMRMLMarkupsContourNode);
   void PrintSelf(ostream& os, vtkIndent indent) override;
 
   //--------------------------------------------------------------------------------
@@ -77,18 +81,51 @@ public:
   /// Get markup short name
   const char* GetDefaultNodeNamePrefix() override {return "SC";}
 
-  /// \sa vtkMRMLNode::CopyContent
-  vtkMRMLCopyContentDefaultMacro(vtkMRMLMarkupsDistanceContourNode);
+  /// Read node attributes from XML file
+  void ReadXMLAttributes( const char** atts) override;
 
-  vtkMRMLModelNode* GetTarget() const {return this->Target;}
-  void SetTarget(vtkMRMLModelNode* target) {this->Target = target; this->Modified();}
+  /// Write this node's information to a MRML file in XML format.
+  void WriteXML(ostream& of, int indent) override;
+
+  /// \sa vtkMRMLNode::CopyContent
+  vtkMRMLCopyContentMacro(vtkMRMLMarkupsDistanceContourNode);
+
+  /// Distance the contour is drawn at: Euclidean distance from the reference
+  /// point, or geodesic distance along the surface of the target
+  enum DistanceMeasures
+  {
+    Euclidean = 0,
+    Geodesic
+  };
+
+  vtkSetMacro(DistanceMeasure, int);
+  vtkGetMacro(DistanceMeasure, int);
+  void SetDistanceMeasureToEuclidean() {this->SetDistanceMeasure(Euclidean);}
+  void SetDistanceMeasureToGeodesic() {this->SetDistanceMeasure(Geodesic);}
+
+  /// Intersection of the target with the sphere centered at the reference
+  /// point (second control point) through the external point, or the
+  /// isoline of the geodesic distance field from the reference point through
+  /// the external point in geodesic mode
+  bool UpdateContourExtractor(vtkSurfaceContourExtractor* contourExtractor) override;
 
 protected:
   vtkMRMLMarkupsDistanceContourNode();
-  ~vtkMRMLMarkupsDistanceContourNode() override = default;
+  ~vtkMRMLMarkupsDistanceContourNode() override;
+
+  /// Recomputes the geodesic distance field of the target surface when the
+  /// reference point or the target geometry changed since the last update.
+  /// The field is kept by the node, so it is computed once for all the views.
+  bool UpdateGeodesicDistances(vtkPolyData* surface, const double referencePoint[3]);
 
 private:
- vtkWeakPointer<vtkMRMLModelNode> Target;
+ int DistanceMeasure;
+
+ vtkSmartPointer<vtkSurfaceGeodesicDistance> GeodesicDistance;
+ vtkSmartPointer<vtkFloatArray> GeodesicDistances;
+ double GeodesicReferencePoint[3];
+ vtkMTimeType GeodesicSurfaceTime;
+ vtkWeakPointer<vtkPolyData> GeodesicSurface;
 
 private:
  vtkMRMLMarkupsDistanceContourNode(const vtkMRMLMarkupsDistanceContourNode&);
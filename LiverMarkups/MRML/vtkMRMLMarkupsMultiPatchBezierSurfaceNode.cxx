@@ -0,0 +1,271 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (The Intervention Centre,
+  Oslo University Hospital) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#include "vtkMRMLMarkupsMultiPatchBezierSurfaceNode.h"
+
+// MRML includes
+#include <vtkMRMLScene.h>
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+
+// STD includes
+#include <algorithm>
+
+//--------------------------------------------------------------------------------
+vtkMRMLNodeNewMacro(vtkMRMLMarkupsMultiPatchBezierSurfaceNode);
+
+//--------------------------------------------------------------------------------
+vtkMRMLMarkupsMultiPatchBezierSurfaceNode::vtkMRMLMarkupsMultiPatchBezierSurfaceNode()
+  :Superclass(), EnforcingContinuity(false)
+{
+  this->NumberOfPatches[0] = 2;
+  this->NumberOfPatches[1] = 2;
+  this->SetControlPointGridSize(7, 7);
+
+  this->AddObserver(vtkMRMLMarkupsNode::PointModifiedEvent, this,
+                    &vtkMRMLMarkupsMultiPatchBezierSurfaceNode::OnPointModified);
+  this->AddObserver(vtkMRMLMarkupsNode::PointAddedEvent, this,
+                    &vtkMRMLMarkupsMultiPatchBezierSurfaceNode::OnPointAdded);
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLMarkupsMultiPatchBezierSurfaceNode::PrintSelf(ostream& os, vtkIndent indent)
+{
+  Superclass::PrintSelf(os,indent);
+  vtkMRMLPrintBeginMacro(os, indent);
+  vtkMRMLPrintVectorMacro(NumberOfPatches, int, 2);
+  vtkMRMLPrintEndMacro();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLMarkupsMultiPatchBezierSurfaceNode::WriteXML(ostream& of, int nIndent)
+{
+  Superclass::WriteXML(of,nIndent);
+  vtkMRMLWriteXMLBeginMacro(of);
+  vtkMRMLWriteXMLVectorMacro(numberOfPatches, NumberOfPatches, int, 2);
+  vtkMRMLWriteXMLEndMacro();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLMarkupsMultiPatchBezierSurfaceNode::ReadXMLAttributes(const char** atts)
+{
+  MRMLNodeModifyBlocker blocker(this);
+  Superclass::ReadXMLAttributes(atts);
+  vtkMRMLReadXMLBeginMacro(atts);
+  vtkMRMLReadXMLVectorMacro(numberOfPatches, NumberOfPatches, int, 2);
+  vtkMRMLReadXMLEndMacro();
+
+  this->SetControlPointGridSize(3*this->NumberOfPatches[0]+1, 3*this->NumberOfPatches[1]+1);
+  this->ConstrainedPositions.clear();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLMarkupsMultiPatchBezierSurfaceNode::CopyContent(vtkMRMLNode* anode, bool deepCopy/*=true*/)
+{
+  MRMLNodeModifyBlocker blocker(this);
+  Superclass::CopyContent(anode, deepCopy);
+  vtkMRMLCopyBeginMacro(anode);
+  vtkMRMLCopyVectorMacro(NumberOfPatches, int, 2);
+  vtkMRMLCopyEndMacro();
+
+  this->SetControlPointGridSize(3*this->NumberOfPatches[0]+1, 3*this->NumberOfPatches[1]+1);
+  this->UpdateConstrainedPositions();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLMarkupsMultiPatchBezierSurfaceNode::SetNumberOfPatches(int p, int q)
+{
+  p = std::max(p, 1);
+  q = std::max(q, 1);
+
+  if (this->NumberOfPatches[0] == p && this->NumberOfPatches[1] == q)
+    {
+    return;
+    }
+
+  this->NumberOfPatches[0] = p;
+  this->NumberOfPatches[1] = q;
+  this->ConstrainedPositions.clear();
+  this->SetControlPointGridSize(3*p+1, 3*q+1);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLMarkupsMultiPatchBezierSurfaceNode::EnforceContinuity()
+{
+  int m = 3*this->NumberOfPatches[0]+1;
+  int n = 3*this->NumberOfPatches[1]+1;
+  if (this->EnforcingContinuity || this->GetNumberOfControlPoints() != m*n)
+    {
+    return;
+    }
+
+  // NOTE: The point modified events are deferred until EndModify, so the
+  // guard must outlive the modification to keep the handler from re-entering.
+  this->EnforcingContinuity = true;
+  int wasModifying = this->StartModify();
+  this->ApplyContinuityConstraints();
+  this->EndModify(wasModifying);
+  this->EnforcingContinuity = false;
+
+  this->UpdateConstrainedPositions();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLMarkupsMultiPatchBezierSurfaceNode::ApplyContinuityConstraints()
+{
+  int m = 3*this->NumberOfPatches[0]+1;
+  int n = 3*this->NumberOfPatches[1]+1;
+
+  auto setMidpoint = [this](int index, int first, int second)
+    {
+    double position[3], firstPosition[3], secondPosition[3];
+    this->GetNthControlPointPosition(index, position);
+    this->GetNthControlPointPosition(first, firstPosition);
+    this->GetNthControlPointPosition(second, secondPosition);
+
+    double midpoint[3] = {0.5*(firstPosition[0]+secondPosition[0]),
+                          0.5*(firstPosition[1]+secondPosition[1]),
+                          0.5*(firstPosition[2]+secondPosition[2])};
+    if (midpoint[0] != position[0] || midpoint[1] != position[1] || midpoint[2] != position[2])
+      {
+      this->SetNthControlPointPosition(index, midpoint[0], midpoint[1], midpoint[2]);
+      }
+    };
+
+  // Boundaries between patches along u (rows 3k) and then along v (columns
+  // 3l). Points shared by four patches end up at the average of their four
+  // diagonal neighbours, which satisfies both constraints.
+  for (int i=3; i<m-1; i+=3)
+    {
+    for (int j=0; j<n; j++)
+      {
+      setMidpoint(i*n+j, (i-1)*n+j, (i+1)*n+j);
+      }
+    }
+
+  for (int j=3; j<n-1; j+=3)
+    {
+    for (int i=0; i<m; i++)
+      {
+      setMidpoint(i*n+j, i*n+j-1, i*n+j+1);
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLMarkupsMultiPatchBezierSurfaceNode::OnPointModified(vtkObject* vtkNotUsed(caller),
+                                                                unsigned long vtkNotUsed(event),
+                                                                void* callData)
+{
+  int m = 3*this->NumberOfPatches[0]+1;
+  int n = 3*this->NumberOfPatches[1]+1;
+  if (this->EnforcingContinuity || this->GetNumberOfControlPoints() != m*n)
+    {
+    return;
+    }
+
+  this->EnforcingContinuity = true;
+  int wasModifying = this->StartModify();
+
+  int index = callData ? *static_cast<int*>(callData) : -1;
+  if (index >= 0 && index < m*n &&
+      this->ConstrainedPositions.size() == static_cast<size_t>(3*m*n))
+    {
+    int i = index / n;
+    int j = index % n;
+    bool uBoundary = (i % 3 == 0) && i > 0 && i < m-1;
+    bool vBoundary = (j % 3 == 0) && j > 0 && j < n-1;
+
+    // A boundary control point drags its neighbours across the boundary
+    if (uBoundary || vBoundary)
+      {
+      double position[3];
+      this->GetNthControlPointPosition(index, position);
+      const double *previous = &this->ConstrainedPositions[3*index];
+      double delta[3] = {position[0]-previous[0],
+                         position[1]-previous[1],
+                         position[2]-previous[2]};
+
+      for (int di=(uBoundary ? -1 : 0); di<=(uBoundary ? 1 : 0); di++)
+        {
+        for (int dj=(vBoundary ? -1 : 0); dj<=(vBoundary ? 1 : 0); dj++)
+          {
+          if (di == 0 && dj == 0)
+            {
+            continue;
+            }
+          int neighbor = (i+di)*n+(j+dj);
+          const double *neighborPosition = &this->ConstrainedPositions[3*neighbor];
+          this->SetNthControlPointPosition(neighbor,
+                                           neighborPosition[0]+delta[0],
+                                           neighborPosition[1]+delta[1],
+                                           neighborPosition[2]+delta[2]);
+          }
+        }
+      }
+    }
+
+  this->ApplyContinuityConstraints();
+  this->EndModify(wasModifying);
+  this->EnforcingContinuity = false;
+
+  this->UpdateConstrainedPositions();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLMarkupsMultiPatchBezierSurfaceNode::OnPointAdded(vtkObject* vtkNotUsed(caller),
+                                                             unsigned long vtkNotUsed(event),
+                                                             void* vtkNotUsed(callData))
+{
+  this->EnforceContinuity();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLMarkupsMultiPatchBezierSurfaceNode::UpdateConstrainedPositions()
+{
+  int numberOfControlPoints = this->GetNumberOfControlPoints();
+  this->ConstrainedPositions.resize(3*numberOfControlPoints);
+  for (int index=0; index<numberOfControlPoints; index++)
+    {
+    this->GetNthControlPointPosition(index, &this->ConstrainedPositions[3*index]);
+    }
+}
@@ -0,0 +1,128 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (The Intervention Centre,
+  Oslo University Hospital) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#ifndef __vtkmrmlmarkupsmultipatchbeziersurfacenode_h_
+#define __vtkmrmlmarkupsmultipatchbeziersurfacenode_h_
+
+#include "vtkSlicerLiverMarkupsModuleMRMLExport.h"
+
+// Liver Markups MRML includes
+#include "vtkMRMLMarkupsBezierSurfaceNode.h"
+
+// STD includes
+#include <vector>
+
+//-----------------------------------------------------------------------------
+/// Markup holding a grid of P x Q bicubic Bézier patches. Neighbouring
+/// patches share their boundary control points, so the node holds a
+/// (3P+1) x (3Q+1) grid of control points (control point (i,j) has index
+/// i*(3Q+1)+j). C1 continuity across patch boundaries is enforced by keeping
+/// every boundary control point at the midpoint of its two neighbours across
+/// the boundary: moving a boundary point drags its neighbours along, while
+/// moving a neighbour slides the boundary point.
+class VTK_SLICER_LIVERMARKUPS_MODULE_MRML_EXPORT vtkMRMLMarkupsMultiPatchBezierSurfaceNode
+: public vtkMRMLMarkupsBezierSurfaceNode
+{
+public:
+  static vtkMRMLMarkupsMultiPatchBezierSurfaceNode* New();
+  vtkTypeMacro(vtkMRMLMarkupsMultiPatchBezierSurfaceNode, vtkMRMLMarkupsBezierSurfaceNode);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  //--------------------------------------------------------------------------------
+  // MRMLNode methods
+  //--------------------------------------------------------------------------------
+  vtkMRMLNode* CreateNodeInstance() override;
+
+  /// Get node XML tag name (like Volume, Model)
+  ///
+  const char* GetNodeTagName() override {return "MarkupsMultiPatchBezierSurface";}
+
+  /// Get markup name
+  const char* GetMarkupType() override {return "MultiPatchBezierSurface";}
+
+  /// Get markup short name
+  const char* GetDefaultNodeNamePrefix() override {return "MBS";}
+
+  /// Read node attributes from XML file
+  void ReadXMLAttributes( const char** atts) override;
+
+  /// Write this node's information to a MRML file in XML format.
+  void WriteXML(ostream& of, int indent) override;
+
+  /// \sa vtkMRMLNode::CopyContent
+  vtkMRMLCopyContentMacro(vtkMRMLMarkupsMultiPatchBezierSurfaceNode);
+
+  /// Set the number of bicubic patches in the u and v directions (2x2 by
+  /// default). This also sets the size of the control point grid.
+  void SetNumberOfPatches(int p, int q);
+  vtkGetVector2Macro(NumberOfPatches, int);
+
+  /// Move the boundary control points to the midpoint of their neighbours so
+  /// that the surface is C1 continuous across patch boundaries.
+  void EnforceContinuity();
+
+protected:
+  vtkMRMLMarkupsMultiPatchBezierSurfaceNode();
+  ~vtkMRMLMarkupsMultiPatchBezierSurfaceNode() override = default;
+
+  /// Keep C1 continuity when a control point is moved
+  void OnPointModified(vtkObject* caller, unsigned long event, void* callData);
+
+  /// Keep C1 continuity once all control points are placed
+  void OnPointAdded(vtkObject* caller, unsigned long event, void* callData);
+
+  /// Move the boundary control points to the midpoint of their neighbours.
+  /// The caller guards against re-entrance from the point modified events.
+  void ApplyContinuityConstraints();
+
+  /// Store the current control points as the reference positions used to
+  /// detect how a boundary control point has been moved
+  void UpdateConstrainedPositions();
+
+private:
+ int NumberOfPatches[2];
+ std::vector<double> ConstrainedPositions;
+ bool EnforcingContinuity;
+
+private:
+ vtkMRMLMarkupsMultiPatchBezierSurfaceNode(const vtkMRMLMarkupsMultiPatchBezierSurfaceNode&);
+ void operator=(const vtkMRMLMarkupsMultiPatchBezierSurfaceNode&);
+};
+
+#endif //__vtkmrmlmarkupsmultipatchbeziersurfacenode_h_
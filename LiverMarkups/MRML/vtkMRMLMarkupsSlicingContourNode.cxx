@@ -39,19 +39,24 @@
 
 #include "vtkMRMLMarkupsSlicingContourNode.h"
 
+// Liver Markups VTKAlgorithms includes
+#include "vtkSurfaceContourExtractor.h"
+
 // MRML includes
 #include <vtkMRMLScene.h>
 
 // VTK includes
+#include <vtkMath.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkPolyData.h>
 
 //--------------------------------------------------------------------------------
 vtkMRMLNodeNewMacro(vtkMRMLMarkupsSlicingContourNode);
 
 //--------------------------------------------------------------------------------
 vtkMRMLMarkupsSlicingContourNode::vtkMRMLMarkupsSlicingContourNode()
-  :Superclass(), Target(nullptr)
+  :Superclass()
 {
 }
 
@@ -60,3 +65,40 @@ void vtkMRMLMarkupsSlicingContourNode::PrintSelf(ostream& os, vtkIndent indent)
 {
   Superclass::PrintSelf(os,indent);
 }
+
+//----------------------------------------------------------------------------
+bool vtkMRMLMarkupsSlicingContourNode::UpdateContourExtractor(vtkSurfaceContourExtractor* contourExtractor)
+{
+  double point1Position[3] = {0.0, 0.0, 0.0};
+  double point2Position[3] = {0.0, 0.0, 0.0};
+  auto targetPolyData = this->GetControlPointPositionsInTarget(point1Position, point2Position);
+  if (!targetPolyData || !contourExtractor)
+    {
+    return false;
+    }
+
+  double middlePointPosition[3] = {
+    (point2Position[0] + point1Position[0]) / 2.0,
+    (point2Position[1] + point1Position[1]) / 2.0,
+    (point2Position[2] + point1Position[2]) / 2.0
+  };
+
+  // The normal is normalized once here, not per vertex in the shader
+  double planeNormal[3] = {
+    point2Position[0] - point1Position[0],
+    point2Position[1] - point1Position[1],
+    point2Position[2] - point1Position[2]
+  };
+  vtkMath::Normalize(planeNormal);
+
+  if (contourExtractor->GetInput() != targetPolyData)
+    {
+    contourExtractor->SetInputData(targetPolyData);
+    }
+  contourExtractor->SetContourTypeToPlane();
+  contourExtractor->SetContourScalars(nullptr);
+  contourExtractor->SetOrigin(middlePointPosition);
+  contourExtractor->SetNormal(planeNormal);
+
+  return true;
+}
@@ -42,20 +42,16 @@
 
 #include "vtkSlicerLiverMarkupsModuleMRMLExport.h"
 
-// MRML includes
-#include <vtkMRMLMarkupsLineNode.h>
-#include <vtkMRMLModelNode.h>
-
-//VTK includes
-#include <vtkWeakPointer.h>
+// Liver Markups MRML includes
+#include "vtkMRMLMarkupsContourNode.h"
 
 //-----------------------------------------------------------------------------
 class VTK_SLICER_LIVERMARKUPS_MODULE_MRML_EXPORT vtkMRMLMarkupsSlicingContourNode
-: public vtkMRMLMarkupsLineNode
+: public vtkMRMLMarkupsContourNode
 {
 public:
   static vtkMRMLMarkupsSlicingContourNode* New();
-  vtkTypeMacro(vtkMRMLMarkupsSlicingContourNode, vtkMRMLMarkupsLineNode);
+  vtkTypeMacro(vtkMRMLMarkupsSlicingContourNode, vtkMRMLMarkupsContourNode);
   void PrintSelf(ostream& os, vtkIndent indent) override;
 
   //--------------------------------------------------------------------------------
@@ -80,16 +76,14 @@ public:
   /// \sa vtkMRMLNode::CopyContent
   vtkMRMLCopyContentDefaultMacro(vtkMRMLMarkupsSlicingContourNode);
 
-  vtkMRMLModelNode* GetTarget() const {return this->Target;}
-  void SetTarget(vtkMRMLModelNode* target) {this->Target = target; this->Modified();}
+  /// Intersection of the target with the plane through the middle point of
+  /// the control points, orthogonal to the line between them (unit normal)
+  bool UpdateContourExtractor(vtkSurfaceContourExtractor* contourExtractor) override;
 
 protected:
   vtkMRMLMarkupsSlicingContourNode();
   ~vtkMRMLMarkupsSlicingContourNode() override = default;
 
-private:
- vtkWeakPointer<vtkMRMLModelNode> Target;
-
 private:
  vtkMRMLMarkupsSlicingContourNode(const vtkMRMLMarkupsSlicingContourNode&);
  void operator=(const vtkMRMLMarkupsSlicingContourNode&);
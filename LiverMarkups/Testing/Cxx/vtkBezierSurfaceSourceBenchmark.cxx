@@ -0,0 +1,359 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (The Intervention Centre,
+  Oslo University Hospital) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+// Micro-benchmark of vtkBezierSurfaceSource. It measures the time of an update
+// (one control point moved, then Update()) for several control grid sizes,
+// resolutions, evaluation and tessellation modes, output precisions, with and
+// without normals and, when built with OpenMP, thread counts.
+// The time is reported per generated vertex along with the number of heap
+// allocations performed per update, beyond the ones of the VTK pipeline
+// itself. The benchmark fails if an update of the uniform tessellation
+// allocates memory in steady state.
+//
+// Usage: vtkBezierSurfaceSourceBenchmark [maximum resolution]
+//
+// NOTE: the surface is only evaluated in parallel when the module is
+// configured with LiverMarkups_USE_OPENMP (off by default). Otherwise the
+// benchmark is built without OpenMP as well and only runs on one thread.
+
+#include "vtkBezierSurfaceSource.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkInformationVector.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+//------------------------------------------------------------------------------
+// Global allocation counter
+namespace
+{
+std::atomic<unsigned long long> NumberOfAllocations(0);
+}
+
+void* operator new(std::size_t size)
+{
+  NumberOfAllocations++;
+  if (void *pointer = std::malloc(size ? size : 1))
+    {
+    return pointer;
+    }
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+  return operator new(size);
+}
+
+void operator delete(void *pointer) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept
+{
+  std::free(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t) noexcept
+{
+  std::free(pointer);
+}
+
+//------------------------------------------------------------------------------
+// Source producing the given points, polygons and normals without computing
+// anything, to measure the allocations made by the pipeline on each update
+// (e.g., the output attributes are re-initialized before every execution).
+class vtkPassThroughSurfaceSource : public vtkPolyDataAlgorithm
+{
+public:
+  static vtkPassThroughSurfaceSource *New();
+  vtkTypeMacro(vtkPassThroughSurfaceSource, vtkPolyDataAlgorithm);
+
+  void SetSurface(vtkPolyData *surface)
+  {
+    this->Surface = surface;
+    this->Modified();
+  }
+
+protected:
+  vtkPassThroughSurfaceSource()
+  {
+    this->SetNumberOfInputPorts(0);
+  }
+
+  int RequestData(vtkInformation *vtkNotUsed(request),
+                  vtkInformationVector **vtkNotUsed(inputVector),
+                  vtkInformationVector *outputVector) override
+  {
+    vtkPolyData *output = vtkPolyData::GetData(outputVector);
+    output->SetPoints(this->Surface->GetPoints());
+    output->SetPolys(this->Surface->GetPolys());
+    if (vtkDataArray *normals = this->Surface->GetPointData()->GetNormals())
+      {
+      output->GetPointData()->SetNormals(normals);
+      }
+    return 1;
+  }
+
+  vtkSmartPointer<vtkPolyData> Surface;
+};
+
+vtkStandardNewMacro(vtkPassThroughSurfaceSource);
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+// Evaluation strategy. The output precision and the normals are separate
+// axes of the benchmark, so every strategy is measured with each of them.
+struct BenchmarkMode
+{
+  const char *Name;
+  int EvaluationMode;
+  bool Incremental;
+  int TessellationMode;
+};
+
+//------------------------------------------------------------------------------
+// The adaptive tessellation is rebuilt on every update, with at most as many
+// cells as the uniform one at the same resolution.
+const BenchmarkMode Modes[] =
+{
+  {"direct",      vtkBezierSurfaceSource::DIRECT_EVALUATION, false, vtkBezierSurfaceSource::UNIFORM_TESSELLATION},
+  {"matrix",      vtkBezierSurfaceSource::MATRIX_EVALUATION, false, vtkBezierSurfaceSource::UNIFORM_TESSELLATION},
+  {"incremental", vtkBezierSurfaceSource::MATRIX_EVALUATION, true,  vtkBezierSurfaceSource::UNIFORM_TESSELLATION},
+  {"adaptive",    vtkBezierSurfaceSource::MATRIX_EVALUATION, false, vtkBezierSurfaceSource::ADAPTIVE_TESSELLATION},
+};
+
+//------------------------------------------------------------------------------
+const int Precisions[] = {vtkAlgorithm::DOUBLE_PRECISION, vtkAlgorithm::SINGLE_PRECISION};
+
+//------------------------------------------------------------------------------
+struct BenchmarkResult
+{
+  double NanosecondsPerVertex;
+  double AllocationsPerUpdate;
+};
+
+//------------------------------------------------------------------------------
+BenchmarkResult RunBenchmark(unsigned int grid, unsigned int resolution, const BenchmarkMode &mode,
+                             int precision, bool normals)
+{
+  vtkNew<vtkPoints> controlPoints;
+  controlPoints->SetDataTypeToDouble();
+  controlPoints->SetNumberOfPoints(grid*grid);
+  for (unsigned int i=0; i<grid; i++)
+    {
+    for (unsigned int j=0; j<grid; j++)
+      {
+      controlPoints->SetPoint(i*grid+j, i/static_cast<double>(grid-1),
+                              j/static_cast<double>(grid-1), 0.0);
+      }
+    }
+
+  vtkNew<vtkBezierSurfaceSource> source;
+  source->SetNumberOfControlPoints(grid, grid);
+  source->SetResolution(resolution, resolution);
+  source->SetEvaluationMode(mode.EvaluationMode);
+  source->SetOutputPointsPrecision(precision);
+  source->SetIncrementalUpdate(mode.Incremental);
+  source->SetComputeNormals(normals);
+  source->SetTessellationMode(mode.TessellationMode);
+  int level = 0;
+  while ((1u << level) < resolution && level < 10)
+    {
+    level++;
+    }
+  source->SetMaximumSubdivisionLevel(level);
+  source->SetControlPoints(controlPoints);
+  source->Update();
+
+  // Repeat until the measured time is long enough to be meaningful
+  const double minimumSeconds = 0.2;
+  const unsigned int minimumUpdates = 5;
+  unsigned int updates = 0;
+  long long allocations = 0;
+  double seconds = 0.0;
+
+  while (updates < minimumUpdates || seconds < minimumSeconds)
+    {
+    // Emulate an interactive drag of one of the control points
+    unsigned int index = (updates * 7) % (grid*grid);
+    double point[3];
+    controlPoints->GetPoint(index, point);
+    point[2] += (updates % 2 ? -0.01 : 0.01);
+    controlPoints->SetPoint(index, point);
+
+    unsigned long long allocationsBefore = NumberOfAllocations;
+    auto start = std::chrono::steady_clock::now();
+    source->SetControlPoints(controlPoints);
+    source->Update();
+    auto end = std::chrono::steady_clock::now();
+    allocations += static_cast<long long>(NumberOfAllocations - allocationsBefore);
+
+    seconds += std::chrono::duration<double>(end - start).count();
+    updates++;
+    }
+
+  // Allocations of the pipeline for the same output, which are discounted
+  vtkNew<vtkPolyData> surface;
+  surface->ShallowCopy(source->GetOutput());
+  vtkNew<vtkPassThroughSurfaceSource> passThrough;
+  passThrough->SetSurface(surface);
+  passThrough->Update();
+  for (unsigned int update=0; update<updates; update++)
+    {
+    unsigned long long allocationsBefore = NumberOfAllocations;
+    passThrough->Modified();
+    passThrough->Update();
+    allocations -= static_cast<long long>(NumberOfAllocations - allocationsBefore);
+    }
+
+  BenchmarkResult result;
+  vtkIdType numberOfVertices = std::max<vtkIdType>(source->GetOutput()->GetNumberOfPoints(), 1);
+  result.NanosecondsPerVertex = 1e9 * seconds / (static_cast<double>(updates) * numberOfVertices);
+  result.AllocationsPerUpdate = allocations / static_cast<double>(updates);
+  return result;
+}
+
+} // end of anonymous namespace
+
+//------------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  unsigned int maximumResolution = 1024;
+  if (argc > 1)
+    {
+    maximumResolution = static_cast<unsigned int>(std::atoi(argv[1]));
+    }
+
+  const unsigned int grids[] = {4, 6, 8, 10};
+  const unsigned int resolutions[] = {10, 32, 64, 128, 256, 512, 1024};
+
+  std::vector<int> threadCounts(1, 1);
+#ifdef _OPENMP
+  for (int threads=2; threads<=omp_get_max_threads(); threads*=2)
+    {
+    threadCounts.push_back(threads);
+    }
+  if (threadCounts.back() != omp_get_max_threads())
+    {
+    threadCounts.push_back(omp_get_max_threads());
+    }
+#endif
+
+  bool success = true;
+
+#ifndef _OPENMP
+  std::printf("Built without OpenMP: the surface is evaluated on one thread only\n");
+#endif
+
+  std::printf("%-6s %-6s %-8s %-12s %-10s %-8s %14s %14s\n",
+              "grid", "res", "threads", "mode", "precision", "normals", "ns/vertex", "allocs/update");
+
+  for (int threads : threadCounts)
+    {
+#ifdef _OPENMP
+    omp_set_num_threads(threads);
+#endif
+    for (unsigned int grid : grids)
+      {
+      for (unsigned int resolution : resolutions)
+        {
+        if (resolution > maximumResolution)
+          {
+          continue;
+          }
+        for (const BenchmarkMode &mode : Modes)
+          {
+          for (int precision : Precisions)
+            {
+            for (bool normals : {false, true})
+              {
+              BenchmarkResult result = RunBenchmark(grid, resolution, mode, precision, normals);
+              std::printf("%-6s %-6u %-8d %-12s %-10s %-8s %14.3f %14.1f\n",
+                          (std::to_string(grid) + "x" + std::to_string(grid)).c_str(),
+                          resolution, threads, mode.Name,
+                          precision == vtkAlgorithm::SINGLE_PRECISION ? "single" : "double",
+                          normals ? "yes" : "no",
+                          result.NanosecondsPerVertex, result.AllocationsPerUpdate);
+              std::fflush(stdout);
+
+              // Updating the uniform tessellation must not allocate memory
+              if (mode.TessellationMode == vtkBezierSurfaceSource::UNIFORM_TESSELLATION &&
+                  result.AllocationsPerUpdate > 0.0)
+                {
+                std::fprintf(stderr, "%u x %u grid at resolution %u, %s mode: %.1f allocations per update\n",
+                             grid, grid, resolution, mode.Name, result.AllocationsPerUpdate);
+                success = false;
+                }
+              }
+            }
+          }
+        }
+      }
+    }
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,549 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (The Intervention Centre,
+  Oslo University Hospital) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+// Tests of vtkBezierSurfaceSource. The evaluation paths (matrix, incremental,
+// single precision and adaptive tessellation) are checked against
+// DIRECT_EVALUATION on random control nets, and the projection and
+// intersection against known answers on a flat patch, where the surface is
+// the affine map (u,v) -> (10u,10v,0), and on a parabolic cylinder
+// z = 20u(1-u).
+
+#include "vtkBezierSurfaceSource.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <utility>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+const double Tolerance = 1e-6;
+
+//------------------------------------------------------------------------------
+bool CheckValue(const char *name, double value, double expected)
+{
+  if (std::fabs(value - expected) > Tolerance)
+    {
+    std::cerr << name << ": got " << value << ", expected " << expected << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool CheckPoint(const char *name, const double point[3], double x, double y, double z)
+{
+  double expected[3] = {x, y, z};
+  if (std::sqrt(vtkMath::Distance2BetweenPoints(point, expected)) > Tolerance)
+    {
+    std::cerr << name << ": got (" << point[0] << ", " << point[1] << ", " << point[2]
+              << "), expected (" << x << ", " << y << ", " << z << ")" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Control points on an evenly spaced m x n grid spanning [0,10]x[0,10], with
+// the given heights along u (one per row)
+void SetGridControlPoints(vtkBezierSurfaceSource *source, unsigned int m, unsigned int n,
+                          const double *heights)
+{
+  vtkNew<vtkPoints> controlPoints;
+  controlPoints->SetDataTypeToDouble();
+  controlPoints->SetNumberOfPoints(m*n);
+  for (unsigned int i=0; i<m; i++)
+    {
+    for (unsigned int j=0; j<n; j++)
+      {
+      controlPoints->SetPoint(i*n+j, 10.0*i/(m-1), 10.0*j/(n-1), heights ? heights[i] : 0.0);
+      }
+    }
+  source->SetNumberOfControlPoints(m, n);
+  source->SetControlPoints(controlPoints);
+}
+
+//------------------------------------------------------------------------------
+// Control points on an m x n grid spanning [0,10]x[0,10] with random offsets
+vtkSmartPointer<vtkPoints> RandomControlPoints(unsigned int m, unsigned int n,
+                                               std::mt19937 &generator)
+{
+  std::uniform_real_distribution<double> offset(-1.0, 1.0);
+  auto controlPoints = vtkSmartPointer<vtkPoints>::New();
+  controlPoints->SetDataTypeToDouble();
+  controlPoints->SetNumberOfPoints(m*n);
+  for (unsigned int i=0; i<m; i++)
+    {
+    for (unsigned int j=0; j<n; j++)
+      {
+      controlPoints->SetPoint(i*n+j, 10.0*i/(m-1) + offset(generator),
+                              10.0*j/(n-1) + offset(generator), 3.0*offset(generator));
+      }
+    }
+  return controlPoints;
+}
+
+//------------------------------------------------------------------------------
+// Maximum distance between the corresponding tuples of two 3-component arrays
+double MaximumDistance(vtkDataArray *array, vtkDataArray *reference)
+{
+  if (array == nullptr || reference == nullptr ||
+      array->GetNumberOfTuples() != reference->GetNumberOfTuples())
+    {
+    return VTK_DOUBLE_MAX;
+    }
+
+  double maximumDistance2 = 0.0;
+  for (vtkIdType index=0; index<array->GetNumberOfTuples(); index++)
+    {
+    double tuple[3], referenceTuple[3];
+    array->GetTuple(index, tuple);
+    reference->GetTuple(index, referenceTuple);
+    maximumDistance2 = std::max(maximumDistance2,
+                                vtkMath::Distance2BetweenPoints(tuple, referenceTuple));
+    }
+  return std::sqrt(maximumDistance2);
+}
+
+//------------------------------------------------------------------------------
+// Comparison of the points (and the normals, if any) of a surface with the
+// ones of the direct evaluation
+bool CheckSurface(const char *name, vtkBezierSurfaceSource *source,
+                  vtkBezierSurfaceSource *reference, double tolerance)
+{
+  source->Update();
+  reference->Update();
+  vtkPolyData *surface = source->GetOutput();
+  vtkPolyData *referenceSurface = reference->GetOutput();
+
+  double pointsDistance = MaximumDistance(surface->GetPoints()->GetData(),
+                                          referenceSurface->GetPoints()->GetData());
+  if (pointsDistance > tolerance)
+    {
+    std::cerr << name << ": points differ from the direct evaluation by "
+              << pointsDistance << std::endl;
+    return false;
+    }
+
+  if (source->GetComputeNormals())
+    {
+    double normalsDistance = MaximumDistance(surface->GetPointData()->GetNormals(),
+                                             referenceSurface->GetPointData()->GetNormals());
+    if (normalsDistance > tolerance)
+      {
+      std::cerr << name << ": normals differ from the direct evaluation by "
+                << normalsDistance << std::endl;
+      return false;
+      }
+    }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Control grids and resolutions the evaluation paths are checked with: square
+// and non-square grids, and resolutions that are not multiples of the width
+// of the single precision kernel, so its tail is exercised.
+const unsigned int Grids[][2] = {{4, 4}, {3, 7}, {6, 2}, {10, 5}};
+const unsigned int Resolutions[][2] = {{10, 10}, {13, 9}, {31, 17}, {8, 11}};
+
+//------------------------------------------------------------------------------
+bool TestEvaluationModes()
+{
+  std::mt19937 generator(1);
+  bool success = true;
+
+  for (const auto &grid : Grids)
+    {
+    for (const auto &resolution : Resolutions)
+      {
+      vtkSmartPointer<vtkPoints> controlPoints = RandomControlPoints(grid[0], grid[1], generator);
+
+      vtkNew<vtkBezierSurfaceSource> reference;
+      reference->SetEvaluationModeToDirect();
+      reference->SetComputeNormals(true);
+      reference->SetResolution(resolution[0], resolution[1]);
+      reference->SetNumberOfControlPoints(grid[0], grid[1]);
+      reference->SetControlPoints(controlPoints);
+
+      vtkNew<vtkBezierSurfaceSource> matrix;
+      matrix->SetEvaluationModeToMatrix();
+      matrix->SetIncrementalUpdate(false);
+      matrix->SetComputeNormals(true);
+      matrix->SetResolution(resolution[0], resolution[1]);
+      matrix->SetNumberOfControlPoints(grid[0], grid[1]);
+      matrix->SetControlPoints(controlPoints);
+      success &= CheckSurface("Matrix evaluation", matrix, reference, 1e-9);
+
+      // The single precision kernel is the one selected by the build (AVX,
+      // SSE or scalar)
+      vtkNew<vtkBezierSurfaceSource> singlePrecision;
+      singlePrecision->SetEvaluationModeToMatrix();
+      singlePrecision->SetIncrementalUpdate(false);
+      singlePrecision->SetOutputPointsPrecision(vtkAlgorithm::SINGLE_PRECISION);
+      singlePrecision->SetResolution(resolution[0], resolution[1]);
+      singlePrecision->SetNumberOfControlPoints(grid[0], grid[1]);
+      singlePrecision->SetControlPoints(controlPoints);
+      success &= CheckSurface("Single precision evaluation", singlePrecision, reference, 1e-4);
+      }
+    }
+
+  return success;
+}
+
+//------------------------------------------------------------------------------
+// Drag of random control points, one at a time, for more consecutive
+// incremental updates than the ones allowed before a full evaluation, so the
+// accumulated error is checked along the whole sequence.
+bool TestIncrementalUpdates()
+{
+  std::mt19937 generator(2);
+  std::uniform_real_distribution<double> displacement(-0.5, 0.5);
+  bool success = true;
+
+  for (int precision : {vtkAlgorithm::DOUBLE_PRECISION, vtkAlgorithm::SINGLE_PRECISION})
+    {
+    vtkSmartPointer<vtkPoints> controlPoints = RandomControlPoints(5, 6, generator);
+
+    vtkNew<vtkBezierSurfaceSource> reference;
+    reference->SetEvaluationModeToDirect();
+    reference->SetComputeNormals(true);
+    reference->SetResolution(13, 9);
+    reference->SetNumberOfControlPoints(5, 6);
+    reference->SetControlPoints(controlPoints);
+
+    vtkNew<vtkBezierSurfaceSource> incremental;
+    incremental->SetEvaluationModeToMatrix();
+    incremental->SetIncrementalUpdate(true);
+    incremental->SetComputeNormals(true);
+    incremental->SetOutputPointsPrecision(precision);
+    incremental->SetResolution(13, 9);
+    incremental->SetNumberOfControlPoints(5, 6);
+    incremental->SetControlPoints(controlPoints);
+    incremental->Update();
+
+    double tolerance = precision == vtkAlgorithm::SINGLE_PRECISION ? 1e-4 : 1e-9;
+    std::uniform_int_distribution<vtkIdType> index(0, controlPoints->GetNumberOfPoints()-1);
+    for (int update=0; update<300 && success; update++)
+      {
+      vtkIdType moved = index(generator);
+      double point[3];
+      controlPoints->GetPoint(moved, point);
+      for (int d=0; d<3; d++)
+        {
+        point[d] += displacement(generator);
+        }
+      controlPoints->SetPoint(moved, point);
+      reference->SetControlPoints(controlPoints);
+      incremental->SetControlPoints(controlPoints);
+      success &= CheckSurface(precision == vtkAlgorithm::SINGLE_PRECISION ?
+                              "Single precision incremental update" : "Incremental update",
+                              incremental, reference, tolerance);
+      }
+    }
+
+  return success;
+}
+
+//------------------------------------------------------------------------------
+// The adaptive tessellation must be a manifold without cracks (T-junctions
+// would open holes, i.e., boundary edges inside the domain), its vertices must
+// lie on the surface and its triangles within the flatness tolerance of it.
+bool TestAdaptiveTessellation()
+{
+  std::mt19937 generator(3);
+  bool success = true;
+
+  for (const auto &grid : Grids)
+    {
+    vtkNew<vtkBezierSurfaceSource> source;
+    source->SetTessellationModeToAdaptive();
+    source->SetAdaptiveTolerance(0.002);
+    source->SetMaximumSubdivisionLevel(8);
+    vtkSmartPointer<vtkPoints> controlPoints = RandomControlPoints(grid[0], grid[1], generator);
+    source->SetNumberOfControlPoints(grid[0], grid[1]);
+    source->SetControlPoints(controlPoints);
+    source->Update();
+    vtkPolyData *surface = source->GetOutput();
+
+    double bounds[6];
+    controlPoints->GetBounds(bounds);
+    double diagonal = std::sqrt((bounds[1]-bounds[0])*(bounds[1]-bounds[0]) +
+                                (bounds[3]-bounds[2])*(bounds[3]-bounds[2]) +
+                                (bounds[5]-bounds[4])*(bounds[5]-bounds[4]));
+    double tolerance = source->GetAdaptiveTolerance()*diagonal;
+
+    // Directed edges are used once and undirected ones at most twice
+    std::map<std::pair<vtkIdType, vtkIdType>, int> edges;
+    vtkIdType numberOfTriangles = 0;
+    double maximumDeviation = 0.0;
+    vtkCellArray *polys = surface->GetPolys();
+    vtkIdType numberOfPoints;
+    const vtkIdType *pointIds;
+    for (polys->InitTraversal(); polys->GetNextCell(numberOfPoints, pointIds);)
+      {
+      numberOfTriangles++;
+      double centroid[3] = {0.0, 0.0, 0.0};
+      for (vtkIdType k=0; k<3; k++)
+        {
+        vtkIdType from = pointIds[k];
+        vtkIdType to = pointIds[(k+1)%3];
+        if (edges[std::make_pair(from, to)]++ > 0)
+          {
+          std::cerr << "Adaptive tessellation: inconsistent winding of edge "
+                    << from << "-" << to << std::endl;
+          success = false;
+          }
+        double point[3];
+        surface->GetPoint(from, point);
+        for (int d=0; d<3; d++)
+          {
+          centroid[d] += point[d]/3.0;
+          }
+        }
+      double closestPoint[3];
+      maximumDeviation = std::max(maximumDeviation, source->ProjectPoint(centroid, closestPoint));
+      }
+
+    vtkIdType numberOfEdges = 0;
+    for (const auto &edge : edges)
+      {
+      if (edge.first.first < edge.first.second ||
+          edges.find(std::make_pair(edge.first.second, edge.first.first)) == edges.end())
+        {
+        numberOfEdges++;
+        }
+      }
+
+    // A triangulated disk has an Euler characteristic of 1, each hole lowers it
+    vtkIdType eulerCharacteristic = surface->GetNumberOfPoints() - numberOfEdges + numberOfTriangles;
+    if (eulerCharacteristic != 1)
+      {
+      std::cerr << "Adaptive tessellation: Euler characteristic " << eulerCharacteristic
+                << " instead of 1 (cracks)" << std::endl;
+      success = false;
+      }
+
+    for (vtkIdType index=0; index<surface->GetNumberOfPoints(); index++)
+      {
+      double point[3], closestPoint[3];
+      surface->GetPoint(index, point);
+      double distance = source->ProjectPoint(point, closestPoint);
+      if (distance > 1e-6*diagonal)
+        {
+        std::cerr << "Adaptive tessellation: vertex " << index << " is " << distance
+                  << " away from the surface" << std::endl;
+        success = false;
+        break;
+        }
+      }
+
+    if (maximumDeviation > tolerance)
+      {
+      std::cerr << "Adaptive tessellation: triangles deviate " << maximumDeviation
+                << " from the surface, more than the tolerance " << tolerance << std::endl;
+      success = false;
+      }
+    }
+
+  return success;
+}
+
+//------------------------------------------------------------------------------
+bool TestFlatProjection()
+{
+  vtkNew<vtkBezierSurfaceSource> source;
+  SetGridControlPoints(source, 4, 4, nullptr);
+
+  bool success = true;
+  double closestPoint[3], uv[2];
+
+  // Interior closest point: straight below the point
+  double point[3] = {3.0, 4.0, 7.0};
+  double distance = source->ProjectPoint(point, closestPoint, uv);
+  success &= CheckValue("Flat projection distance", distance, 7.0);
+  success &= CheckPoint("Flat projection point", closestPoint, 3.0, 4.0, 0.0);
+  success &= CheckValue("Flat projection u", uv[0], 0.3);
+  success &= CheckValue("Flat projection v", uv[1], 0.4);
+
+  // Closest point on the border of the patch
+  double outsidePoint[3] = {-2.0, 5.0, 1.0};
+  distance = source->ProjectPoint(outsidePoint, closestPoint, uv);
+  success &= CheckValue("Border projection distance", distance, std::sqrt(5.0));
+  success &= CheckPoint("Border projection point", closestPoint, 0.0, 5.0, 0.0);
+  success &= CheckValue("Border projection u", uv[0], 0.0);
+
+  // Batch projection agrees with the single point projection
+  vtkNew<vtkPoints> points;
+  points->InsertNextPoint(point);
+  points->InsertNextPoint(outsidePoint);
+  vtkNew<vtkPoints> closestPoints;
+  vtkNew<vtkDoubleArray> distances;
+  source->ProjectPoints(points, closestPoints, nullptr, distances);
+  success &= CheckValue("Batch projection distance 0", distances->GetValue(0), 7.0);
+  success &= CheckValue("Batch projection distance 1", distances->GetValue(1), std::sqrt(5.0));
+
+  return success;
+}
+
+//------------------------------------------------------------------------------
+bool TestParabolicProjection()
+{
+  // Heights 0, 10, 0 give z(u) = 20u(1-u), with x = 10u
+  const double heights[3] = {0.0, 10.0, 0.0};
+  vtkNew<vtkBezierSurfaceSource> source;
+  SetGridControlPoints(source, 3, 2, heights);
+
+  bool success = true;
+
+  // Point offset by 0.5 along the unit normal at u = 0.25 (x = 2.5, z = 3.75,
+  // slope 1), well within the radius of curvature there (about 7.07)
+  double offset = 0.5 / std::sqrt(2.0);
+  double point[3] = {2.5 + offset, 6.0, 3.75 - offset};
+  double closestPoint[3], uv[2];
+  double distance = source->ProjectPoint(point, closestPoint, uv);
+  success &= CheckValue("Parabolic projection distance", distance, 0.5);
+  success &= CheckPoint("Parabolic projection point", closestPoint, 2.5, 6.0, 3.75);
+  success &= CheckValue("Parabolic projection u", uv[0], 0.25);
+  success &= CheckValue("Parabolic projection v", uv[1], 0.6);
+
+  return success;
+}
+
+//------------------------------------------------------------------------------
+bool TestFlatIntersection()
+{
+  vtkNew<vtkBezierSurfaceSource> source;
+  SetGridControlPoints(source, 4, 4, nullptr);
+
+  bool success = true;
+  double uv[2];
+
+  // Ray through the patch
+  double t, x[3];
+  double p1[3] = {3.0, 4.0, 5.0};
+  double p2[3] = {3.0, 4.0, -5.0};
+  if (!source->IntersectWithLine(p1, p2, 1e-3, t, x, uv))
+    {
+    std::cerr << "Flat intersection: ray missed the patch" << std::endl;
+    return false;
+    }
+  success &= CheckValue("Flat intersection t", t, 0.5);
+  success &= CheckPoint("Flat intersection point", x, 3.0, 4.0, 0.0);
+  success &= CheckValue("Flat intersection u", uv[0], 0.3);
+  success &= CheckValue("Flat intersection v", uv[1], 0.4);
+
+  // Ray passing beside the patch
+  double q1[3] = {12.0, 4.0, 5.0};
+  double q2[3] = {12.0, 4.0, -5.0};
+  if (source->IntersectWithLine(q1, q2, 1e-3, t, x, uv))
+    {
+    std::cerr << "Flat intersection: ray beside the patch reported a hit" << std::endl;
+    success = false;
+    }
+
+  return success;
+}
+
+//------------------------------------------------------------------------------
+bool TestParabolicIntersection()
+{
+  const double heights[3] = {0.0, 10.0, 0.0};
+  vtkNew<vtkBezierSurfaceSource> source;
+  SetGridControlPoints(source, 3, 2, heights);
+
+  bool success = true;
+  double uv[2];
+
+  // Vertical ray through the apex (x = 5, z = 5)
+  double t, x[3];
+  double p1[3] = {5.0, 2.0, 10.0};
+  double p2[3] = {5.0, 2.0, -10.0};
+  if (!source->IntersectWithLine(p1, p2, 1e-3, t, x, uv))
+    {
+    std::cerr << "Parabolic intersection: ray missed the patch" << std::endl;
+    return false;
+    }
+  success &= CheckValue("Parabolic intersection t", t, 0.25);
+  success &= CheckPoint("Parabolic intersection point", x, 5.0, 2.0, 5.0);
+
+  // Oblique ray crossing the surface twice: the crossing closest to p1 is
+  // reported. Along x = 1 + 8s, z = 4 the surface (z = 2x - 0.2x^2) is
+  // crossed at x = 5 - sqrt(5) and x = 5 + sqrt(5).
+  double q1[3] = {1.0, 5.0, 4.0};
+  double q2[3] = {9.0, 5.0, 4.0};
+  if (!source->IntersectWithLine(q1, q2, 1e-3, t, x, uv))
+    {
+    std::cerr << "Parabolic intersection: oblique ray missed the patch" << std::endl;
+    return false;
+    }
+  success &= CheckPoint("Parabolic first crossing", x, 5.0 - std::sqrt(5.0), 5.0, 4.0);
+
+  return success;
+}
+
+} // end of anonymous namespace
+
+//------------------------------------------------------------------------------
+int vtkBezierSurfaceSourceTest1(int vtkNotUsed(argc), char *vtkNotUsed(argv)[])
+{
+  bool success = TestEvaluationModes();
+  success &= TestIncrementalUpdates();
+  success &= TestAdaptiveTessellation();
+  success &= TestFlatProjection();
+  success &= TestParabolicProjection();
+  success &= TestFlatIntersection();
+  success &= TestParabolicIntersection();
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,234 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (The Intervention Centre,
+  Oslo University Hospital) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+// Known-answer tests of vtkSurfaceContourExtractor on a triangulated sphere:
+// plane, sphere and scalar contours of a closed surface, and a plane contour
+// of an open hemisphere.
+
+#include "vtkSurfaceContourExtractor.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+const double Radius = 50.0;
+
+//------------------------------------------------------------------------------
+// Sphere centered at the origin with poles on the z axis, made of triangles.
+// Only the upper half (z >= 0) is generated when hemisphere is true.
+void CreateSphere(vtkPolyData *sphere, int numberOfSectors, int numberOfRings, bool hemisphere)
+{
+  vtkNew<vtkPoints> points;
+  points->SetDataTypeToDouble();
+  points->InsertNextPoint(0.0, 0.0, Radius);
+  int lastRing = hemisphere ? numberOfRings/2 : numberOfRings-1;
+  for (int i=1; i<=lastRing; i++)
+    {
+    double theta = vtkMath::Pi()*i/numberOfRings;
+    for (int j=0; j<numberOfSectors; j++)
+      {
+      double phi = 2.0*vtkMath::Pi()*j/numberOfSectors;
+      points->InsertNextPoint(Radius*std::sin(theta)*std::cos(phi),
+                              Radius*std::sin(theta)*std::sin(phi),
+                              Radius*std::cos(theta));
+      }
+    }
+
+  auto ringPoint = [numberOfSectors](int i, int j)
+    {
+    return static_cast<vtkIdType>(1 + (i-1)*numberOfSectors + j%numberOfSectors);
+    };
+
+  vtkNew<vtkCellArray> triangles;
+  for (int j=0; j<numberOfSectors; j++)
+    {
+    vtkIdType triangle[3] = {0, ringPoint(1, j), ringPoint(1, j+1)};
+    triangles->InsertNextCell(3, triangle);
+    }
+  for (int i=1; i<lastRing; i++)
+    {
+    for (int j=0; j<numberOfSectors; j++)
+      {
+      vtkIdType first[3] = {ringPoint(i, j), ringPoint(i+1, j), ringPoint(i+1, j+1)};
+      vtkIdType second[3] = {ringPoint(i, j), ringPoint(i+1, j+1), ringPoint(i, j+1)};
+      triangles->InsertNextCell(3, first);
+      triangles->InsertNextCell(3, second);
+      }
+    }
+  if (!hemisphere)
+    {
+    vtkIdType southPole = points->InsertNextPoint(0.0, 0.0, -Radius);
+    for (int j=0; j<numberOfSectors; j++)
+      {
+      vtkIdType triangle[3] = {southPole, ringPoint(lastRing, j+1), ringPoint(lastRing, j)};
+      triangles->InsertNextCell(3, triangle);
+      }
+    }
+
+  sphere->SetPoints(points);
+  sphere->SetPolys(triangles);
+}
+
+//------------------------------------------------------------------------------
+// Check that the output is a single polyline, closed or open as expected, and
+// that the error function vanishes at all of its points
+bool CheckContour(const char *name, vtkPolyData *contour, bool closed,
+                  const std::function<double(const double*)> &error, double tolerance)
+{
+  vtkCellArray *lines = contour->GetLines();
+  if (!lines || lines->GetNumberOfCells() != 1)
+    {
+    std::cerr << name << ": expected a single polyline, got "
+              << (lines ? lines->GetNumberOfCells() : 0) << std::endl;
+    return false;
+    }
+
+  vtkIdType numberOfPoints;
+  const vtkIdType *pointIds;
+  lines->InitTraversal();
+  lines->GetNextCell(numberOfPoints, pointIds);
+  if (numberOfPoints < 3 || (pointIds[0] == pointIds[numberOfPoints-1]) != closed)
+    {
+    std::cerr << name << ": expected a" << (closed ? " closed" : "n open")
+              << " polyline of at least 3 points" << std::endl;
+    return false;
+    }
+
+  for (vtkIdType index=0; index<numberOfPoints; index++)
+    {
+    double point[3];
+    contour->GetPoint(pointIds[index], point);
+    double value = error(point);
+    if (std::fabs(value) > tolerance)
+      {
+      std::cerr << name << ": point (" << point[0] << ", " << point[1] << ", " << point[2]
+                << ") is " << value << " off the contour" << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//------------------------------------------------------------------------------
+int vtkSurfaceContourExtractorTest1(int vtkNotUsed(argc), char *vtkNotUsed(argv)[])
+{
+  vtkNew<vtkPolyData> sphere;
+  CreateSphere(sphere, 40, 20, false);
+
+  vtkNew<vtkSurfaceContourExtractor> extractor;
+  extractor->SetInputData(sphere);
+  bool success = true;
+
+  // Oblique plane: the contour points lie on the plane up to the single
+  // precision of the output points
+  double origin[3] = {0.0, 0.0, 10.0};
+  double normal[3] = {0.1, 0.2, 1.0};
+  vtkMath::Normalize(normal);
+  extractor->SetContourTypeToPlane();
+  extractor->SetOrigin(origin);
+  extractor->SetNormal(normal);
+  extractor->Update();
+  success &= CheckContour("Plane contour", extractor->GetOutput(), true,
+    [&](const double *point)
+    {
+    double offset[3];
+    vtkMath::Subtract(point, origin, offset);
+    return vtkMath::Dot(offset, normal);
+    }, 1e-5*Radius);
+
+  // Sphere centered on the north pole: the distance is interpolated linearly
+  // along the edges, so the points are only close to the sphere
+  double center[3] = {0.0, 0.0, Radius};
+  double contourRadius = 30.0;
+  extractor->SetContourTypeToSphere();
+  extractor->SetOrigin(center);
+  extractor->SetContourValue(contourRadius);
+  extractor->Update();
+  success &= CheckContour("Sphere contour", extractor->GetOutput(), true,
+    [&](const double *point)
+    {
+    return std::sqrt(vtkMath::Distance2BetweenPoints(point, center)) - contourRadius;
+    }, 0.01*contourRadius);
+
+  // Isovalue of the z coordinate, which is linear over the triangles
+  vtkNew<vtkDoubleArray> heights;
+  heights->SetName("Height");
+  heights->SetNumberOfTuples(sphere->GetNumberOfPoints());
+  for (vtkIdType pointId=0; pointId<sphere->GetNumberOfPoints(); pointId++)
+    {
+    heights->SetValue(pointId, sphere->GetPoint(pointId)[2]);
+    }
+  extractor->SetContourTypeToScalars();
+  extractor->SetContourScalars(heights);
+  extractor->SetContourValue(-20.0);
+  extractor->Update();
+  success &= CheckContour("Scalars contour", extractor->GetOutput(), true,
+    [](const double *point) { return point[2] + 20.0; }, 1e-5*Radius);
+
+  // Vertical plane through an open hemisphere: a single open arc
+  vtkNew<vtkPolyData> hemisphere;
+  CreateSphere(hemisphere, 40, 20, true);
+  double verticalOrigin[3] = {0.0, 0.0, 0.0};
+  double verticalNormal[3] = {1.0, 0.0, 0.0};
+  extractor->SetInputData(hemisphere);
+  extractor->SetContourTypeToPlane();
+  extractor->SetOrigin(verticalOrigin);
+  extractor->SetNormal(verticalNormal);
+  extractor->Update();
+  success &= CheckContour("Open contour", extractor->GetOutput(), false,
+    [](const double *point) { return point[0]; }, 1e-5*Radius);
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
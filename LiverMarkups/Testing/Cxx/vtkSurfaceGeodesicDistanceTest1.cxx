@@ -0,0 +1,212 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (The Intervention Centre,
+  Oslo University Hospital) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+// Known-answer tests of vtkSurfaceGeodesicDistance on a triangulated strip
+// folded at a right angle: the geodesic distance is the Euclidean distance in
+// the unfolded strip.
+
+#include "vtkSurfaceGeodesicDistance.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkFloatArray.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+// Strip of width 10 (x) and unfolded length 20 (s), folded at s = 10: the
+// first half lies in the z = 0 plane and the second half in the y = 10 plane.
+const int NumberOfSteps[2] = {40, 80};
+const double StripSize[2] = {10.0, 20.0};
+const double FoldPosition = 10.0;
+
+//------------------------------------------------------------------------------
+void FoldedStripPoint(double x, double s, double point[3])
+{
+  point[0] = x;
+  point[1] = std::min(s, FoldPosition);
+  point[2] = std::max(s - FoldPosition, 0.0);
+}
+
+//------------------------------------------------------------------------------
+void CreateFoldedStrip(vtkPolyData *strip)
+{
+  vtkNew<vtkPoints> points;
+  points->SetDataTypeToDouble();
+  for (int i=0; i<=NumberOfSteps[0]; i++)
+    {
+    for (int j=0; j<=NumberOfSteps[1]; j++)
+      {
+      double point[3];
+      FoldedStripPoint(StripSize[0]*i/NumberOfSteps[0], StripSize[1]*j/NumberOfSteps[1], point);
+      points->InsertNextPoint(point);
+      }
+    }
+
+  // Alternate the diagonals so that the triangulation has no preferred
+  // direction
+  vtkNew<vtkCellArray> triangles;
+  int rowSize = NumberOfSteps[1]+1;
+  for (int i=0; i<NumberOfSteps[0]; i++)
+    {
+    for (int j=0; j<NumberOfSteps[1]; j++)
+      {
+      vtkIdType a = i*rowSize+j, b = (i+1)*rowSize+j, c = (i+1)*rowSize+j+1, d = i*rowSize+j+1;
+      if ((i+j) % 2 == 0)
+        {
+        vtkIdType first[3] = {a, b, c}, second[3] = {a, c, d};
+        triangles->InsertNextCell(3, first);
+        triangles->InsertNextCell(3, second);
+        }
+      else
+        {
+        vtkIdType first[3] = {a, b, d}, second[3] = {b, c, d};
+        triangles->InsertNextCell(3, first);
+        triangles->InsertNextCell(3, second);
+        }
+      }
+    }
+
+  strip->SetPoints(points);
+  strip->SetPolys(triangles);
+}
+
+} // end of anonymous namespace
+
+//------------------------------------------------------------------------------
+int vtkSurfaceGeodesicDistanceTest1(int vtkNotUsed(argc), char *vtkNotUsed(argv)[])
+{
+  vtkNew<vtkPolyData> strip;
+  CreateFoldedStrip(strip);
+
+  vtkNew<vtkSurfaceGeodesicDistance> geodesicDistance;
+  geodesicDistance->SetSurface(strip);
+
+  // Source on the flat part, 8 away from the fold
+  const double sourceCoordinates[2] = {5.0, 2.0};
+  double source[3];
+  FoldedStripPoint(sourceCoordinates[0], sourceCoordinates[1], source);
+
+  vtkNew<vtkFloatArray> distances;
+  if (!geodesicDistance->ComputeDistances(source, distances))
+    {
+    std::cerr << "ComputeDistances failed on a valid surface" << std::endl;
+    return EXIT_FAILURE;
+    }
+  if (distances->GetNumberOfTuples() != strip->GetNumberOfPoints())
+    {
+    std::cerr << "Expected one distance per vertex, got " << distances->GetNumberOfTuples()
+              << " for " << strip->GetNumberOfPoints() << " vertices" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The triangle update propagates a planar front exactly, so on a
+  // developable surface the distances match up to float precision
+  const double relativeTolerance = 1e-4;
+  int rowSize = NumberOfSteps[1]+1;
+  double maximumRelativeError = 0.0;
+  for (int i=0; i<=NumberOfSteps[0]; i++)
+    {
+    for (int j=0; j<=NumberOfSteps[1]; j++)
+      {
+      double dx = StripSize[0]*i/NumberOfSteps[0] - sourceCoordinates[0];
+      double ds = StripSize[1]*j/NumberOfSteps[1] - sourceCoordinates[1];
+      double expected = std::sqrt(dx*dx + ds*ds);
+      if (expected < 1.0)
+        {
+        continue;
+        }
+      double error = std::fabs(distances->GetValue(i*rowSize+j) - expected) / expected;
+      maximumRelativeError = std::max(maximumRelativeError, error);
+      }
+    }
+  if (maximumRelativeError > relativeTolerance)
+    {
+    std::cerr << "Geodesic distances off by up to " << 100.0*maximumRelativeError
+              << "% of the unfolded distance" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Straight across the fold: 8 on the flat part and 6 up the folded part
+  double target[3];
+  FoldedStripPoint(5.0, 16.0, target);
+  double distance = geodesicDistance->GetDistance(target, distances);
+  if (std::fabs(distance - 14.0) > 14.0*relativeTolerance)
+    {
+    std::cerr << "Distance across the fold: got " << distance << ", expected 14" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // A triangle disconnected from the strip is not reached by the front
+  vtkIdType isolated[3];
+  isolated[0] = strip->GetPoints()->InsertNextPoint(100.0, 0.0, 0.0);
+  isolated[1] = strip->GetPoints()->InsertNextPoint(101.0, 0.0, 0.0);
+  isolated[2] = strip->GetPoints()->InsertNextPoint(100.0, 1.0, 0.0);
+  strip->GetPolys()->InsertNextCell(3, isolated);
+  strip->GetPoints()->Modified();
+  strip->GetPolys()->Modified();
+  geodesicDistance->ComputeDistances(source, distances);
+  for (vtkIdType pointId : isolated)
+    {
+    if (distances->GetValue(pointId) != VTK_FLOAT_MAX)
+      {
+      std::cerr << "Unreached vertex " << pointId << ": got " << distances->GetValue(pointId)
+                << ", expected VTK_FLOAT_MAX" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  double unreached[3] = {100.2, 0.2, 0.0};
+  if (geodesicDistance->GetDistance(unreached, distances) != VTK_DOUBLE_MAX)
+    {
+    std::cerr << "Unreached point: expected VTK_DOUBLE_MAX" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
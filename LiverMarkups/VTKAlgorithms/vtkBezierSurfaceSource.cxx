@@ -0,0 +1,1933 @@
+/*=========================================================================
+
+  Program: NorMIT-Plan
+  Module: vtkBezierSurfaceSource.cxx
+
+  Copyright (c) 2017, The Intervention Centre, Oslo University Hospital
+
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+  this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  =========================================================================*/
+#include "vtkBezierSurfaceSource.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkObjectFactory.h>
+#include <vtkInformation.h>
+#include <vtkExecutive.h>
+#include <vtkInformationVector.h>
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
+#include <vtkMath.h>
+#include <vtkPointData.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+// SIMD includes
+#if defined(__AVX__)
+#define BEZIER_SURFACE_SOURCE_USE_AVX
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BEZIER_SURFACE_SOURCE_USE_SSE
+#include <emmintrin.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace
+{
+
+//-------------------------------------------------------------------------------
+// Bernstein polynomials of the given degree evaluated at t (and optionally
+// their first and second derivatives). The triangular (de Casteljau) recurrence
+// B_k^p(t) = (1-t) B_k^{p-1}(t) + t B_{k-1}^{p-1}(t) is used, which only
+// involves convex combinations and therefore remains stable for high degrees
+// (no binomial coefficients or powers are computed).
+void BernsteinBasis(unsigned int degree, double t, double *basis, double *derivative=nullptr,
+                    double *secondDerivative=nullptr)
+{
+  double s = 1.0 - t;
+
+  basis[0] = 1.0;
+  for (unsigned int p=1; p<=degree; p++)
+    {
+    // d2/dt2 B_k^p(t) = p (p-1) (B_{k-2}^{p-2}(t) - 2 B_{k-1}^{p-2}(t) + B_k^{p-2}(t))
+    if (p+1 == degree && secondDerivative != nullptr)
+      {
+      for (unsigned int k=0; k<=degree; k++)
+        {
+        double left = k > 1 ? basis[k-2] : 0.0;
+        double middle = (k > 0 && k < degree) ? basis[k-1] : 0.0;
+        double right = k+1 < degree ? basis[k] : 0.0;
+        secondDerivative[k] = degree * (degree-1) * (left - 2.0*middle + right);
+        }
+      }
+
+    // d/dt B_k^p(t) = p (B_{k-1}^{p-1}(t) - B_k^{p-1}(t))
+    if (p == degree && derivative != nullptr)
+      {
+      for (unsigned int k=0; k<=degree; k++)
+        {
+        double left = k > 0 ? basis[k-1] : 0.0;
+        double right = k < degree ? basis[k] : 0.0;
+        derivative[k] = degree * (left - right);
+        }
+      }
+
+    double previous = 0.0;
+    for (unsigned int k=0; k<p; k++)
+      {
+      double current = basis[k];
+      basis[k] = s*current + t*previous;
+      previous = current;
+      }
+    basis[p] = t*previous;
+    }
+
+  if (degree == 0 && derivative != nullptr)
+    {
+    derivative[0] = 0.0;
+    }
+
+  if (degree < 2 && secondDerivative != nullptr)
+    {
+    std::fill(secondDerivative, secondDerivative+degree+1, 0.0);
+    }
+}
+
+//-------------------------------------------------------------------------------
+// Maximum number of Newton iterations used to project points onto the surface
+const int MaximumNumberOfProjectionIterations = 20;
+
+//-------------------------------------------------------------------------------
+// Convergence tolerance (parametric step) of the projection onto the surface
+const double ProjectionTolerance = 1e-12;
+
+//-------------------------------------------------------------------------------
+// Number of consecutive incremental updates after which a full evaluation is
+// forced to flush the accumulated floating point error.
+const unsigned int MaximumNumberOfIncrementalUpdates = 256;
+
+//-------------------------------------------------------------------------------
+// Number of v samples evaluated at once by the single precision kernel
+const unsigned int SinglePrecisionBlockSize = 8;
+
+//-------------------------------------------------------------------------------
+// Number of threads the tessellation may be evaluated with and index of the
+// calling thread, which select the slice of the scratch buffers it uses.
+int GetMaximumNumberOfThreads()
+{
+#ifdef _OPENMP
+  return omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
+
+int GetThreadNumber()
+{
+#ifdef _OPENMP
+  return omp_get_thread_num();
+#else
+  return 0;
+#endif
+}
+
+//-------------------------------------------------------------------------------
+// Scratch storage for the basis functions of a single point evaluation. The
+// evaluations run inside the Newton iterations of the projection and
+// intersection, so the storage stays on the stack for the usual control grid
+// sizes and only falls back to the heap for very large grids.
+class BasisBuffer
+{
+public:
+  explicit BasisBuffer(unsigned int size)
+  {
+    this->Data = this->Buffer;
+    if (size > MaximumSize)
+      {
+      this->Heap.resize(size);
+      this->Data = this->Heap.data();
+      }
+  }
+
+  double *operator[](unsigned int offset) { return this->Data+offset; }
+
+private:
+  static const unsigned int MaximumSize = 192;
+  double Buffer[MaximumSize];
+  std::vector<double> Heap;
+  double *Data;
+};
+
+//-------------------------------------------------------------------------------
+// Evaluation of one row of the surface in single precision:
+//   row[j*3+k] = sum_cj basisY[cj*stride+j] * rowPoints[cj*3+k]
+// basisY is the transposed v basis table with rows padded to a multiple of
+// SinglePrecisionBlockSize, so full blocks can always be loaded.
+inline void EvaluateSinglePrecisionRow(const float *basisY, unsigned int stride,
+                                       const float *rowPoints, unsigned int yGrid,
+                                       unsigned int yRes, float *row)
+{
+  for (unsigned int j=0; j<yRes; j+=SinglePrecisionBlockSize)
+    {
+    float x[SinglePrecisionBlockSize];
+    float y[SinglePrecisionBlockSize];
+    float z[SinglePrecisionBlockSize];
+
+#if defined(BEZIER_SURFACE_SOURCE_USE_AVX)
+    __m256 accumulatorX = _mm256_setzero_ps();
+    __m256 accumulatorY = _mm256_setzero_ps();
+    __m256 accumulatorZ = _mm256_setzero_ps();
+    for (unsigned int cj=0; cj<yGrid; cj++)
+      {
+      __m256 basis = _mm256_loadu_ps(basisY + cj*stride + j);
+      accumulatorX = _mm256_add_ps(accumulatorX, _mm256_mul_ps(basis, _mm256_set1_ps(rowPoints[cj*3])));
+      accumulatorY = _mm256_add_ps(accumulatorY, _mm256_mul_ps(basis, _mm256_set1_ps(rowPoints[cj*3+1])));
+      accumulatorZ = _mm256_add_ps(accumulatorZ, _mm256_mul_ps(basis, _mm256_set1_ps(rowPoints[cj*3+2])));
+      }
+    _mm256_storeu_ps(x, accumulatorX);
+    _mm256_storeu_ps(y, accumulatorY);
+    _mm256_storeu_ps(z, accumulatorZ);
+#elif defined(BEZIER_SURFACE_SOURCE_USE_SSE)
+    __m128 accumulatorX[2] = {_mm_setzero_ps(), _mm_setzero_ps()};
+    __m128 accumulatorY[2] = {_mm_setzero_ps(), _mm_setzero_ps()};
+    __m128 accumulatorZ[2] = {_mm_setzero_ps(), _mm_setzero_ps()};
+    for (unsigned int cj=0; cj<yGrid; cj++)
+      {
+      __m128 controlX = _mm_set1_ps(rowPoints[cj*3]);
+      __m128 controlY = _mm_set1_ps(rowPoints[cj*3+1]);
+      __m128 controlZ = _mm_set1_ps(rowPoints[cj*3+2]);
+      for (int half=0; half<2; half++)
+        {
+        __m128 basis = _mm_loadu_ps(basisY + cj*stride + j + half*4);
+        accumulatorX[half] = _mm_add_ps(accumulatorX[half], _mm_mul_ps(basis, controlX));
+        accumulatorY[half] = _mm_add_ps(accumulatorY[half], _mm_mul_ps(basis, controlY));
+        accumulatorZ[half] = _mm_add_ps(accumulatorZ[half], _mm_mul_ps(basis, controlZ));
+        }
+      }
+    for (int half=0; half<2; half++)
+      {
+      _mm_storeu_ps(x + half*4, accumulatorX[half]);
+      _mm_storeu_ps(y + half*4, accumulatorY[half]);
+      _mm_storeu_ps(z + half*4, accumulatorZ[half]);
+      }
+#else
+    std::fill(x, x+SinglePrecisionBlockSize, 0.0f);
+    std::fill(y, y+SinglePrecisionBlockSize, 0.0f);
+    std::fill(z, z+SinglePrecisionBlockSize, 0.0f);
+    for (unsigned int cj=0; cj<yGrid; cj++)
+      {
+      const float *basis = basisY + cj*stride + j;
+      for (unsigned int lane=0; lane<SinglePrecisionBlockSize; lane++)
+        {
+        x[lane] += basis[lane] * rowPoints[cj*3];
+        y[lane] += basis[lane] * rowPoints[cj*3+1];
+        z[lane] += basis[lane] * rowPoints[cj*3+2];
+        }
+      }
+#endif
+
+    // De-interleave the lanes into the xyz output (skipping the padding)
+    unsigned int count = std::min(SinglePrecisionBlockSize, yRes-j);
+    for (unsigned int lane=0; lane<count; lane++)
+      {
+      float *point = row + (j+lane)*3;
+      point[0] = x[lane];
+      point[1] = y[lane];
+      point[2] = z[lane];
+      }
+    }
+}
+
+//-------------------------------------------------------------------------------
+// Subdivision of a control net (m x n, row-major with xyz triplets) at the
+// middle of the parametric direction u (direction 0) or v (direction 1)
+// using the de Casteljau algorithm.
+void SubdivideControlNet(const std::vector<double> &net,
+                         unsigned int m, unsigned int n, int direction,
+                         std::vector<double> &first, std::vector<double> &second)
+{
+  first.resize(net.size());
+  second.resize(net.size());
+
+  unsigned int count = direction == 0 ? m : n;
+  unsigned int lines = direction == 0 ? n : m;
+  std::vector<double> work(count*3);
+
+  for (unsigned int line=0; line<lines; line++)
+    {
+    // Gather the control polygon of this iso-line
+    for (unsigned int c=0; c<count; c++)
+      {
+      unsigned int index = direction == 0 ? c*n+line : line*n+c;
+      std::copy(&net[index*3], &net[index*3]+3, &work[c*3]);
+      }
+
+    // Triangular de Casteljau scheme at t = 0.5
+    for (unsigned int c=0; c<count; c++)
+      {
+      unsigned int firstIndex = direction == 0 ? c*n+line : line*n+c;
+      unsigned int secondIndex = direction == 0 ? (count-1-c)*n+line : line*n+(count-1-c);
+      std::copy(&work[0], &work[0]+3, &first[firstIndex*3]);
+      std::copy(&work[(count-1-c)*3], &work[(count-1-c)*3]+3, &second[secondIndex*3]);
+      for (unsigned int k=0; k+1<count-c; k++)
+        {
+        for (int d=0; d<3; d++)
+          {
+          work[k*3+d] = 0.5*(work[k*3+d] + work[(k+1)*3+d]);
+          }
+        }
+      }
+    }
+}
+
+//-------------------------------------------------------------------------------
+// Maximum distance between the control points of a net and the bilinear
+// patch interpolating its four corners.
+double ControlNetFlatness(const std::vector<double> &net, unsigned int m, unsigned int n)
+{
+  const double *p00 = &net[0];
+  const double *p10 = &net[((m-1)*n)*3];
+  const double *p01 = &net[(n-1)*3];
+  const double *p11 = &net[((m-1)*n+n-1)*3];
+
+  double maximumDistance2 = 0.0;
+  for (unsigned int ci=0; ci<m; ci++)
+    {
+    double s = ci / static_cast<double>(m-1);
+    for (unsigned int cj=0; cj<n; cj++)
+      {
+      double t = cj / static_cast<double>(n-1);
+      double bilinear[3];
+      for (int d=0; d<3; d++)
+        {
+        bilinear[d] = (1-s)*(1-t)*p00[d] + s*(1-t)*p10[d] + (1-s)*t*p01[d] + s*t*p11[d];
+        }
+      maximumDistance2 = std::max(maximumDistance2,
+                                  vtkMath::Distance2BetweenPoints(bilinear, &net[(ci*n+cj)*3]));
+      }
+    }
+
+  return std::sqrt(maximumDistance2);
+}
+
+//-------------------------------------------------------------------------------
+// Intersection of the segment p1 + t*direction (t in [0,1]) with an axis
+// aligned box (slab test). Returns the entry parameter of the segment.
+bool IntersectSegmentWithBox(const double p1[3], const double direction[3],
+                             const double bounds[6], double &entry)
+{
+  double tMinimum = 0.0;
+  double tMaximum = 1.0;
+  for (int d=0; d<3; d++)
+    {
+    if (std::fabs(direction[d]) < VTK_DBL_EPSILON)
+      {
+      if (p1[d] < bounds[2*d] || p1[d] > bounds[2*d+1])
+        {
+        return false;
+        }
+      continue;
+      }
+
+    double t0 = (bounds[2*d] - p1[d]) / direction[d];
+    double t1 = (bounds[2*d+1] - p1[d]) / direction[d];
+    tMinimum = std::max(tMinimum, std::min(t0, t1));
+    tMaximum = std::min(tMaximum, std::max(t0, t1));
+    if (tMinimum > tMaximum)
+      {
+      return false;
+      }
+    }
+
+  entry = tMinimum;
+  return true;
+}
+
+//-------------------------------------------------------------------------------
+// Sub-patch visited by the ray intersection, with its parametric extent
+struct IntersectionPatch
+{
+  std::vector<double> Net;
+  double U;
+  double V;
+  double Size;
+  int Level;
+};
+
+//-------------------------------------------------------------------------------
+// Maximum subdivision level of the ray intersection
+const int MaximumIntersectionLevel = 16;
+
+//-------------------------------------------------------------------------------
+// Maximum number of Newton iterations refining a ray intersection
+const int MaximumNumberOfIntersectionIterations = 10;
+
+//-------------------------------------------------------------------------------
+// Leaf cell of the adaptive quadtree, in lattice coordinates
+struct AdaptiveCell
+{
+  unsigned int I;
+  unsigned int J;
+  unsigned int Size;
+};
+
+//-------------------------------------------------------------------------------
+// Recursive subdivision of the parametric domain until the control net of
+// every cell is flat enough.
+void SubdivideAdaptiveCell(const std::vector<double> &net, unsigned int m, unsigned int n,
+                           unsigned int i, unsigned int j, unsigned int size,
+                           int level, int maximumLevel, double tolerance,
+                           std::vector<AdaptiveCell> &cells)
+{
+  if (level >= maximumLevel || ControlNetFlatness(net, m, n) <= tolerance)
+    {
+    AdaptiveCell cell = {i, j, size};
+    cells.push_back(cell);
+    return;
+    }
+
+  std::vector<double> lowU, highU, lowULowV, lowUHighV, highULowV, highUHighV;
+  SubdivideControlNet(net, m, n, 0, lowU, highU);
+  SubdivideControlNet(lowU, m, n, 1, lowULowV, lowUHighV);
+  SubdivideControlNet(highU, m, n, 1, highULowV, highUHighV);
+
+  unsigned int half = size/2;
+  SubdivideAdaptiveCell(lowULowV, m, n, i, j, half, level+1, maximumLevel, tolerance, cells);
+  SubdivideAdaptiveCell(highULowV, m, n, i+half, j, half, level+1, maximumLevel, tolerance, cells);
+  SubdivideAdaptiveCell(lowUHighV, m, n, i, j+half, half, level+1, maximumLevel, tolerance, cells);
+  SubdivideAdaptiveCell(highUHighV, m, n, i+half, j+half, half, level+1, maximumLevel, tolerance, cells);
+}
+
+} // end of anonymous namespace
+
+//-------------------------------------------------------------------------------
+vtkStandardNewMacro(vtkBezierSurfaceSource);
+
+//-------------------------------------------------------------------------------
+vtkBezierSurfaceSource::vtkBezierSurfaceSource()
+{
+  this->SetNumberOfInputPorts(0);
+  this->SetNumberOfOutputPorts(1);
+  this->ControlPoints = NULL;
+  this->EvaluationMode = MATRIX_EVALUATION;
+  this->IncrementalUpdate = true;
+  this->ComputeNormals = false;
+  this->OutputPointsPrecision = vtkAlgorithm::DOUBLE_PRECISION;
+  this->TessellationMode = UNIFORM_TESSELLATION;
+  this->AdaptiveTolerance = 0.001;
+  this->MaximumSubdivisionLevel = 6;
+  this->ProjectionSeedResolution = 0;
+  this->SinglePrecisionBasisStride = 0;
+  this->ScratchStride = 0;
+  this->NumberOfScratchThreads = 0;
+  this->EvaluationValid = false;
+  this->NumberOfIncrementalUpdates = 0;
+  this->NumberOfControlPoints[0] = 0;
+  this->NumberOfControlPoints[1] = 0;
+  this->Resolution[0] = 0;
+  this->Resolution[1] = 0;
+
+  //Note: default is bi-cubic bezier surface (cp=4x4)
+  this->SetNumberOfControlPoints(4,4);
+  this->SetResolution(10,10);
+}
+
+//-------------------------------------------------------------------------------
+vtkBezierSurfaceSource::~vtkBezierSurfaceSource()
+{
+  if (this->ControlPoints != NULL)
+    {
+
+    for(unsigned int i=0; i<this->NumberOfControlPoints[0]; i++)
+      {
+      delete[] this->ControlPoints[i];
+      }
+    delete[] this->ControlPoints;
+    this->ControlPoints = NULL;
+    }
+
+  this->NumberOfControlPoints[0] = 0;
+  this->NumberOfControlPoints[1] = 0;
+}
+
+//-------------------------------------------------------------------------------
+void vtkBezierSurfaceSource::PrintSelf(ostream &os, vtkIndent indent)
+{
+  vtkPolyDataAlgorithm::PrintSelf(os, indent);
+
+  os << "Resolution: " << this->Resolution[0] << ", " << this->Resolution[1] << "\n";
+
+  os << "Evaluation mode: " <<
+    (this->EvaluationMode == MATRIX_EVALUATION ? "Matrix" : "Direct") << "\n";
+
+  os << "Incremental update: " << this->IncrementalUpdate << "\n";
+
+  os << "Compute normals: " << this->ComputeNormals << "\n";
+
+  os << "Output points precision: " <<
+    (this->OutputPointsPrecision == vtkAlgorithm::SINGLE_PRECISION ? "Single" : "Double") << "\n";
+
+  os << "Tessellation mode: " <<
+    (this->TessellationMode == ADAPTIVE_TESSELLATION ? "Adaptive" : "Uniform") << "\n";
+
+  os << "Adaptive tolerance: " << this->AdaptiveTolerance << "\n";
+
+  os << "Maximum subdivision level: " << this->MaximumSubdivisionLevel << "\n";
+
+  os << "Number of Control Points : " <<
+    this->NumberOfControlPoints[0] << ", " <<
+    this->NumberOfControlPoints[1] << "\n";
+
+  unsigned int xGrid = this->NumberOfControlPoints[0];
+  unsigned int yGrid = this->NumberOfControlPoints[1];
+
+  for(unsigned int i=0; i<xGrid; i++)
+    {
+    for(unsigned int j=0; j<yGrid; j++)
+      {
+      double cpt[3];
+      cpt[0] = this->ControlPoints[i][j*3];
+      cpt[1] = this->ControlPoints[i][j*3+1];
+      cpt[2] = this->ControlPoints[i][j*3+2];
+
+      os << "Control point[" << i << ", " << j << "] = "
+         << cpt[0] << ", " << cpt[1] << ", " << cpt[2] << "\n";
+      }
+    os << "\n";
+    }
+}
+
+//-------------------------------------------------------------------------------
+void vtkBezierSurfaceSource::SetControlPoints(vtkPoints *points)
+{
+  bool changed = false;
+
+  for(unsigned int i=0; i<this->NumberOfControlPoints[0]; i++)
+    {
+    for(unsigned int j=0; j<this->NumberOfControlPoints[1]; j++)
+      {
+      double *point = points->GetPoint(i*this->NumberOfControlPoints[1]+j);
+      double *controlPoint = this->ControlPoints[i]+j*3;
+      if (controlPoint[0] != point[0] ||
+          controlPoint[1] != point[1] ||
+          controlPoint[2] != point[2])
+        {
+        controlPoint[0] = point[0];
+        controlPoint[1] = point[1];
+        controlPoint[2] = point[2];
+        changed = true;
+        }
+      }
+    }
+
+  // Avoid re-executing the pipeline when the control points did not move
+  if (changed)
+    {
+    this->ComputeProjectionSeeds();
+    this->Modified();
+    }
+}
+
+
+//-------------------------------------------------------------------------------
+vtkSmartPointer<vtkPoints>
+vtkBezierSurfaceSource::GetControlPoints() const
+{
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+
+  for(unsigned int i=0; i<this->NumberOfControlPoints[0]; i++)
+    {
+    for(unsigned int j=0; j<this->NumberOfControlPoints[1]; j++)
+      {
+        double point[3] = {this->ControlPoints[i][j*3],
+                           this->ControlPoints[i][j*3+1],
+                           this->ControlPoints[i][j*3+2]};
+        points->InsertPoint(i*this->NumberOfControlPoints[1]+j,point);
+      }
+    }
+
+  return points;
+}
+
+//-------------------------------------------------------------------------------
+void vtkBezierSurfaceSource::SetNumberOfControlPoints(unsigned int m, unsigned int n)
+{
+  if (this->NumberOfControlPoints[0] == m && this->NumberOfControlPoints[1] == n)
+    {
+    return;
+    }
+
+  if (this->ControlPoints != NULL)
+    {
+    for(unsigned int i=0; i<this->NumberOfControlPoints[0]; i++)
+      {
+      delete[] this->ControlPoints[i];
+      }
+    delete [] this->ControlPoints;
+    }
+
+  //Assignment of less than 2 control points in any dimension will result in 2
+  //control points
+  this->NumberOfControlPoints[0] = (m<2) ? 2 : m;
+  this->NumberOfControlPoints[1] = (n<2) ? 2 : n;
+
+  this->ControlPoints = new double*[this->NumberOfControlPoints[0]];
+  for(unsigned int i=0; i<this->NumberOfControlPoints[0]; i++)
+    {
+    this->ControlPoints[i] = new double[this->NumberOfControlPoints[1]*3];
+    }
+
+  this->ResetControlPoints();
+  this->ComputeBasisTables();
+  this->AllocateScratchBuffers();
+  this->InvalidateEvaluation();
+}
+
+//-------------------------------------------------------------------------------
+void vtkBezierSurfaceSource::ResetControlPoints()
+{
+  unsigned int m = this->NumberOfControlPoints[0];
+  unsigned int n = this->NumberOfControlPoints[1];
+
+  double distx = 1.0 / static_cast<double>(m-1);
+  double disty = 1.0 / static_cast<double>(n-1);
+
+  for (unsigned int i=0; i<m; i++)
+    {
+    for (unsigned int j=0; j<n; j++)
+      {
+      double *pt = this->ControlPoints[i]+j*3;
+      pt[0] = -0.5 + i*distx;
+      pt[1] = -0.5 + j*disty;
+      pt[2] = 0.0;
+      }
+    }
+
+  this->ComputeProjectionSeeds();
+  this->Modified();
+}
+
+//-------------------------------------------------------------------------------
+void vtkBezierSurfaceSource::SetResolution(unsigned int x, unsigned int y)
+{
+  if (this->Resolution[0] == x && this->Resolution[1] == y)
+    {
+    return;
+    }
+
+  this->Resolution[0] = x;
+  this->Resolution[1] = y;
+
+  this->AllocateOutputArrays();
+  this->UpdateTopology();
+  this->ComputeBasisTables();
+  this->InvalidateEvaluation();
+  this->Modified();
+}
+
+//-------------------------------------------------------------------------------
+void vtkBezierSurfaceSource::SetComputeNormals(bool computeNormals)
+{
+  if (this->ComputeNormals == computeNormals)
+    {
+    return;
+    }
+
+  this->ComputeNormals = computeNormals;
+
+  // The partial derivatives are only kept up to date while normals are on
+  this->InvalidateEvaluation();
+  this->Modified();
+}
+
+//-------------------------------------------------------------------------------
+void vtkBezierSurfaceSource::SetOutputPointsPrecision(int precision)
+{
+  if (this->OutputPointsPrecision == precision)
+    {
+    return;
+    }
+
+  this->OutputPointsPrecision = precision;
+  this->AllocateOutputArrays();
+  this->InvalidateEvaluation();
+  this->Modified();
+}
+
+//-------------------------------------------------------------------------------
+void vtkBezierSurfaceSource::AllocateOutputArrays()
+{
+  if (this->OutputPointsPrecision == vtkAlgorithm::SINGLE_PRECISION)
+    {
+    this->DataArray = vtkSmartPointer<vtkFloatArray>::New();
+    this->Normals = vtkSmartPointer<vtkFloatArray>::New();
+    }
+  else
+    {
+    this->DataArray = vtkSmartPointer<vtkDoubleArray>::New();
+    this->Normals = vtkSmartPointer<vtkDoubleArray>::New();
+    }
+
+  unsigned int numberOfPoints = this->Resolution[0]*this->Resolution[1];
+
+  this->DataArray->SetNumberOfComponents(3);
+  this->DataArray->SetNumberOfTuples(numberOfPoints);
+  this->Normals->SetName("Normals");
+  this->Normals->SetNumberOfComponents(3);
+  this->Normals->SetNumberOfTuples(numberOfPoints);
+
+  this->Points = vtkSmartPointer<vtkPoints>::New();
+  this->Points->SetData(this->DataArray);
+
+  this->AllocateScratchBuffers();
+}
+
+//-------------------------------------------------------------------------------
+void vtkBezierSurfaceSource::AllocateScratchBuffers()
+{
+  unsigned int xGrid = this->NumberOfControlPoints[0];
+  unsigned int yGrid = this->NumberOfControlPoints[1];
+
+  // Each thread gets the basis functions of a sample (xGrid + yGrid values)
+  // and a row of the control net collapsed along u and its derivative
+  // (yGrid points each)
+  this->NumberOfScratchThreads = GetMaximumNumberOfThreads();
+  this->ScratchStride = xGrid + yGrid + 6*yGrid;
+  this->Scratch.resize(this->NumberOfScratchThreads*this->ScratchStride);
+  this->SinglePrecisionScratch.resize(this->NumberOfScratchThreads*yGrid*3);
+
+  // At most every control point moves between two evaluations
+  this->ChangedControlPoints.reserve(xGrid*yGrid);
+  this->ChangedControlPointDeltas.resize(xGrid*yGrid*3);
+}
+
+//-------------------------------------------------------------------------------
+void vtkBezierSurfaceSource::GetResolution(unsigned int resolution[2]) const
+{
+  resolution[0] = this->Resolution[0];
+  resolution[1] = this->Resolution[1];
+}
+
+//-------------------------------------------------------------------------------
+int vtkBezierSurfaceSource::RequestData(vtkInformation *vtkNotUsed(request),
+                                        vtkInformationVector **vtkNotUsed(inputVector),
+                                        vtkInformationVector *outputVector)
+{
+  vtkInformation *bezierSurfaceOutputInfo = outputVector->GetInformationObject(0);
+  if (bezierSurfaceOutputInfo)
+    {
+    vtkPolyData *bezierSurfaceOutput =
+      vtkPolyData::SafeDownCast(bezierSurfaceOutputInfo->Get(vtkDataObject::DATA_OBJECT()));
+    if (this->TessellationMode == ADAPTIVE_TESSELLATION)
+      {
+      this->UpdateAdaptiveBezierSurfacePolyData(bezierSurfaceOutput);
+      }
+    else
+      {
+      this->UpdateBezierSurfacePolyData(bezierSurfaceOutput);
+      bezierSurfaceOutput->SetPolys(this->Topology);
+      }
+    }
+
+  return 1;
+}
+
+//-------------------------------------------------------------------------------
+void vtkBezierSurfaceSource::UpdateTopology()
+{
+  unsigned int xRes = this->Resolution[0];
+  unsigned int yRes = this->Resolution[1];
+
+  this->Topology = vtkSmartPointer<vtkCellArray>::New();
+
+  for (unsigned int i=0; i<xRes-1; i++)
+    {
+    for (unsigned int j=0; j<yRes-1; j++)
+      {
+      unsigned int base = i*yRes + j;
+      unsigned int a = base;
+      unsigned int b = base + 1;
+      unsigned int c = base + yRes + 1;
+      unsigned int d = base + yRes;
+      vtkIdType triangle[3];
+
+      triangle[0] = c;
+      triangle[1] = b;
+      triangle[2] = a;
+      Topology->InsertNextCell(3, triangle);
+
+      triangle[0] = d;
+      triangle[1] = c;
+      triangle[2] = a;
+      Topology->InsertNextCell(3, triangle);
+      }
+    }
+}
+
+//-------------------------------------------------------------------------------
+void vtkBezierSurfaceSource::ComputeBasisTables()
+{
+  unsigned int xGrid = this->NumberOfControlPoints[0];
+  unsigned int yGrid = this->NumberOfControlPoints[1];
+  unsigned int xRes = this->Resolution[0];
+  unsigned int yRes = this->Resolution[1];
+
+  // Tables are laid out row-major: BasisX[i*xGrid+ci] = B_ci(u_i)
+  this->BasisX.assign(xRes*xGrid, 0.0);
+  this->BasisY.assign(yRes*yGrid, 0.0);
+  this->DerivativeBasisX.assign(xRes*xGrid, 0.0);
+  this->DerivativeBasisY.assign(yRes*yGrid, 0.0);
+
+  if (xGrid == 0 || yGrid == 0)
+    {
+    return;
+    }
+
+  for (unsigned int i=0; i<xRes; i++)
+    {
+    double u = xRes > 1 ? i / static_cast<double>(xRes - 1) : 0.0;
+    BernsteinBasis(xGrid-1, u, &this->BasisX[i*xGrid], &this->DerivativeBasisX[i*xGrid]);
+    }
+
+  for (unsigned int j=0; j<yRes; j++)
+    {
+    double v = yRes > 1 ? j / static_cast<double>(yRes - 1) : 0.0;
+    BernsteinBasis(yGrid-1, v, &this->BasisY[j*yGrid], &this->DerivativeBasisY[j*yGrid]);
+    }
+
+  // Transposed and padded copy of Bv for the single precision kernel:
+  // SinglePrecisionBasisY[cj*stride+j] = B_cj(v_j)
+  this->SinglePrecisionBasisStride =
+    (yRes + SinglePrecisionBlockSize - 1) / SinglePrecisionBlockSize * SinglePrecisionBlockSize;
+  this->SinglePrecisionBasisY.assign(yGrid*this->SinglePrecisionBasisStride, 0.0f);
+  for (unsigned int j=0; j<yRes; j++)
+    {
+    for (unsigned int cj=0; cj<yGrid; cj++)
+      {
+      this->SinglePrecisionBasisY[cj*this->SinglePrecisionBasisStride+j] =
+        static_cast<float>(this->BasisY[j*yGrid+cj]);
+      }
+    }
+}
+
+//-------------------------------------------------------------------------------
+void vtkBezierSurfaceSource::UpdateBezierSurfacePolyData(vtkPolyData *polyData)
+{
+  if (polyData == NULL)
+    {
+    return;
+    }
+
+  // The points, normals and topology are persistent and updated in place, so
+  // no memory is allocated per update and the rendering buffers of unchanged
+  // arrays (e.g., the topology) are reused by the mapper.
+  this->EvaluateBezierSurface(this->Points);
+  polyData->SetPoints(this->Points);
+
+  if (this->ComputeNormals)
+    {
+    polyData->GetPointData()->SetNormals(this->Normals);
+    }
+}
+
+//-------------------------------------------------------------------------------
+void vtkBezierSurfaceSource::InvalidateEvaluation()
+{
+  this->EvaluationValid = false;
+  this->NumberOfIncrementalUpdates = 0;
+}
+
+//-------------------------------------------------------------------------------
+void vtkBezierSurfaceSource::EvaluateBezierSurface(vtkPoints *points)
+{
+  unsigned int xGrid = this->NumberOfControlPoints[0];
+  unsigned int yGrid = this->NumberOfControlPoints[1];
+
+  // The number of threads can change between evaluations (e.g., by
+  // omp_set_num_threads), which is the only case allocating memory here
+  if (this->NumberOfScratchThreads != GetMaximumNumberOfThreads())
+    {
+    this->AllocateScratchBuffers();
+    }
+
+  // Find out which control points moved since the last evaluation
+  std::vector<unsigned int> &changedControlPoints = this->ChangedControlPoints;
+  changedControlPoints.clear();
+  if (this->EvaluationValid)
+    {
+    for (unsigned int ci=0; ci<xGrid; ci++)
+      {
+      for (unsigned int cj=0; cj<yGrid; cj++)
+        {
+        const double *controlPoint = this->ControlPoints[ci]+cj*3;
+        const double *evaluatedControlPoint = &this->EvaluatedControlPoints[(ci*yGrid+cj)*3];
+        if (controlPoint[0] != evaluatedControlPoint[0] ||
+            controlPoint[1] != evaluatedControlPoint[1] ||
+            controlPoint[2] != evaluatedControlPoint[2])
+          {
+          changedControlPoints.push_back(ci*yGrid+cj);
+          }
+        }
+      }
+    }
+
+  // Each displaced control point costs one multiply-add per vertex, whereas
+  // the matrix evaluation costs roughly yGrid of them.
+  bool incremental =
+    this->EvaluationValid &&
+    this->IncrementalUpdate &&
+    this->EvaluationMode == MATRIX_EVALUATION &&
+    changedControlPoints.size() < yGrid &&
+    this->NumberOfIncrementalUpdates < MaximumNumberOfIncrementalUpdates;
+
+  if (incremental)
+    {
+    if (!changedControlPoints.empty())
+      {
+      if (vtkFloatArray *floatArray = vtkFloatArray::SafeDownCast(this->DataArray))
+        {
+        this->UpdateBezierSurfaceIncremental(floatArray->GetPointer(0), changedControlPoints);
+        }
+      else
+        {
+        this->UpdateBezierSurfaceIncremental(
+          vtkDoubleArray::SafeDownCast(this->DataArray)->GetPointer(0), changedControlPoints);
+        }
+      this->NumberOfIncrementalUpdates++;
+      }
+    }
+  else
+    {
+    if (this->EvaluationMode == MATRIX_EVALUATION &&
+        this->OutputPointsPrecision == vtkAlgorithm::SINGLE_PRECISION)
+      {
+      this->EvaluateBezierSurfaceSinglePrecision();
+      }
+    else if (this->EvaluationMode == MATRIX_EVALUATION)
+      {
+      this->EvaluateBezierSurfaceMatrix();
+      }
+    else
+      {
+      this->EvaluateBezierSurfaceDirect();
+      }
+    if (this->ComputeNormals)
+      {
+      this->EvaluateBezierSurfaceDerivatives();
+      }
+    this->NumberOfIncrementalUpdates = 0;
+    }
+
+  if (this->ComputeNormals)
+    {
+    if (vtkFloatArray *floatArray = vtkFloatArray::SafeDownCast(this->DataArray))
+      {
+      this->UpdateNormals(floatArray->GetPointer(0),
+                          vtkFloatArray::SafeDownCast(this->Normals)->GetPointer(0));
+      }
+    else
+      {
+      this->UpdateNormals(vtkDoubleArray::SafeDownCast(this->DataArray)->GetPointer(0),
+                          vtkDoubleArray::SafeDownCast(this->Normals)->GetPointer(0));
+      }
+    this->Normals->Modified();
+    }
+
+  // Keep track of the control points the surface was evaluated with
+  this->EvaluatedControlPoints.resize(xGrid*yGrid*3);
+  for (unsigned int ci=0; ci<xGrid; ci++)
+    {
+    std::copy(this->ControlPoints[ci], this->ControlPoints[ci]+yGrid*3,
+              this->EvaluatedControlPoints.begin()+ci*yGrid*3);
+    }
+  this->EvaluationValid = true;
+
+  this->DataArray->Modified();
+  if (points->GetData() != this->DataArray.GetPointer())
+    {
+    points->SetData(this->DataArray.GetPointer());
+    }
+}
+
+//-------------------------------------------------------------------------------
+void vtkBezierSurfaceSource::EvaluateBezierSurfaceDirect()
+{
+  unsigned int xGrid = this->NumberOfControlPoints[0];
+  unsigned int yGrid = this->NumberOfControlPoints[1];
+  unsigned int xRes = this->Resolution[0];
+  unsigned int yRes = this->Resolution[1];
+
+#pragma omp parallel for
+  for (int i=0; i<xRes; i++)
+    {
+    double u;
+    u = i / static_cast<double>(xRes - 1);
+
+    double *basisX = &this->Scratch[GetThreadNumber()*this->ScratchStride];
+    double *basisY = basisX + xGrid;
+    BernsteinBasis(xGrid-1, u, basisX);
+
+    for (unsigned int j=0; j<yRes; j++)
+      {
+
+      double basisx, basisy;
+      double point[3];
+      double v;
+      v = j / static_cast<double>(yRes - 1);
+      BernsteinBasis(yGrid-1, v, basisY);
+
+      point[0] = 0;
+      point[1] = 0;
+      point[2] = 0;
+
+      for (unsigned int ci=0; ci<xGrid; ci++)
+        {
+        basisx = basisX[ci];
+
+        for (unsigned int cj=0; cj<yGrid; cj++)
+          {
+          basisy = basisY[cj];
+
+          double *controlPoint = this->ControlPoints[ci]+cj*3;
+
+          point[0] += controlPoint[0] * basisx * basisy;
+          point[1] += controlPoint[1] * basisx * basisy;
+          point[2] += controlPoint[2] * basisx * basisy;
+
+          }
+        }
+      DataArray->SetTuple(i*yRes+j,point);
+      }
+    }
+  //END: parallel for
+}
+
+
+//-------------------------------------------------------------------------------
+void vtkBezierSurfaceSource::EvaluateBezierSurfaceMatrix()
+{
+  unsigned int xGrid = this->NumberOfControlPoints[0];
+  unsigned int yGrid = this->NumberOfControlPoints[1];
+  unsigned int xRes = this->Resolution[0];
+  unsigned int yRes = this->Resolution[1];
+
+  double *surface = vtkDoubleArray::SafeDownCast(this->DataArray)->GetPointer(0);
+
+#pragma omp parallel for
+  for (int i=0; i<xRes; i++)
+    {
+    // Row i of Bu·P: the control net collapsed along the u direction
+    double *rowPoints = &this->Scratch[GetThreadNumber()*this->ScratchStride];
+    std::fill(rowPoints, rowPoints+yGrid*3, 0.0);
+    const double *basisx = &this->BasisX[i*xGrid];
+
+    for (unsigned int ci=0; ci<xGrid; ci++)
+      {
+      const double *controlRow = this->ControlPoints[ci];
+      for (unsigned int k=0; k<yGrid*3; k++)
+        {
+        rowPoints[k] += basisx[ci] * controlRow[k];
+        }
+      }
+
+    // Row i of (Bu·P)·Bv^T
+    for (unsigned int j=0; j<yRes; j++)
+      {
+      const double *basisy = &this->BasisY[j*yGrid];
+      double *point = surface + (i*yRes+j)*3;
+
+      point[0] = 0;
+      point[1] = 0;
+      point[2] = 0;
+
+      for (unsigned int cj=0; cj<yGrid; cj++)
+        {
+        point[0] += basisy[cj] * rowPoints[cj*3];
+        point[1] += basisy[cj] * rowPoints[cj*3+1];
+        point[2] += basisy[cj] * rowPoints[cj*3+2];
+        }
+      }
+    }
+  //END: parallel for
+}
+
+//-------------------------------------------------------------------------------
+void vtkBezierSurfaceSource::EvaluateBezierSurfaceSinglePrecision()
+{
+  unsigned int xGrid = this->NumberOfControlPoints[0];
+  unsigned int yGrid = this->NumberOfControlPoints[1];
+  unsigned int xRes = this->Resolution[0];
+  unsigned int yRes = this->Resolution[1];
+
+  float *surface = vtkFloatArray::SafeDownCast(this->DataArray)->GetPointer(0);
+
+#pragma omp parallel for
+  for (int i=0; i<xRes; i++)
+    {
+    // Row i of Bu·P (accumulated in double precision, it is tiny)
+    int thread = GetThreadNumber();
+    double *rowPoints = &this->Scratch[thread*this->ScratchStride];
+    std::fill(rowPoints, rowPoints+yGrid*3, 0.0);
+    const double *basisx = &this->BasisX[i*xGrid];
+
+    for (unsigned int ci=0; ci<xGrid; ci++)
+      {
+      const double *controlRow = this->ControlPoints[ci];
+      for (unsigned int k=0; k<yGrid*3; k++)
+        {
+        rowPoints[k] += basisx[ci] * controlRow[k];
+        }
+      }
+
+    float *singlePrecisionRowPoints = &this->SinglePrecisionScratch[thread*yGrid*3];
+    std::copy(rowPoints, rowPoints+yGrid*3, singlePrecisionRowPoints);
+
+    // Row i of (Bu·P)·Bv^T
+    EvaluateSinglePrecisionRow(this->SinglePrecisionBasisY.data(),
+                               this->SinglePrecisionBasisStride,
+                               singlePrecisionRowPoints, yGrid,
+                               yRes, surface + i*yRes*3);
+    }
+  //END: parallel for
+}
+
+//-------------------------------------------------------------------------------
+template <typename ValueType>
+void vtkBezierSurfaceSource::UpdateBezierSurfaceIncremental(ValueType *surface,
+                                                            const std::vector<unsigned int> &changedControlPoints)
+{
+  unsigned int xGrid = this->NumberOfControlPoints[0];
+  unsigned int yGrid = this->NumberOfControlPoints[1];
+  unsigned int xRes = this->Resolution[0];
+  unsigned int yRes = this->Resolution[1];
+  unsigned int numberOfChanges = static_cast<unsigned int>(changedControlPoints.size());
+
+  // Displacement of each changed control point
+  double *deltas = this->ChangedControlPointDeltas.data();
+  for (unsigned int c=0; c<numberOfChanges; c++)
+    {
+    unsigned int ci = changedControlPoints[c] / yGrid;
+    unsigned int cj = changedControlPoints[c] % yGrid;
+    const double *controlPoint = this->ControlPoints[ci]+cj*3;
+    const double *evaluatedControlPoint = &this->EvaluatedControlPoints[(ci*yGrid+cj)*3];
+    deltas[c*3]   = controlPoint[0] - evaluatedControlPoint[0];
+    deltas[c*3+1] = controlPoint[1] - evaluatedControlPoint[1];
+    deltas[c*3+2] = controlPoint[2] - evaluatedControlPoint[2];
+    }
+
+#pragma omp parallel for
+  for (int i=0; i<xRes; i++)
+    {
+    for (unsigned int c=0; c<numberOfChanges; c++)
+      {
+      unsigned int ci = changedControlPoints[c] / yGrid;
+      unsigned int cj = changedControlPoints[c] % yGrid;
+      double basisx = this->BasisX[i*xGrid+ci];
+      if (basisx == 0.0 && !this->ComputeNormals)
+        {
+        continue;
+        }
+
+      const double *delta = &deltas[c*3];
+      for (unsigned int j=0; j<yRes; j++)
+        {
+        double weight = basisx * this->BasisY[j*yGrid+cj];
+        ValueType *point = surface + (i*yRes+j)*3;
+        point[0] += weight * delta[0];
+        point[1] += weight * delta[1];
+        point[2] += weight * delta[2];
+        }
+
+      // The partial derivatives are linear in the control points as well
+      if (this->ComputeNormals)
+        {
+        double derivativex = this->DerivativeBasisX[i*xGrid+ci];
+        for (unsigned int j=0; j<yRes; j++)
+          {
+          double weightU = derivativex * this->BasisY[j*yGrid+cj];
+          double weightV = basisx * this->DerivativeBasisY[j*yGrid+cj];
+          double *derivativeU = &this->DerivativesU[(i*yRes+j)*3];
+          double *derivativeV = &this->DerivativesV[(i*yRes+j)*3];
+          for (int k=0; k<3; k++)
+            {
+            derivativeU[k] += weightU * delta[k];
+            derivativeV[k] += weightV * delta[k];
+            }
+          }
+        }
+      }
+    }
+  //END: parallel for
+}
+
+//-------------------------------------------------------------------------------
+void vtkBezierSurfaceSource::EvaluateBezierSurfaceDerivatives()
+{
+  unsigned int xGrid = this->NumberOfControlPoints[0];
+  unsigned int yGrid = this->NumberOfControlPoints[1];
+  unsigned int xRes = this->Resolution[0];
+  unsigned int yRes = this->Resolution[1];
+
+  this->DerivativesU.resize(xRes*yRes*3);
+  this->DerivativesV.resize(xRes*yRes*3);
+
+#pragma omp parallel for
+  for (int i=0; i<xRes; i++)
+    {
+    // Row i of Bu·P and Bu'·P
+    double *rowPoints = &this->Scratch[GetThreadNumber()*this->ScratchStride];
+    double *rowDerivatives = rowPoints + yGrid*3;
+    std::fill(rowPoints, rowPoints+yGrid*6, 0.0);
+    const double *basisx = &this->BasisX[i*xGrid];
+    const double *derivativex = &this->DerivativeBasisX[i*xGrid];
+
+    for (unsigned int ci=0; ci<xGrid; ci++)
+      {
+      const double *controlRow = this->ControlPoints[ci];
+      for (unsigned int k=0; k<yGrid*3; k++)
+        {
+        rowPoints[k] += basisx[ci] * controlRow[k];
+        rowDerivatives[k] += derivativex[ci] * controlRow[k];
+        }
+      }
+
+    // dS/du = (Bu'·P)·Bv^T and dS/dv = (Bu·P)·Bv'^T
+    for (unsigned int j=0; j<yRes; j++)
+      {
+      const double *basisy = &this->BasisY[j*yGrid];
+      const double *derivativey = &this->DerivativeBasisY[j*yGrid];
+      double *derivativeU = &this->DerivativesU[(i*yRes+j)*3];
+      double *derivativeV = &this->DerivativesV[(i*yRes+j)*3];
+
+      for (int k=0; k<3; k++)
+        {
+        derivativeU[k] = 0.0;
+        derivativeV[k] = 0.0;
+        }
+
+      for (unsigned int cj=0; cj<yGrid; cj++)
+        {
+        for (int k=0; k<3; k++)
+          {
+          derivativeU[k] += basisy[cj] * rowDerivatives[cj*3+k];
+          derivativeV[k] += derivativey[cj] * rowPoints[cj*3+k];
+          }
+        }
+      }
+    }
+  //END: parallel for
+}
+
+//-------------------------------------------------------------------------------
+template <typename ValueType>
+void vtkBezierSurfaceSource::UpdateNormals(const ValueType *surface, ValueType *normals)
+{
+  unsigned int xRes = this->Resolution[0];
+  unsigned int yRes = this->Resolution[1];
+
+#pragma omp parallel for
+  for (int i=0; i<xRes; i++)
+    {
+    for (unsigned int j=0; j<yRes; j++)
+      {
+      unsigned int index = i*yRes+j;
+      double normal[3];
+
+      // NOTE: the orientation u x v matches the winding of the topology
+      vtkMath::Cross(&this->DerivativesU[index*3], &this->DerivativesV[index*3], normal);
+      if (vtkMath::Normalize(normal) == 0.0)
+        {
+        // Degenerate parametrization (e.g., collapsed boundary): fall back to
+        // central differences on the tessellation grid.
+        unsigned int iPrev = i > 0 ? i-1 : i;
+        unsigned int iNext = i+1 < xRes ? i+1 : i;
+        unsigned int jPrev = j > 0 ? j-1 : j;
+        unsigned int jNext = j+1 < yRes ? j+1 : j;
+        double tangentU[3], tangentV[3];
+        for (int k=0; k<3; k++)
+          {
+          tangentU[k] = surface[(iNext*yRes+j)*3+k] - surface[(iPrev*yRes+j)*3+k];
+          tangentV[k] = surface[(i*yRes+jNext)*3+k] - surface[(i*yRes+jPrev)*3+k];
+          }
+        vtkMath::Cross(tangentU, tangentV, normal);
+        vtkMath::Normalize(normal);
+        }
+
+      normals[index*3]   = static_cast<ValueType>(normal[0]);
+      normals[index*3+1] = static_cast<ValueType>(normal[1]);
+      normals[index*3+2] = static_cast<ValueType>(normal[2]);
+      }
+    }
+  //END: parallel for
+}
+
+//-------------------------------------------------------------------------------
+void vtkBezierSurfaceSource::EvaluatePoint(double u, double v, double point[3],
+                                          double derivativeU[3], double derivativeV[3]) const
+{
+  unsigned int xGrid = this->NumberOfControlPoints[0];
+  unsigned int yGrid = this->NumberOfControlPoints[1];
+
+  BasisBuffer buffer(2*(xGrid+yGrid));
+  double *basisx = buffer[0];
+  double *derivativex = buffer[xGrid];
+  double *basisy = buffer[2*xGrid];
+  double *derivativey = buffer[2*xGrid+yGrid];
+  BernsteinBasis(xGrid-1, u, basisx, derivativex);
+  BernsteinBasis(yGrid-1, v, basisy, derivativey);
+
+  double du[3] = {0.0, 0.0, 0.0};
+  double dv[3] = {0.0, 0.0, 0.0};
+  point[0] = point[1] = point[2] = 0.0;
+
+  for (unsigned int ci=0; ci<xGrid; ci++)
+    {
+    for (unsigned int cj=0; cj<yGrid; cj++)
+      {
+      const double *controlPoint = this->ControlPoints[ci]+cj*3;
+      double weight = basisx[ci]*basisy[cj];
+      double weightU = derivativex[ci]*basisy[cj];
+      double weightV = basisx[ci]*derivativey[cj];
+      for (int k=0; k<3; k++)
+        {
+        point[k] += weight*controlPoint[k];
+        du[k] += weightU*controlPoint[k];
+        dv[k] += weightV*controlPoint[k];
+        }
+      }
+    }
+
+  if (derivativeU)
+    {
+    std::copy(du, du+3, derivativeU);
+    }
+  if (derivativeV)
+    {
+    std::copy(dv, dv+3, derivativeV);
+    }
+}
+
+//-------------------------------------------------------------------------------
+void vtkBezierSurfaceSource::UpdateAdaptiveBezierSurfacePolyData(vtkPolyData *polyData)
+{
+  if (polyData == NULL)
+    {
+    return;
+    }
+
+  unsigned int xGrid = this->NumberOfControlPoints[0];
+  unsigned int yGrid = this->NumberOfControlPoints[1];
+
+  // Control net in a flat layout and its size for the relative tolerance
+  std::vector<double> net(xGrid*yGrid*3);
+  double bounds[6] = {VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX,
+                      VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX,
+                      VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX};
+  for (unsigned int ci=0; ci<xGrid; ci++)
+    {
+    std::copy(this->ControlPoints[ci], this->ControlPoints[ci]+yGrid*3, &net[ci*yGrid*3]);
+    for (unsigned int cj=0; cj<yGrid; cj++)
+      {
+      for (int d=0; d<3; d++)
+        {
+        bounds[2*d] = std::min(bounds[2*d], this->ControlPoints[ci][cj*3+d]);
+        bounds[2*d+1] = std::max(bounds[2*d+1], this->ControlPoints[ci][cj*3+d]);
+        }
+      }
+    }
+  double diagonal = std::sqrt((bounds[1]-bounds[0])*(bounds[1]-bounds[0]) +
+                              (bounds[3]-bounds[2])*(bounds[3]-bounds[2]) +
+                              (bounds[5]-bounds[4])*(bounds[5]-bounds[4]));
+
+  // Quadtree subdivision on a lattice of latticeSize x latticeSize cells
+  unsigned int latticeSize = 1u << this->MaximumSubdivisionLevel;
+  std::vector<AdaptiveCell> cells;
+  SubdivideAdaptiveCell(net, xGrid, yGrid, 0, 0, latticeSize, 0,
+                        this->MaximumSubdivisionLevel,
+                        this->AdaptiveTolerance*diagonal, cells);
+
+  // Vertices are the corners of the leaf cells (and the centers of the cells
+  // having hanging vertices on their edges)
+  unsigned int latticeStride = latticeSize+1;
+  std::vector<vtkIdType> vertexIds(latticeStride*latticeStride, -1);
+  std::vector<unsigned int> vertices;
+  auto addVertex = [&](unsigned int i, unsigned int j)
+    {
+    vtkIdType &id = vertexIds[i*latticeStride+j];
+    if (id < 0)
+      {
+      id = static_cast<vtkIdType>(vertices.size());
+      vertices.push_back(i*latticeStride+j);
+      }
+    return id;
+    };
+
+  for (const AdaptiveCell &cell : cells)
+    {
+    addVertex(cell.I, cell.J);
+    addVertex(cell.I+cell.Size, cell.J);
+    addVertex(cell.I+cell.Size, cell.J+cell.Size);
+    addVertex(cell.I, cell.J+cell.Size);
+    }
+
+  // Triangulation: cells without hanging vertices are split in two
+  // triangles, the rest are triangulated as a fan around their center so
+  // that edges shared with finer neighbors match (no T-junctions). The
+  // winding (counter-clockwise in u,v) matches the uniform tessellation.
+  auto topology = vtkSmartPointer<vtkCellArray>::New();
+  std::vector<vtkIdType> boundary;
+  for (const AdaptiveCell &cell : cells)
+    {
+    unsigned int i0 = cell.I;
+    unsigned int j0 = cell.J;
+    unsigned int i1 = cell.I+cell.Size;
+    unsigned int j1 = cell.J+cell.Size;
+
+    boundary.clear();
+    for (unsigned int i=i0; i<i1; i++)
+      {
+      if (vertexIds[i*latticeStride+j0] >= 0) boundary.push_back(vertexIds[i*latticeStride+j0]);
+      }
+    for (unsigned int j=j0; j<j1; j++)
+      {
+      if (vertexIds[i1*latticeStride+j] >= 0) boundary.push_back(vertexIds[i1*latticeStride+j]);
+      }
+    for (unsigned int i=i1; i>i0; i--)
+      {
+      if (vertexIds[i*latticeStride+j1] >= 0) boundary.push_back(vertexIds[i*latticeStride+j1]);
+      }
+    for (unsigned int j=j1; j>j0; j--)
+      {
+      if (vertexIds[i0*latticeStride+j] >= 0) boundary.push_back(vertexIds[i0*latticeStride+j]);
+      }
+
+    vtkIdType triangle[3];
+    if (boundary.size() == 4)
+      {
+      triangle[0] = boundary[0]; triangle[1] = boundary[1]; triangle[2] = boundary[2];
+      topology->InsertNextCell(3, triangle);
+      triangle[0] = boundary[0]; triangle[1] = boundary[2]; triangle[2] = boundary[3];
+      topology->InsertNextCell(3, triangle);
+      continue;
+      }
+
+    vtkIdType center = addVertex(i0+cell.Size/2, j0+cell.Size/2);
+    for (size_t k=0; k<boundary.size(); k++)
+      {
+      triangle[0] = center;
+      triangle[1] = boundary[k];
+      triangle[2] = boundary[(k+1)%boundary.size()];
+      topology->InsertNextCell(3, triangle);
+      }
+    }
+
+  // Evaluation of the vertices
+  auto points = vtkSmartPointer<vtkPoints>::New();
+  points->SetDataType(this->OutputPointsPrecision == vtkAlgorithm::SINGLE_PRECISION ?
+                      VTK_FLOAT : VTK_DOUBLE);
+  points->SetNumberOfPoints(static_cast<vtkIdType>(vertices.size()));
+
+  vtkSmartPointer<vtkDataArray> normals;
+  if (this->ComputeNormals)
+    {
+    if (this->OutputPointsPrecision == vtkAlgorithm::SINGLE_PRECISION)
+      {
+      normals = vtkSmartPointer<vtkFloatArray>::New();
+      }
+    else
+      {
+      normals = vtkSmartPointer<vtkDoubleArray>::New();
+      }
+    normals->SetName("Normals");
+    normals->SetNumberOfComponents(3);
+    normals->SetNumberOfTuples(static_cast<vtkIdType>(vertices.size()));
+    }
+
+  int numberOfVertices = static_cast<int>(vertices.size());
+
+#pragma omp parallel for
+  for (int index=0; index<numberOfVertices; index++)
+    {
+    double u = (vertices[index] / latticeStride) / static_cast<double>(latticeSize);
+    double v = (vertices[index] % latticeStride) / static_cast<double>(latticeSize);
+
+    double point[3], derivativeU[3], derivativeV[3];
+    this->EvaluatePoint(u, v, point, derivativeU, derivativeV);
+    points->SetPoint(index, point);
+
+    if (normals)
+      {
+      double normal[3];
+      vtkMath::Cross(derivativeU, derivativeV, normal);
+      if (vtkMath::Normalize(normal) == 0.0)
+        {
+        // Degenerate parametrization: use the normal slightly inside the patch
+        double nudge = 1e-3;
+        this->EvaluatePoint(u+nudge*(0.5-u), v+nudge*(0.5-v), point, derivativeU, derivativeV);
+        vtkMath::Cross(derivativeU, derivativeV, normal);
+        vtkMath::Normalize(normal);
+        }
+      normals->SetTuple(index, normal);
+      }
+    }
+  //END: parallel for
+
+  polyData->SetPoints(points);
+  polyData->SetPolys(topology);
+  if (normals)
+    {
+    polyData->GetPointData()->SetNormals(normals);
+    }
+}
+
+//-------------------------------------------------------------------------------
+void vtkBezierSurfaceSource::EvaluatePointSecondDerivatives(double u, double v, double point[3],
+                                                           double derivativeU[3], double derivativeV[3],
+                                                           double derivativeUU[3], double derivativeUV[3],
+                                                           double derivativeVV[3]) const
+{
+  unsigned int xGrid = this->NumberOfControlPoints[0];
+  unsigned int yGrid = this->NumberOfControlPoints[1];
+
+  BasisBuffer buffer(3*(xGrid+yGrid));
+  double *basisx = buffer[0];
+  double *derivativex = buffer[xGrid];
+  double *secondDerivativex = buffer[2*xGrid];
+  double *basisy = buffer[3*xGrid];
+  double *derivativey = buffer[3*xGrid+yGrid];
+  double *secondDerivativey = buffer[3*xGrid+2*yGrid];
+  BernsteinBasis(xGrid-1, u, basisx, derivativex, secondDerivativex);
+  BernsteinBasis(yGrid-1, v, basisy, derivativey, secondDerivativey);
+
+  for (int k=0; k<3; k++)
+    {
+    point[k] = derivativeU[k] = derivativeV[k] = 0.0;
+    derivativeUU[k] = derivativeUV[k] = derivativeVV[k] = 0.0;
+    }
+
+  for (unsigned int ci=0; ci<xGrid; ci++)
+    {
+    for (unsigned int cj=0; cj<yGrid; cj++)
+      {
+      const double *controlPoint = this->ControlPoints[ci]+cj*3;
+      double weight = basisx[ci]*basisy[cj];
+      double weightU = derivativex[ci]*basisy[cj];
+      double weightV = basisx[ci]*derivativey[cj];
+      double weightUU = secondDerivativex[ci]*basisy[cj];
+      double weightUV = derivativex[ci]*derivativey[cj];
+      double weightVV = basisx[ci]*secondDerivativey[cj];
+      for (int k=0; k<3; k++)
+        {
+        point[k] += weight*controlPoint[k];
+        derivativeU[k] += weightU*controlPoint[k];
+        derivativeV[k] += weightV*controlPoint[k];
+        derivativeUU[k] += weightUU*controlPoint[k];
+        derivativeUV[k] += weightUV*controlPoint[k];
+        derivativeVV[k] += weightVV*controlPoint[k];
+        }
+      }
+    }
+}
+
+//-------------------------------------------------------------------------------
+void vtkBezierSurfaceSource::ComputeProjectionSeeds()
+{
+  // A few samples per control point capture all the basins of the distance
+  unsigned int resolution = 2*std::max(this->NumberOfControlPoints[0],
+                                       this->NumberOfControlPoints[1]);
+  resolution = std::max(resolution, 8u);
+
+  this->ProjectionSeedResolution = resolution;
+  this->ProjectionSeeds.resize(resolution*resolution*3);
+
+  for (unsigned int i=0; i<resolution; i++)
+    {
+    double u = i / static_cast<double>(resolution-1);
+    for (unsigned int j=0; j<resolution; j++)
+      {
+      double v = j / static_cast<double>(resolution-1);
+      this->EvaluatePoint(u, v, &this->ProjectionSeeds[(i*resolution+j)*3]);
+      }
+    }
+}
+
+//-------------------------------------------------------------------------------
+double vtkBezierSurfaceSource::ProjectPoint(const double point[3], double closestPoint[3],
+                                           double parametricCoordinates[2]) const
+{
+  // Seed with the closest sample of the coarse grid
+  unsigned int resolution = this->ProjectionSeedResolution;
+  unsigned int seed = 0;
+  double seedDistance2 = VTK_DOUBLE_MAX;
+  for (unsigned int index=0; index<resolution*resolution; index++)
+    {
+    double distance2 = vtkMath::Distance2BetweenPoints(point, &this->ProjectionSeeds[index*3]);
+    if (distance2 < seedDistance2)
+      {
+      seedDistance2 = distance2;
+      seed = index;
+      }
+    }
+
+  double u = (seed / resolution) / static_cast<double>(resolution-1);
+  double v = (seed % resolution) / static_cast<double>(resolution-1);
+
+  double position[3], su[3], sv[3], suu[3], suv[3], svv[3];
+  this->EvaluatePointSecondDerivatives(u, v, position, su, sv, suu, suv, svv);
+  double distance2 = vtkMath::Distance2BetweenPoints(position, point);
+
+  // Newton iterations on f(u,v) = |S(u,v) - p|^2 / 2 restricted to [0,1]^2
+  for (int iteration=0; iteration<MaximumNumberOfProjectionIterations; iteration++)
+    {
+    double residual[3];
+    vtkMath::Subtract(position, point, residual);
+
+    double gu = vtkMath::Dot(su, residual);
+    double gv = vtkMath::Dot(sv, residual);
+    double huu = vtkMath::Dot(su, su) + vtkMath::Dot(suu, residual);
+    double huv = vtkMath::Dot(su, sv) + vtkMath::Dot(suv, residual);
+    double hvv = vtkMath::Dot(sv, sv) + vtkMath::Dot(svv, residual);
+    double determinant = huu*hvv - huv*huv;
+
+    // Fall back to Gauss-Newton where the Hessian is not positive definite
+    if (huu <= 0.0 || determinant <= 0.0)
+      {
+      huu = vtkMath::Dot(su, su);
+      huv = vtkMath::Dot(su, sv);
+      hvv = vtkMath::Dot(sv, sv);
+      determinant = huu*hvv - huv*huv;
+      }
+
+    if (determinant <= VTK_DBL_EPSILON*huu*hvv)
+      {
+      break;
+      }
+
+    double du = -(hvv*gu - huv*gv) / determinant;
+    double dv = -(huu*gv - huv*gu) / determinant;
+
+    // On the border of the parametric domain, a coordinate whose descent
+    // direction leaves the domain is locked and the step is taken along the
+    // border (a corner with both coordinates locked is a constrained minimum)
+    bool lockedU = (u <= 0.0 && gu > 0.0) || (u >= 1.0 && gu < 0.0);
+    bool lockedV = (v <= 0.0 && gv > 0.0) || (v >= 1.0 && gv < 0.0);
+    if (lockedU && lockedV)
+      {
+      break;
+      }
+    else if (lockedU)
+      {
+      du = 0.0;
+      dv = -gv / hvv;
+      }
+    else if (lockedV)
+      {
+      du = -gu / huu;
+      dv = 0.0;
+      }
+
+    // Backtracking: the step is halved until the distance decreases
+    bool improved = false;
+    double step = 1.0;
+    double nextU = u, nextV = v;
+    for (int halving=0; halving<10 && !improved; halving++, step*=0.5)
+      {
+      nextU = std::min(std::max(u + step*du, 0.0), 1.0);
+      nextV = std::min(std::max(v + step*dv, 0.0), 1.0);
+
+      double nextPosition[3], nextSu[3], nextSv[3], nextSuu[3], nextSuv[3], nextSvv[3];
+      this->EvaluatePointSecondDerivatives(nextU, nextV, nextPosition, nextSu, nextSv,
+                                           nextSuu, nextSuv, nextSvv);
+      double nextDistance2 = vtkMath::Distance2BetweenPoints(nextPosition, point);
+      if (nextDistance2 <= distance2)
+        {
+        improved = true;
+        distance2 = nextDistance2;
+        std::copy(nextPosition, nextPosition+3, position);
+        std::copy(nextSu, nextSu+3, su);
+        std::copy(nextSv, nextSv+3, sv);
+        std::copy(nextSuu, nextSuu+3, suu);
+        std::copy(nextSuv, nextSuv+3, suv);
+        std::copy(nextSvv, nextSvv+3, svv);
+        }
+      }
+
+    if (!improved)
+      {
+      break;
+      }
+
+    double change = std::fabs(nextU - u) + std::fabs(nextV - v);
+    u = nextU;
+    v = nextV;
+    if (change < ProjectionTolerance)
+      {
+      break;
+      }
+    }
+
+  std::copy(position, position+3, closestPoint);
+  if (parametricCoordinates)
+    {
+    parametricCoordinates[0] = u;
+    parametricCoordinates[1] = v;
+    }
+
+  return std::sqrt(distance2);
+}
+
+//-------------------------------------------------------------------------------
+void vtkBezierSurfaceSource::ProjectPoints(vtkPoints *points, vtkPoints *closestPoints,
+                                          vtkDataArray *parametricCoordinates,
+                                          vtkDataArray *distances) const
+{
+  if (points == NULL || closestPoints == NULL)
+    {
+    vtkErrorMacro("ProjectPoints: invalid input or output points.");
+    return;
+    }
+
+  vtkIdType numberOfPoints = points->GetNumberOfPoints();
+  closestPoints->SetNumberOfPoints(numberOfPoints);
+  if (parametricCoordinates)
+    {
+    parametricCoordinates->SetNumberOfComponents(2);
+    parametricCoordinates->SetNumberOfTuples(numberOfPoints);
+    }
+  if (distances)
+    {
+    distances->SetNumberOfComponents(1);
+    distances->SetNumberOfTuples(numberOfPoints);
+    }
+
+#pragma omp parallel for
+  for (int index=0; index<static_cast<int>(numberOfPoints); index++)
+    {
+    double point[3], closestPoint[3], uv[2];
+    points->GetPoint(index, point);
+
+    double distance = this->ProjectPoint(point, closestPoint, uv);
+
+    closestPoints->SetPoint(index, closestPoint);
+    if (parametricCoordinates)
+      {
+      parametricCoordinates->SetTuple(index, uv);
+      }
+    if (distances)
+      {
+      distances->SetTuple1(index, distance);
+      }
+    }
+  //END: parallel for
+
+  closestPoints->Modified();
+  if (parametricCoordinates)
+    {
+    parametricCoordinates->Modified();
+    }
+  if (distances)
+    {
+    distances->Modified();
+    }
+}
+
+//-------------------------------------------------------------------------------
+int vtkBezierSurfaceSource::IntersectWithLine(const double p1[3], const double p2[3], double tolerance,
+                                              double &t, double x[3], double parametricCoordinates[2]) const
+{
+  if (this->ControlPoints == NULL)
+    {
+    return 0;
+    }
+
+  unsigned int xGrid = this->NumberOfControlPoints[0];
+  unsigned int yGrid = this->NumberOfControlPoints[1];
+
+  double direction[3];
+  vtkMath::Subtract(p2, p1, direction);
+  double length2 = vtkMath::Dot(direction, direction);
+  if (length2 == 0.0)
+    {
+    return 0;
+    }
+
+  IntersectionPatch root;
+  root.Net.resize(xGrid*yGrid*3);
+  root.U = 0.0;
+  root.V = 0.0;
+  root.Size = 1.0;
+  root.Level = 0;
+  double bounds[6] = {VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX,
+                      VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX,
+                      VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX};
+  for (unsigned int ci=0; ci<xGrid; ci++)
+    {
+    std::copy(this->ControlPoints[ci], this->ControlPoints[ci]+yGrid*3, &root.Net[ci*yGrid*3]);
+    for (unsigned int cj=0; cj<yGrid; cj++)
+      {
+      for (int d=0; d<3; d++)
+        {
+        bounds[2*d] = std::min(bounds[2*d], this->ControlPoints[ci][cj*3+d]);
+        bounds[2*d+1] = std::max(bounds[2*d+1], this->ControlPoints[ci][cj*3+d]);
+        }
+      }
+    }
+  double diagonal = std::sqrt((bounds[1]-bounds[0])*(bounds[1]-bounds[0]) +
+                              (bounds[3]-bounds[2])*(bounds[3]-bounds[2]) +
+                              (bounds[5]-bounds[4])*(bounds[5]-bounds[4]));
+  double absoluteTolerance = std::max(tolerance*diagonal, VTK_DBL_EPSILON);
+
+  int found = 0;
+  double closestT = VTK_DOUBLE_MAX;
+
+  // Depth-first traversal of the subdivision of the control net
+  std::vector<IntersectionPatch> stack;
+  stack.push_back(root);
+  while (!stack.empty())
+    {
+    IntersectionPatch patch = std::move(stack.back());
+    stack.pop_back();
+
+    // Culling by the (slightly enlarged) bounding box of the control net
+    double patchBounds[6] = {VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX,
+                             VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX,
+                             VTK_DOUBLE_MAX, -VTK_DOUBLE_MAX};
+    for (unsigned int index=0; index<xGrid*yGrid; index++)
+      {
+      for (int d=0; d<3; d++)
+        {
+        patchBounds[2*d] = std::min(patchBounds[2*d], patch.Net[index*3+d] - absoluteTolerance);
+        patchBounds[2*d+1] = std::max(patchBounds[2*d+1], patch.Net[index*3+d] + absoluteTolerance);
+        }
+      }
+    double entry;
+    if (!IntersectSegmentWithBox(p1, direction, patchBounds, entry) || entry > closestT)
+      {
+      continue;
+      }
+
+    if (patch.Level < MaximumIntersectionLevel &&
+        ControlNetFlatness(patch.Net, xGrid, yGrid) > absoluteTolerance)
+      {
+      std::vector<double> lowU, highU;
+      IntersectionPatch children[4];
+      SubdivideControlNet(patch.Net, xGrid, yGrid, 0, lowU, highU);
+      SubdivideControlNet(lowU, xGrid, yGrid, 1, children[0].Net, children[1].Net);
+      SubdivideControlNet(highU, xGrid, yGrid, 1, children[2].Net, children[3].Net);
+      double half = 0.5*patch.Size;
+      for (int c=0; c<4; c++)
+        {
+        children[c].U = patch.U + (c/2)*half;
+        children[c].V = patch.V + (c%2)*half;
+        children[c].Size = half;
+        children[c].Level = patch.Level+1;
+        stack.push_back(std::move(children[c]));
+        }
+      continue;
+      }
+
+    // Newton iterations on F(u,v,s) = S(u,v) - (p1 + s*direction) = 0 seeded at
+    // the center of the flat sub-patch
+    double u = patch.U + 0.5*patch.Size;
+    double v = patch.V + 0.5*patch.Size;
+    double point[3], su[3], sv[3];
+    this->EvaluatePoint(u, v, point, su, sv);
+    double toPoint[3];
+    vtkMath::Subtract(point, p1, toPoint);
+    double s = vtkMath::Dot(toPoint, direction) / length2;
+
+    bool converged = false;
+    for (int iteration=0; iteration<MaximumNumberOfIntersectionIterations; iteration++)
+      {
+      double residual[3];
+      for (int d=0; d<3; d++)
+        {
+        residual[d] = p1[d] + s*direction[d] - point[d];
+        }
+
+      // Cramer's rule on the columns (Su, Sv, -direction)
+      double minusDirection[3] = {-direction[0], -direction[1], -direction[2]};
+      double cross[3];
+      vtkMath::Cross(sv, minusDirection, cross);
+      double determinant = vtkMath::Dot(su, cross);
+      if (std::fabs(determinant) < VTK_DBL_EPSILON*vtkMath::Norm(su)*vtkMath::Norm(sv)*std::sqrt(length2))
+        {
+        break;
+        }
+      double du = vtkMath::Dot(residual, cross) / determinant;
+      vtkMath::Cross(residual, minusDirection, cross);
+      double dv = vtkMath::Dot(su, cross) / determinant;
+      vtkMath::Cross(sv, residual, cross);
+      double ds = vtkMath::Dot(su, cross) / determinant;
+
+      u += du;
+      v += dv;
+      s += ds;
+      if (u < -patch.Size || u > 1.0+patch.Size || v < -patch.Size || v > 1.0+patch.Size)
+        {
+        break;
+        }
+
+      this->EvaluatePoint(u, v, point, su, sv);
+      if (std::fabs(du) + std::fabs(dv) < ProjectionTolerance)
+        {
+        converged = true;
+        break;
+        }
+      }
+
+    // Solutions belong to the sub-patch (up to the tolerance of its borders)
+    // and the segment, the closest one to p1 is kept
+    double margin = 1e-9;
+    if (!converged ||
+        u < std::max(patch.U - margin, -margin) || u > std::min(patch.U + patch.Size + margin, 1.0 + margin) ||
+        v < std::max(patch.V - margin, -margin) || v > std::min(patch.V + patch.Size + margin, 1.0 + margin) ||
+        s < 0.0 || s > 1.0 || s >= closestT)
+      {
+      continue;
+      }
+
+    found = 1;
+    closestT = s;
+    t = s;
+    std::copy(point, point+3, x);
+    if (parametricCoordinates)
+      {
+      parametricCoordinates[0] = std::min(std::max(u, 0.0), 1.0);
+      parametricCoordinates[1] = std::min(std::max(v, 0.0), 1.0);
+      }
+    }
+
+  return found;
+}
@@ -0,0 +1,537 @@
+/*=========================================================================
+
+  Program: NorMIT-Plan
+  Module: vtkBezierSurfaceSource.h
+
+  Copyright (c) 2017, The Intervention Centre, Oslo University Hospital
+
+  All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions are met:
+
+  1. Redistributions of source code must retain the above copyright notice,
+  this list of conditions and the following disclaimer.
+
+  2. Redistributions in binary form must reproduce the above copyright notice,
+  this list of conditions and the following disclaimer in the documentation
+  and/or other materials provided with the distribution.
+
+  3. Neither the name of the copyright holder nor the names of its contributors
+  may be used to endorse or promote products derived from this software
+  without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+  AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+  IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+  DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+  FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+  DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+  SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+  CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+  OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+  =========================================================================*/
+#ifndef __vtkBezierSurfaceSource_h
+#define __vtkBezierSurfaceSource_h
+
+#include "vtkSlicerLiverMarkupsModuleVTKAlgorithmsExport.h"
+
+// VTK includes
+#include <vtkPolyDataAlgorithm.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <vector>
+
+//-------------------------------------------------------------------------------
+class vtkDataArray;
+class vtkPoints;
+class vtkPolyData;
+class vtkFloatArray;
+
+//------------------------------------------------------------------------------
+/**
+ * \ingroup ResectionPlanning
+ *
+ * \brief This class generates the geometry of a Bézier surface
+ * of degree \f$m+1\times n+1\f$ where \f$m\f$ and \f$n\f$ are number of control
+ * points in the respective parametric directions $u$ and \f$v\f$.
+ */
+class VTK_SLICER_LIVERMARKUPS_MODULE_VTKALGORITHMS_EXPORT vtkBezierSurfaceSource : public vtkPolyDataAlgorithm
+{
+ public:
+
+  /**
+   * Instantiation of object.
+   *
+   *
+   * @return pointer to vtkBezierSurfaceSource newly created.
+   */
+  static vtkBezierSurfaceSource *New();
+
+  vtkTypeMacro(vtkBezierSurfaceSource, vtkPolyDataAlgorithm);
+
+  /**
+   * Print the properties of the object.
+   *
+   * @param os ouptut stream to print the properties to.
+   * @param indent indentation value.
+   */
+  void PrintSelf(ostream &os, vtkIndent indent);
+
+  /**
+   * Set the control points.
+   *
+   * @param points pointer to vtkPoints object containing the
+   * coordinates of the control points.
+   */
+  void SetControlPoints(vtkPoints *points);
+
+  /**
+   * Get the control points.
+   *
+   * @return pointer to vtkPoints object containing the coordinates of
+   * the control points.
+   */
+  vtkSmartPointer<vtkPoints> GetControlPoints() const;
+
+  /**
+   * Evaluation of the Bézier surface and its partial derivatives at an
+   * arbitrary parametric location.
+   *
+   * @param u parametric coordinate u in [0,1].
+   * @param v parametric coordinate v in [0,1].
+   * @param point surface point at (u,v).
+   * @param derivativeU partial derivative with respect to u (optional).
+   * @param derivativeV partial derivative with respect to v (optional).
+   */
+  void EvaluatePoint(double u, double v, double point[3],
+                     double derivativeU[3]=nullptr, double derivativeV[3]=nullptr) const;
+
+  /**
+   * Projection of a point onto the Bézier surface (closest point). The
+   * closest sample of a coarse grid seeds Newton iterations on the squared
+   * distance using the analytic derivatives of the surface, so the result
+   * is exact up to numerical precision and no tessellation is required.
+   * The seeds are computed whenever the control points change, so
+   * concurrent calls are safe.
+   *
+   * @param point point to project.
+   * @param closestPoint closest point on the surface.
+   * @param parametricCoordinates parametric coordinates (u,v) of the closest
+   * point (optional).
+   *
+   * @return distance between the point and the surface.
+   */
+  double ProjectPoint(const double point[3], double closestPoint[3],
+                      double parametricCoordinates[2]=nullptr) const;
+
+  /**
+   * Projection of a batch of points onto the Bézier surface (see
+   * ProjectPoint). The points are processed in parallel.
+   *
+   * @param points points to project.
+   * @param closestPoints closest points on the surface (resized to the
+   * number of points).
+   * @param parametricCoordinates 2-component array receiving the parametric
+   * coordinates of the closest points (optional).
+   * @param distances 1-component array receiving the distances (optional).
+   */
+  void ProjectPoints(vtkPoints *points, vtkPoints *closestPoints,
+                     vtkDataArray *parametricCoordinates=nullptr,
+                     vtkDataArray *distances=nullptr) const;
+
+  /**
+   * Intersection of a line segment with the Bézier surface. The control net
+   * is recursively subdivided and the sub-patches whose bounding box (which
+   * contains the sub-patch by the convex hull property) does not intersect
+   * the segment are culled. Sub-patches that are flat within the tolerance
+   * are refined with Newton iterations on the exact surface, so the cost is
+   * independent of the tessellation resolution.
+   *
+   * @param p1 first point of the segment.
+   * @param p2 second point of the segment.
+   * @param tolerance flatness tolerance relative to the diagonal of the
+   * bounding box of the control net.
+   * @param t parametric coordinate of the intersection along the segment.
+   * @param x intersection point.
+   * @param parametricCoordinates parametric coordinates (u,v) of the
+   * intersection on the surface (optional).
+   *
+   * @return 1 if the segment intersects the surface (the intersection
+   * closest to p1 is reported), 0 otherwise.
+   */
+  int IntersectWithLine(const double p1[3], const double p2[3], double tolerance,
+                        double &t, double x[3], double parametricCoordinates[2]=nullptr) const;
+
+  /**
+   * Set the number of control points.
+   *
+   * @param m number of control points in the parametric u direction.
+   * @param n number of control points in the parametric v direction.
+   */
+  void SetNumberOfControlPoints(unsigned int m, unsigned int n);
+
+  /**
+   * Get the number of control points.
+   *
+   * @param numberOfControlPoints pointer to int array receiving the number of
+   * control points in the parametric u and v directions.
+   */
+  void GetNumberOfControlPoints(unsigned int *numberOfControlPoints) const
+  {
+    numberOfControlPoints[0] = this->NumberOfControlPoints[0];
+    numberOfControlPoints[1] = this->NumberOfControlPoints[1];
+  }
+
+  /**
+   * Set the resolution of the Bézier surface (number of quads).
+   *
+   * @param x resolution of the surface in the parametric u direction.
+   * @param y resolution of the surface in the parametric v direction.
+   */
+  void SetResolution(unsigned int x, unsigned int y);
+
+  /**
+   * Get the resolution of the Bézier surface (number of quads).
+   *
+   * @param resolution pointer to int array containing u and v resolution.
+   */
+  void GetResolution(unsigned int *resolution) const;
+
+  /**
+   * Get thre resolution in the parametric direction u (number of quads).
+   *
+   * @return resolution in parametric direction u.
+   */
+  unsigned int GetResolutionX() const
+  {return this->Resolution[0];}
+
+  /**
+   * Get the resolution in the parametric direction v (number of quads).
+   *
+   * @return resolution in the parametric direction v.
+   */
+  unsigned int GetResolutionY() const
+  {return this->Resolution[1];}
+
+  /**
+   * Resolutions the surface is displayed with in the views, at rest and
+   * while it is being interacted with. Computations on the displayed
+   * tessellation use the same ones.
+   */
+  static const unsigned int DisplayResolution = 50;
+  static const unsigned int InteractionResolution = 10;
+
+  /**
+   * Set the control points to the default values (e.g., lying in a
+   * plane of size 1).
+   */
+  void ResetControlPoints();
+
+  /**
+   * Get the number of control poits in the parametric direction u.
+   *
+   * @return number of control points in the parametric direction u.
+   */
+  unsigned int GetNumberOfControlPointsX() const
+  {return this->NumberOfControlPoints[0];}
+
+  /**
+   * Get the number of control poits in the parametric direction v.
+   *
+   * @return number of control points in the parametric direction v.
+   */
+  unsigned int GetNumberOfControlPointsY() const
+  {return this->NumberOfControlPoints[1];}
+
+  /**
+   * Strategies available to evaluate the Bézier surface.
+   */
+  enum EvaluationModes
+  {
+    DIRECT_EVALUATION = 0,
+    MATRIX_EVALUATION
+  };
+
+  /**
+   * Set the evaluation mode. DIRECT_EVALUATION computes every Bernstein
+   * term on the fly for each sample. MATRIX_EVALUATION (default) uses the
+   * basis tables precomputed for the current resolution and number of
+   * control points and evaluates the surface as the matrix product
+   * \f$B_u P B_v^T\f$ per coordinate.
+   *
+   * @param mode evaluation mode.
+   */
+  vtkSetClampMacro(EvaluationMode, int, DIRECT_EVALUATION, MATRIX_EVALUATION);
+
+  /**
+   * Get the evaluation mode.
+   *
+   * @return evaluation mode.
+   */
+  vtkGetMacro(EvaluationMode, int);
+
+  void SetEvaluationModeToDirect()
+  {this->SetEvaluationMode(DIRECT_EVALUATION);}
+
+  void SetEvaluationModeToMatrix()
+  {this->SetEvaluationMode(MATRIX_EVALUATION);}
+
+  /**
+   * Enable/disable incremental updates. When enabled (default) and only a
+   * few control points changed since the last evaluation, the surface is
+   * updated in place by adding \f$\Delta_{ij} B_i(u) B_j(v)\f$ for each
+   * displaced control point instead of being re-evaluated. Only used with
+   * MATRIX_EVALUATION.
+   *
+   * @param incrementalUpdate whether incremental updates are allowed.
+   */
+  vtkSetMacro(IncrementalUpdate, bool);
+  vtkGetMacro(IncrementalUpdate, bool);
+  vtkBooleanMacro(IncrementalUpdate, bool);
+
+  /**
+   * Enable/disable the computation of exact per-vertex normals (off by
+   * default). Normals are computed as the normalized cross product of the
+   * partial derivatives \f$\partial S/\partial u\f$ and
+   * \f$\partial S/\partial v\f$ and stored as the point normals of the
+   * output, which makes a vtkPolyDataNormals stage unnecessary.
+   *
+   * @param computeNormals whether normals should be computed.
+   */
+  void SetComputeNormals(bool computeNormals);
+  vtkGetMacro(ComputeNormals, bool);
+  vtkBooleanMacro(ComputeNormals, bool);
+
+  /**
+   * Set the precision of the output points and normals
+   * (vtkAlgorithm::SINGLE_PRECISION or vtkAlgorithm::DOUBLE_PRECISION, the
+   * default). In single precision with MATRIX_EVALUATION the surface is
+   * evaluated by a vectorized kernel producing 8 samples at a time.
+   *
+   * @param precision desired output precision.
+   */
+  void SetOutputPointsPrecision(int precision);
+  vtkGetMacro(OutputPointsPrecision, int);
+
+  /**
+   * Strategies available to tessellate the Bézier surface.
+   */
+  enum TessellationModes
+  {
+    UNIFORM_TESSELLATION = 0,
+    ADAPTIVE_TESSELLATION
+  };
+
+  /**
+   * Set the tessellation mode. UNIFORM_TESSELLATION (default) samples the
+   * surface on a regular grid given by the resolution. ADAPTIVE_TESSELLATION
+   * recursively subdivides the parametric domain (de Casteljau subdivision of
+   * the control net) until each cell is flat up to the adaptive tolerance,
+   * and produces a crack-free triangulation of the resulting quadtree.
+   *
+   * @param mode tessellation mode.
+   */
+  vtkSetClampMacro(TessellationMode, int, UNIFORM_TESSELLATION, ADAPTIVE_TESSELLATION);
+
+  /**
+   * Get the tessellation mode.
+   *
+   * @return tessellation mode.
+   */
+  vtkGetMacro(TessellationMode, int);
+
+  void SetTessellationModeToUniform()
+  {this->SetTessellationMode(UNIFORM_TESSELLATION);}
+
+  void SetTessellationModeToAdaptive()
+  {this->SetTessellationMode(ADAPTIVE_TESSELLATION);}
+
+  /**
+   * Set the flatness tolerance of the adaptive tessellation, relative to the
+   * diagonal of the bounding box of the control points (default 0.001).
+   *
+   * @param tolerance flatness tolerance.
+   */
+  vtkSetClampMacro(AdaptiveTolerance, double, 0.0, 1.0);
+  vtkGetMacro(AdaptiveTolerance, double);
+
+  /**
+   * Set the maximum number of subdivisions of the adaptive tessellation
+   * (default 6, i.e., at most 64x64 cells).
+   *
+   * @param level maximum subdivision level.
+   */
+  vtkSetClampMacro(MaximumSubdivisionLevel, int, 0, 10);
+  vtkGetMacro(MaximumSubdivisionLevel, int);
+
+ protected:
+  vtkBezierSurfaceSource();
+  ~vtkBezierSurfaceSource();
+
+  /**
+   * Function computing the Bézier surface according to the pipeline
+   * architecture of VTK.
+   *
+   * @return return code.
+   */
+  int RequestData(vtkInformation *, vtkInformationVector **, vtkInformationVector *);
+
+ private:
+  vtkBezierSurfaceSource(const vtkBezierSurfaceSource&);  // Not implemented.
+  void operator=(const vtkBezierSurfaceSource&);  // Not implemented.
+
+  /**
+   * Updates the topology of the mesh representing the Bézier
+   * surface. An effective update will happen whenever the resolution
+   * of the surface is changed.
+   */
+  void UpdateTopology();
+
+  /**
+   * Computation of the Bernstein basis tables \f$B_u\f$ (resolution u
+   * \f$\times\f$ control points u) and \f$B_v\f$ (resolution v \f$\times\f$
+   * control points v). The tables only depend on the resolution and the
+   * number of control points, hence this function is called whenever one of
+   * them changes.
+   */
+  void ComputeBasisTables();
+
+  /**
+   * Computation of the tensor product surface of Bernstein basis (Bézier).
+   *
+   * @param polyData pointer to vtkPolyData which will hold the Bézier surface.
+   */
+  void UpdateBezierSurfacePolyData(vtkPolyData *polyData);
+
+  /**
+   * Computation of the adaptive tessellation of the Bézier surface
+   * (ADAPTIVE_TESSELLATION).
+   *
+   * @param polyData pointer to vtkPolyData which will hold the Bézier surface.
+   */
+  void UpdateAdaptiveBezierSurfacePolyData(vtkPolyData *polyData);
+
+  /**
+   * Evaluation of the Bézier surface, its first and second partial
+   * derivatives at an arbitrary parametric location.
+   */
+  void EvaluatePointSecondDerivatives(double u, double v, double point[3],
+                                      double derivativeU[3], double derivativeV[3],
+                                      double derivativeUU[3], double derivativeUV[3],
+                                      double derivativeVV[3]) const;
+
+  /**
+   * Computation of the coarse grid of surface samples used to seed the
+   * projection of points onto the surface. Called whenever the control
+   * points change.
+   */
+  void ComputeProjectionSeeds();
+
+  /**
+   * Evaluation of Bézier surface.
+   *
+   * @param points coordinates of control points.
+   */
+  void EvaluateBezierSurface(vtkPoints *points);
+
+  /**
+   * Evaluation of the Bézier surface term by term (DIRECT_EVALUATION).
+   */
+  void EvaluateBezierSurfaceDirect();
+
+  /**
+   * Evaluation of the Bézier surface as two dense matrix products using the
+   * precomputed basis tables (MATRIX_EVALUATION).
+   */
+  void EvaluateBezierSurfaceMatrix();
+
+  /**
+   * Evaluation of the Bézier surface as MATRIX_EVALUATION but in single
+   * precision using a vectorized kernel.
+   */
+  void EvaluateBezierSurfaceSinglePrecision();
+
+  /**
+   * Update of the previously evaluated surface adding the contribution of
+   * the control points that moved since the last evaluation.
+   *
+   * @param surface pointer to the evaluated surface points.
+   * @param changedControlPoints indices (i*n+j) of the displaced control points.
+   */
+  template <typename ValueType>
+  void UpdateBezierSurfaceIncremental(ValueType *surface,
+                                      const std::vector<unsigned int> &changedControlPoints);
+
+  /**
+   * Allocation of the output point and normal arrays according to the
+   * resolution and the output points precision.
+   */
+  void AllocateOutputArrays();
+
+  /**
+   * Allocation of the scratch buffers of the evaluation (one slice per
+   * thread) according to the number of control points, so that updating
+   * the surface does not allocate memory.
+   */
+  void AllocateScratchBuffers();
+
+  /**
+   * Mark the evaluated surface as out of date so the next evaluation is a
+   * full one.
+   */
+  void InvalidateEvaluation();
+
+  /**
+   * Evaluation of the partial derivatives of the Bézier surface at every
+   * vertex using the derivative basis tables.
+   */
+  void EvaluateBezierSurfaceDerivatives();
+
+  /**
+   * Computation of the normals from the partial derivatives of the surface.
+   *
+   * @param surface pointer to the evaluated surface points.
+   * @param normals pointer to the normals to compute.
+   */
+  template <typename ValueType>
+  void UpdateNormals(const ValueType *surface, ValueType *normals);
+
+  int EvaluationMode;
+  bool IncrementalUpdate;
+  bool ComputeNormals;
+  int OutputPointsPrecision;
+  int TessellationMode;
+  double AdaptiveTolerance;
+  int MaximumSubdivisionLevel;
+  unsigned int NumberOfControlPoints[2];
+  unsigned int Resolution[2];
+  double **ControlPoints;
+  std::vector<double> BasisX;
+  std::vector<double> BasisY;
+  std::vector<double> DerivativeBasisX;
+  std::vector<double> DerivativeBasisY;
+  std::vector<double> DerivativesU;
+  std::vector<double> DerivativesV;
+  std::vector<float> SinglePrecisionBasisY;
+  unsigned int SinglePrecisionBasisStride;
+  std::vector<double> EvaluatedControlPoints;
+  std::vector<unsigned int> ChangedControlPoints;
+  std::vector<double> ChangedControlPointDeltas;
+  std::vector<double> Scratch;
+  std::vector<float> SinglePrecisionScratch;
+  unsigned int ScratchStride;
+  int NumberOfScratchThreads;
+  std::vector<double> ProjectionSeeds;
+  unsigned int ProjectionSeedResolution;
+  bool EvaluationValid;
+  unsigned int NumberOfIncrementalUpdates;
+  vtkSmartPointer<vtkPoints> Points;
+  vtkSmartPointer<vtkDataArray> DataArray;
+  vtkSmartPointer<vtkDataArray> Normals;
+  vtkSmartPointer<vtkCellArray> Topology;
+};
+
+#endif
@@ -0,0 +1,425 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (The Intervention Centre,
+  Oslo University Hospital) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#include "vtkMultiPatchBezierSurfaceSource.h"
+
+#include "vtkBezierSurfaceSource.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+// STD includes
+#include <algorithm>
+
+//-------------------------------------------------------------------------------
+vtkStandardNewMacro(vtkMultiPatchBezierSurfaceSource);
+
+//-------------------------------------------------------------------------------
+vtkMultiPatchBezierSurfaceSource::vtkMultiPatchBezierSurfaceSource()
+{
+  this->SetNumberOfInputPorts(0);
+  this->SetNumberOfOutputPorts(1);
+  this->NumberOfPatches[0] = 0;
+  this->NumberOfPatches[1] = 0;
+  this->Resolution[0] = 10;
+  this->Resolution[1] = 10;
+  this->ComputeNormals = false;
+  this->OutputPointsPrecision = vtkAlgorithm::DOUBLE_PRECISION;
+  this->OutputValid = false;
+  this->PatchControlPoints = vtkSmartPointer<vtkPoints>::New();
+  this->PatchControlPoints->SetDataTypeToDouble();
+  this->PatchControlPoints->SetNumberOfPoints(16);
+  this->SetNumberOfPatches(2,2);
+}
+
+//-------------------------------------------------------------------------------
+vtkMultiPatchBezierSurfaceSource::~vtkMultiPatchBezierSurfaceSource() = default;
+
+//-------------------------------------------------------------------------------
+void vtkMultiPatchBezierSurfaceSource::PrintSelf(ostream &os, vtkIndent indent)
+{
+  vtkPolyDataAlgorithm::PrintSelf(os, indent);
+
+  os << "Number of patches: " << this->NumberOfPatches[0] << ", " <<
+    this->NumberOfPatches[1] << "\n";
+
+  os << "Resolution: " << this->Resolution[0] << ", " << this->Resolution[1] << "\n";
+
+  os << "Compute normals: " << this->ComputeNormals << "\n";
+
+  os << "Output points precision: " <<
+    (this->OutputPointsPrecision == vtkAlgorithm::SINGLE_PRECISION ? "Single" : "Double") << "\n";
+}
+
+//-------------------------------------------------------------------------------
+void vtkMultiPatchBezierSurfaceSource::SetNumberOfPatches(unsigned int p, unsigned int q)
+{
+  p = p < 1 ? 1 : p;
+  q = q < 1 ? 1 : q;
+
+  if (this->NumberOfPatches[0] == p && this->NumberOfPatches[1] == q)
+    {
+    return;
+    }
+
+  this->NumberOfPatches[0] = p;
+  this->NumberOfPatches[1] = q;
+
+  this->Patches.resize(p*q);
+  for (auto &patch : this->Patches)
+    {
+    if (!patch)
+      {
+      patch = vtkSmartPointer<vtkBezierSurfaceSource>::New();
+      }
+    patch->SetNumberOfControlPoints(4,4);
+    patch->SetResolution(this->Resolution[0], this->Resolution[1]);
+    patch->SetComputeNormals(this->ComputeNormals);
+    patch->SetOutputPointsPrecision(this->OutputPointsPrecision);
+    }
+
+  // Reset the control points to a regular grid on the unit square
+  unsigned int m = 3*p+1;
+  unsigned int n = 3*q+1;
+  auto controlPoints = vtkSmartPointer<vtkPoints>::New();
+  controlPoints->SetDataTypeToDouble();
+  controlPoints->SetNumberOfPoints(m*n);
+  for (unsigned int i=0; i<m; i++)
+    {
+    for (unsigned int j=0; j<n; j++)
+      {
+      controlPoints->SetPoint(i*n+j, -0.5 + i/static_cast<double>(m-1),
+                              -0.5 + j/static_cast<double>(n-1), 0.0);
+      }
+    }
+  this->SetControlPoints(controlPoints);
+
+  this->OutputValid = false;
+  this->Modified();
+}
+
+//-------------------------------------------------------------------------------
+void vtkMultiPatchBezierSurfaceSource::GetNumberOfPatches(unsigned int *numberOfPatches) const
+{
+  numberOfPatches[0] = this->NumberOfPatches[0];
+  numberOfPatches[1] = this->NumberOfPatches[1];
+}
+
+//-------------------------------------------------------------------------------
+void vtkMultiPatchBezierSurfaceSource::SetControlPoints(vtkPoints *points)
+{
+  if (!points)
+    {
+    return;
+    }
+
+  unsigned int n = 3*this->NumberOfPatches[1]+1;
+  if (points->GetNumberOfPoints() < static_cast<vtkIdType>((3*this->NumberOfPatches[0]+1)*n))
+    {
+    vtkErrorMacro("SetControlPoints: not enough control points for "
+                  << this->NumberOfPatches[0] << "x" << this->NumberOfPatches[1] << " patches.");
+    return;
+    }
+
+  bool changed = false;
+  for (unsigned int p=0; p<this->NumberOfPatches[0]; p++)
+    {
+    for (unsigned int q=0; q<this->NumberOfPatches[1]; q++)
+      {
+      for (unsigned int a=0; a<4; a++)
+        {
+        for (unsigned int b=0; b<4; b++)
+          {
+          this->PatchControlPoints->SetPoint(a*4+b, points->GetPoint((3*p+a)*n+3*q+b));
+          }
+        }
+
+      // The patch is only marked as modified if its control points moved
+      vtkBezierSurfaceSource *patch = this->Patches[p*this->NumberOfPatches[1]+q];
+      vtkMTimeType patchTime = patch->GetMTime();
+      patch->SetControlPoints(this->PatchControlPoints);
+      changed = changed || patch->GetMTime() != patchTime;
+      }
+    }
+
+  if (changed)
+    {
+    this->Modified();
+    }
+}
+
+//-------------------------------------------------------------------------------
+void vtkMultiPatchBezierSurfaceSource::SetResolution(unsigned int x, unsigned int y)
+{
+  if (this->Resolution[0] == x && this->Resolution[1] == y)
+    {
+    return;
+    }
+
+  this->Resolution[0] = x;
+  this->Resolution[1] = y;
+  for (auto &patch : this->Patches)
+    {
+    patch->SetResolution(x, y);
+    }
+
+  this->OutputValid = false;
+  this->Modified();
+}
+
+//-------------------------------------------------------------------------------
+void vtkMultiPatchBezierSurfaceSource::GetResolution(unsigned int *resolution) const
+{
+  resolution[0] = this->Resolution[0];
+  resolution[1] = this->Resolution[1];
+}
+
+//-------------------------------------------------------------------------------
+void vtkMultiPatchBezierSurfaceSource::SetComputeNormals(bool computeNormals)
+{
+  if (this->ComputeNormals == computeNormals)
+    {
+    return;
+    }
+
+  this->ComputeNormals = computeNormals;
+  for (auto &patch : this->Patches)
+    {
+    patch->SetComputeNormals(computeNormals);
+    }
+
+  this->OutputValid = false;
+  this->Modified();
+}
+
+//-------------------------------------------------------------------------------
+void vtkMultiPatchBezierSurfaceSource::SetOutputPointsPrecision(int precision)
+{
+  if (this->OutputPointsPrecision == precision)
+    {
+    return;
+    }
+
+  this->OutputPointsPrecision = precision;
+  for (auto &patch : this->Patches)
+    {
+    patch->SetOutputPointsPrecision(precision);
+    }
+
+  this->OutputValid = false;
+  this->Modified();
+}
+
+//-------------------------------------------------------------------------------
+vtkBezierSurfaceSource* vtkMultiPatchBezierSurfaceSource::GetPatch(unsigned int p, unsigned int q) const
+{
+  if (p >= this->NumberOfPatches[0] || q >= this->NumberOfPatches[1])
+    {
+    return nullptr;
+    }
+
+  return this->Patches[p*this->NumberOfPatches[1]+q];
+}
+
+//-------------------------------------------------------------------------------
+int vtkMultiPatchBezierSurfaceSource::IntersectWithLine(const double p1[3], const double p2[3],
+                                                        double tolerance, double &t, double x[3],
+                                                        double parametricCoordinates[2]) const
+{
+  int found = 0;
+  for (unsigned int p=0; p<this->NumberOfPatches[0]; p++)
+    {
+    for (unsigned int q=0; q<this->NumberOfPatches[1]; q++)
+      {
+      double patchT, patchX[3], patchCoordinates[2];
+      vtkBezierSurfaceSource *patch = this->Patches[p*this->NumberOfPatches[1]+q];
+      if (!patch->IntersectWithLine(p1, p2, tolerance, patchT, patchX, patchCoordinates) ||
+          (found && patchT >= t))
+        {
+        continue;
+        }
+
+      found = 1;
+      t = patchT;
+      std::copy(patchX, patchX+3, x);
+      if (parametricCoordinates)
+        {
+        parametricCoordinates[0] = (p + patchCoordinates[0]) / this->NumberOfPatches[0];
+        parametricCoordinates[1] = (q + patchCoordinates[1]) / this->NumberOfPatches[1];
+        }
+      }
+    }
+
+  return found;
+}
+
+//-------------------------------------------------------------------------------
+void vtkMultiPatchBezierSurfaceSource::AllocateOutput()
+{
+  unsigned int numberOfPatches = this->NumberOfPatches[0]*this->NumberOfPatches[1];
+  unsigned int xRes = this->Resolution[0];
+  unsigned int yRes = this->Resolution[1];
+  vtkIdType pointsPerPatch = static_cast<vtkIdType>(xRes)*yRes;
+
+  this->Points = vtkSmartPointer<vtkPoints>::New();
+  this->Points->SetDataType(this->OutputPointsPrecision == vtkAlgorithm::SINGLE_PRECISION ?
+                            VTK_FLOAT : VTK_DOUBLE);
+  this->Points->SetNumberOfPoints(numberOfPatches*pointsPerPatch);
+
+  this->Normals = nullptr;
+  if (this->ComputeNormals)
+    {
+    if (this->OutputPointsPrecision == vtkAlgorithm::SINGLE_PRECISION)
+      {
+      this->Normals = vtkSmartPointer<vtkFloatArray>::New();
+      }
+    else
+      {
+      this->Normals = vtkSmartPointer<vtkDoubleArray>::New();
+      }
+    this->Normals->SetName("Normals");
+    this->Normals->SetNumberOfComponents(3);
+    this->Normals->SetNumberOfTuples(numberOfPatches*pointsPerPatch);
+    }
+
+  // Same triangulation (and winding) as vtkBezierSurfaceSource, offset for
+  // each patch. Vertices on the boundaries between patches are duplicated.
+  this->Topology = vtkSmartPointer<vtkCellArray>::New();
+  for (unsigned int patch=0; patch<numberOfPatches; patch++)
+    {
+    vtkIdType offset = patch*pointsPerPatch;
+    for (unsigned int i=0; i+1<xRes; i++)
+      {
+      for (unsigned int j=0; j+1<yRes; j++)
+        {
+        vtkIdType a = offset + i*yRes + j;
+        vtkIdType b = a + 1;
+        vtkIdType c = a + yRes + 1;
+        vtkIdType d = a + yRes;
+        vtkIdType triangle[3];
+
+        triangle[0] = c;
+        triangle[1] = b;
+        triangle[2] = a;
+        this->Topology->InsertNextCell(3, triangle);
+
+        triangle[0] = d;
+        triangle[1] = c;
+        triangle[2] = a;
+        this->Topology->InsertNextCell(3, triangle);
+        }
+      }
+    }
+
+  this->AssembledPatchTimes.assign(numberOfPatches, 0);
+  this->OutputValid = true;
+}
+
+//-------------------------------------------------------------------------------
+int vtkMultiPatchBezierSurfaceSource::RequestData(vtkInformation *vtkNotUsed(request),
+                                                  vtkInformationVector **vtkNotUsed(inputVector),
+                                                  vtkInformationVector *outputVector)
+{
+  vtkInformation *outputInfo = outputVector->GetInformationObject(0);
+  vtkPolyData *output =
+    vtkPolyData::SafeDownCast(outputInfo->Get(vtkDataObject::DATA_OBJECT()));
+  if (!output)
+    {
+    return 1;
+    }
+
+  if (!this->OutputValid)
+    {
+    this->AllocateOutput();
+    }
+
+  vtkIdType pointsPerPatch = static_cast<vtkIdType>(this->Resolution[0])*this->Resolution[1];
+  bool changed = false;
+
+  // Only patches re-evaluated since they were last copied are assembled
+  for (size_t index=0; index<this->Patches.size(); index++)
+    {
+    vtkBezierSurfaceSource *patch = this->Patches[index];
+    patch->Update();
+
+    vtkPolyData *patchOutput = patch->GetOutput();
+    vtkDataArray *patchPoints = patchOutput->GetPoints()->GetData();
+    if (patchPoints->GetMTime() == this->AssembledPatchTimes[index])
+      {
+      continue;
+      }
+
+    vtkIdType offset = static_cast<vtkIdType>(index)*pointsPerPatch;
+    this->Points->GetData()->InsertTuples(offset, pointsPerPatch, 0, patchPoints);
+    if (this->Normals)
+      {
+      this->Normals->InsertTuples(offset, pointsPerPatch, 0,
+                                  patchOutput->GetPointData()->GetNormals());
+      }
+
+    this->AssembledPatchTimes[index] = patchPoints->GetMTime();
+    changed = true;
+    }
+
+  if (changed)
+    {
+    this->Points->GetData()->Modified();
+    if (this->Normals)
+      {
+      this->Normals->Modified();
+      }
+    }
+
+  output->SetPoints(this->Points);
+  output->SetPolys(this->Topology);
+  if (this->Normals)
+    {
+    output->GetPointData()->SetNormals(this->Normals);
+    }
+
+  return 1;
+}
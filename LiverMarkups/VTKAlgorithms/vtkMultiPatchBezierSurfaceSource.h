@@ -0,0 +1,219 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (The Intervention Centre,
+  Oslo University Hospital) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#ifndef __vtkMultiPatchBezierSurfaceSource_h
+#define __vtkMultiPatchBezierSurfaceSource_h
+
+#include "vtkSlicerLiverMarkupsModuleVTKAlgorithmsExport.h"
+
+// VTK includes
+#include <vtkPolyDataAlgorithm.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <vector>
+
+//-------------------------------------------------------------------------------
+class vtkBezierSurfaceSource;
+class vtkCellArray;
+class vtkDataArray;
+class vtkPoints;
+
+//------------------------------------------------------------------------------
+/**
+ * \ingroup ResectionPlanning
+ *
+ * \brief This class generates the geometry of a surface made of a grid of
+ * \f$P\times Q\f$ bicubic Bézier patches sharing their boundary control
+ * points. The control points are given as a \f$(3P+1)\times(3Q+1)\f$ grid.
+ *
+ * Every patch is evaluated by its own vtkBezierSurfaceSource, so only the
+ * patches whose control points changed are re-evaluated and copied into the
+ * output when the surface is updated.
+ */
+class VTK_SLICER_LIVERMARKUPS_MODULE_VTKALGORITHMS_EXPORT vtkMultiPatchBezierSurfaceSource : public vtkPolyDataAlgorithm
+{
+ public:
+
+  /**
+   * Instantiation of object.
+   *
+   * @return pointer to vtkMultiPatchBezierSurfaceSource newly created.
+   */
+  static vtkMultiPatchBezierSurfaceSource *New();
+
+  vtkTypeMacro(vtkMultiPatchBezierSurfaceSource, vtkPolyDataAlgorithm);
+
+  /**
+   * Print the properties of the object.
+   *
+   * @param os ouptut stream to print the properties to.
+   * @param indent indentation value.
+   */
+  void PrintSelf(ostream &os, vtkIndent indent) override;
+
+  /**
+   * Set the number of patches. The control points are reset.
+   *
+   * @param p number of patches in the parametric u direction.
+   * @param q number of patches in the parametric v direction.
+   */
+  void SetNumberOfPatches(unsigned int p, unsigned int q);
+
+  /**
+   * Get the number of patches.
+   *
+   * @param numberOfPatches pointer to int array receiving the number of
+   * patches in the parametric u and v directions.
+   */
+  void GetNumberOfPatches(unsigned int *numberOfPatches) const;
+
+  /**
+   * Set the control points. Control point \f$(i,j)\f$ is expected at index
+   * \f$i(3Q+1)+j\f$. Only the patches whose control points changed are
+   * marked as modified.
+   *
+   * @param points pointer to vtkPoints object containing the
+   * coordinates of the control points.
+   */
+  void SetControlPoints(vtkPoints *points);
+
+  /**
+   * Set the resolution of every patch.
+   *
+   * @param x resolution of each patch in the parametric u direction.
+   * @param y resolution of each patch in the parametric v direction.
+   */
+  void SetResolution(unsigned int x, unsigned int y);
+
+  /**
+   * Get the resolution of every patch.
+   *
+   * @param resolution pointer to int array containing u and v resolution.
+   */
+  void GetResolution(unsigned int *resolution) const;
+
+  /**
+   * Resolutions of every patch when the surface is displayed in the views,
+   * at rest and while it is being interacted with (see
+   * vtkBezierSurfaceSource::DisplayResolution).
+   */
+  static const unsigned int DisplayResolution = 25;
+  static const unsigned int InteractionResolution = 6;
+
+  /**
+   * Set whether point normals are generated (see
+   * vtkBezierSurfaceSource::SetComputeNormals).
+   *
+   * @param computeNormals whether to compute the normals.
+   */
+  void SetComputeNormals(bool computeNormals);
+  vtkGetMacro(ComputeNormals, bool);
+  vtkBooleanMacro(ComputeNormals, bool);
+
+  /**
+   * Set the precision of the output points (see
+   * vtkBezierSurfaceSource::SetOutputPointsPrecision).
+   *
+   * @param precision vtkAlgorithm::SINGLE_PRECISION or
+   * vtkAlgorithm::DOUBLE_PRECISION.
+   */
+  void SetOutputPointsPrecision(int precision);
+  vtkGetMacro(OutputPointsPrecision, int);
+
+  /**
+   * Get the source evaluating one of the patches.
+   *
+   * @param p patch index in the parametric u direction.
+   * @param q patch index in the parametric v direction.
+   *
+   * @return pointer to the source of the patch, nullptr if out of range.
+   */
+  vtkBezierSurfaceSource* GetPatch(unsigned int p, unsigned int q) const;
+
+  /**
+   * Intersection of a line segment with the surface (see
+   * vtkBezierSurfaceSource::IntersectWithLine). The intersection closest to
+   * p1 over all the patches is reported.
+   *
+   * @param p1 first point of the segment.
+   * @param p2 second point of the segment.
+   * @param tolerance flatness tolerance relative to the size of each patch.
+   * @param t parametric coordinate of the intersection along the segment.
+   * @param x intersection point.
+   * @param parametricCoordinates global parametric coordinates (u,v) in
+   * [0,1] of the intersection, patch (p,q) covering
+   * [p/P,(p+1)/P] x [q/Q,(q+1)/Q] (optional).
+   *
+   * @return 1 if the segment intersects the surface, 0 otherwise.
+   */
+  int IntersectWithLine(const double p1[3], const double p2[3], double tolerance,
+                        double &t, double x[3], double parametricCoordinates[2]=nullptr) const;
+
+ protected:
+  vtkMultiPatchBezierSurfaceSource();
+  ~vtkMultiPatchBezierSurfaceSource() override;
+
+  int RequestData(vtkInformation *, vtkInformationVector **, vtkInformationVector *) override;
+
+ private:
+  vtkMultiPatchBezierSurfaceSource(const vtkMultiPatchBezierSurfaceSource&);  // Not implemented.
+  void operator=(const vtkMultiPatchBezierSurfaceSource&);  // Not implemented.
+
+  /**
+   * (Re)allocation of the output points, normals and topology whenever the
+   * number of patches, resolution or output precision change.
+   */
+  void AllocateOutput();
+
+ private:
+  unsigned int NumberOfPatches[2];
+  unsigned int Resolution[2];
+  bool ComputeNormals;
+  int OutputPointsPrecision;
+  bool OutputValid;
+  std::vector<vtkSmartPointer<vtkBezierSurfaceSource> > Patches;
+  std::vector<vtkMTimeType> AssembledPatchTimes;
+  vtkSmartPointer<vtkPoints> PatchControlPoints;
+  vtkSmartPointer<vtkPoints> Points;
+  vtkSmartPointer<vtkDataArray> Normals;
+  vtkSmartPointer<vtkCellArray> Topology;
+};
+
+#endif
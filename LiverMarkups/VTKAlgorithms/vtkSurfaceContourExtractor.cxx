@@ -0,0 +1,396 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (The Intervention Centre,
+  Oslo University Hospital) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#include "vtkSurfaceContourExtractor.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkDataArray.h>
+#include <vtkInformationVector.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSMPTools.h>
+
+// STD includes
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <unordered_map>
+#include <utility>
+
+//------------------------------------------------------------------------------
+namespace
+{
+
+//------------------------------------------------------------------------------
+struct EdgeHash
+{
+  size_t operator()(const std::pair<vtkIdType, vtkIdType> &edge) const
+  {
+    return std::hash<vtkIdType>()(edge.first) ^ (std::hash<vtkIdType>()(edge.second) * 0x9e3779b97f4a7c15ULL);
+  }
+};
+
+} // end of anonymous namespace
+
+//------------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSurfaceContourExtractor);
+
+//------------------------------------------------------------------------------
+vtkSurfaceContourExtractor::vtkSurfaceContourExtractor()
+  :ContourType(Plane), ContourValue(0.0), MeshSurface(nullptr), MeshTime(0)
+{
+  this->Origin[0] = this->Origin[1] = this->Origin[2] = 0.0;
+  this->Normal[0] = 0.0;
+  this->Normal[1] = 0.0;
+  this->Normal[2] = 1.0;
+}
+
+//------------------------------------------------------------------------------
+vtkSurfaceContourExtractor::~vtkSurfaceContourExtractor() = default;
+
+//------------------------------------------------------------------------------
+void vtkSurfaceContourExtractor::PrintSelf(ostream &os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  const char *contourTypes[] = {"Plane", "Sphere", "Scalars"};
+  os << indent << "Contour Type: " << contourTypes[this->ContourType] << "\n";
+  os << indent << "Origin: (" << this->Origin[0] << ", " << this->Origin[1] << ", "
+     << this->Origin[2] << ")\n";
+  os << indent << "Normal: (" << this->Normal[0] << ", " << this->Normal[1] << ", "
+     << this->Normal[2] << ")\n";
+  os << indent << "Contour Value: " << this->ContourValue << "\n";
+}
+
+//------------------------------------------------------------------------------
+void vtkSurfaceContourExtractor::SetContourScalars(vtkDataArray *scalars)
+{
+  if (scalars == this->ContourScalars)
+    {
+    return;
+    }
+
+  this->ContourScalars = scalars;
+  this->Modified();
+}
+
+//------------------------------------------------------------------------------
+vtkDataArray* vtkSurfaceContourExtractor::GetContourScalars() const
+{
+  return this->ContourScalars;
+}
+
+//------------------------------------------------------------------------------
+vtkMTimeType vtkSurfaceContourExtractor::GetMTime()
+{
+  vtkMTimeType mTime = this->Superclass::GetMTime();
+  if (this->ContourScalars)
+    {
+    mTime = std::max(mTime, this->ContourScalars->GetMTime());
+    }
+
+  return mTime;
+}
+
+//------------------------------------------------------------------------------
+void vtkSurfaceContourExtractor::UpdateMesh(vtkPolyData *input)
+{
+  // Only the geometry matters (new point data arrays do not invalidate it)
+  vtkMTimeType meshTime = input->GetPoints() ? input->GetPoints()->GetMTime() : 0;
+  meshTime = std::max(meshTime, input->GetPolys()->GetMTime());
+  if (input == this->MeshSurface && meshTime == this->MeshTime)
+    {
+    return;
+    }
+
+  vtkIdType numberOfPoints = input->GetNumberOfPoints();
+  this->Points.resize(3*numberOfPoints);
+  for (vtkIdType pointId=0; pointId<numberOfPoints; pointId++)
+    {
+    input->GetPoint(pointId, &this->Points[3*pointId]);
+    }
+
+  this->Triangles.clear();
+  vtkCellArray *polys = input->GetPolys();
+  vtkIdType numberOfCellPoints;
+  const vtkIdType *cellPointIds;
+  for (polys->InitTraversal(); polys->GetNextCell(numberOfCellPoints, cellPointIds);)
+    {
+    for (vtkIdType i=1; i+1<numberOfCellPoints; i++)
+      {
+      this->Triangles.push_back(cellPointIds[0]);
+      this->Triangles.push_back(cellPointIds[i]);
+      this->Triangles.push_back(cellPointIds[i+1]);
+      }
+    }
+
+  this->MeshSurface = input;
+  this->MeshTime = meshTime;
+}
+
+//------------------------------------------------------------------------------
+int vtkSurfaceContourExtractor::RequestData(vtkInformation *vtkNotUsed(request),
+                                            vtkInformationVector **inputVector,
+                                            vtkInformationVector *outputVector)
+{
+  vtkPolyData *input = vtkPolyData::GetData(inputVector[0]);
+  vtkPolyData *output = vtkPolyData::GetData(outputVector);
+  if (!input || !output)
+    {
+    return 1;
+    }
+
+  this->UpdateMesh(input);
+
+  vtkIdType numberOfPoints = static_cast<vtkIdType>(this->Points.size()/3);
+  vtkIdType numberOfTriangles = static_cast<vtkIdType>(this->Triangles.size()/3);
+  if (numberOfPoints == 0 || numberOfTriangles == 0)
+    {
+    return 1;
+    }
+
+  // Signed value of every vertex, the contour being the zero set. The loops
+  // only read contiguous coordinates, so they vectorize.
+  std::vector<double> values(numberOfPoints);
+  const double *points = this->Points.data();
+  double *signedValues = values.data();
+  switch (this->ContourType)
+    {
+    case Plane:
+      {
+      double normal[3] = {this->Normal[0], this->Normal[1], this->Normal[2]};
+      if (vtkMath::Normalize(normal) == 0.0)
+        {
+        vtkErrorMacro("Invalid plane normal.");
+        return 1;
+        }
+      const double *origin = this->Origin;
+      vtkSMPTools::For(0, numberOfPoints, [&](vtkIdType begin, vtkIdType end)
+        {
+        for (vtkIdType pointId=begin; pointId<end; pointId++)
+          {
+          const double *point = points + 3*pointId;
+          signedValues[pointId] = normal[0]*(point[0]-origin[0]) +
+                                  normal[1]*(point[1]-origin[1]) +
+                                  normal[2]*(point[2]-origin[2]);
+          }
+        });
+      }
+      break;
+    case Sphere:
+      {
+      const double *center = this->Origin;
+      double radius = this->ContourValue;
+      vtkSMPTools::For(0, numberOfPoints, [&](vtkIdType begin, vtkIdType end)
+        {
+        for (vtkIdType pointId=begin; pointId<end; pointId++)
+          {
+          const double *point = points + 3*pointId;
+          double dx = point[0]-center[0], dy = point[1]-center[1], dz = point[2]-center[2];
+          signedValues[pointId] = std::sqrt(dx*dx + dy*dy + dz*dz) - radius;
+          }
+        });
+      }
+      break;
+    case Scalars:
+      {
+      vtkDataArray *scalars = this->ContourScalars;
+      if (!scalars || scalars->GetNumberOfTuples() != numberOfPoints)
+        {
+        vtkErrorMacro("Invalid contour scalars.");
+        return 1;
+        }
+      double value = this->ContourValue;
+      vtkSMPTools::For(0, numberOfPoints, [&](vtkIdType begin, vtkIdType end)
+        {
+        for (vtkIdType pointId=begin; pointId<end; pointId++)
+          {
+          signedValues[pointId] = scalars->GetComponent(pointId, 0) - value;
+          }
+        });
+      }
+      break;
+    default:
+      break;
+    }
+
+  // Case of every triangle (bit i set if vertex i is inside, i.e. >= 0); only
+  // the triangles with mixed cases cross the contour
+  std::vector<unsigned char> cases(numberOfTriangles);
+  const vtkIdType *triangles = this->Triangles.data();
+  vtkSMPTools::For(0, numberOfTriangles, [&](vtkIdType begin, vtkIdType end)
+    {
+    for (vtkIdType triangleId=begin; triangleId<end; triangleId++)
+      {
+      const vtkIdType *ids = triangles + 3*triangleId;
+      cases[triangleId] = static_cast<unsigned char>((signedValues[ids[0]] >= 0.0 ? 1 : 0) |
+                                                     (signedValues[ids[1]] >= 0.0 ? 2 : 0) |
+                                                     (signedValues[ids[2]] >= 0.0 ? 4 : 0));
+      }
+    });
+
+  // One contour point per crossed edge, shared by the (up to two) segments
+  // of the triangles around that edge
+  vtkNew<vtkPoints> contourPoints;
+  std::unordered_map<std::pair<vtkIdType, vtkIdType>, vtkIdType, EdgeHash> edgePoints;
+  std::vector<std::array<vtkIdType, 2>> neighbors;
+  vtkNew<vtkCellArray> lines;
+
+  auto edgePoint = [&](vtkIdType a, vtkIdType b)
+    {
+    auto edge = std::make_pair(std::min(a, b), std::max(a, b));
+    auto inserted = edgePoints.emplace(edge, static_cast<vtkIdType>(neighbors.size()));
+    if (inserted.second)
+      {
+      double valueA = signedValues[edge.first];
+      double valueB = signedValues[edge.second];
+      double t = valueA / (valueA - valueB);
+      const double *pointA = points + 3*edge.first;
+      const double *pointB = points + 3*edge.second;
+      contourPoints->InsertNextPoint(pointA[0] + t*(pointB[0]-pointA[0]),
+                                     pointA[1] + t*(pointB[1]-pointA[1]),
+                                     pointA[2] + t*(pointB[2]-pointA[2]));
+      neighbors.push_back({{-1, -1}});
+      }
+    return inserted.first->second;
+    };
+
+  auto link = [&](vtkIdType from, vtkIdType to)
+    {
+    auto &slots = neighbors[from];
+    vtkIdType &slot = slots[0] < 0 ? slots[0] : slots[1];
+    slot = to;
+    };
+
+  for (vtkIdType triangleId=0; triangleId<numberOfTriangles; triangleId++)
+    {
+    unsigned char triangleCase = cases[triangleId];
+    if (triangleCase == 0 || triangleCase == 7)
+      {
+      continue;
+      }
+
+    const vtkIdType *ids = triangles + 3*triangleId;
+    vtkIdType segment[2];
+    int numberOfSegmentPoints = 0;
+    for (int i=0; i<3; i++)
+      {
+      int j = (i+1) % 3;
+      if (((triangleCase >> i) & 1) != ((triangleCase >> j) & 1))
+        {
+        segment[numberOfSegmentPoints++] = edgePoint(ids[i], ids[j]);
+        }
+      }
+    if (segment[0] == segment[1])
+      {
+      continue;
+      }
+
+    // Non-manifold crossings are kept as separate segments
+    if (neighbors[segment[0]][1] >= 0 || neighbors[segment[1]][1] >= 0)
+      {
+      lines->InsertNextCell(2, segment);
+      continue;
+      }
+    link(segment[0], segment[1]);
+    link(segment[1], segment[0]);
+    }
+
+  // Stitch the segments: open polylines from their ends first, then the
+  // remaining closed loops
+  vtkIdType numberOfContourPoints = static_cast<vtkIdType>(neighbors.size());
+  std::vector<bool> visited(numberOfContourPoints, false);
+  std::vector<vtkIdType> polyline;
+  auto walk = [&](vtkIdType start)
+    {
+    polyline.clear();
+    vtkIdType previous = -1;
+    vtkIdType current = start;
+    while (current >= 0 && !visited[current])
+      {
+      visited[current] = true;
+      polyline.push_back(current);
+
+      vtkIdType next = -1;
+      for (vtkIdType neighbor : neighbors[current])
+        {
+        if (neighbor >= 0 && neighbor != previous && !visited[neighbor])
+          {
+          next = neighbor;
+          break;
+          }
+        if (neighbor == start && neighbor != previous && polyline.size() > 2)
+          {
+          polyline.push_back(start);
+          }
+        }
+      previous = current;
+      current = next;
+      }
+
+    if (polyline.size() > 1)
+      {
+      lines->InsertNextCell(static_cast<vtkIdType>(polyline.size()), polyline.data());
+      }
+    };
+
+  for (vtkIdType pointId=0; pointId<numberOfContourPoints; pointId++)
+    {
+    if (!visited[pointId] && (neighbors[pointId][0] < 0 || neighbors[pointId][1] < 0))
+      {
+      walk(pointId);
+      }
+    }
+  for (vtkIdType pointId=0; pointId<numberOfContourPoints; pointId++)
+    {
+    if (!visited[pointId])
+      {
+      walk(pointId);
+      }
+    }
+
+  output->SetPoints(contourPoints);
+  output->SetLines(lines);
+
+  return 1;
+}
@@ -0,0 +1,174 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (The Intervention Centre,
+  Oslo University Hospital) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#ifndef __vtksurfacecontourextractor_h_
+#define __vtksurfacecontourextractor_h_
+
+#include "vtkSlicerLiverMarkupsModuleVTKAlgorithmsExport.h"
+
+// VTK includes
+#include <vtkDataArray.h>
+#include <vtkPolyDataAlgorithm.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <vector>
+
+//------------------------------------------------------------------------------
+/**
+ * \ingroup ResectionPlanning
+ *
+ * \brief Polylines of the intersection of a surface mesh with a plane, a sphere
+ * or an isovalue of a scalar field over its vertices (e.g. a geodesic
+ * distance field).
+ *
+ * A signed value is computed for every vertex (in parallel), then every
+ * triangle crossing the contour contributes one segment between two of its
+ * edges. The segments are stitched into polylines through the edges they
+ * share; closed contours repeat their first point at the end.
+ *
+ * The triangles and vertex coordinates of the input are cached until its
+ * points or polygons change, and the output is only recomputed when the
+ * contour parameters change (pipeline modification time).
+ */
+class VTK_SLICER_LIVERMARKUPS_MODULE_VTKALGORITHMS_EXPORT vtkSurfaceContourExtractor : public vtkPolyDataAlgorithm
+{
+ public:
+
+  /**
+   * Instantiation of object.
+   *
+   *
+   * @return pointer to vtkSurfaceContourExtractor newly created.
+   */
+  static vtkSurfaceContourExtractor *New();
+
+  vtkTypeMacro(vtkSurfaceContourExtractor, vtkPolyDataAlgorithm);
+
+  /**
+   * Print the properties of the object.
+   *
+   * @param os ouptut stream to print the properties to.
+   * @param indent indentation value.
+   */
+  void PrintSelf(ostream &os, vtkIndent indent) override;
+
+  enum ContourTypes
+  {
+    Plane = 0,
+    Sphere,
+    Scalars
+  };
+
+  /**
+   * Type of contour: plane (Origin and Normal), sphere (Origin as center and
+   * ContourValue as radius) or isovalue ContourValue of the ContourScalars.
+   */
+  vtkSetClampMacro(ContourType, int, Plane, Scalars);
+  vtkGetMacro(ContourType, int);
+  void SetContourTypeToPlane() {this->SetContourType(Plane);}
+  void SetContourTypeToSphere() {this->SetContourType(Sphere);}
+  void SetContourTypeToScalars() {this->SetContourType(Scalars);}
+
+  /**
+   * Origin of the plane or center of the sphere.
+   */
+  vtkSetVector3Macro(Origin, double);
+  vtkGetVector3Macro(Origin, double);
+
+  /**
+   * Normal of the plane (it does not need to be normalized).
+   */
+  vtkSetVector3Macro(Normal, double);
+  vtkGetVector3Macro(Normal, double);
+
+  /**
+   * Radius of the sphere or isovalue of the point scalars.
+   */
+  vtkSetMacro(ContourValue, double);
+  vtkGetMacro(ContourValue, double);
+
+  /**
+   * Scalar field contoured in Scalars mode, one value (first component) per
+   * vertex of the input. It does not need to be part of the input point data.
+   *
+   * @param scalars pointer to the scalar field.
+   */
+  void SetContourScalars(vtkDataArray *scalars);
+  vtkDataArray* GetContourScalars() const;
+
+  /**
+   * Modification time including the one of the scalar field.
+   */
+  vtkMTimeType GetMTime() override;
+
+ protected:
+  vtkSurfaceContourExtractor();
+  ~vtkSurfaceContourExtractor() override;
+
+  int RequestData(vtkInformation *request,
+                  vtkInformationVector **inputVector,
+                  vtkInformationVector *outputVector) override;
+
+  /**
+   * Cache the triangles and the vertex coordinates of the input if its
+   * geometry changed since they were last cached.
+   *
+   * @param input surface to cache.
+   */
+  void UpdateMesh(vtkPolyData *input);
+
+ private:
+  int ContourType;
+  double Origin[3];
+  double Normal[3];
+  double ContourValue;
+  vtkSmartPointer<vtkDataArray> ContourScalars;
+
+  vtkPolyData *MeshSurface;
+  vtkMTimeType MeshTime;
+  std::vector<double> Points;
+  std::vector<vtkIdType> Triangles;
+
+ private:
+  vtkSurfaceContourExtractor(const vtkSurfaceContourExtractor&) = delete;
+  void operator=(const vtkSurfaceContourExtractor&) = delete;
+};
+
+#endif // __vtksurfacecontourextractor_h_
@@ -0,0 +1,315 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (The Intervention Centre,
+  Oslo University Hospital) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#include "vtkSurfaceGeodesicDistance.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkFloatArray.h>
+#include <vtkMath.h>
+#include <vtkObjectFactory.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkStaticPointLocator.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <utility>
+
+//------------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSurfaceGeodesicDistance);
+
+//------------------------------------------------------------------------------
+vtkSurfaceGeodesicDistance::vtkSurfaceGeodesicDistance()
+  :MeshTime(0), MeshSurface(nullptr)
+{
+}
+
+//------------------------------------------------------------------------------
+vtkSurfaceGeodesicDistance::~vtkSurfaceGeodesicDistance() = default;
+
+//------------------------------------------------------------------------------
+void vtkSurfaceGeodesicDistance::PrintSelf(ostream &os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "Number Of Vertices: " << this->Points.size()/3 << "\n";
+  os << indent << "Number Of Triangles: " << this->Triangles.size()/3 << "\n";
+}
+
+//------------------------------------------------------------------------------
+void vtkSurfaceGeodesicDistance::SetSurface(vtkPolyData *surface)
+{
+  if (surface == this->Surface)
+    {
+    return;
+    }
+
+  this->Surface = surface;
+  this->Modified();
+}
+
+//------------------------------------------------------------------------------
+vtkPolyData* vtkSurfaceGeodesicDistance::GetSurface() const
+{
+  return this->Surface;
+}
+
+//------------------------------------------------------------------------------
+bool vtkSurfaceGeodesicDistance::UpdateMesh()
+{
+  vtkPolyData *surface = this->Surface;
+  if (!surface || !surface->GetPoints() || !surface->GetPolys() ||
+      surface->GetPolys()->GetNumberOfCells() == 0)
+    {
+    return false;
+    }
+
+  // Only the geometry matters (new point data arrays do not invalidate it)
+  vtkMTimeType meshTime = std::max(surface->GetPoints()->GetMTime(), surface->GetPolys()->GetMTime());
+  if (surface == this->MeshSurface && meshTime == this->MeshTime)
+    {
+    return true;
+    }
+
+  vtkIdType numberOfPoints = surface->GetNumberOfPoints();
+  this->Points.resize(3*numberOfPoints);
+  for (vtkIdType pointId=0; pointId<numberOfPoints; pointId++)
+    {
+    surface->GetPoint(pointId, &this->Points[3*pointId]);
+    }
+
+  this->Triangles.clear();
+  vtkCellArray *polys = surface->GetPolys();
+  vtkIdType numberOfCellPoints;
+  const vtkIdType *cellPointIds;
+  for (polys->InitTraversal(); polys->GetNextCell(numberOfCellPoints, cellPointIds);)
+    {
+    for (vtkIdType i=1; i+1<numberOfCellPoints; i++)
+      {
+      this->Triangles.push_back(cellPointIds[0]);
+      this->Triangles.push_back(cellPointIds[i]);
+      this->Triangles.push_back(cellPointIds[i+1]);
+      }
+    }
+
+  // Triangles around each vertex (compressed rows)
+  this->VertexTriangleOffsets.assign(numberOfPoints+1, 0);
+  for (vtkIdType pointId : this->Triangles)
+    {
+    this->VertexTriangleOffsets[pointId+1]++;
+    }
+  for (vtkIdType pointId=0; pointId<numberOfPoints; pointId++)
+    {
+    this->VertexTriangleOffsets[pointId+1] += this->VertexTriangleOffsets[pointId];
+    }
+  this->VertexTriangles.resize(this->Triangles.size());
+  std::vector<vtkIdType> fill(this->VertexTriangleOffsets.begin(), this->VertexTriangleOffsets.end()-1);
+  for (size_t index=0; index<this->Triangles.size(); index++)
+    {
+    this->VertexTriangles[fill[this->Triangles[index]]++] = static_cast<vtkIdType>(index/3);
+    }
+
+  this->Locator = vtkSmartPointer<vtkStaticPointLocator>::New();
+  this->Locator->SetDataSet(surface);
+  this->Locator->BuildLocator();
+
+  this->MeshSurface = surface;
+  this->MeshTime = meshTime;
+  return true;
+}
+
+//------------------------------------------------------------------------------
+double vtkSurfaceGeodesicDistance::UpdateFromTriangle(vtkIdType a, double distanceA,
+                                                      vtkIdType b, double distanceB,
+                                                      vtkIdType c) const
+{
+  // Unfolding of the triangle in the plane: a at the origin, b on the x
+  // axis and c above it. The virtual source s lies below the x axis at
+  // distances distanceA and distanceB from a and b.
+  const double *pointA = &this->Points[3*a];
+  const double *pointB = &this->Points[3*b];
+  const double *pointC = &this->Points[3*c];
+
+  double axis[3], edge[3];
+  vtkMath::Subtract(pointB, pointA, axis);
+  vtkMath::Subtract(pointC, pointA, edge);
+  double length = vtkMath::Normalize(axis);
+  if (length == 0.0)
+    {
+    return VTK_DOUBLE_MAX;
+    }
+  double cx = vtkMath::Dot(edge, axis);
+  double cy = std::sqrt(std::max(0.0, vtkMath::Dot(edge, edge) - cx*cx));
+
+  double sx = (distanceA*distanceA - distanceB*distanceB + length*length) / (2.0*length);
+  double sy2 = distanceA*distanceA - sx*sx;
+  if (sy2 < 0.0)
+    {
+    return VTK_DOUBLE_MAX;
+    }
+  double sy = -std::sqrt(sy2);
+
+  // The straight path from s to c must go through the edge ab
+  if (cy - sy <= 0.0)
+    {
+    return VTK_DOUBLE_MAX;
+    }
+  double crossing = sx + (cx - sx)*(-sy)/(cy - sy);
+  if (crossing < 0.0 || crossing > length)
+    {
+    return VTK_DOUBLE_MAX;
+    }
+
+  return std::sqrt((cx - sx)*(cx - sx) + (cy - sy)*(cy - sy));
+}
+
+//------------------------------------------------------------------------------
+bool vtkSurfaceGeodesicDistance::ComputeDistances(const double point[3], vtkFloatArray *distances)
+{
+  if (!distances || !this->UpdateMesh())
+    {
+    return false;
+    }
+
+  vtkIdType numberOfPoints = static_cast<vtkIdType>(this->Points.size()/3);
+  std::vector<double> distance(numberOfPoints, VTK_DOUBLE_MAX);
+  std::vector<char> alive(numberOfPoints, 0);
+
+  typedef std::pair<double, vtkIdType> Trial;
+  std::priority_queue<Trial, std::vector<Trial>, std::greater<Trial> > trials;
+
+  // Initialization around the closest vertex to the source
+  vtkIdType closestPointId = this->Locator->FindClosestPoint(point);
+  auto initialize = [&](vtkIdType pointId)
+    {
+    distance[pointId] = std::sqrt(vtkMath::Distance2BetweenPoints(point, &this->Points[3*pointId]));
+    trials.push(Trial(distance[pointId], pointId));
+    };
+  initialize(closestPointId);
+  for (vtkIdType t=this->VertexTriangleOffsets[closestPointId];
+       t<this->VertexTriangleOffsets[closestPointId+1]; t++)
+    {
+    const vtkIdType *triangle = &this->Triangles[3*this->VertexTriangles[t]];
+    for (int k=0; k<3; k++)
+      {
+      if (distance[triangle[k]] == VTK_DOUBLE_MAX)
+        {
+        initialize(triangle[k]);
+        }
+      }
+    }
+
+  // Fast marching: the closest trial vertex is frozen and its neighbors are
+  // updated from the edges and triangles with frozen vertices
+  while (!trials.empty())
+    {
+    Trial trial = trials.top();
+    trials.pop();
+    vtkIdType pointId = trial.second;
+    if (alive[pointId] || trial.first > distance[pointId])
+      {
+      continue;
+      }
+    alive[pointId] = 1;
+
+    for (vtkIdType t=this->VertexTriangleOffsets[pointId]; t<this->VertexTriangleOffsets[pointId+1]; t++)
+      {
+      const vtkIdType *triangle = &this->Triangles[3*this->VertexTriangles[t]];
+      for (int k=0; k<3; k++)
+        {
+        vtkIdType target = triangle[k];
+        if (target == pointId || alive[target])
+          {
+          continue;
+          }
+        vtkIdType other = triangle[0] != pointId && triangle[0] != target ? triangle[0] :
+          (triangle[1] != pointId && triangle[1] != target ? triangle[1] : triangle[2]);
+
+        double candidate = distance[pointId] +
+          std::sqrt(vtkMath::Distance2BetweenPoints(&this->Points[3*pointId], &this->Points[3*target]));
+        if (alive[other])
+          {
+          candidate = std::min(candidate,
+            this->UpdateFromTriangle(pointId, distance[pointId], other, distance[other], target));
+          }
+
+        if (candidate < distance[target])
+          {
+          distance[target] = candidate;
+          trials.push(Trial(candidate, target));
+          }
+        }
+      }
+    }
+
+  distances->SetNumberOfComponents(1);
+  distances->SetNumberOfTuples(numberOfPoints);
+  for (vtkIdType pointId=0; pointId<numberOfPoints; pointId++)
+    {
+    // VTK_DOUBLE_MAX (vertices the front does not reach) is out of the range
+    // of float
+    double value = distance[pointId];
+    distances->SetValue(pointId, value < VTK_FLOAT_MAX ? static_cast<float>(value) : VTK_FLOAT_MAX);
+    }
+  distances->Modified();
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+double vtkSurfaceGeodesicDistance::GetDistance(const double point[3], vtkFloatArray *distances)
+{
+  if (!distances || !this->UpdateMesh() ||
+      distances->GetNumberOfTuples() != static_cast<vtkIdType>(this->Points.size()/3))
+    {
+    return 0.0;
+    }
+
+  vtkIdType closestPointId = this->Locator->FindClosestPoint(point);
+  if (distances->GetValue(closestPointId) == VTK_FLOAT_MAX)
+    {
+    return VTK_DOUBLE_MAX;
+    }
+  return distances->GetValue(closestPointId) +
+    std::sqrt(vtkMath::Distance2BetweenPoints(point, &this->Points[3*closestPointId]));
+}
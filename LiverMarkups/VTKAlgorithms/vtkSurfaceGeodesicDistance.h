@@ -0,0 +1,164 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (The Intervention Centre,
+  Oslo University Hospital) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#ifndef __vtksurfacegeodesicdistance_h_
+#define __vtksurfacegeodesicdistance_h_
+
+#include "vtkSlicerLiverMarkupsModuleVTKAlgorithmsExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <vector>
+
+//------------------------------------------------------------------------------
+class vtkFloatArray;
+class vtkPolyData;
+class vtkStaticPointLocator;
+
+//------------------------------------------------------------------------------
+/**
+ * \ingroup ResectionPlanning
+ *
+ * \brief Geodesic distance field over a surface mesh, computed with the fast
+ * marching method on the triangles of the mesh.
+ *
+ * The mesh structure (triangles, vertex to triangle adjacency and point
+ * locator) is built once and kept until the points or the polygons of the
+ * surface change, so a new source point only costs one fast marching sweep,
+ * \f$O(n\log n)\f$ in the number of vertices.
+ */
+class VTK_SLICER_LIVERMARKUPS_MODULE_VTKALGORITHMS_EXPORT vtkSurfaceGeodesicDistance : public vtkObject
+{
+ public:
+
+  /**
+   * Instantiation of object.
+   *
+   *
+   * @return pointer to vtkSurfaceGeodesicDistance newly created.
+   */
+  static vtkSurfaceGeodesicDistance *New();
+
+  vtkTypeMacro(vtkSurfaceGeodesicDistance, vtkObject);
+
+  /**
+   * Print the properties of the object.
+   *
+   * @param os ouptut stream to print the properties to.
+   * @param indent indentation value.
+   */
+  void PrintSelf(ostream &os, vtkIndent indent) override;
+
+  /**
+   * Set the surface the distances are computed on. Polygons are split into
+   * triangles (fan).
+   *
+   * @param surface pointer to the surface.
+   */
+  void SetSurface(vtkPolyData *surface);
+
+  /**
+   * Get the surface the distances are computed on.
+   *
+   * @return pointer to the surface.
+   */
+  vtkPolyData* GetSurface() const;
+
+  /**
+   * Geodesic distance from a source point to every vertex of the surface.
+   * The vertices around the closest vertex to the source are initialized
+   * with their Euclidean distance to it. The vertices the front does not
+   * reach (e.g. on other connected components) get VTK_FLOAT_MAX.
+   *
+   * @param point source point.
+   * @param distances output distances (one per vertex of the surface).
+   *
+   * @return false if there is no valid surface.
+   */
+  bool ComputeDistances(const double point[3], vtkFloatArray *distances);
+
+  /**
+   * Geodesic distance of an arbitrary point according to a distance field
+   * (distance of its closest vertex plus the distance to that vertex).
+   *
+   * @param point point to evaluate.
+   * @param distances distance field computed by ComputeDistances.
+   *
+   * @return geodesic distance of the point, or VTK_DOUBLE_MAX if its
+   * closest vertex is not reached.
+   */
+  double GetDistance(const double point[3], vtkFloatArray *distances);
+
+ protected:
+  vtkSurfaceGeodesicDistance();
+  ~vtkSurfaceGeodesicDistance() override;
+
+  /**
+   * Build the mesh structure if the surface changed since it was last built.
+   *
+   * @return false if there is no valid surface.
+   */
+  bool UpdateMesh();
+
+  /**
+   * Distance at vertex c from a planar front through the vertices a and b,
+   * or VTK_DOUBLE_MAX if the front does not reach c through the edge ab.
+   */
+  double UpdateFromTriangle(vtkIdType a, double distanceA, vtkIdType b, double distanceB, vtkIdType c) const;
+
+ private:
+  vtkSmartPointer<vtkPolyData> Surface;
+  vtkSmartPointer<vtkStaticPointLocator> Locator;
+  vtkMTimeType MeshTime;
+  vtkPolyData *MeshSurface;
+
+  std::vector<double> Points;
+  std::vector<vtkIdType> Triangles;
+  std::vector<vtkIdType> VertexTriangleOffsets;
+  std::vector<vtkIdType> VertexTriangles;
+
+ private:
+  vtkSurfaceGeodesicDistance(const vtkSurfaceGeodesicDistance&) = delete;
+  void operator=(const vtkSurfaceGeodesicDistance&) = delete;
+};
+
+#endif // __vtksurfacegeodesicdistance_h_
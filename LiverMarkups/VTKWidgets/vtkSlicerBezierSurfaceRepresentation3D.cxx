@@ -44,6 +44,7 @@
 
 // MRML includes
 #include <qMRMLThreeDWidget.h>
+#include <vtkMRMLInteractionEventData.h>
 #include <vtkMRMLDisplayableManagerGroup.h>
 #include <vtkMRMLModelDisplayableManager.h>
 
@@ -55,39 +56,53 @@
 #include <vtkActor.h>
 #include <vtkCollection.h>
 #include <vtkNew.h>
-#include <vtkPlaneSource.h>
 #include <vtkPolyDataMapper.h>
-#include <vtkPolyDataNormals.h>
 #include <vtkPolyLine.h>
 #include <vtkProperty.h>
+#include <vtkRenderer.h>
+
+// STD includes
+#include <algorithm>
+
+//------------------------------------------------------------------------------
+// Intersections are refined on the exact surface, so the tolerance only
+// trades subdivision against Newton steps.
+const double vtkSlicerBezierSurfaceRepresentation3D::SurfaceIntersectionTolerance = 1e-3;
 
 //------------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerBezierSurfaceRepresentation3D);
 
 //------------------------------------------------------------------------------
 vtkSlicerBezierSurfaceRepresentation3D::vtkSlicerBezierSurfaceRepresentation3D()
-  :Superclass()
+  :Superclass(), Interacting(false)
 {
   this->BezierSurfaceSource= vtkSmartPointer<vtkBezierSurfaceSource>::New();
-
-  // Set the initial position of the bezier surface
-  auto planeSource = vtkSmartPointer<vtkPlaneSource>::New();
-  planeSource->SetResolution(3,3);
-  planeSource->Update();
-
-  this->BezierSurfaceNormals = vtkSmartPointer<vtkPolyDataNormals>::New();
-  this->BezierSurfaceNormals->SetInputConnection(this->BezierSurfaceSource->GetOutputPort());
-
+  this->BezierSurfaceSource->ComputeNormalsOn();
+  this->BezierSurfaceSource->SetOutputPointsPrecision(vtkAlgorithm::SINGLE_PRECISION);
+  this->BezierSurfaceSource->SetResolution(vtkBezierSurfaceSource::DisplayResolution,
+                                           vtkBezierSurfaceSource::DisplayResolution);
+
+  // Coarse tessellation used while dragging
+  this->InteractionBezierSurfaceSource= vtkSmartPointer<vtkBezierSurfaceSource>::New();
+  this->InteractionBezierSurfaceSource->ComputeNormalsOn();
+  this->InteractionBezierSurfaceSource->SetOutputPointsPrecision(vtkAlgorithm::SINGLE_PRECISION);
+  this->InteractionBezierSurfaceSource->SetResolution(vtkBezierSurfaceSource::InteractionResolution,
+                                                      vtkBezierSurfaceSource::InteractionResolution);
+
+  // NOTE: Control points are kept in double precision, only the
+  // tessellation is generated in single precision for rendering. They are
+  // resized to the control point grid of the node in UpdateBezierSurface.
   this->BezierSurfaceControlPoints = vtkSmartPointer<vtkPoints>::New();
-  this->BezierSurfaceControlPoints->SetNumberOfPoints(16);
-  this->BezierSurfaceControlPoints->DeepCopy(planeSource->GetOutput()->GetPoints());;
+  this->BezierSurfaceControlPoints->SetDataTypeToDouble();
 
   this->BezierSurfaceMapper = vtkSmartPointer<vtkPolyDataMapper>::New();
-  this->BezierSurfaceMapper->SetInputConnection(this->BezierSurfaceNormals->GetOutputPort());
+  this->BezierSurfaceMapper->SetInputConnection(this->BezierSurfaceSource->GetOutputPort());
   this->BezierSurfaceActor = vtkSmartPointer<vtkActor>::New();
   this->BezierSurfaceActor->SetMapper(this->BezierSurfaceMapper);
 
   this->ControlPolygonPolyData = vtkSmartPointer<vtkPolyData>::New();
+  this->ControlPolygonGridSize[0] = 0;
+  this->ControlPolygonGridSize[1] = 0;
   this->ControlPolygonTubeFilter = vtkSmartPointer<vtkTubeFilter>::New();
   this->ControlPolygonTubeFilter->SetInputData(this->ControlPolygonPolyData.GetPointer());
   this->ControlPolygonTubeFilter->SetRadius(1);
@@ -98,6 +113,12 @@ vtkSlicerBezierSurfaceRepresentation3D::vtkSlicerBezierSurfaceRepresentation3D()
 
   this->ControlPolygonActor = vtkSmartPointer<vtkActor>::New();
   this->ControlPolygonActor->SetMapper(this->ControlPolygonMapper);
+
+  this->PickedParametricCoordinates[0] = 0.0;
+  this->PickedParametricCoordinates[1] = 0.0;
+  this->PickedPosition[0] = 0.0;
+  this->PickedPosition[1] = 0.0;
+  this->PickedPosition[2] = 0.0;
 }
 
 //------------------------------------------------------------------------------
@@ -235,28 +256,89 @@ double *vtkSlicerBezierSurfaceRepresentation3D::GetBounds()
   return this->Bounds;
 }
 
+//-----------------------------------------------------------------------------
+void vtkSlicerBezierSurfaceRepresentation3D::CanInteract(
+  vtkMRMLInteractionEventData* interactionEventData,
+  int &foundComponentType, int &foundComponentIndex, double &closestDistance2)
+{
+  foundComponentType = vtkMRMLMarkupsDisplayNode::ComponentNone;
+  vtkMRMLMarkupsNode* markupsNode = this->GetMarkupsNode();
+  if ( !markupsNode || markupsNode->GetLocked() || markupsNode->GetNumberOfDefinedControlPoints(true) < 1
+    || !this->GetVisibility() || !interactionEventData )
+    {
+    return;
+    }
+  Superclass::CanInteract(interactionEventData, foundComponentType, foundComponentIndex, closestDistance2);
+  if (foundComponentType != vtkMRMLMarkupsDisplayNode::ComponentNone)
+    {
+    // if mouse is near a control point then select that (ignore the surface)
+    return;
+    }
 
-//----------------------------------------------------------------------
-// void vtkSlicerBezierSurfaceRepresentation3D::CanInteract(
-//   vtkMRMLInteractionEventData* interactionEventData,
-//   int &foundComponentType, int &foundComponentIndex, double &closestDistance2)
-// {
-//   foundComponentType = vtkMRMLMarkupsDisplayNode::ComponentNone;
-//   vtkMRMLMarkupsNode* markupsNode = this->GetMarkupsNode();
-//   if ( !markupsNode || markupsNode->GetLocked() || markupsNode->GetNumberOfDefinedControlPoints(true) < 1
-//     || !interactionEventData )
-//     {
-//     return;
-//     }
-//   Superclass::CanInteract(interactionEventData, foundComponentType, foundComponentIndex, closestDistance2);
-//   if (foundComponentType != vtkMRMLMarkupsDisplayNode::ComponentNone)
-//     {
-//     // if mouse is near a control point then select that (ignore the line)
-//     return;
-//     }
+  this->CanInteractWithBezierSurface(interactionEventData, foundComponentType, foundComponentIndex, closestDistance2);
+}
 
-//   this->CanInteractWithBezierSurface(interactionEventData, foundComponentType, foundComponentIndex, closestDistance2);
-// }
+//-----------------------------------------------------------------------------
+void vtkSlicerBezierSurfaceRepresentation3D::CanInteractWithBezierSurface(
+  vtkMRMLInteractionEventData* interactionEventData,
+  int &foundComponentType, int &foundComponentIndex, double &closestDistance2)
+{
+  if (!this->Renderer || !this->BezierSurfaceActor->GetVisibility() ||
+      !interactionEventData->IsDisplayPositionValid())
+    {
+    return;
+    }
+
+  // View ray between the near and far clipping planes under the pointer
+  const int* displayPosition = interactionEventData->GetDisplayPosition();
+  double rayPoints[2][3];
+  for (int r=0; r<2; r++)
+    {
+    double worldPoint[4];
+    this->Renderer->SetDisplayPoint(displayPosition[0], displayPosition[1], r);
+    this->Renderer->DisplayToWorld();
+    this->Renderer->GetWorldPoint(worldPoint);
+    if (worldPoint[3] == 0.0)
+      {
+      return;
+      }
+    for (int k=0; k<3; k++)
+      {
+      rayPoints[r][k] = worldPoint[k] / worldPoint[3];
+      }
+    }
+
+  double t;
+  if (!this->IntersectBezierSurfaceWithLine(rayPoints[0], rayPoints[1], t,
+                                            this->PickedPosition, this->PickedParametricCoordinates))
+    {
+    return;
+    }
+
+  // Display-space distance between the pointer and the picked point. The
+  // whole area of the surface is pickable, so it is never reported closer than
+  // the picking tolerance: control points and handles (of this or other
+  // markups) under the pointer take precedence over the surface behind them.
+  double pickedDisplayPosition[3];
+  this->Renderer->SetWorldPoint(this->PickedPosition[0], this->PickedPosition[1],
+                                this->PickedPosition[2], 1.0);
+  this->Renderer->WorldToDisplay();
+  this->Renderer->GetDisplayPoint(pickedDisplayPosition);
+  double dx = pickedDisplayPosition[0] - displayPosition[0];
+  double dy = pickedDisplayPosition[1] - displayPosition[1];
+  double pixelTolerance = this->PickingTolerance * this->ScreenScaleFactor;
+
+  foundComponentType = vtkMRMLMarkupsDisplayNode::ComponentLine;
+  foundComponentIndex = 0;
+  closestDistance2 = std::max(dx*dx + dy*dy, pixelTolerance*pixelTolerance);
+}
+
+//-----------------------------------------------------------------------------
+int vtkSlicerBezierSurfaceRepresentation3D::IntersectBezierSurfaceWithLine(
+  const double p1[3], const double p2[3], double &t, double x[3], double parametricCoordinates[2])
+{
+  return this->BezierSurfaceSource->IntersectWithLine(p1, p2, SurfaceIntersectionTolerance, t, x, parametricCoordinates);
+}
 
 //-----------------------------------------------------------------------------
 void vtkSlicerBezierSurfaceRepresentation3D::PrintSelf(ostream& os, vtkIndent indent)
@@ -273,6 +355,10 @@ void vtkSlicerBezierSurfaceRepresentation3D::PrintSelf(ostream& os, vtkIndent in
     os << indent << "BezierSurface Visibility: (none)\n";
     }
 
+  os << indent << "Interacting: " << this->Interacting << "\n";
+  os << indent << "Picked Parametric Coordinates: " << this->PickedParametricCoordinates[0]
+     << ", " << this->PickedParametricCoordinates[1] << "\n";
+
   if (this->ControlPolygonActor)
     {
     os << indent << "ControlPolygon Visibility: " << this->ControlPolygonActor->GetVisibility() << "\n";
@@ -286,7 +372,7 @@ void vtkSlicerBezierSurfaceRepresentation3D::PrintSelf(ostream& os, vtkIndent in
 //-----------------------------------------------------------------------------
 // void vtkSlicerBezierSurfaceRepresentation3D::UpdateInteractionPipeline()
 // {
-//   if (!this->MarkupsNode || this->MarkupsNode->GetNumberOfDefinedControlPoints(true) < 16)
+//   if (!this->MarkupsNode || this->MarkupsNode->GetNumberOfDefinedControlPoints(true) < this->MarkupsNode->GetRequiredNumberOfControlPoints())
 //     {
 //     this->InteractionPipeline->Actor->SetVisibility(false);
 //     return;
@@ -295,6 +381,48 @@ void vtkSlicerBezierSurfaceRepresentation3D::PrintSelf(ostream& os, vtkIndent in
 //   Superclass::UpdateInteractionPipeline();
 // }
 
+//-----------------------------------------------------------------------------
+void vtkSlicerBezierSurfaceRepresentation3D::SetResolution(unsigned int x, unsigned int y)
+{
+  this->SetBezierSurfaceSourceResolution(false, x, y);
+  this->NeedToRenderOn();
+}
+
+//-----------------------------------------------------------------------------
+void vtkSlicerBezierSurfaceRepresentation3D::SetInteractionResolution(unsigned int x, unsigned int y)
+{
+  this->SetBezierSurfaceSourceResolution(true, x, y);
+  this->NeedToRenderOn();
+}
+
+//-----------------------------------------------------------------------------
+void vtkSlicerBezierSurfaceRepresentation3D::SetBezierSurfaceSourceResolution(bool interacting,
+                                                                             unsigned int x, unsigned int y)
+{
+  auto source = interacting ? this->InteractionBezierSurfaceSource : this->BezierSurfaceSource;
+  source->SetResolution(x, y);
+}
+
+//-----------------------------------------------------------------------------
+vtkPolyDataAlgorithm* vtkSlicerBezierSurfaceRepresentation3D::GetBezierSurfaceSource(bool interacting)
+{
+  return interacting ? this->InteractionBezierSurfaceSource : this->BezierSurfaceSource;
+}
+
+//-----------------------------------------------------------------------------
+void vtkSlicerBezierSurfaceRepresentation3D::SetInteracting(bool interacting)
+{
+  if (this->Interacting == interacting)
+    {
+    return;
+    }
+
+  this->Interacting = interacting;
+
+  this->BezierSurfaceMapper->SetInputConnection(this->GetBezierSurfaceSource(interacting)->GetOutputPort());
+  this->NeedToRenderOn();
+}
+
 //-----------------------------------------------------------------------------
 void vtkSlicerBezierSurfaceRepresentation3D::UpdateBezierSurface(vtkMRMLMarkupsBezierSurfaceNode *node)
 {
@@ -303,46 +431,71 @@ void vtkSlicerBezierSurfaceRepresentation3D::UpdateBezierSurface(vtkMRMLMarkupsB
     return;
     }
 
-  if (node->GetNumberOfControlPoints() == 16)
+  int gridSize[2];
+  node->GetControlPointGridSize(gridSize);
+  int numberOfControlPoints = gridSize[0]*gridSize[1];
+
+  if (node->GetNumberOfControlPoints() == numberOfControlPoints)
     {
-    for (int i=0; i<16; i++)
+    this->BezierSurfaceControlPoints->SetNumberOfPoints(numberOfControlPoints);
+    for (int i=0; i<numberOfControlPoints; i++)
       {
       double point[3];
       node->GetNthControlPointPosition(i,point);
-      this->BezierSurfaceControlPoints->SetPoint(i,
-                                                 static_cast<float>(point[0]),
-                                                 static_cast<float>(point[1]),
-                                                 static_cast<float>(point[2]));
+      this->BezierSurfaceControlPoints->SetPoint(i, point);
       }
+    this->BezierSurfaceControlPoints->Modified();
 
-    this->BezierSurfaceSource->SetControlPoints(this->BezierSurfaceControlPoints);
+    this->UpdateBezierSurfaceSources(node);
     }
 }
 
+//-----------------------------------------------------------------------------
+void vtkSlicerBezierSurfaceRepresentation3D::UpdateBezierSurfaceSources(vtkMRMLMarkupsBezierSurfaceNode *node)
+{
+  int gridSize[2];
+  node->GetControlPointGridSize(gridSize);
+  this->BezierSurfaceSource->SetNumberOfControlPoints(gridSize[0], gridSize[1]);
+  this->InteractionBezierSurfaceSource->SetNumberOfControlPoints(gridSize[0], gridSize[1]);
+
+  // NOTE: Only the source connected to the mapper is executed, the other
+  // one is just marked as modified.
+  this->BezierSurfaceSource->SetControlPoints(this->BezierSurfaceControlPoints);
+  this->InteractionBezierSurfaceSource->SetControlPoints(this->BezierSurfaceControlPoints);
+}
+
 //-----------------------------------------------------------------------------
 void vtkSlicerBezierSurfaceRepresentation3D::UpdateControlPolygon(vtkMRMLMarkupsBezierSurfaceNode *node)
 {
-  if (node->GetNumberOfControlPoints() == 16)
+  int gridSize[2];
+  node->GetControlPointGridSize(gridSize);
+
+  // The topology is only regenerated when the size of the grid changes
+  if (node->GetNumberOfControlPoints() == gridSize[0]*gridSize[1] &&
+      (gridSize[0] != this->ControlPolygonGridSize[0] ||
+       gridSize[1] != this->ControlPolygonGridSize[1]))
     {
     //Generate topology;
     vtkSmartPointer<vtkCellArray> planeCells =
       vtkSmartPointer<vtkCellArray>::New();
-    for(int i=0; i<3; ++i)
+    for(int i=0; i<gridSize[0]-1; ++i)
       {
-      for(int j=0; j<3; ++j)
+      for(int j=0; j<gridSize[1]-1; ++j)
         {
         vtkSmartPointer<vtkPolyLine> polyLine = vtkSmartPointer<vtkPolyLine>::New();
         polyLine->GetPointIds()->SetNumberOfIds(5);
-        polyLine->GetPointIds()->SetId(0,i*4+j);
-        polyLine->GetPointIds()->SetId(1,i*4+j+1);
-        polyLine->GetPointIds()->SetId(2,(i+1)*4+j+1);
-        polyLine->GetPointIds()->SetId(3,(i+1)*4+j);
-        polyLine->GetPointIds()->SetId(4,i*4+j);
+        polyLine->GetPointIds()->SetId(0,i*gridSize[1]+j);
+        polyLine->GetPointIds()->SetId(1,i*gridSize[1]+j+1);
+        polyLine->GetPointIds()->SetId(2,(i+1)*gridSize[1]+j+1);
+        polyLine->GetPointIds()->SetId(3,(i+1)*gridSize[1]+j);
+        polyLine->GetPointIds()->SetId(4,i*gridSize[1]+j);
         planeCells->InsertNextCell(polyLine);
         }
       }
 
     this->ControlPolygonPolyData->SetPoints(this->BezierSurfaceControlPoints);
     this->ControlPolygonPolyData->SetLines(planeCells);
+    this->ControlPolygonGridSize[0] = gridSize[0];
+    this->ControlPolygonGridSize[1] = gridSize[1];
     }
 }
@@ -55,7 +55,7 @@
 //------------------------------------------------------------------------------
 class vtkBezierSurfaceSource;
 class vtkPolyData;
-class vtkPolyDataNormals;
+class vtkPolyDataAlgorithm;
 class vtkPoints;
 class vtkTubeFilter;
 class vtkMRMLMarkupsBezierSurfaceNode;
@@ -82,20 +82,56 @@ public:
   /// Return the bounds of the representation
   double *GetBounds() override;
 
+  /// Check whether the pointer is over a control point or the surface. The
+  /// surface is picked by intersecting the view ray with the exact Bezier
+  /// surface (not the tessellation) and reported as ComponentLine.
+  void CanInteract(vtkMRMLInteractionEventData* interactionEventData,
+                   int &foundComponentType, int &foundComponentIndex, double &closestDistance2) override;
+
+  /// Parametric coordinates (u,v) and position of the surface point picked
+  /// by the last CanInteract call that found the surface
+  vtkGetVector2Macro(PickedParametricCoordinates, double);
+  vtkGetVector3Macro(PickedPosition, double);
+
+  /// Set the tessellation resolution of the surface when it is not being
+  /// interacted with (e.g., for screenshots and volume computations).
+  /// Defaults to vtkBezierSurfaceSource::DisplayResolution (50x50).
+  void SetResolution(unsigned int x, unsigned int y);
+
+  /// Set the (coarse) tessellation resolution of the surface used while the
+  /// user interacts with the widget. Defaults to
+  /// vtkBezierSurfaceSource::InteractionResolution (10x10).
+  void SetInteractionResolution(unsigned int x, unsigned int y);
+
+  /// Switch between the interaction and the full resolution tessellations.
+  /// Both tessellations are kept, so switching does not recompute topology.
+  void SetInteracting(bool interacting);
+  bool GetInteracting() const {return this->Interacting;}
+
 protected:
   // Bezier surface releated elements
   vtkSmartPointer<vtkBezierSurfaceSource> BezierSurfaceSource;
+  vtkSmartPointer<vtkBezierSurfaceSource> InteractionBezierSurfaceSource;
+  bool Interacting;
   vtkSmartPointer<vtkPoints> BezierSurfaceControlPoints;
   vtkSmartPointer<vtkPolyDataMapper> BezierSurfaceMapper;
   vtkSmartPointer<vtkActor> BezierSurfaceActor;
-  vtkSmartPointer<vtkPolyDataNormals> BezierSurfaceNormals;
 
   // Control polygon related elements
   vtkSmartPointer<vtkPolyData> ControlPolygonPolyData;
+  int ControlPolygonGridSize[2];
   vtkSmartPointer<vtkTubeFilter> ControlPolygonTubeFilter;
   vtkSmartPointer<vtkPolyDataMapper> ControlPolygonMapper;
   vtkSmartPointer<vtkActor> ControlPolygonActor;
 
+  // Picking related elements
+  double PickedParametricCoordinates[2];
+  double PickedPosition[3];
+
+  /// Flatness tolerance (relative to the size of the control net) below which
+  /// the surface is no longer subdivided when intersecting it with the view ray
+  static const double SurfaceIntersectionTolerance;
+
 protected:
   vtkSlicerBezierSurfaceRepresentation3D();
   ~vtkSlicerBezierSurfaceRepresentation3D() override;
@@ -103,6 +139,25 @@ protected:
   void UpdateControlPolygon(vtkMRMLMarkupsBezierSurfaceNode*);
   void UpdateBezierSurface(vtkMRMLMarkupsBezierSurfaceNode*);
 
+  /// Pass the control points (already copied into BezierSurfaceControlPoints)
+  /// to the idle and interaction surface sources
+  virtual void UpdateBezierSurfaceSources(vtkMRMLMarkupsBezierSurfaceNode*);
+
+  /// Source of the tessellation shown when idle or while interacting
+  virtual vtkPolyDataAlgorithm* GetBezierSurfaceSource(bool interacting);
+
+  /// Set the resolution of the idle or the interaction surface source
+  virtual void SetBezierSurfaceSourceResolution(bool interacting, unsigned int x, unsigned int y);
+
+  void CanInteractWithBezierSurface(vtkMRMLInteractionEventData* interactionEventData,
+                                    int &foundComponentType, int &foundComponentIndex,
+                                    double &closestDistance2);
+
+  /// Intersect the segment p1-p2 with the surface, returning the closest
+  /// intersection to p1 (see vtkBezierSurfaceSource::IntersectWithLine)
+  virtual int IntersectBezierSurfaceWithLine(const double p1[3], const double p2[3],
+                                             double &t, double x[3], double parametricCoordinates[2]);
+
 private:
   vtkSlicerBezierSurfaceRepresentation3D(const vtkSlicerBezierSurfaceRepresentation3D&) = delete;
   void operator=(const vtkSlicerBezierSurfaceRepresentation3D&) = delete;
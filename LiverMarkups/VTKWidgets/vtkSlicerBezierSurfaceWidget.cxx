@@ -72,7 +72,7 @@ void vtkSlicerBezierSurfaceWidget::CreateDefaultRepresentation(vtkMRMLMarkupsDis
     }
   else
     {
-    rep = vtkSmartPointer<vtkSlicerBezierSurfaceRepresentation3D>::New();
+    rep = this->CreateRepresentation3D();
     }
   this->SetRenderer(renderer);
   this->SetRepresentation(rep);
@@ -81,6 +81,12 @@ void vtkSlicerBezierSurfaceWidget::CreateDefaultRepresentation(vtkMRMLMarkupsDis
   rep->UpdateFromMRML(nullptr, 0); // full update
 }
 
+//------------------------------------------------------------------------------
+vtkSmartPointer<vtkSlicerBezierSurfaceRepresentation3D> vtkSlicerBezierSurfaceWidget::CreateRepresentation3D()
+{
+  return vtkSmartPointer<vtkSlicerBezierSurfaceRepresentation3D>::New();
+}
+
 //------------------------------------------------------------------------------
 vtkSlicerMarkupsWidget* vtkSlicerBezierSurfaceWidget::CreateInstance() const
 {
@@ -96,3 +102,24 @@ vtkSlicerMarkupsWidget* vtkSlicerBezierSurfaceWidget::CreateInstance() const
 #endif
   return result;
 }
+
+//------------------------------------------------------------------------------
+bool vtkSlicerBezierSurfaceWidget::ProcessInteractionEvent(vtkMRMLInteractionEventData* eventData)
+{
+  bool processed = this->Superclass::ProcessInteractionEvent(eventData);
+
+  auto rep = vtkSlicerBezierSurfaceRepresentation3D::SafeDownCast(this->GetRepresentation());
+  if (!rep)
+    {
+    return processed;
+    }
+
+  int state = this->GetWidgetState();
+  bool interacting = (state == WidgetStateTranslateControlPoint ||
+                      state == WidgetStateTranslate ||
+                      state == WidgetStateRotate ||
+                      state == WidgetStateScale);
+  rep->SetInteracting(interacting);
+
+  return processed;
+}
@@ -43,6 +43,8 @@
 
 #include <vtkSlicerMarkupsWidget.h>
 
+class vtkSlicerBezierSurfaceRepresentation3D;
+
 class VTK_SLICER_LIVERMARKUPS_MODULE_VTKWIDGETS_EXPORT vtkSlicerBezierSurfaceWidget
 : public vtkSlicerMarkupsWidget
 {
@@ -57,10 +59,17 @@ public:
   /// Create instance of the markups widget
   vtkSlicerMarkupsWidget* CreateInstance() const override;
 
+  /// Process interaction events and switch the surface tessellation to a
+  /// coarse resolution while the widget is being interacted with
+  bool ProcessInteractionEvent(vtkMRMLInteractionEventData* eventData) override;
+
 protected:
   vtkSlicerBezierSurfaceWidget();
   ~vtkSlicerBezierSurfaceWidget();
 
+  /// Create the representation used in 3D views
+  virtual vtkSmartPointer<vtkSlicerBezierSurfaceRepresentation3D> CreateRepresentation3D();
+
 private:
   vtkSlicerBezierSurfaceWidget(const vtkSlicerBezierSurfaceWidget&) = delete;
   void operator=(const vtkSlicerBezierSurfaceWidget) = delete;
@@ -0,0 +1,216 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (The Intervention Centre,
+  Oslo University Hospital) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#include "vtkSlicerContourRepresentation2D.h"
+
+#include "vtkMRMLMarkupsContourNode.h"
+
+// MRML includes
+#include <vtkMRMLMarkupsDisplayNode.h>
+#include <vtkMRMLTransformNode.h>
+
+// VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkMath.h>
+#include <vtkPlane.h>
+#include <vtkPoints.h>
+#include <vtkPropCollection.h>
+#include <vtkProperty2D.h>
+#include <vtkTransform.h>
+
+//------------------------------------------------------------------------------
+vtkSlicerContourRepresentation2D::vtkSlicerContourRepresentation2D()
+  :Superclass(), SlabThickness(2.0)
+{
+  // The contour is extracted in the coordinates of the target, brought to
+  // world, cut to the slab around the slice and then projected into the slice
+  this->ContourTargetToWorldTransformer->SetTransform(this->ContourTargetToWorldTransform);
+  this->ContourTargetToWorldTransformer->SetInputConnection(this->ContourExtractor->GetOutputPort());
+
+  vtkNew<vtkPoints> slabPoints;
+  slabPoints->SetNumberOfPoints(2);
+  vtkNew<vtkDoubleArray> slabNormals;
+  slabNormals->SetNumberOfComponents(3);
+  slabNormals->SetNumberOfTuples(2);
+  this->ContourSlab->SetPoints(slabPoints);
+  this->ContourSlab->SetNormals(slabNormals);
+
+  this->ContourSlabClipper->SetClipFunction(this->ContourSlab);
+  this->ContourSlabClipper->InsideOutOn();
+  this->ContourSlabClipper->SetInputConnection(this->ContourTargetToWorldTransformer->GetOutputPort());
+
+  this->ContourWorldToSliceTransformer->SetTransform(this->WorldToSliceTransform);
+  this->ContourWorldToSliceTransformer->SetInputConnection(this->ContourSlabClipper->GetOutputPort());
+
+  this->ContourMapper->SetInputConnection(this->ContourWorldToSliceTransformer->GetOutputPort());
+  this->ContourMapper->ScalarVisibilityOff();
+
+  this->ContourActor->SetMapper(this->ContourMapper);
+  this->ContourActor->GetProperty()->SetLineWidth(2.0);
+  this->ContourActor->VisibilityOff();
+}
+
+//------------------------------------------------------------------------------
+vtkSlicerContourRepresentation2D::~vtkSlicerContourRepresentation2D() = default;
+
+//------------------------------------------------------------------------------
+void vtkSlicerContourRepresentation2D::PrintSelf(ostream& os, vtkIndent indent)
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Slab Thickness: " << this->SlabThickness << "\n";
+}
+
+//----------------------------------------------------------------------
+void vtkSlicerContourRepresentation2D::UpdateFromMRML(vtkMRMLNode* caller, unsigned long event, void *callData /*=nullptr*/)
+{
+  this->Superclass::UpdateFromMRML(caller, event, callData);
+
+  bool contourVisible = this->GetVisibility() && this->MarkupsDisplayNode &&
+                        this->UpdateContourExtractor();
+  this->ContourActor->SetVisibility(contourVisible);
+  if (contourVisible)
+    {
+    this->UpdateContourSlab();
+
+    vtkProperty2D* property = this->ContourActor->GetProperty();
+    property->SetColor(this->MarkupsDisplayNode->GetSelectedColor());
+    property->SetOpacity(this->MarkupsDisplayNode->GetOpacity());
+    }
+
+  this->NeedToRenderOn();
+}
+
+//----------------------------------------------------------------------
+bool vtkSlicerContourRepresentation2D::UpdateContourExtractor()
+{
+  auto contourNode = vtkMRMLMarkupsContourNode::SafeDownCast(this->GetMarkupsNode());
+  return contourNode && contourNode->UpdateContourExtractor(this->ContourExtractor);
+}
+
+//----------------------------------------------------------------------
+void vtkSlicerContourRepresentation2D::UpdateContourSlab()
+{
+  auto contourNode = vtkMRMLMarkupsContourNode::SafeDownCast(this->GetMarkupsNode());
+  auto targetModelNode = contourNode ? contourNode->GetTarget() : nullptr;
+
+  vtkMRMLTransformNode::GetTransformBetweenNodes(
+    targetModelNode ? targetModelNode->GetParentTransformNode() : nullptr, nullptr,
+    this->ContourTargetToWorldTransform);
+
+  // The slab is the intersection of two half-spaces facing away from each
+  // other, at half the thickness on each side of the slice plane
+  double origin[3] = {0.0, 0.0, 0.0};
+  double normal[3] = {0.0, 0.0, 1.0};
+  this->SlicePlane->GetOrigin(origin);
+  this->SlicePlane->GetNormal(normal);
+  vtkMath::Normalize(normal);
+
+  double halfThickness = this->SlabThickness / 2.0;
+  for (int side = 0; side < 2; ++side)
+    {
+    double sign = side == 0 ? 1.0 : -1.0;
+    double slabPoint[3] = {
+      origin[0] + sign * halfThickness * normal[0],
+      origin[1] + sign * halfThickness * normal[1],
+      origin[2] + sign * halfThickness * normal[2]
+    };
+    this->ContourSlab->GetPoints()->SetPoint(side, slabPoint);
+    this->ContourSlab->GetNormals()->SetTuple3(side, sign * normal[0], sign * normal[1], sign * normal[2]);
+    }
+  this->ContourSlab->Modified();
+}
+
+//----------------------------------------------------------------------
+void vtkSlicerContourRepresentation2D::GetActors(vtkPropCollection* pc)
+{
+  this->Superclass::GetActors(pc);
+  this->ContourActor->GetActors(pc);
+}
+
+//----------------------------------------------------------------------
+void vtkSlicerContourRepresentation2D::ReleaseGraphicsResources(vtkWindow* window)
+{
+  this->Superclass::ReleaseGraphicsResources(window);
+  this->ContourActor->ReleaseGraphicsResources(window);
+}
+
+//----------------------------------------------------------------------
+int vtkSlicerContourRepresentation2D::RenderOverlay(vtkViewport* viewport)
+{
+  int count = this->Superclass::RenderOverlay(viewport);
+  if (this->ContourActor->GetVisibility())
+    {
+    count += this->ContourActor->RenderOverlay(viewport);
+    }
+  return count;
+}
+
+//----------------------------------------------------------------------
+int vtkSlicerContourRepresentation2D::RenderOpaqueGeometry(vtkViewport* viewport)
+{
+  int count = this->Superclass::RenderOpaqueGeometry(viewport);
+  if (this->ContourActor->GetVisibility())
+    {
+    count += this->ContourActor->RenderOpaqueGeometry(viewport);
+    }
+  return count;
+}
+
+//----------------------------------------------------------------------
+int vtkSlicerContourRepresentation2D::RenderTranslucentPolygonalGeometry(vtkViewport* viewport)
+{
+  int count = this->Superclass::RenderTranslucentPolygonalGeometry(viewport);
+  if (this->ContourActor->GetVisibility())
+    {
+    count += this->ContourActor->RenderTranslucentPolygonalGeometry(viewport);
+    }
+  return count;
+}
+
+//----------------------------------------------------------------------
+vtkTypeBool vtkSlicerContourRepresentation2D::HasTranslucentPolygonalGeometry()
+{
+  if (this->Superclass::HasTranslucentPolygonalGeometry())
+    {
+    return true;
+    }
+  return this->ContourActor->GetVisibility() &&
+         this->ContourActor->HasTranslucentPolygonalGeometry();
+}
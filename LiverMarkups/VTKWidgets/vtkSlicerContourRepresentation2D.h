@@ -0,0 +1,114 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (The Intervention Centre,
+  Oslo University Hospital) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#ifndef __vtkslicercontourrepresentation2d_h_
+#define __vtkslicercontourrepresentation2d_h_
+
+#include "vtkSlicerLiverMarkupsModuleVTKWidgetsExport.h"
+
+// Markups VTKWidgets includes
+#include "vtkSlicerLineRepresentation2D.h"
+#include "vtkSurfaceContourExtractor.h"
+
+// VTK includes
+#include <vtkActor2D.h>
+#include <vtkClipPolyData.h>
+#include <vtkGeneralTransform.h>
+#include <vtkNew.h>
+#include <vtkPlanes.h>
+#include <vtkPolyDataMapper2D.h>
+#include <vtkTransformPolyDataFilter.h>
+
+//------------------------------------------------------------------------------
+/// Base 2D representation of the contour markups: the contour on the target
+/// model is extracted on the CPU and the part of its polylines within a slab
+/// around the slice plane is drawn in the slice view, together with the line
+/// between the control points.
+class VTK_SLICER_LIVERMARKUPS_MODULE_VTKWIDGETS_EXPORT vtkSlicerContourRepresentation2D
+: public vtkSlicerLineRepresentation2D
+{
+public:
+  vtkTypeMacro(vtkSlicerContourRepresentation2D, vtkSlicerLineRepresentation2D);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  void UpdateFromMRML(vtkMRMLNode* caller, unsigned long event, void* callData=nullptr) override;
+
+  void GetActors(vtkPropCollection* pc) override;
+  void ReleaseGraphicsResources(vtkWindow* window) override;
+  int RenderOverlay(vtkViewport* viewport) override;
+  int RenderOpaqueGeometry(vtkViewport* viewport) override;
+  int RenderTranslucentPolygonalGeometry(vtkViewport* viewport) override;
+  vtkTypeBool HasTranslucentPolygonalGeometry() override;
+
+  /// Thickness (mm) of the slab centered on the slice plane the contour is
+  /// shown in
+  vtkSetMacro(SlabThickness, double);
+  vtkGetMacro(SlabThickness, double);
+
+protected:
+  vtkSlicerContourRepresentation2D();
+  ~vtkSlicerContourRepresentation2D() override;
+
+  /// Sets the target surface and the contour parameters of the extractor from
+  /// the markups node (see vtkMRMLMarkupsContourNode::UpdateContourExtractor).
+  /// Returns false if there is no contour to display. The contour itself is
+  /// only extracted when the view renders and the parameters changed.
+  virtual bool UpdateContourExtractor();
+
+  /// Updates the transform of the contour from the target to world and the
+  /// slab around the slice plane
+  void UpdateContourSlab();
+
+  double SlabThickness;
+
+  vtkNew<vtkSurfaceContourExtractor> ContourExtractor;
+  vtkNew<vtkGeneralTransform> ContourTargetToWorldTransform;
+  vtkNew<vtkTransformPolyDataFilter> ContourTargetToWorldTransformer;
+  vtkNew<vtkPlanes> ContourSlab;
+  vtkNew<vtkClipPolyData> ContourSlabClipper;
+  vtkNew<vtkTransformPolyDataFilter> ContourWorldToSliceTransformer;
+  vtkNew<vtkPolyDataMapper2D> ContourMapper;
+  vtkNew<vtkActor2D> ContourActor;
+
+private:
+  vtkSlicerContourRepresentation2D(const vtkSlicerContourRepresentation2D&) = delete;
+  void operator=(const vtkSlicerContourRepresentation2D&) = delete;
+};
+
+#endif // __vtkslicercontourrepresentation2d_h_
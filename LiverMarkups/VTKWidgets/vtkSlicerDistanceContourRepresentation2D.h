@@ -41,15 +41,15 @@
 
 #include "vtkSlicerLiverMarkupsModuleVTKWidgetsExport.h"
 
-// Markups VTKWidgets includes
-#include "vtkSlicerLineRepresentation2D.h"
+// Liver Markups VTKWidgets includes
+#include "vtkSlicerContourRepresentation2D.h"
 
 class VTK_SLICER_LIVERMARKUPS_MODULE_VTKWIDGETS_EXPORT vtkSlicerDistanceContourRepresentation2D
-: public vtkSlicerLineRepresentation2D
+: public vtkSlicerContourRepresentation2D
 {
 public:
   static vtkSlicerDistanceContourRepresentation2D* New();
-  vtkTypeMacro(vtkSlicerDistanceContourRepresentation2D, vtkSlicerLineRepresentation2D);
+  vtkTypeMacro(vtkSlicerDistanceContourRepresentation2D, vtkSlicerContourRepresentation2D);
   void PrintSelf(ostream& os, vtkIndent indent) override;
 
 protected:
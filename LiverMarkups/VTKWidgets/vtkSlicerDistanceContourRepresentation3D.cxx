@@ -50,12 +50,6 @@
 #include <qSlicerApplication.h>
 #include <qSlicerLayoutManager.h>
 
-// VTK includes
-#include <vtkCollection.h>
-#include <vtkOpenGLVertexBufferObject.h>
-#include <vtkShaderProperty.h>
-#include <vtkUniforms.h>
-
 //------------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerDistanceContourRepresentation3D);
 
@@ -94,50 +88,22 @@ void vtkSlicerDistanceContourRepresentation3D::UpdateFromMRML(vtkMRMLNode* calle
  if (targetModelNode != this->Target)
    {
    this->ShaderHelper->SetTargetModelNode(targetModelNode);
-   this->ShaderHelper->AttachDistanceContourShader();
+   this->ShaderHelper->AttachDistanceContourShader(this->GetMarkupsNode());
    this->Target = targetModelNode;
    }
 
- if (liverMarkupsDistanceContourNode->GetNumberOfControlPoints() != 2)
+ if (!liverMarkupsDistanceContourNode->UpdateContourExtractor(this->ContourParameters))
    {
+   this->ShaderHelper->SetContourVisibility(false);
+   this->ShaderHelper->UpdateUniforms();
    return;
    }
 
- // Recalculate the middle plane and update the shader parameters
- double point1Position[3] = {1.0f};
- double point2Position[3] = {1.0f};
-
- liverMarkupsDistanceContourNode->GetNthControlPointPosition(0, point1Position);
- liverMarkupsDistanceContourNode->GetNthControlPointPosition(1, point2Position);
-
- auto VBOs = this->ShaderHelper->GetTargetModelVertexVBOs();
- auto actors = this->ShaderHelper->GetTargetActors();
-
- for(int index = 0; index < VBOs->GetNumberOfItems(); ++index)
-   {
-   auto VBO = vtkOpenGLVertexBufferObject::SafeDownCast(VBOs->GetItemAsObject(index));
-   auto scale = VBO->GetScale();
-   auto shift = VBO->GetShift();
-
-   float externalPointPositionScaled[4] = {
-     (point1Position[0] - shift[0]) * scale[0],
-     (point1Position[1] - shift[1]) * scale[1],
-     (point1Position[2] - shift[2]) * scale[2],
-     1.0f};
-
-   float referencePointPositionScaled[4] = {
-     (point2Position[0] - shift[0]) * scale[0],
-     (point2Position[1] - shift[1]) * scale[1],
-     (point2Position[2] - shift[2]) * scale[2],
-     1.0f};
-
-   auto actor = vtkActor::SafeDownCast(this->ShaderHelper->GetTargetActors()->GetItemAsObject(index));
-   auto fragmentUniforms = actor->GetShaderProperty()->GetFragmentCustomUniforms();
-   fragmentUniforms->SetUniform4f("externalPointMC", externalPointPositionScaled);
-   fragmentUniforms->SetUniform4f("referencePointMC", referencePointPositionScaled);
-   fragmentUniforms->SetUniformf("contourThickness", 2.0f*(scale[0]+scale[1])/2.0f);
-   fragmentUniforms->SetUniformi("contourVisibility", 1);
-   }
+ // The contour itself is computed in the shader (the geodesic distance field
+ // is computed by the node, once for all the views)
+ this->ShaderHelper->SetContour(this->ContourParameters);
+ this->ShaderHelper->SetContourVisibility(true);
+ this->ShaderHelper->UpdateUniforms();
 
  this->NeedToRenderOn();
 }
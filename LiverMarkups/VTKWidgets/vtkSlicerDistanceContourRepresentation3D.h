@@ -45,6 +45,7 @@
 // Markups VTKWidgets includes
 #include "vtkSlicerLineRepresentation3D.h"
 #include "vtkSlicerShaderHelper.h"
+#include "vtkSurfaceContourExtractor.h"
 
 // MRML includes
 #include <vtkMRMLModelNode.h>
@@ -72,6 +73,9 @@ private:
   vtkWeakPointer<vtkMRMLModelNode> Target;
   vtkNew<vtkSlicerShaderHelper> ShaderHelper;
 
+  // Parameters of the contour, never updated
+  vtkNew<vtkSurfaceContourExtractor> ContourParameters;
+
 private:
   vtkSlicerDistanceContourRepresentation3D(const vtkSlicerDistanceContourRepresentation3D&) = delete;
   void operator=(const vtkSlicerDistanceContourRepresentation3D&) = delete;
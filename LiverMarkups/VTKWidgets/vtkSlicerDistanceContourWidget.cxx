@@ -40,14 +40,12 @@
 #include "vtkSlicerDistanceContourWidget.h"
 
 // Liver Markups VTKWidgets include
+#include "vtkSlicerDistanceContourRepresentation2D.h"
 #include "vtkSlicerDistanceContourRepresentation3D.h"
 
 // VTK includes
 #include <vtkObjectFactory.h>
 
-// Markups VTKWidgets includes
-#include <vtkSlicerLineRepresentation2D.h>
-
 //------------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerDistanceContourWidget);
 
@@ -68,7 +66,7 @@ void vtkSlicerDistanceContourWidget::CreateDefaultRepresentation(vtkMRMLMarkupsD
   vtkSmartPointer<vtkSlicerMarkupsWidgetRepresentation> rep = nullptr;
   if (vtkMRMLSliceNode::SafeDownCast(viewNode))
     {
-    rep = vtkSmartPointer<vtkSlicerLineRepresentation2D>::New();
+    rep = vtkSmartPointer<vtkSlicerDistanceContourRepresentation2D>::New();
     }
   else
     {
@@ -0,0 +1,128 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (The Intervention Centre,
+  Oslo University Hospital) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#include "vtkSlicerMultiPatchBezierSurfaceRepresentation3D.h"
+
+#include "vtkMRMLMarkupsMultiPatchBezierSurfaceNode.h"
+#include "vtkMultiPatchBezierSurfaceSource.h"
+
+// VTK includes
+#include <vtkObjectFactory.h>
+#include <vtkPoints.h>
+#include <vtkPolyDataMapper.h>
+
+//------------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerMultiPatchBezierSurfaceRepresentation3D);
+
+//------------------------------------------------------------------------------
+vtkSlicerMultiPatchBezierSurfaceRepresentation3D::vtkSlicerMultiPatchBezierSurfaceRepresentation3D()
+  :Superclass()
+{
+  this->MultiPatchBezierSurfaceSource = vtkSmartPointer<vtkMultiPatchBezierSurfaceSource>::New();
+  this->MultiPatchBezierSurfaceSource->ComputeNormalsOn();
+  this->MultiPatchBezierSurfaceSource->SetOutputPointsPrecision(vtkAlgorithm::SINGLE_PRECISION);
+  this->MultiPatchBezierSurfaceSource->SetResolution(vtkMultiPatchBezierSurfaceSource::DisplayResolution,
+                                                     vtkMultiPatchBezierSurfaceSource::DisplayResolution);
+
+  // Coarse tessellation used while dragging
+  this->InteractionMultiPatchBezierSurfaceSource = vtkSmartPointer<vtkMultiPatchBezierSurfaceSource>::New();
+  this->InteractionMultiPatchBezierSurfaceSource->ComputeNormalsOn();
+  this->InteractionMultiPatchBezierSurfaceSource->SetOutputPointsPrecision(vtkAlgorithm::SINGLE_PRECISION);
+  this->InteractionMultiPatchBezierSurfaceSource->SetResolution(
+    vtkMultiPatchBezierSurfaceSource::InteractionResolution,
+    vtkMultiPatchBezierSurfaceSource::InteractionResolution);
+
+  this->BezierSurfaceMapper->SetInputConnection(this->MultiPatchBezierSurfaceSource->GetOutputPort());
+}
+
+//------------------------------------------------------------------------------
+vtkSlicerMultiPatchBezierSurfaceRepresentation3D::~vtkSlicerMultiPatchBezierSurfaceRepresentation3D() = default;
+
+//-----------------------------------------------------------------------------
+void vtkSlicerMultiPatchBezierSurfaceRepresentation3D::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  unsigned int numberOfPatches[2];
+  this->MultiPatchBezierSurfaceSource->GetNumberOfPatches(numberOfPatches);
+  os << indent << "Number of patches: " << numberOfPatches[0] << ", " << numberOfPatches[1] << "\n";
+}
+
+//-----------------------------------------------------------------------------
+void vtkSlicerMultiPatchBezierSurfaceRepresentation3D::SetBezierSurfaceSourceResolution(bool interacting,
+                                                                                       unsigned int x, unsigned int y)
+{
+  auto source = interacting ?
+    this->InteractionMultiPatchBezierSurfaceSource : this->MultiPatchBezierSurfaceSource;
+  source->SetResolution(x, y);
+}
+
+//-----------------------------------------------------------------------------
+vtkPolyDataAlgorithm* vtkSlicerMultiPatchBezierSurfaceRepresentation3D::GetBezierSurfaceSource(bool interacting)
+{
+  return interacting ?
+    this->InteractionMultiPatchBezierSurfaceSource : this->MultiPatchBezierSurfaceSource;
+}
+
+//-----------------------------------------------------------------------------
+int vtkSlicerMultiPatchBezierSurfaceRepresentation3D::IntersectBezierSurfaceWithLine(
+  const double p1[3], const double p2[3], double &t, double x[3], double parametricCoordinates[2])
+{
+  return this->MultiPatchBezierSurfaceSource->IntersectWithLine(p1, p2, SurfaceIntersectionTolerance,
+                                                               t, x, parametricCoordinates);
+}
+
+//-----------------------------------------------------------------------------
+void vtkSlicerMultiPatchBezierSurfaceRepresentation3D::UpdateBezierSurfaceSources(vtkMRMLMarkupsBezierSurfaceNode *node)
+{
+  auto multiPatchNode = vtkMRMLMarkupsMultiPatchBezierSurfaceNode::SafeDownCast(node);
+  if (!multiPatchNode)
+    {
+    return;
+    }
+
+  int numberOfPatches[2];
+  multiPatchNode->GetNumberOfPatches(numberOfPatches);
+  this->MultiPatchBezierSurfaceSource->SetNumberOfPatches(numberOfPatches[0], numberOfPatches[1]);
+  this->InteractionMultiPatchBezierSurfaceSource->SetNumberOfPatches(numberOfPatches[0], numberOfPatches[1]);
+
+  // NOTE: Only the patches whose control points moved are re-evaluated
+  this->MultiPatchBezierSurfaceSource->SetControlPoints(this->BezierSurfaceControlPoints);
+  this->InteractionMultiPatchBezierSurfaceSource->SetControlPoints(this->BezierSurfaceControlPoints);
+}
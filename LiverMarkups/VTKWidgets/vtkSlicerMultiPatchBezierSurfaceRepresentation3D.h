@@ -0,0 +1,89 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (The Intervention Centre,
+  Oslo University Hospital) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#ifndef __vtkslicermultipatchbeziersurfacewidgetrepresentation3d_h_
+#define __vtkslicermultipatchbeziersurfacewidgetrepresentation3d_h_
+
+#include "vtkSlicerLiverMarkupsModuleVTKWidgetsExport.h"
+
+// Liver Markups VTKWidgets includes
+#include "vtkSlicerBezierSurfaceRepresentation3D.h"
+
+//------------------------------------------------------------------------------
+class vtkMultiPatchBezierSurfaceSource;
+
+//------------------------------------------------------------------------------
+/// Representation of vtkMRMLMarkupsMultiPatchBezierSurfaceNode. The control
+/// polygon is handled by vtkSlicerBezierSurfaceRepresentation3D while the
+/// surface is generated by vtkMultiPatchBezierSurfaceSource, so dragging a
+/// control point only re-evaluates the patches it belongs to.
+class VTK_SLICER_LIVERMARKUPS_MODULE_VTKWIDGETS_EXPORT vtkSlicerMultiPatchBezierSurfaceRepresentation3D
+: public vtkSlicerBezierSurfaceRepresentation3D
+{
+public:
+  static vtkSlicerMultiPatchBezierSurfaceRepresentation3D* New();
+  vtkTypeMacro(vtkSlicerMultiPatchBezierSurfaceRepresentation3D, vtkSlicerBezierSurfaceRepresentation3D);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+
+protected:
+  vtkSmartPointer<vtkMultiPatchBezierSurfaceSource> MultiPatchBezierSurfaceSource;
+  vtkSmartPointer<vtkMultiPatchBezierSurfaceSource> InteractionMultiPatchBezierSurfaceSource;
+
+protected:
+  vtkSlicerMultiPatchBezierSurfaceRepresentation3D();
+  ~vtkSlicerMultiPatchBezierSurfaceRepresentation3D() override;
+
+  void UpdateBezierSurfaceSources(vtkMRMLMarkupsBezierSurfaceNode*) override;
+  vtkPolyDataAlgorithm* GetBezierSurfaceSource(bool interacting) override;
+
+  /// The resolution applies to each patch
+  void SetBezierSurfaceSourceResolution(bool interacting, unsigned int x, unsigned int y) override;
+
+  /// Intersect the segment p1-p2 with the patches, the reported parametric
+  /// coordinates are global to the multi-patch surface
+  int IntersectBezierSurfaceWithLine(const double p1[3], const double p2[3],
+                                     double &t, double x[3], double parametricCoordinates[2]) override;
+
+private:
+  vtkSlicerMultiPatchBezierSurfaceRepresentation3D(const vtkSlicerMultiPatchBezierSurfaceRepresentation3D&) = delete;
+  void operator=(const vtkSlicerMultiPatchBezierSurfaceRepresentation3D&) = delete;
+};
+
+#endif // __vtkslicermultipatchbeziersurfacewidgetrepresentation3d_h_
@@ -39,197 +39,644 @@
 
 #include "vtkSlicerShaderHelper.h"
 
+// Liver Markups VTKAlgorithms includes
+#include "vtkSurfaceContourExtractor.h"
+
 // MRML includes
 #include <qMRMLThreeDWidget.h>
 #include <vtkMRMLModelDisplayableManager.h>
 #include <vtkMRMLModelDisplayNode.h>
+#include <vtkMRMLNode.h>
 
 // Slicer includes
 #include <qSlicerApplication.h>
 #include <qSlicerLayoutManager.h>
 
+// Qt includes
+#include <QPointer>
+
 // VTK includes
 #include <vtkActor.h>
+#include <vtkCallbackCommand.h>
 #include <vtkCollection.h>
+#include <vtkFloatArray.h>
 #include <vtkObjectFactory.h>
+#include <vtkOpenGLBufferObject.h>
 #include <vtkOpenGLPolyDataMapper.h>
+#include <vtkOpenGLRenderWindow.h>
 #include <vtkOpenGLVertexBufferObjectGroup.h>
 #include <vtkOpenGLVertexBufferObject.h>
+#include <vtkPolyData.h>
+#include <vtkRenderer.h>
+#include <vtkShaderProgram.h>
 #include <vtkShaderProperty.h>
+#include <vtkSmartPointer.h>
+#include <vtkTextureObject.h>
 #include <vtkUniforms.h>
 
+// STD includes
+#include <algorithm>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
 //------------------------------------------------------------------------------
-vtkStandardNewMacro(vtkSlicerShaderHelper);
+namespace
+{
+
+const int MaximumNumberOfContours = vtkSlicerShaderHelper::MaximumNumberOfContours;
 
 //------------------------------------------------------------------------------
-vtkSlicerShaderHelper::vtkSlicerShaderHelper()
-  :TargetModelNode(nullptr)
+/// Contour slot of a markups node, shared by its representations in all the
+/// views
+struct ContourParameters
+{
+  vtkWeakPointer<vtkMRMLNode> ContourNode;
+  int NumberOfUsers = 0;
+  bool Visible = false;
+  int Type = vtkSlicerShaderHelper::NoContour;
+  double Position[3] = {0.0, 0.0, 0.0};
+  double Normal[3] = {1.0, 0.0, 0.0};
+  double Distance = 0.0;
+  int GeodesicChannel = -1;
+  vtkMTimeType GeodesicTime = 0;
+};
+
+//------------------------------------------------------------------------------
+/// Actor of the target in a 3D view (model displayable manager), along with
+/// the uniform values last uploaded to it and its copy of the geodesic
+/// distance fields
+struct ViewActor
 {
+  vtkWeakPointer<vtkMRMLModelDisplayableManager> DisplayableManager;
+  vtkWeakPointer<vtkActor> Actor;
+  vtkWeakPointer<vtkOpenGLPolyDataMapper> Mapper;
+  unsigned long UpdateShaderObserverTag = 0;
+
+  vtkSmartPointer<vtkOpenGLBufferObject> GeodesicBuffer;
+  vtkSmartPointer<vtkTextureObject> GeodesicTexture;
+  unsigned long UploadedGeodesicVersion = 0;
+
+  unsigned long UploadedVersion = 0;
+  double UploadedShift[3] = {0.0, 0.0, 0.0};
+  double UploadedScale[3] = {0.0, 0.0, 0.0};
+  int Types[MaximumNumberOfContours] = {vtkSlicerShaderHelper::NoContour};
+  float ParametersA[MaximumNumberOfContours][4] = {{0.0f}};
+  float ParametersB[MaximumNumberOfContours][4] = {{0.0f}};
+  float Values[MaximumNumberOfContours] = {0.0f};
+};
+
+//------------------------------------------------------------------------------
+/// Contour program shared by all the contour representations of a target model
+struct ContourProgram
+{
+  vtkWeakPointer<vtkMRMLModelNode> ModelNode;
+  ContourParameters Slots[MaximumNumberOfContours];
+
+  // Incremented on every change of the contour parameters; the actors are
+  // brought up to date right before their view renders
+  unsigned long Version = 1;
+
+  std::vector<ViewActor> ViewActors;
+
+  // Geodesic distance fields of the geodesic contours, one per component (the
+  // number of components grows with the geodesic channels in use).
+  // They are owned by the program and uploaded to a texture buffer of each
+  // actor, the polydata of the target is left untouched.
+  vtkNew<vtkFloatArray> GeodesicDistances;
+  unsigned long GeodesicVersion = 1;
+};
+
+//------------------------------------------------------------------------------
+std::map<vtkMRMLModelNode*, std::unique_ptr<ContourProgram>>& GetContourPrograms()
+{
+  static std::map<vtkMRMLModelNode*, std::unique_ptr<ContourProgram>> contourPrograms;
+  return contourPrograms;
 }
 
 //------------------------------------------------------------------------------
-void vtkSlicerShaderHelper::PrintSelf(ostream& os, vtkIndent indent)
+ContourProgram* GetContourProgram(vtkMRMLModelNode* modelNode, bool create)
 {
-  Superclass::PrintSelf(os, indent);
+  if (!modelNode)
+    {
+    return nullptr;
+    }
+
+  auto &contourPrograms = GetContourPrograms();
+  auto it = contourPrograms.find(modelNode);
+
+  // A deleted model node may have left an entry at the same address
+  if (it != contourPrograms.end() && it->second->ModelNode != modelNode)
+    {
+    contourPrograms.erase(it);
+    it = contourPrograms.end();
+    }
+
+  if (it == contourPrograms.end())
+    {
+    if (!create)
+      {
+      return nullptr;
+      }
+
+    auto program = std::unique_ptr<ContourProgram>(new ContourProgram);
+    program->ModelNode = modelNode;
+    it = contourPrograms.emplace(modelNode, std::move(program)).first;
+    }
+
+  return it->second.get();
+}
+
+//------------------------------------------------------------------------------
+int GetNumberOfUsers(ContourProgram* program)
+{
+  int numberOfUsers = 0;
+  for (const auto &slot : program->Slots)
+    {
+    numberOfUsers += slot.NumberOfUsers;
+    }
+  return numberOfUsers;
+}
+
+//------------------------------------------------------------------------------
+vtkOpenGLVertexBufferObject* GetVertexVBO(vtkActor* actor)
+{
+  auto mapper = vtkOpenGLPolyDataMapper::SafeDownCast(actor->GetMapper());
+  auto VBOs = mapper ? mapper->GetVBOs() : nullptr;
+  return VBOs ? VBOs->GetVBO("vertexMC") : nullptr;
+}
+
+//------------------------------------------------------------------------------
+/// Uploads the geodesic distance fields to the texture buffer of an actor if
+/// they changed since the last upload and binds it to the contour program.
+/// Called by the mapper right before it draws, when its context is current.
+void OnContourMapperUpdateShader(vtkObject* caller, unsigned long, void* clientData, void* callData)
+{
+  auto shaderProgram = static_cast<vtkShaderProgram*>(callData);
+  auto program = GetContourProgram(static_cast<vtkMRMLModelNode*>(clientData), false);
+  if (!shaderProgram || !program || !shaderProgram->IsUniformUsed("geodesicDistances"))
+    {
+    return;
+    }
+
+  auto viewActor = std::find_if(program->ViewActors.begin(), program->ViewActors.end(),
+    [caller](const ViewActor &entry)
+    {
+    return entry.Mapper == caller;
+    });
+  auto renderer = viewActor != program->ViewActors.end() && viewActor->DisplayableManager ?
+    viewActor->DisplayableManager->GetRenderer() : nullptr;
+  auto renderWindow = renderer ? vtkOpenGLRenderWindow::SafeDownCast(renderer->GetRenderWindow()) : nullptr;
+  if (!renderWindow)
+    {
+    return;
+    }
+
+  if (!viewActor->GeodesicTexture)
+    {
+    viewActor->GeodesicBuffer = vtkSmartPointer<vtkOpenGLBufferObject>::New();
+    viewActor->GeodesicTexture = vtkSmartPointer<vtkTextureObject>::New();
+    viewActor->UploadedGeodesicVersion = 0;
+    }
+
+  if (viewActor->UploadedGeodesicVersion != program->GeodesicVersion)
+    {
+    // A texture is bound even without geodesic contours, so the sampler of
+    // the program never refers to a texture of another type
+    auto geodesicDistances = program->GeodesicDistances.GetPointer();
+    size_t numberOfValues = static_cast<size_t>(geodesicDistances->GetNumberOfValues());
+    float noDistance = 0.0f;
+    const float* values = numberOfValues > 0 ? geodesicDistances->GetPointer(0) : &noDistance;
+    numberOfValues = std::max<size_t>(numberOfValues, 1);
+
+    viewActor->GeodesicTexture->SetContext(renderWindow);
+    viewActor->GeodesicBuffer->Upload(values, numberOfValues, vtkOpenGLBufferObject::TextureBuffer);
+    viewActor->GeodesicTexture->CreateTextureBuffer(
+      static_cast<unsigned int>(numberOfValues), 1, VTK_FLOAT, viewActor->GeodesicBuffer);
+    viewActor->UploadedGeodesicVersion = program->GeodesicVersion;
+    }
+
+  viewActor->GeodesicTexture->Activate();
+  shaderProgram->SetUniformi("geodesicDistances", viewActor->GeodesicTexture->GetTextureUnit());
+  shaderProgram->SetUniformi("geodesicStride", program->GeodesicDistances->GetNumberOfComponents());
+}
+
+//------------------------------------------------------------------------------
+/// Releases the texture units of the geodesic distance fields once a view has
+/// rendered
+void DeactivateGeodesicTextures(vtkMRMLModelDisplayableManager* displayableManager)
+{
+  for (const auto &entry : GetContourPrograms())
+    {
+    for (const auto &viewActor : entry.second->ViewActors)
+      {
+      if (viewActor.DisplayableManager == displayableManager && viewActor.GeodesicTexture &&
+          viewActor.GeodesicTexture->GetContext())
+        {
+        viewActor.GeodesicTexture->Deactivate();
+        }
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+/// Observes the mapper of an actor of the target to bind the geodesic distance
+/// fields
+void ObserveMapper(ContourProgram* program, ViewActor& viewActor)
+{
+  viewActor.Mapper = vtkOpenGLPolyDataMapper::SafeDownCast(viewActor.Actor->GetMapper());
+  if (!viewActor.Mapper)
+    {
+    return;
+    }
+
+  vtkNew<vtkCallbackCommand> updateShaderCallback;
+  updateShaderCallback->SetCallback(OnContourMapperUpdateShader);
+  updateShaderCallback->SetClientData(program->ModelNode.GetPointer());
+  viewActor.UpdateShaderObserverTag =
+    viewActor.Mapper->AddObserver(vtkCommand::UpdateShaderEvent, updateShaderCallback);
+}
+
+//------------------------------------------------------------------------------
+void UnobserveMapper(ViewActor& viewActor)
+{
+  if (viewActor.Mapper)
+    {
+    viewActor.Mapper->RemoveObserver(viewActor.UpdateShaderObserverTag);
+    }
+  viewActor.Mapper = nullptr;
+  viewActor.UpdateShaderObserverTag = 0;
+}
+
+//------------------------------------------------------------------------------
+/// Installs the contour program on an actor of the target. The program is
+/// installed only once per actor, whatever the number of contours, so adding
+/// a contour does not recompile it.
+void InstallContourProgram(vtkActor* actor)
+{
+  auto shaderProperty = actor->GetShaderProperty();
+  auto vertexUniforms = shaderProperty->GetVertexCustomUniforms();
+  if (vertexUniforms->GetUniformTupleType("contourTypes") != vtkUniforms::TupleTypeInvalid)
+    {
+    return;
+    }
+
+  // NOTE: The distance of each vertex to every contour is computed in the
+  // vertex shader and interpolated over the fragments (see
+  // MaximumNumberOfContours). contourParameterA holds the scaled plane
+  // position / sphere center, or the geodesic channel in x; contourParameterB
+  // holds the plane normal divided by the VBO scale / the inverse VBO scale,
+  // so all the distances are in mm. The geodesic distances are fetched from a
+  // texture buffer by vertex id, since the VBO holds one vertex per point.
+  const std::string numberOfContours = std::to_string(MaximumNumberOfContours);
+  shaderProperty->AddVertexShaderReplacement(
+    "//VTK::PositionVC::Dec",
+    true,
+    "//VTK::PositionVC::Dec\n"
+    "uniform samplerBuffer geodesicDistances;\n"
+    "uniform int geodesicStride;\n"
+    "out float contourDistancesVSOutput[" + numberOfContours + "];\n",
+    false
+  );
+
+  shaderProperty->AddVertexShaderReplacement(
+    "//VTK::PositionVC::Impl",
+    true,
+    "//VTK::PositionVC::Impl\n"
+    "for (int i = 0; i < " + numberOfContours + "; ++i)\n"
+    "  {\n"
+    "  vec3 w = vertexMC.xyz - contourParameterA[i].xyz;\n"
+    "  if (contourTypes[i] == 1) contourDistancesVSOutput[i] = dot(contourParameterB[i].xyz, w);\n"
+    "  else if (contourTypes[i] == 2) contourDistancesVSOutput[i] = length(w * contourParameterB[i].xyz);\n"
+    "  else if (contourTypes[i] == 3) contourDistancesVSOutput[i] =\n"
+    "    texelFetch(geodesicDistances, gl_VertexID * geodesicStride + int(contourParameterA[i].x)).r;\n"
+    "  else contourDistancesVSOutput[i] = 0.0;\n"
+    "  }\n",
+    false
+  );
+
+  shaderProperty->AddFragmentShaderReplacement(
+    "//VTK::PositionVC::Dec",
+    true,
+    "//VTK::PositionVC::Dec\n"
+    "in float contourDistancesVSOutput[" + numberOfContours + "];\n",
+    false
+  );
+
+  shaderProperty->AddFragmentShaderReplacement(
+    "//VTK::Color::Impl",
+    true,
+    "//VTK::Color::Impl\n"
+    "  vec3 contourColor= vec3(1.0, 1.0 ,1.0);\n"
+    "  for (int i = 0; i < " + numberOfContours + "; ++i){\n"
+    "    if(contourTypes[i] != 0 && abs(contourDistancesVSOutput[i]-contourValues[i]) < contourThickness){\n"
+    "       ambientColor = contourColor;\n"
+    "       diffuseColor = contourColor;\n"
+    "       opacity = 1.0;\n"
+    "    }\n"
+    "  }\n",
+    false
+  );
+
+  int types[MaximumNumberOfContours] = {vtkSlicerShaderHelper::NoContour};
+  float parameters[MaximumNumberOfContours][4] = {{0.0f}};
+  float values[MaximumNumberOfContours] = {0.0f};
+
+  vertexUniforms->SetUniform1iv("contourTypes", MaximumNumberOfContours, types);
+  vertexUniforms->SetUniform4fv("contourParameterA", MaximumNumberOfContours, parameters);
+  vertexUniforms->SetUniform4fv("contourParameterB", MaximumNumberOfContours, parameters);
+
+  auto fragmentUniforms = shaderProperty->GetFragmentCustomUniforms();
+  fragmentUniforms->SetUniform1iv("contourTypes", MaximumNumberOfContours, types);
+  fragmentUniforms->SetUniform1fv("contourValues", MaximumNumberOfContours, values);
+  fragmentUniforms->SetUniformf("contourThickness", 2.0);
 }
 
 //------------------------------------------------------------------------------
-void vtkSlicerShaderHelper::AttachSlicingContourShader()
+/// Removes the contour program from the actors of the target. Only called once
+/// the last contour of the target has been released.
+void UninstallContourProgram(ContourProgram* program)
 {
-  vtkNew<vtkCollection> propertiesCollection;
-  this->getShaderProperties(propertiesCollection.GetPointer());
+  const char* uniformNames[] = {"contourTypes", "contourParameterA", "contourParameterB"};
+  const char* fragmentUniformNames[] = {"contourTypes", "contourValues", "contourThickness"};
 
-  for(int index=0; index<propertiesCollection->GetNumberOfItems(); ++index)
+  for (const auto &viewActor : program->ViewActors)
     {
-    auto shaderProperty =
-      vtkShaderProperty::SafeDownCast(propertiesCollection->GetItemAsObject(index));
-    if (!shaderProperty)
+    auto actor = viewActor.Actor.GetPointer();
+    if (!actor)
       {
       continue;
       }
 
-    shaderProperty->AddVertexShaderReplacement(
-      "//VTK::PositionVC::Dec",
-      true,
-      "//VTK::PositionVC::Dec\n"
-      "out vec4 vertexMCVSOutput;\n",
-      false
-    );
-
-    shaderProperty->AddVertexShaderReplacement(
-      "//VTK::PositionVC::Impl",
-      true,
-      "//VTK::PositionVC::Impl\n"
-      "vertexMCVSOutput = vertexMC;\n",
-      false
-    );
-
-    shaderProperty->AddFragmentShaderReplacement(
-      "//VTK::PositionVC::Dec",
-      true,
-      "//VTK::PositionVC::Dec\n"
-      "in vec4 vertexMCVSOutput;\n"
-      "vec4 fragPositionMC = vertexMCVSOutput;\n",
-      false
-    );
-
-    shaderProperty->AddFragmentShaderReplacement(
-      "//VTK::Color::Impl",
-      true,
-      "//VTK::Color::Impl\n"
-      "  vec3 contourColor= vec3(1.0, 1.0 ,1.0);\n"
-      "  vec3 w = -(planePositionMC.xyz*fragPositionMC.w - fragPositionMC.xyz);\n"
-      "  float dist = (planeNormalMC.x * w.x + planeNormalMC.y * w.y + planeNormalMC.z * w.z) / sqrt( pow(planeNormalMC.x,2) + pow(planeNormalMC.y,2)+ pow(planeNormalMC.z,2));\n"
-      "  if(abs(dist) < contourThickness && contourVisibility != 0){\n"
-      "     ambientColor = contourColor;\n"
-      "     diffuseColor = contourColor;\n"
-      "     opacity = 1.0;\n"
-      "  }\n",
-      false
-    );
-
-    float position[] = {0.0f, 0.0f, 0.0f, 0.0f};
-    float normal[] = {1.0f, 0.0f, 0.0f, 0.0f};
-
-    auto fragmentUniforms = shaderProperty->GetFragmentCustomUniforms();
-    fragmentUniforms->SetUniform4f("planePositionMC", position);
-    fragmentUniforms->SetUniform4f("planeNormalMC", normal);
-    fragmentUniforms->SetUniformf("contourThickness", 0.05);
-    fragmentUniforms->SetUniformi("contourVisibility", 0);
+    auto shaderProperty = actor->GetShaderProperty();
+    shaderProperty->ClearVertexShaderReplacement("//VTK::PositionVC::Dec", true);
+    shaderProperty->ClearVertexShaderReplacement("//VTK::PositionVC::Impl", true);
+    shaderProperty->ClearFragmentShaderReplacement("//VTK::PositionVC::Dec", true);
+    shaderProperty->ClearFragmentShaderReplacement("//VTK::Color::Impl", true);
+
+    for (auto name : uniformNames)
+      {
+      shaderProperty->GetVertexCustomUniforms()->RemoveUniform(name);
+      }
+    for (auto name : fragmentUniformNames)
+      {
+      shaderProperty->GetFragmentCustomUniforms()->RemoveUniform(name);
+      }
+
     }
+
+  for (auto &viewActor : program->ViewActors)
+    {
+    UnobserveMapper(viewActor);
+    }
+  program->ViewActors.clear();
 }
 
 //------------------------------------------------------------------------------
-void vtkSlicerShaderHelper::AttachDistanceContourShader()
+/// Uploads the contour parameters to an actor of the target if they changed
+/// since the last upload, either because of new parameters (version) or a new
+/// shift and scale of the VBO. Only the uniforms whose values changed are set.
+void UpdateActorUniforms(ContourProgram* program, ViewActor& viewActor)
 {
-  vtkNew<vtkCollection> propertiesCollection;
-  this->getShaderProperties(propertiesCollection.GetPointer());
+  auto actor = viewActor.Actor.GetPointer();
+  if (!actor)
+    {
+    return;
+    }
+
+  // The contour parameters are expressed in the shifted and scaled
+  // coordinates of the VBO of each actor
+  std::vector<double> scale;
+  std::vector<double> shift;
+  auto VBO = GetVertexVBO(actor);
+  if (VBO)
+    {
+    scale = VBO->GetScale();
+    shift = VBO->GetShift();
+    }
+  if (scale.size() != 3 || shift.size() != 3)
+    {
+    scale.assign(3, 1.0);
+    shift.assign(3, 0.0);
+    }
+
+  if (viewActor.UploadedVersion == program->Version &&
+      std::equal(shift.begin(), shift.end(), viewActor.UploadedShift) &&
+      std::equal(scale.begin(), scale.end(), viewActor.UploadedScale))
+    {
+    return;
+    }
+
+  int types[MaximumNumberOfContours] = {vtkSlicerShaderHelper::NoContour};
+  float parametersA[MaximumNumberOfContours][4] = {{0.0f}};
+  float parametersB[MaximumNumberOfContours][4] = {{0.0f}};
+  float values[MaximumNumberOfContours] = {0.0f};
 
-  for(int index=0; index<propertiesCollection->GetNumberOfItems(); ++index)
+  for (int slotIndex = 0; slotIndex < MaximumNumberOfContours; ++slotIndex)
     {
-    auto shaderProperty =
-      vtkShaderProperty::SafeDownCast(propertiesCollection->GetItemAsObject(index));
-    if (!shaderProperty)
+    const auto &slot = program->Slots[slotIndex];
+    if (slot.NumberOfUsers == 0 || !slot.Visible)
       {
       continue;
       }
 
-    shaderProperty->AddVertexShaderReplacement(
-      "//VTK::PositionVC::Dec",
-      true,
-      "//VTK::PositionVC::Dec\n"
-      "out vec4 vertexMCVSOutput;\n",
-      false
-    );
-
-    shaderProperty->AddVertexShaderReplacement(
-      "//VTK::PositionVC::Impl",
-      true,
-      "//VTK::PositionVC::Impl\n"
-      "vertexMCVSOutput = vertexMC;\n",
-      false
-    );
-
-    shaderProperty->AddFragmentShaderReplacement(
-      "//VTK::PositionVC::Dec",
-      true,
-      "//VTK::PositionVC::Dec\n"
-      "in vec4 vertexMCVSOutput;\n"
-      "vec4 fragPositionMC = vertexMCVSOutput;\n",
-      false
-    );
-
-    shaderProperty->AddFragmentShaderReplacement(
-      "//VTK::Color::Impl",
-      true,
-      "//VTK::Color::Impl\n"
-      "  vec3 contourColor= vec3(1.0, 1.0 ,1.0);\n"
-      "  float refDist= distance(externalPointMC, referencePointMC);\n"
-      "  float dist = distance(referencePointMC, fragPositionMC);\n"
-      "  if(abs(dist-refDist) < contourThickness && contourVisibility != 0){\n"
-      "     ambientColor = contourColor;\n"
-      "     diffuseColor = contourColor;\n"
-      "     opacity = 1.0;\n"
-      "  }\n",
-      false
-    );
-
-    float externalPointMC[] = {0.0f, 0.0f, 0.0f, 0.0f};
-    float referencePointMC[] = {0.0f, 0.0f, 0.0f, 0.0f};
-
-    auto fragmentUniforms = shaderProperty->GetFragmentCustomUniforms();
-    fragmentUniforms->SetUniform4f("externalPointMC", externalPointMC);
-    fragmentUniforms->SetUniform4f("referencePointMC", referencePointMC);
-    fragmentUniforms->SetUniformf("contourThickness", 0.05);
-    fragmentUniforms->SetUniformi("contourVisibility", 0);
+    types[slotIndex] = slot.Type;
+    values[slotIndex] = static_cast<float>(slot.Distance);
+    for (int i = 0; i < 3; ++i)
+      {
+      switch (slot.Type)
+        {
+        case vtkSlicerShaderHelper::PlaneContour:
+          parametersA[slotIndex][i] = static_cast<float>((slot.Position[i] - shift[i]) * scale[i]);
+          parametersB[slotIndex][i] = static_cast<float>(slot.Normal[i] / scale[i]);
+          break;
+        case vtkSlicerShaderHelper::SphereContour:
+          parametersA[slotIndex][i] = static_cast<float>((slot.Position[i] - shift[i]) * scale[i]);
+          parametersB[slotIndex][i] = static_cast<float>(1.0 / scale[i]);
+          break;
+        case vtkSlicerShaderHelper::GeodesicContour:
+          parametersA[slotIndex][i] = static_cast<float>(slot.GeodesicChannel);
+          break;
+        default:
+          break;
+        }
+      }
+    }
+
+  auto shaderProperty = actor->GetShaderProperty();
+  auto vertexUniforms = shaderProperty->GetVertexCustomUniforms();
+  auto fragmentUniforms = shaderProperty->GetFragmentCustomUniforms();
+
+  if (!std::equal(types, types + MaximumNumberOfContours, viewActor.Types))
+    {
+    vertexUniforms->SetUniform1iv("contourTypes", MaximumNumberOfContours, types);
+    fragmentUniforms->SetUniform1iv("contourTypes", MaximumNumberOfContours, types);
+    std::copy(types, types + MaximumNumberOfContours, viewActor.Types);
+    }
+
+  if (!std::equal(parametersA[0], parametersA[0] + 4*MaximumNumberOfContours, viewActor.ParametersA[0]))
+    {
+    vertexUniforms->SetUniform4fv("contourParameterA", MaximumNumberOfContours, parametersA);
+    std::copy(parametersA[0], parametersA[0] + 4*MaximumNumberOfContours, viewActor.ParametersA[0]);
     }
+
+  if (!std::equal(parametersB[0], parametersB[0] + 4*MaximumNumberOfContours, viewActor.ParametersB[0]))
+    {
+    vertexUniforms->SetUniform4fv("contourParameterB", MaximumNumberOfContours, parametersB);
+    std::copy(parametersB[0], parametersB[0] + 4*MaximumNumberOfContours, viewActor.ParametersB[0]);
+    }
+
+  if (!std::equal(values, values + MaximumNumberOfContours, viewActor.Values))
+    {
+    fragmentUniforms->SetUniform1fv("contourValues", MaximumNumberOfContours, values);
+    std::copy(values, values + MaximumNumberOfContours, viewActor.Values);
+    }
+
+  viewActor.UploadedVersion = program->Version;
+  std::copy(shift.begin(), shift.end(), viewActor.UploadedShift);
+  std::copy(scale.begin(), scale.end(), viewActor.UploadedScale);
 }
+
 //------------------------------------------------------------------------------
-void vtkSlicerShaderHelper::getShaderProperties(vtkCollection* propertiesCollection)
+/// Looks up the actor of the target in a 3D view, installs the contour program
+/// on it if it is new (view opened or display node recreated) and brings its
+/// uniforms up to date
+void UpdateViewActor(ContourProgram* program, vtkMRMLModelDisplayableManager* displayableManager)
 {
+  auto displayNode = program->ModelNode ? program->ModelNode->GetDisplayNode() : nullptr;
+  if (!displayNode || !displayableManager)
+    {
+    return;
+    }
+
+  auto actor = vtkActor::SafeDownCast(displayableManager->GetActorByID(displayNode->GetID()));
 
-  if (!this->TargetModelNode)
+  auto viewActor = std::find_if(program->ViewActors.begin(), program->ViewActors.end(),
+    [displayableManager](const ViewActor &entry)
     {
-    vtkWarningMacro("Invalid  model node");
+    return entry.DisplayableManager == displayableManager;
+    });
+  if (viewActor == program->ViewActors.end())
+    {
+    program->ViewActors.push_back(ViewActor());
+    viewActor = program->ViewActors.end() - 1;
+    viewActor->DisplayableManager = displayableManager;
+    }
+
+  if (viewActor->Actor == actor)
+    {
+    UpdateActorUniforms(program, *viewActor);
     return;
     }
 
-  if (!propertiesCollection)
+  // The uniforms of a new actor hold the default values set on install
+  UnobserveMapper(*viewActor);
+  *viewActor = ViewActor();
+  viewActor->DisplayableManager = displayableManager;
+  viewActor->Actor = actor;
+  if (!actor)
     {
-    vtkWarningMacro("Invalid  properties collection");
     return;
     }
 
-  auto layoutManager = qSlicerApplication::application()->layoutManager();
+  InstallContourProgram(actor);
+  ObserveMapper(program, *viewActor);
+  UpdateActorUniforms(program, *viewActor);
+}
+
+//------------------------------------------------------------------------------
+/// 3D views the contour programs are installed in. Views are tracked when the
+/// layout changes and the actors of the targets are looked up right before
+/// each view renders, so actors created at any time (including in views
+/// opened mid-session) get the contour program without scanning the layout.
+struct ContourView
+{
+  vtkWeakPointer<vtkMRMLModelDisplayableManager> DisplayableManager;
+  vtkWeakPointer<vtkRenderer> Renderer;
+  unsigned long StartObserverTag = 0;
+  unsigned long EndObserverTag = 0;
+};
+
+struct ContourViews
+{
+  bool Initialized = false;
+  std::vector<ContourView> Views;
+  vtkNew<vtkCallbackCommand> RenderCallback;
+  QPointer<QObject> LayoutContext;
+};
+
+//------------------------------------------------------------------------------
+ContourViews& GetContourViews()
+{
+  static ContourViews contourViews;
+  return contourViews;
+}
+
+//------------------------------------------------------------------------------
+void OnContourViewRender(vtkObject* caller, unsigned long event, void*, void*)
+{
+  auto &contourViews = GetContourViews();
+  for (const auto &view : contourViews.Views)
+    {
+    if (view.Renderer != caller || !view.DisplayableManager)
+      {
+      continue;
+      }
+
+    if (event == vtkCommand::EndEvent)
+      {
+      DeactivateGeodesicTextures(view.DisplayableManager);
+      continue;
+      }
+
+    for (const auto &entry : GetContourPrograms())
+      {
+      UpdateViewActor(entry.second.get(), view.DisplayableManager);
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+/// Tracks the model displayable managers of the 3D views of the layout. Only
+/// called on layout changes.
+void UpdateContourViews()
+{
+  auto &contourViews = GetContourViews();
+
+  // Forget the views that no longer exist
+  for (const auto &view : contourViews.Views)
+    {
+    if (!view.DisplayableManager && view.Renderer)
+      {
+      view.Renderer->RemoveObserver(view.StartObserverTag);
+      view.Renderer->RemoveObserver(view.EndObserverTag);
+      }
+    }
+  contourViews.Views.erase(
+    std::remove_if(contourViews.Views.begin(), contourViews.Views.end(),
+                   [](const ContourView &view) { return !view.DisplayableManager; }),
+    contourViews.Views.end());
+  for (const auto &entry : GetContourPrograms())
+    {
+    auto &viewActors = entry.second->ViewActors;
+    viewActors.erase(
+      std::remove_if(viewActors.begin(), viewActors.end(),
+                     [](const ViewActor &viewActor)
+                     { return !viewActor.DisplayableManager; }),
+      viewActors.end());
+    }
+
+  auto layoutManager = qSlicerApplication::application() ?
+    qSlicerApplication::application()->layoutManager() : nullptr;
   if (!layoutManager)
     {
-    vtkWarningMacro("No valid layout manager");
     return;
     }
 
   for (int threeDViewId = 0; threeDViewId < layoutManager->threeDViewCount(); ++threeDViewId)
     {
-
     auto threeDWidget = layoutManager->threeDWidget(threeDViewId);
     if (!threeDWidget)
       {
@@ -241,61 +688,376 @@ void vtkSlicerShaderHelper::getShaderProperties(vtkCollection* propertiesCollect
 
     for(int index = 0; index < displayableManagers->GetNumberOfItems(); ++index)
       {
-
       auto modelDisplayableManager =
         vtkMRMLModelDisplayableManager::SafeDownCast(displayableManagers->GetItemAsObject(index));
-      if (!modelDisplayableManager)
+      if (!modelDisplayableManager || !modelDisplayableManager->GetRenderer())
         {
         continue;
         }
 
-      auto modelDisplayNode = this->TargetModelNode->GetDisplayNode();
-      if (!modelDisplayNode)
+      auto tracked = std::find_if(contourViews.Views.begin(), contourViews.Views.end(),
+        [modelDisplayableManager](const ContourView &view)
         {
-        continue;
-        }
-      auto modelActor =
-        vtkActor::SafeDownCast(modelDisplayableManager->GetActorByID(modelDisplayNode->GetID()));
-      if (!modelActor)
+        return view.DisplayableManager == modelDisplayableManager;
+        });
+      if (tracked != contourViews.Views.end())
         {
         continue;
         }
 
-      this->TargetModelActors->AddItem(modelActor);
+      ContourView view;
+      view.DisplayableManager = modelDisplayableManager;
+      view.Renderer = modelDisplayableManager->GetRenderer();
+      view.StartObserverTag =
+        view.Renderer->AddObserver(vtkCommand::StartEvent, contourViews.RenderCallback);
+      view.EndObserverTag =
+        view.Renderer->AddObserver(vtkCommand::EndEvent, contourViews.RenderCallback);
+      contourViews.Views.push_back(view);
 
-      auto shaderProperty = modelActor->GetShaderProperty();
-      if (!shaderProperty)
+      for (const auto &entry : GetContourPrograms())
         {
-        continue;
+        UpdateViewActor(entry.second.get(), modelDisplayableManager);
         }
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+void InitializeContourViews()
+{
+  auto &contourViews = GetContourViews();
+  if (contourViews.Initialized)
+    {
+    return;
+    }
 
-      // Cache the shader property
-      propertiesCollection->AddItem(shaderProperty);
+  auto layoutManager = qSlicerApplication::application() ?
+    qSlicerApplication::application()->layoutManager() : nullptr;
+  if (!layoutManager)
+    {
+    return;
+    }
 
-      // NOTE: Query and cache the target model VBOs as they are useful during update in the widget representation
+  contourViews.RenderCallback->SetCallback(OnContourViewRender);
 
-      auto modelMapper =vtkOpenGLPolyDataMapper::SafeDownCast(modelActor->GetMapper());
-      if (!modelMapper)
-        {
-        vtkWarningMacro("Invalid model mapper");
-        continue;
-        }
+  // The context is owned by the layout manager so the connection does not
+  // outlive it
+  contourViews.LayoutContext = new QObject(layoutManager);
+  QObject::connect(layoutManager, &qMRMLLayoutManager::layoutChanged,
+                   contourViews.LayoutContext, [](int) { UpdateContourViews(); });
+
+  contourViews.Initialized = true;
+  UpdateContourViews();
+}
+
+} // end of anonymous namespace
+
+//------------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlicerShaderHelper);
+
+//------------------------------------------------------------------------------
+vtkSlicerShaderHelper::vtkSlicerShaderHelper()
+  :TargetModelNode(nullptr), ContourNode(nullptr), ContourSlot(-1)
+{
+}
+
+//------------------------------------------------------------------------------
+vtkSlicerShaderHelper::~vtkSlicerShaderHelper()
+{
+  this->DetachContourShader();
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerShaderHelper::PrintSelf(ostream& os, vtkIndent indent)
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Target Model Node: "
+     << (this->TargetModelNode ? this->TargetModelNode->GetID() : "(none)") << "\n";
+  os << indent << "Contour Node: "
+     << (this->ContourNode ? this->ContourNode->GetID() : "(none)") << "\n";
+  os << indent << "Contour Slot: " << this->ContourSlot << "\n";
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerShaderHelper::SetTargetModelNode(vtkMRMLModelNode* modelNode)
+{
+  if (modelNode == this->TargetModelNode)
+    {
+    return;
+    }
+
+  this->DetachContourShader();
+  this->TargetModelNode = modelNode;
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerShaderHelper::AttachSlicingContourShader(vtkMRMLNode* contourNode)
+{
+  this->AttachContourShader(contourNode);
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerShaderHelper::AttachDistanceContourShader(vtkMRMLNode* contourNode)
+{
+  this->AttachContourShader(contourNode);
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerShaderHelper::AttachContourShader(vtkMRMLNode* contourNode)
+{
+  if (!contourNode)
+    {
+    vtkWarningMacro("Invalid contour node");
+    return;
+    }
+
+  if (this->ContourSlot >= 0 && contourNode != this->ContourNode)
+    {
+    this->DetachContourShader();
+    }
+
+  auto program = GetContourProgram(this->TargetModelNode, true);
+  if (!program)
+    {
+    vtkWarningMacro("Invalid  model node");
+    return;
+    }
+
+  // Only the views already tracked are looked up, new views are picked up as
+  // the layout changes
+  InitializeContourViews();
+  for (const auto &view : GetContourViews().Views)
+    {
+    UpdateViewActor(program, view.DisplayableManager);
+    }
+
+  if (this->ContourSlot >= 0)
+    {
+    return;
+    }
+
+  // The representations of a contour node in all the views share its slot
+  auto sharedSlot = std::find_if(std::begin(program->Slots), std::end(program->Slots),
+    [contourNode](const ContourParameters &slot)
+    {
+    return slot.NumberOfUsers > 0 && slot.ContourNode == contourNode;
+    });
+  if (sharedSlot == std::end(program->Slots))
+    {
+    sharedSlot = std::find_if(std::begin(program->Slots), std::end(program->Slots),
+      [](const ContourParameters &slot)
+      {
+      return slot.NumberOfUsers == 0;
+      });
+    if (sharedSlot == std::end(program->Slots))
+      {
+      vtkErrorMacro("The maximum number of contours (" << MaximumNumberOfContours
+                    << ") on the target model has been reached, the contour is not shown.");
+      return;
+      }
+    *sharedSlot = ContourParameters();
+    sharedSlot->ContourNode = contourNode;
+    }
+
+  ++sharedSlot->NumberOfUsers;
+  this->ContourNode = contourNode;
+  this->ContourSlot = static_cast<int>(sharedSlot - std::begin(program->Slots));
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerShaderHelper::DetachContourShader()
+{
+  auto program = GetContourProgram(this->TargetModelNode, false);
+  if (program && this->ContourSlot >= 0)
+    {
+    auto &slot = program->Slots[this->ContourSlot];
+    if (--slot.NumberOfUsers == 0)
+      {
+      slot = ContourParameters();
+      }
+
+    // The program is removed along with its last contour
+    if (GetNumberOfUsers(program) == 0)
+      {
+      UninstallContourProgram(program);
+      GetContourPrograms().erase(this->TargetModelNode);
+      }
+    else
+      {
+      this->UpdateUniforms();
+      }
+    }
+
+  this->ContourNode = nullptr;
+  this->ContourSlot = -1;
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerShaderHelper::SetSlicingContour(const double planePosition[3], const double planeNormal[3])
+{
+  auto program = GetContourProgram(this->TargetModelNode, false);
+  if (!program || this->ContourSlot < 0)
+    {
+    return;
+    }
+
+  auto &slot = program->Slots[this->ContourSlot];
+  slot.Type = PlaneContour;
+  std::copy(planePosition, planePosition + 3, slot.Position);
+  std::copy(planeNormal, planeNormal + 3, slot.Normal);
+  slot.Distance = 0.0;
+  slot.GeodesicChannel = -1;
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerShaderHelper::SetDistanceContour(const double referencePoint[3], double distance)
+{
+  auto program = GetContourProgram(this->TargetModelNode, false);
+  if (!program || this->ContourSlot < 0)
+    {
+    return;
+    }
 
-      auto modelVBOs = modelMapper->GetVBOs();
-      if (!modelVBOs)
+  auto &slot = program->Slots[this->ContourSlot];
+  slot.Type = SphereContour;
+  std::copy(referencePoint, referencePoint + 3, slot.Position);
+  slot.Distance = distance;
+  slot.GeodesicChannel = -1;
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerShaderHelper::SetGeodesicDistanceContour(vtkFloatArray* distances, double distance)
+{
+  auto program = GetContourProgram(this->TargetModelNode, false);
+  if (!program || this->ContourSlot < 0 || !distances)
+    {
+    return;
+    }
+
+  auto polyData = program->ModelNode->GetPolyData();
+  if (!polyData || distances->GetNumberOfTuples() != polyData->GetNumberOfPoints())
+    {
+    vtkWarningMacro("Invalid geodesic distances");
+    return;
+    }
+
+  auto &slot = program->Slots[this->ContourSlot];
+
+  // Acquire a component of the geodesic distance fields, the lowest free one.
+  // Each slot holds at most one, so there is always one available.
+  if (slot.GeodesicChannel < 0)
+    {
+    int channel = 0;
+    while (std::any_of(std::begin(program->Slots), std::end(program->Slots),
+                       [channel](const ContourParameters &other)
+                       {
+                       return other.NumberOfUsers > 0 && other.GeodesicChannel == channel;
+                       }))
+      {
+      ++channel;
+      }
+    slot.GeodesicChannel = channel;
+    slot.GeodesicTime = 0;
+    }
+
+  slot.Type = GeodesicContour;
+  slot.Distance = distance;
+
+  auto geodesicDistances = program->GeodesicDistances.GetPointer();
+  vtkIdType numberOfPoints = polyData->GetNumberOfPoints();
+  int numberOfComponents = std::max(geodesicDistances->GetNumberOfComponents(), slot.GeodesicChannel + 1);
+  if (geodesicDistances->GetNumberOfTuples() != numberOfPoints ||
+      geodesicDistances->GetNumberOfComponents() != numberOfComponents)
+    {
+    vtkNew<vtkFloatArray> resizedDistances;
+    resizedDistances->SetNumberOfComponents(numberOfComponents);
+    resizedDistances->SetNumberOfTuples(numberOfPoints);
+    resizedDistances->Fill(0.0);
+
+    // The fields of the other contours are kept as long as the target has the
+    // same vertices
+    if (geodesicDistances->GetNumberOfTuples() == numberOfPoints)
+      {
+      for (vtkIdType pointId = 0; pointId < numberOfPoints; ++pointId)
         {
-        vtkWarningMacro("Invalid model VBOs");
-        continue;
+        for (int component = 0; component < geodesicDistances->GetNumberOfComponents(); ++component)
+          {
+          resizedDistances->SetTypedComponent(pointId, component,
+                                              geodesicDistances->GetTypedComponent(pointId, component));
+          }
         }
-
-      auto modelVertexVBO  = modelVBOs->GetVBO("vertexMC");
-      if (!modelVertexVBO)
+      }
+    else
+      {
+      for (auto &other : program->Slots)
         {
-        vtkWarningMacro("Invalid model vertexMC VBO");
-        continue;
+        other.GeodesicTime = 0;
         }
+      }
 
-      this->TargetModelVertexVBOs->AddItem(modelVertexVBO);
+    geodesicDistances->DeepCopy(resizedDistances);
+    ++program->GeodesicVersion;
+    }
+
+  // The field is only copied (and uploaded) when it has changed
+  if (distances->GetMTime() > slot.GeodesicTime)
+    {
+    for (vtkIdType pointId = 0; pointId < numberOfPoints; ++pointId)
+      {
+      geodesicDistances->SetTypedComponent(pointId, slot.GeodesicChannel, distances->GetValue(pointId));
       }
+    geodesicDistances->Modified();
+    ++program->GeodesicVersion;
+    slot.GeodesicTime = distances->GetMTime();
+    }
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerShaderHelper::SetContour(vtkSurfaceContourExtractor* contourParameters)
+{
+  if (!contourParameters)
+    {
+    return;
+    }
+
+  switch (contourParameters->GetContourType())
+    {
+    case vtkSurfaceContourExtractor::Plane:
+      this->SetSlicingContour(contourParameters->GetOrigin(), contourParameters->GetNormal());
+      break;
+    case vtkSurfaceContourExtractor::Sphere:
+      this->SetDistanceContour(contourParameters->GetOrigin(), contourParameters->GetContourValue());
+      break;
+    case vtkSurfaceContourExtractor::Scalars:
+      this->SetGeodesicDistanceContour(vtkFloatArray::SafeDownCast(contourParameters->GetContourScalars()),
+                                       contourParameters->GetContourValue());
+      break;
+    default:
+      break;
+    }
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerShaderHelper::SetContourVisibility(bool visibility)
+{
+  auto program = GetContourProgram(this->TargetModelNode, false);
+  if (!program || this->ContourSlot < 0)
+    {
+    return;
+    }
+
+  program->Slots[this->ContourSlot].Visible = visibility;
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerShaderHelper::UpdateUniforms()
+{
+  // NOTE: The uniforms are uploaded right before each view renders, so several
+  // updates between two renders cost a single upload
+  auto program = GetContourProgram(this->TargetModelNode, false);
+  if (program)
+    {
+    ++program->Version;
     }
 }
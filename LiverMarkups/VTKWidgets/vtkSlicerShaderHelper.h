@@ -46,17 +46,23 @@
 #include <vtkMRMLModelNode.h>
 
 // VTK includes
-#include <vtkActor.h>
-#include <vtkCollection.h>
 #include <vtkObject.h>
 #include <vtkWeakPointer.h>
 
 //------------------------------------------------------------------------------
-class vtkCollection;
+class vtkFloatArray;
 class vtkMRMLModelNode;
-class vtkShaderProperty;
+class vtkMRMLNode;
+class vtkSurfaceContourExtractor;
 
 //------------------------------------------------------------------------------
+/// The contours on a target model are drawn by a single contour program shared
+/// by all the contour representations of that target. The program evaluates
+/// every contour slot (plane, sphere or geodesic isoline) in one pass using
+/// uniform arrays, so adding a contour neither recompiles the shader nor adds
+/// a render pass. The helpers of a contour node share one slot of the program
+/// of its target (one helper per view); the program is installed with the
+/// first slot and removed with the last one.
 class VTK_SLICER_LIVERMARKUPS_MODULE_VTKWIDGETS_EXPORT vtkSlicerShaderHelper
 : public vtkObject
 {
@@ -65,24 +71,68 @@ public:
   vtkTypeMacro(vtkSlicerShaderHelper, vtkObject);
   void PrintSelf(ostream& os, vtkIndent indent) override;
 
-  void SetTargetModelNode(vtkMRMLModelNode* modelNode){this->TargetModelNode = modelNode;}
+  /// Maximum number of contour nodes shown at once on a target model, whatever
+  /// their type and the number of views. The shader code is generated from it.
+  static const int MaximumNumberOfContours = 16;
+
+  enum ContourTypes
+  {
+    NoContour = 0,
+    PlaneContour,
+    SphereContour,
+    GeodesicContour
+  };
+
+  /// Sets the target model. The contour slot held on the previous target is released.
+  void SetTargetModelNode(vtkMRMLModelNode* modelNode);
   vtkMRMLModelNode* GetTargetModelNode(){return this->TargetModelNode;}
-  vtkCollection* GetTargetModelVertexVBOs(){return this->TargetModelVertexVBOs;}
-  vtkCollection* GetTargetActors(){return this->TargetModelActors;}
-  void AttachSlicingContourShader();
-  void AttachDistanceContourShader();
+
+  /// Installs the shared contour program on the target actors (if needed) and
+  /// acquires the contour slot of the contour node (shared with the helpers
+  /// of the node in the other views). An error is reported when all the slots
+  /// are taken.
+  void AttachSlicingContourShader(vtkMRMLNode* contourNode);
+  void AttachDistanceContourShader(vtkMRMLNode* contourNode);
+
+  /// Releases the contour slot held on the target
+  void DetachContourShader();
+
+  /// Slot of the contour program of the target held by this helper (-1 if none)
+  int GetContourSlot() const {return this->ContourSlot;}
+
+  /// Contour at the intersection of the target with a plane
+  void SetSlicingContour(const double planePosition[3], const double planeNormal[3]);
+
+  /// Contour of the points of the target at a distance from a reference point
+  void SetDistanceContour(const double referencePoint[3], double distance);
+
+  /// Contour of the vertices of the target at a geodesic distance, according
+  /// to a geodesic distance field (one value per vertex of the target). The
+  /// field is copied to the GPU only, the target polydata is not modified.
+  void SetGeodesicDistanceContour(vtkFloatArray* distances, double distance);
+
+  /// Contour of the type and parameters set on a contour extractor (see
+  /// vtkMRMLMarkupsContourNode::UpdateContourExtractor), which is not updated
+  void SetContour(vtkSurfaceContourExtractor* contourParameters);
+
+  void SetContourVisibility(bool visibility);
+
+  /// Requests the parameters of all the contours of the target to be uploaded
+  /// to its actors. The upload happens once, right before each view renders,
+  /// and only the uniforms whose values changed are set.
+  void UpdateUniforms();
 
 protected:
   vtkWeakPointer<vtkMRMLModelNode> TargetModelNode;
-  vtkNew<vtkCollection> TargetModelVertexVBOs;
-  vtkNew<vtkCollection> TargetModelActors;
+  vtkWeakPointer<vtkMRMLNode> ContourNode;
+  int ContourSlot;
 
 protected:
   vtkSlicerShaderHelper();
-  ~vtkSlicerShaderHelper() = default;
+  ~vtkSlicerShaderHelper() override;
 
 private:
-  void getShaderProperties(vtkCollection* propertiesCollection);
+  void AttachContourShader(vtkMRMLNode* contourNode);
 
 private:
   vtkSlicerShaderHelper(const vtkSlicerShaderHelper&) = delete;
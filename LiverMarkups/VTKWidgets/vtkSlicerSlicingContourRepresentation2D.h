@@ -41,15 +41,15 @@
 
 #include "vtkSlicerLiverMarkupsModuleVTKWidgetsExport.h"
 
-// Markups VTKWidgets includes
-#include "vtkSlicerLineRepresentation2D.h"
+// Liver Markups VTKWidgets includes
+#include "vtkSlicerContourRepresentation2D.h"
 
 class VTK_SLICER_LIVERMARKUPS_MODULE_VTKWIDGETS_EXPORT vtkSlicerSlicingContourRepresentation2D
-: public vtkSlicerLineRepresentation2D
+: public vtkSlicerContourRepresentation2D
 {
 public:
   static vtkSlicerSlicingContourRepresentation2D* New();
-  vtkTypeMacro(vtkSlicerSlicingContourRepresentation2D, vtkSlicerLineRepresentation2D);
+  vtkTypeMacro(vtkSlicerSlicingContourRepresentation2D, vtkSlicerContourRepresentation2D);
   void PrintSelf(ostream& os, vtkIndent indent) override;
 
 protected:
@@ -50,12 +50,6 @@
 #include <qSlicerApplication.h>
 #include <qSlicerLayoutManager.h>
 
-// VTK includes
-#include <vtkCollection.h>
-#include <vtkOpenGLVertexBufferObject.h>
-#include <vtkShaderProperty.h>
-#include <vtkUniforms.h>
-
 //------------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerSlicingContourRepresentation3D);
 
@@ -94,78 +88,21 @@ void vtkSlicerSlicingContourRepresentation3D::UpdateFromMRML(vtkMRMLNode* caller
  if (targetModelNode != this->Target)
    {
    this->ShaderHelper->SetTargetModelNode(targetModelNode);
-   this->ShaderHelper->AttachSlicingContourShader();
+   this->ShaderHelper->AttachSlicingContourShader(this->GetMarkupsNode());
    this->Target = targetModelNode;
    }
 
- if (liverMarkupsSlicingContourNode->GetNumberOfControlPoints() != 2)
+ if (!liverMarkupsSlicingContourNode->UpdateContourExtractor(this->ContourParameters))
    {
+   this->ShaderHelper->SetContourVisibility(false);
+   this->ShaderHelper->UpdateUniforms();
    return;
    }
 
- // Recalculate the middle plane and update the shader parameters
- double point1Position[3] = {1.0f};
- double point2Position[3] = {1.0f};
-
- liverMarkupsSlicingContourNode->GetNthControlPointPosition(0, point1Position);
- liverMarkupsSlicingContourNode->GetNthControlPointPosition(1, point2Position);
-
- float middlePointPosition[3] = {
-   static_cast<float>(point2Position[0] + point1Position[0]) / 2.0f,
-   static_cast<float>(point2Position[1] + point1Position[1]) / 2.0f,
-   static_cast<float>(point2Position[2] + point1Position[2]) / 2.0f
- };
-
- float planeNormal[4] = {
-   static_cast<float>(point2Position[0] - point1Position[0]),
-   static_cast<float>(point2Position[1] - point1Position[1]),
-   static_cast<float>(point2Position[2] - point1Position[2]),
-   1.0f
- };
-
- float planeNormalNorm = vtkMath::Normalize(planeNormal);
- planeNormal[0] /= planeNormalNorm;
- planeNormal[1] /= planeNormalNorm;
- planeNormal[2] /= planeNormalNorm;
-
- auto VBOs = this->ShaderHelper->GetTargetModelVertexVBOs();
- auto actors = this->ShaderHelper->GetTargetActors();
-
- for(int index = 0; index < VBOs->GetNumberOfItems(); ++index)
-   {
-   auto VBO = vtkOpenGLVertexBufferObject::SafeDownCast(VBOs->GetItemAsObject(index));
-   if(!VBO)
-     {
-     vtkErrorMacro("Error: could not retrieve vtkOpenGLVertexBufferObject");
-     return;
-     }
-
-   VBO->SetCoordShiftAndScaleMethod(vtkOpenGLVertexBufferObject::AUTO_SHIFT_SCALE);
-   auto scale = VBO->GetScale();
-   auto shift = VBO->GetShift();
-
-   if (scale.size() != 3  || shift.size() != 3)
-     {
-     scale.clear();
-     scale.push_back(1.0f);scale.push_back(1.0f);scale.push_back(1.0f);
-     shift.clear();
-     shift.push_back(0.0f);shift.push_back(0.0f);shift.push_back(0.0f);
-     return;
-     }
-
-   float middlePointPositionScaled[4] = {
-     (middlePointPosition[0] - shift[0]) * scale[0],
-     (middlePointPosition[1] - shift[1]) * scale[1],
-     (middlePointPosition[2] - shift[2]) * scale[2],
-     1.0f};
-
-   auto actor = vtkActor::SafeDownCast(this->ShaderHelper->GetTargetActors()->GetItemAsObject(index));
-   auto fragmentUniforms = actor->GetShaderProperty()->GetFragmentCustomUniforms();
-   fragmentUniforms->SetUniform4f("planePositionMC", middlePointPositionScaled);
-   fragmentUniforms->SetUniform4f("planeNormalMC", planeNormal);
-   fragmentUniforms->SetUniformf("contourThickness", 2.0f*(scale[0]+scale[1])/2.0f);
-   fragmentUniforms->SetUniformi("contourVisibility", 1);
-   }
+ // The contour itself is computed in the shader
+ this->ShaderHelper->SetContour(this->ContourParameters);
+ this->ShaderHelper->SetContourVisibility(true);
+ this->ShaderHelper->UpdateUniforms();
 
  this->NeedToRenderOn();
 }
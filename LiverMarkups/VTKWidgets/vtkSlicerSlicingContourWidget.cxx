@@ -40,14 +40,12 @@
 #include "vtkSlicerSlicingContourWidget.h"
 
 // Liver Markups VTKWidgets include
+#include "vtkSlicerSlicingContourRepresentation2D.h"
 #include "vtkSlicerSlicingContourRepresentation3D.h"
 
 // VTK includes
 #include <vtkObjectFactory.h>
 
-// Markups VTKWidgets includes
-#include <vtkSlicerLineRepresentation2D.h>
-
 //------------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerSlicingContourWidget);
 
@@ -68,7 +66,7 @@ void vtkSlicerSlicingContourWidget::CreateDefaultRepresentation(vtkMRMLMarkupsDi
   vtkSmartPointer<vtkSlicerMarkupsWidgetRepresentation> rep = nullptr;
   if (vtkMRMLSliceNode::SafeDownCast(viewNode))
     {
-    rep = vtkSmartPointer<vtkSlicerLineRepresentation2D>::New();
+    rep = vtkSmartPointer<vtkSlicerSlicingContourRepresentation2D>::New();
     }
   else
     {
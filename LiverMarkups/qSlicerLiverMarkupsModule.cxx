@@ -41,6 +41,7 @@
 
 // MRML includes
 #include "vtkMRMLMarkupsBezierSurfaceNode.h"
+#include "vtkMRMLMarkupsMultiPatchBezierSurfaceNode.h"
 #include "vtkMRMLMarkupsSlicingContourNode.h"
 #include "vtkMRMLMarkupsDistanceContourNode.h"
 
@@ -60,6 +61,7 @@
 #include "vtkSlicerSlicingContourWidget.h"
 #include "vtkSlicerDistanceContourWidget.h"
 #include "vtkSlicerBezierSurfaceWidget.h"
+#include "vtkSlicerMultiPatchBezierSurfaceWidget.h"
 
 #include <qSlicerModuleManager.h>
 #include <qSlicerCoreApplication.h>
@@ -173,6 +175,10 @@ void qSlicerLiverMarkupsModule::setup()
  vtkNew<vtkSlicerBezierSurfaceWidget> bezierSurfaceWidget;
  markupsLogic->RegisterMarkupsNode(bezierSurfaceNode, bezierSurfaceWidget);
 
+ vtkNew<vtkMRMLMarkupsMultiPatchBezierSurfaceNode> multiPatchBezierSurfaceNode;
+ vtkNew<vtkSlicerMultiPatchBezierSurfaceWidget> multiPatchBezierSurfaceWidget;
+ markupsLogic->RegisterMarkupsNode(multiPatchBezierSurfaceNode, multiPatchBezierSurfaceWidget);
+
  // qSlicerModuleManager* moduleManager = qSlicerCoreApplication::application()->moduleManager();
  // if (!moduleManager)
  //   {
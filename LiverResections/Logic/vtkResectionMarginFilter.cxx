@@ -0,0 +1,319 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (The Intervention Centre,
+  Oslo University Hospital) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#include "vtkResectionMarginFilter.h"
+
+// VTK includes
+#include <vtkDoubleArray.h>
+#include <vtkGenericCell.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSMPThreadLocalObject.h>
+#include <vtkSMPTools.h>
+#include <vtkSmartPointer.h>
+#include <vtkStaticCellLocator.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+//------------------------------------------------------------------------------
+class vtkResectionMarginFilter::vtkInternal
+{
+public:
+  struct Tumor
+  {
+    vtkSmartPointer<vtkPolyData> PolyData;
+    vtkSmartPointer<vtkStaticCellLocator> Locator;
+    vtkMTimeType LocatorTime;
+  };
+
+  /// Builds the locators of the new or modified tumors. Returns whether any
+  /// locator was built.
+  bool UpdateLocators()
+  {
+    bool built = false;
+    for (auto &tumor : this->Tumors)
+      {
+      if (tumor.Locator && tumor.LocatorTime == tumor.PolyData->GetMTime())
+        {
+        continue;
+        }
+
+      tumor.Locator = vtkSmartPointer<vtkStaticCellLocator>::New();
+      tumor.Locator->SetDataSet(tumor.PolyData);
+      tumor.Locator->BuildLocator();
+      tumor.LocatorTime = tumor.PolyData->GetMTime();
+      built = true;
+      }
+    return built;
+  }
+
+  /// Squared distance to the closest tumor, searched within the given
+  /// radius when it is finite. Returns VTK_DOUBLE_MAX if nothing is found.
+  double ClosestDistance2(double x[3], double radius, vtkGenericCell *cell) const
+  {
+    double closestDistance2 = VTK_DOUBLE_MAX;
+    for (const auto &tumor : this->Tumors)
+      {
+      double closestPoint[3], distance2;
+      vtkIdType cellId;
+      int subId;
+      if (radius < VTK_DOUBLE_MAX)
+        {
+        double searchRadius = std::min(radius, std::sqrt(closestDistance2));
+        if (!tumor.Locator->FindClosestPointWithinRadius(x, searchRadius, closestPoint, cell,
+                                                         cellId, subId, distance2))
+          {
+          continue;
+          }
+        }
+      else
+        {
+        tumor.Locator->FindClosestPoint(x, closestPoint, cell, cellId, subId, distance2);
+        }
+      closestDistance2 = std::min(closestDistance2, distance2);
+      }
+    return closestDistance2;
+  }
+
+  /// Whether the tumors are the ones of the last update
+  bool SameTumors() const
+  {
+    if (this->Tumors.size() != this->MarginTumors.size())
+      {
+      return false;
+      }
+    for (size_t i=0; i<this->Tumors.size(); i++)
+      {
+      if (this->Tumors[i].PolyData.GetPointer() != this->MarginTumors[i])
+        {
+        return false;
+        }
+      }
+    return true;
+  }
+
+public:
+  std::vector<Tumor> Tumors;
+
+  // Tumors removed since the last update, whose locators are reused if they
+  // are added again
+  std::vector<Tumor> RemovedTumors;
+
+  // Tumors of the last update
+  std::vector<vtkPolyData*> MarginTumors;
+
+  // Input points and margins of the last update
+  std::vector<double> Points;
+  std::vector<double> Margins;
+};
+
+//------------------------------------------------------------------------------
+vtkStandardNewMacro(vtkResectionMarginFilter);
+
+//------------------------------------------------------------------------------
+vtkResectionMarginFilter::vtkResectionMarginFilter()
+  :MinimumMargin(VTK_DOUBLE_MAX), Internal(new vtkInternal)
+{
+}
+
+//------------------------------------------------------------------------------
+vtkResectionMarginFilter::~vtkResectionMarginFilter()
+{
+  delete this->Internal;
+}
+
+//------------------------------------------------------------------------------
+void vtkResectionMarginFilter::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "Number Of Tumors: " << this->GetNumberOfTumors() << "\n";
+  os << indent << "Minimum Margin: " << this->MinimumMargin << "\n";
+}
+
+//------------------------------------------------------------------------------
+void vtkResectionMarginFilter::AddTumor(vtkPolyData *tumor)
+{
+  if (!tumor)
+    {
+    return;
+    }
+
+  std::vector<vtkInternal::Tumor> &removedTumors = this->Internal->RemovedTumors;
+  auto removed = std::find_if(removedTumors.begin(), removedTumors.end(),
+    [tumor](const vtkInternal::Tumor &entry) {return entry.PolyData.GetPointer() == tumor;});
+  if (removed != removedTumors.end())
+    {
+    this->Internal->Tumors.push_back(*removed);
+    removedTumors.erase(removed);
+    }
+  else
+    {
+    vtkInternal::Tumor entry;
+    entry.PolyData = tumor;
+    entry.LocatorTime = 0;
+    this->Internal->Tumors.push_back(entry);
+    }
+  this->Modified();
+}
+
+//------------------------------------------------------------------------------
+void vtkResectionMarginFilter::RemoveAllTumors()
+{
+  if (this->Internal->Tumors.empty())
+    {
+    return;
+    }
+
+  this->Internal->RemovedTumors.insert(this->Internal->RemovedTumors.end(),
+                                       this->Internal->Tumors.begin(), this->Internal->Tumors.end());
+  this->Internal->Tumors.clear();
+  this->Modified();
+}
+
+//------------------------------------------------------------------------------
+int vtkResectionMarginFilter::GetNumberOfTumors() const
+{
+  return static_cast<int>(this->Internal->Tumors.size());
+}
+
+//------------------------------------------------------------------------------
+int vtkResectionMarginFilter::RequestData(vtkInformation *vtkNotUsed(request),
+                                          vtkInformationVector **inputVector,
+                                          vtkInformationVector *outputVector)
+{
+  vtkPolyData *input = vtkPolyData::GetData(inputVector[0]);
+  vtkPolyData *output = vtkPolyData::GetData(outputVector);
+  if (!input || !output)
+    {
+    return 1;
+    }
+
+  output->ShallowCopy(input);
+  this->MinimumMargin = VTK_DOUBLE_MAX;
+
+  vtkInternal *internal = this->Internal;
+  vtkIdType numberOfPoints = input->GetNumberOfPoints();
+  if (internal->Tumors.empty() || numberOfPoints == 0)
+    {
+    internal->Points.clear();
+    internal->Margins.clear();
+    return 1;
+    }
+
+  // The previous margins are only valid for the same tumors and vertices
+  bool locatorsBuilt = internal->UpdateLocators();
+  bool incremental = !locatorsBuilt && internal->SameTumors() &&
+    internal->Margins.size() == static_cast<size_t>(numberOfPoints);
+  internal->RemovedTumors.clear();
+  internal->MarginTumors.clear();
+  for (const auto &tumor : internal->Tumors)
+    {
+    internal->MarginTumors.push_back(tumor.PolyData);
+    }
+  if (!incremental)
+    {
+    internal->Points.assign(3*numberOfPoints, 0.0);
+    internal->Margins.assign(numberOfPoints, VTK_DOUBLE_MAX);
+    }
+
+  vtkNew<vtkDoubleArray> margins;
+  margins->SetName("ResectionMargin");
+  margins->SetNumberOfComponents(1);
+  margins->SetNumberOfTuples(numberOfPoints);
+
+  // NOTE: The queries taking a generic cell can run concurrently once the
+  // locators are built.
+  vtkPoints *points = input->GetPoints();
+  vtkSMPThreadLocalObject<vtkGenericCell> cells;
+  vtkSMPTools::For(0, numberOfPoints,
+    [&](vtkIdType begin, vtkIdType end)
+    {
+    vtkGenericCell *cell = cells.Local();
+    for (vtkIdType pointId=begin; pointId<end; pointId++)
+      {
+      double point[3];
+      points->GetPoint(pointId, point);
+      double *previousPoint = &internal->Points[3*pointId];
+      double &margin = internal->Margins[pointId];
+
+      // The margin changes at most by the displacement of the vertex
+      double radius = VTK_DOUBLE_MAX;
+      if (incremental)
+        {
+        double displacement = std::sqrt(vtkMath::Distance2BetweenPoints(point, previousPoint));
+        if (displacement == 0.0)
+          {
+          margins->SetValue(pointId, margin);
+          continue;
+          }
+        radius = (margin + displacement)*(1.0 + 1e-9) + 1e-9;
+        }
+
+      double distance2 = internal->ClosestDistance2(point, radius, cell);
+      if (distance2 == VTK_DOUBLE_MAX)
+        {
+        distance2 = internal->ClosestDistance2(point, VTK_DOUBLE_MAX, cell);
+        }
+
+      margin = std::sqrt(distance2);
+      std::copy(point, point+3, previousPoint);
+      margins->SetValue(pointId, margin);
+      }
+    });
+
+  for (vtkIdType pointId=0; pointId<numberOfPoints; pointId++)
+    {
+    this->MinimumMargin = std::min(this->MinimumMargin, internal->Margins[pointId]);
+    }
+
+  output->GetPointData()->AddArray(margins);
+  output->GetPointData()->SetActiveScalars(margins->GetName());
+
+  return 1;
+}
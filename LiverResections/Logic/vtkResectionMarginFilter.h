@@ -0,0 +1,97 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (The Intervention Centre,
+  Oslo University Hospital) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#ifndef __vtkresectionmarginfilter_h_
+#define __vtkresectionmarginfilter_h_
+
+#include "vtkSlicerLiverResectionsModuleLogicExport.h"
+
+// VTK includes
+#include <vtkPolyDataAlgorithm.h>
+
+//------------------------------------------------------------------------------
+class vtkPolyData;
+
+//------------------------------------------------------------------------------
+/// Resection margin map: distance from every vertex of the input surface
+/// (e.g. the tessellation of a resection surface) to the closest tumor
+/// surface, stored as the "ResectionMargin" point scalars of the output.
+///
+/// A static cell locator is built once per tumor (and rebuilt only when the
+/// tumor is modified) and queried in parallel. When the input keeps the same
+/// number of points, the update is incremental: vertices that did not move
+/// keep their margin and the closest point search of the others is bounded
+/// by their previous margin plus their displacement.
+class VTK_SLICER_LIVERRESECTIONS_MODULE_LOGIC_EXPORT vtkResectionMarginFilter
+: public vtkPolyDataAlgorithm
+{
+public:
+  static vtkResectionMarginFilter* New();
+  vtkTypeMacro(vtkResectionMarginFilter, vtkPolyDataAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Tumor surfaces the margins are computed to. The locators of the tumors
+  /// added back after RemoveAllTumors (before the next update) are reused.
+  void AddTumor(vtkPolyData *tumor);
+  void RemoveAllTumors();
+  int GetNumberOfTumors() const;
+
+  /// Smallest margin over the vertices of the last update (VTK_DOUBLE_MAX
+  /// without tumors)
+  vtkGetMacro(MinimumMargin, double);
+
+protected:
+  vtkResectionMarginFilter();
+  ~vtkResectionMarginFilter() override;
+
+  int RequestData(vtkInformation *, vtkInformationVector **, vtkInformationVector *) override;
+
+protected:
+  double MinimumMargin;
+
+private:
+  class vtkInternal;
+  vtkInternal* Internal;
+
+private:
+  vtkResectionMarginFilter(const vtkResectionMarginFilter&) = delete;
+  void operator=(const vtkResectionMarginFilter&) = delete;
+};
+
+#endif // __vtkresectionmarginfilter_h_
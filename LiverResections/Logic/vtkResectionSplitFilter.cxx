@@ -0,0 +1,1200 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (The Intervention Centre,
+  Oslo University Hospital) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#include "vtkResectionSplitFilter.h"
+
+// Liver Markups VTKAlgorithms includes
+#include <vtkBezierSurfaceSource.h>
+
+// VTK includes
+#include <vtkAbstractCellLocator.h>
+#include <vtkCellArray.h>
+#include <vtkDataArray.h>
+#include <vtkGenericCell.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSMPThreadLocalObject.h>
+#include <vtkSMPTools.h>
+#include <vtkSmartPointer.h>
+#include <vtkStaticCellLocator.h>
+
+// STD includes
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+typedef std::array<vtkIdType, 3> Triangle;
+
+//------------------------------------------------------------------------------
+// Distance (in grid spacings) below which the grid points are considered too
+// close to the cut loops. It is larger than half the diagonal of a grid cell,
+// so no loop enters a cell whose corners are all kept.
+const double LoopMargin = 0.75;
+
+//------------------------------------------------------------------------------
+// Triangles of the input, false if it has other cells
+bool GetTriangles(vtkPolyData *polyData, std::vector<Triangle> &triangles)
+{
+  vtkCellArray *polys = polyData->GetPolys();
+  if (!polys || polyData->GetNumberOfCells() != polys->GetNumberOfCells())
+    {
+    return false;
+    }
+
+  triangles.reserve(polys->GetNumberOfCells());
+  vtkIdType numberOfPoints;
+  const vtkIdType *pointIds;
+  for (polys->InitTraversal(); polys->GetNextCell(numberOfPoints, pointIds);)
+    {
+    if (numberOfPoints != 3)
+      {
+      return false;
+      }
+    triangles.push_back({{pointIds[0], pointIds[1], pointIds[2]}});
+    }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Clipping of the triangles at the zero level of the signed distances into
+// the positive (0) and negative (1) sides. Every cut edge gets a single point
+// and every clipped triangle contributes one segment of the cut, oriented
+// like the boundary of a cap along the surface normal.
+void ClipTriangles(vtkDataArray *signedDistances, const std::vector<Triangle> &triangles,
+                   vtkPoints *points, std::vector<Triangle> sides[2],
+                   std::map<vtkIdType, vtkIdType> &cutSegments)
+{
+  std::map<std::pair<vtkIdType, vtkIdType>, vtkIdType> cutPoints;
+  auto cutPoint = [&](vtkIdType first, vtkIdType second)
+    {
+    auto edge = std::make_pair(std::min(first, second), std::max(first, second));
+    auto found = cutPoints.find(edge);
+    if (found != cutPoints.end())
+      {
+      return found->second;
+      }
+
+    double firstDistance = signedDistances->GetTuple1(edge.first);
+    double secondDistance = signedDistances->GetTuple1(edge.second);
+    double t = firstDistance / (firstDistance - secondDistance);
+    double firstPoint[3], secondPoint[3], point[3];
+    points->GetPoint(edge.first, firstPoint);
+    points->GetPoint(edge.second, secondPoint);
+    for (int k=0; k<3; k++)
+      {
+      point[k] = firstPoint[k] + t*(secondPoint[k] - firstPoint[k]);
+      }
+    vtkIdType pointId = points->InsertNextPoint(point);
+    cutPoints[edge] = pointId;
+    return pointId;
+    };
+
+  for (const auto &triangle : triangles)
+    {
+    bool positive[3];
+    for (int k=0; k<3; k++)
+      {
+      positive[k] = signedDistances->GetTuple1(triangle[k]) > 0.0;
+      }
+    if (positive[0] == positive[1] && positive[1] == positive[2])
+      {
+      sides[positive[0] ? 0 : 1].push_back(triangle);
+      continue;
+      }
+
+    // The vertex alone on its side is a, the triangle being (a, b, c)
+    int k = positive[0] != positive[1] && positive[0] != positive[2] ? 0 :
+      (positive[1] != positive[0] && positive[1] != positive[2] ? 1 : 2);
+    vtkIdType a = triangle[k], b = triangle[(k+1)%3], c = triangle[(k+2)%3];
+    vtkIdType ab = cutPoint(a, b);
+    vtkIdType ca = cutPoint(c, a);
+
+    int side = positive[k] ? 0 : 1;
+    sides[side].push_back({{a, ab, ca}});
+    sides[1-side].push_back({{ab, b, c}});
+    sides[1-side].push_back({{ab, c, ca}});
+
+    // The cap boundary goes from where the triangle leaves the positive side
+    // to where it enters it again
+    if (positive[k])
+      {
+      cutSegments[ab] = ca;
+      }
+    else
+      {
+      cutSegments[ca] = ab;
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Closed loops of the cut segments. Chains that do not close (at holes of
+// the input) are dropped.
+void GetCutLoops(const std::map<vtkIdType, vtkIdType> &cutSegments,
+                 std::vector<std::vector<vtkIdType> > &loops)
+{
+  std::map<vtkIdType, bool> visited;
+  for (const auto &segment : cutSegments)
+    {
+    if (visited[segment.first])
+      {
+      continue;
+      }
+
+    std::vector<vtkIdType> loop;
+    vtkIdType pointId = segment.first;
+    bool closed = false;
+    while (!visited[pointId])
+      {
+      visited[pointId] = true;
+      loop.push_back(pointId);
+      auto next = cutSegments.find(pointId);
+      if (next == cutSegments.end())
+        {
+        break;
+        }
+      pointId = next->second;
+      closed = pointId == segment.first;
+      }
+
+    if (closed && loop.size() >= 3)
+      {
+      loops.push_back(loop);
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+// Inside test of points by the angle-weighted pseudo-normal at their closest
+// point of a closed triangle mesh: the face normal in the interior of a
+// triangle, the sum of the normals of the two triangles at an edge and the
+// sum of the normals of the incident triangles weighted by their angle at a
+// vertex. Unlike the normal of the closest triangle, its sign is the side of
+// the point wherever the closest point is. Only the triangles around every
+// vertex are precomputed, the normals are computed when queried.
+class PseudoNormals
+{
+public:
+  PseudoNormals(vtkPoints *points, const std::vector<Triangle> &triangles)
+    :Points(points), Triangles(triangles)
+  {
+    vtkIdType numberOfPoints = points->GetNumberOfPoints();
+    this->LinkOffsets.assign(numberOfPoints+1, 0);
+    for (const auto &triangle : triangles)
+      {
+      for (vtkIdType pointId : triangle)
+        {
+        this->LinkOffsets[pointId+1]++;
+        }
+      }
+    for (vtkIdType pointId=0; pointId<numberOfPoints; pointId++)
+      {
+      this->LinkOffsets[pointId+1] += this->LinkOffsets[pointId];
+      }
+    this->Links.resize(this->LinkOffsets[numberOfPoints]);
+    std::vector<vtkIdType> filled(this->LinkOffsets.begin(), this->LinkOffsets.end()-1);
+    for (size_t triangleId=0; triangleId<triangles.size(); triangleId++)
+      {
+      for (vtkIdType pointId : triangles[triangleId])
+        {
+        this->Links[filled[pointId]++] = static_cast<vtkIdType>(triangleId);
+        }
+      }
+  }
+
+  /// Whether a point is inside the mesh, given its closest point on a triangle
+  bool IsInside(const double point[3], const double closestPoint[3], vtkIdType triangleId) const
+  {
+    const Triangle &triangle = this->Triangles[triangleId];
+    double corners[3][3];
+    for (int k=0; k<3; k++)
+      {
+      this->Points->GetPoint(triangle[k], corners[k]);
+      }
+
+    // Barycentric coordinates of the closest point tell whether it is on a
+    // vertex, an edge or in the interior of the triangle
+    double first[3], second[3], offset[3];
+    vtkMath::Subtract(corners[1], corners[0], first);
+    vtkMath::Subtract(corners[2], corners[0], second);
+    vtkMath::Subtract(closestPoint, corners[0], offset);
+    double d00 = vtkMath::Dot(first, first);
+    double d01 = vtkMath::Dot(first, second);
+    double d11 = vtkMath::Dot(second, second);
+    double d20 = vtkMath::Dot(offset, first);
+    double d21 = vtkMath::Dot(offset, second);
+    double denominator = d00*d11 - d01*d01;
+
+    double barycentric[3] = {1.0, 0.0, 0.0};
+    if (denominator > 0.0)
+      {
+      barycentric[1] = (d11*d20 - d01*d21) / denominator;
+      barycentric[2] = (d00*d21 - d01*d20) / denominator;
+      barycentric[0] = 1.0 - barycentric[1] - barycentric[2];
+      }
+
+    const double tolerance = 1e-6;
+    int numberOfZeros = 0;
+    int zero = 0;
+    for (int k=0; k<3; k++)
+      {
+      if (barycentric[k] < tolerance)
+        {
+        numberOfZeros++;
+        zero = k;
+        }
+      }
+
+    double normal[3] = {0.0, 0.0, 0.0};
+    if (numberOfZeros >= 2 || denominator <= 0.0)
+      {
+      int vertex = static_cast<int>(std::max_element(barycentric, barycentric+3) - barycentric);
+      this->AddVertexNormal(triangle[vertex], normal);
+      }
+    else if (numberOfZeros == 1)
+      {
+      this->AddEdgeNormal(triangle[(zero+1)%3], triangle[(zero+2)%3], normal);
+      }
+    else
+      {
+      this->AddFaceNormal(triangleId, -1, normal);
+      }
+
+    vtkMath::Subtract(point, closestPoint, offset);
+    return vtkMath::Dot(offset, normal) < 0.0;
+  }
+
+private:
+  // Adds the unit normal of a triangle, weighted by its angle at one of its
+  // vertices (unless the vertex is -1)
+  void AddFaceNormal(vtkIdType triangleId, vtkIdType vertex, double normal[3]) const
+  {
+    const Triangle &triangle = this->Triangles[triangleId];
+    int k = 0;
+    while (k < 2 && triangle[k] != vertex)
+      {
+      k++;
+      }
+
+    double corner[3], first[3], second[3], faceNormal[3];
+    this->Points->GetPoint(triangle[k], corner);
+    this->Points->GetPoint(triangle[(k+1)%3], first);
+    this->Points->GetPoint(triangle[(k+2)%3], second);
+    vtkMath::Subtract(first, corner, first);
+    vtkMath::Subtract(second, corner, second);
+    vtkMath::Cross(first, second, faceNormal);
+    vtkMath::Normalize(faceNormal);
+
+    double weight = 1.0;
+    if (vertex >= 0)
+      {
+      vtkMath::Normalize(first);
+      vtkMath::Normalize(second);
+      weight = std::acos(std::max(-1.0, std::min(1.0, vtkMath::Dot(first, second))));
+      }
+    for (int d=0; d<3; d++)
+      {
+      normal[d] += weight*faceNormal[d];
+      }
+  }
+
+  void AddVertexNormal(vtkIdType vertex, double normal[3]) const
+  {
+    for (vtkIdType link=this->LinkOffsets[vertex]; link<this->LinkOffsets[vertex+1]; link++)
+      {
+      this->AddFaceNormal(this->Links[link], vertex, normal);
+      }
+  }
+
+  void AddEdgeNormal(vtkIdType first, vtkIdType second, double normal[3]) const
+  {
+    for (vtkIdType link=this->LinkOffsets[first]; link<this->LinkOffsets[first+1]; link++)
+      {
+      const Triangle &triangle = this->Triangles[this->Links[link]];
+      if (std::find(triangle.begin(), triangle.end(), second) != triangle.end())
+        {
+        this->AddFaceNormal(this->Links[link], -1, normal);
+        }
+      }
+  }
+
+private:
+  vtkPoints *Points;
+  const std::vector<Triangle> &Triangles;
+  std::vector<vtkIdType> LinkOffsets;
+  std::vector<vtkIdType> Links;
+};
+
+//------------------------------------------------------------------------------
+// Point of the cap in the parameter domain of the surface, scaled so that
+// the grid points have integer coordinates
+struct CapPoint
+{
+  vtkIdType PointId;
+  double S;
+  double T;
+};
+
+//------------------------------------------------------------------------------
+// Twice the signed area of the triangle (a, b, c), positive if counterclockwise
+double Orientation(const CapPoint &a, const CapPoint &b, const CapPoint &c)
+{
+  return (b.S - a.S)*(c.T - a.T) - (b.T - a.T)*(c.S - a.S);
+}
+
+//------------------------------------------------------------------------------
+double SignedArea(const std::vector<CapPoint> &points, const std::vector<int> &polygon)
+{
+  double area = 0.0;
+  for (size_t i=0; i<polygon.size(); i++)
+    {
+    const CapPoint &a = points[polygon[i]];
+    const CapPoint &b = points[polygon[(i+1) % polygon.size()]];
+    area += a.S*b.T - b.S*a.T;
+    }
+  return 0.5*area;
+}
+
+//------------------------------------------------------------------------------
+// Even-odd test of a point against a polygon
+bool Contains(const std::vector<CapPoint> &points, const std::vector<int> &polygon, const CapPoint &point)
+{
+  bool inside = false;
+  for (size_t i=0; i<polygon.size(); i++)
+    {
+    const CapPoint &a = points[polygon[i]];
+    const CapPoint &b = points[polygon[(i+1) % polygon.size()]];
+    if ((a.T > point.T) != (b.T > point.T) &&
+        point.S < a.S + (point.T - a.T)*(b.S - a.S)/(b.T - a.T))
+      {
+      inside = !inside;
+      }
+    }
+  return inside;
+}
+
+//------------------------------------------------------------------------------
+// Whether the segments p1-p2 and q1-q2 intersect or touch
+bool Intersect(const CapPoint &p1, const CapPoint &p2, const CapPoint &q1, const CapPoint &q2)
+{
+  double o1 = Orientation(q1, q2, p1);
+  double o2 = Orientation(q1, q2, p2);
+  double o3 = Orientation(p1, p2, q1);
+  double o4 = Orientation(p1, p2, q2);
+  if (((o1 > 0.0 && o2 < 0.0) || (o1 < 0.0 && o2 > 0.0)) &&
+      ((o3 > 0.0 && o4 < 0.0) || (o3 < 0.0 && o4 > 0.0)))
+    {
+    return true;
+    }
+
+  auto within = [](const CapPoint &a, const CapPoint &b, const CapPoint &p)
+    {
+    return std::min(a.S, b.S) <= p.S && p.S <= std::max(a.S, b.S) &&
+      std::min(a.T, b.T) <= p.T && p.T <= std::max(a.T, b.T);
+    };
+  return (o1 == 0.0 && within(q1, q2, p1)) || (o2 == 0.0 && within(q1, q2, p2)) ||
+    (o3 == 0.0 && within(p1, p2, q1)) || (o4 == 0.0 && within(p1, p2, q2));
+}
+
+//------------------------------------------------------------------------------
+// Whether the segment from a polygon point to another point crosses or
+// touches an edge of the polygon not incident to either of them
+bool Crosses(const std::vector<CapPoint> &points, const std::vector<int> &polygon, int from, int to)
+{
+  for (size_t i=0; i<polygon.size(); i++)
+    {
+    int a = polygon[i];
+    int b = polygon[(i+1) % polygon.size()];
+    if (a == from || a == to || b == from || b == to)
+      {
+      continue;
+      }
+    if (Intersect(points[from], points[to], points[a], points[b]))
+      {
+      return true;
+      }
+    }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Whether the direction from o to p is inside the (counterclockwise) polygon
+// at its vertex o, between the previous vertex a and the next vertex b
+bool InAngle(const CapPoint &a, const CapPoint &o, const CapPoint &b, const CapPoint &p)
+{
+  if (Orientation(a, o, b) >= 0.0)
+    {
+    return Orientation(a, o, p) > 0.0 && Orientation(o, b, p) > 0.0;
+    }
+  return Orientation(a, o, p) > 0.0 || Orientation(o, b, p) > 0.0;
+}
+
+//------------------------------------------------------------------------------
+// Merging of the (clockwise) holes into the (counterclockwise) outer polygon,
+// from right to left, with a bridge from the rightmost point of every hole to
+// the closest visible point of the polygon. If no point is visible (invalid
+// geometry), the closest one is used so the result stays closed.
+void BridgeHoles(const std::vector<CapPoint> &points, std::vector<int> &outer,
+                 std::vector<std::vector<int> > holes)
+{
+  std::vector<std::pair<double, size_t> > order;
+  for (size_t h=0; h<holes.size(); h++)
+    {
+    auto rightmost = std::max_element(holes[h].begin(), holes[h].end(),
+      [&](int a, int b) {return points[a].S < points[b].S;});
+    std::rotate(holes[h].begin(), rightmost, holes[h].end());
+    order.emplace_back(points[holes[h][0]].S, h);
+    }
+  std::sort(order.begin(), order.end(), std::greater<std::pair<double, size_t> >());
+
+  for (size_t o=0; o<order.size(); o++)
+    {
+    const std::vector<int> &hole = holes[order[o].second];
+    int from = hole[0];
+
+    std::vector<std::pair<double, size_t> > candidates;
+    for (size_t i=0; i<outer.size(); i++)
+      {
+      const CapPoint &point = points[outer[i]];
+      double ds = point.S - points[from].S;
+      double dt = point.T - points[from].T;
+      candidates.emplace_back(ds*ds + dt*dt, i);
+      }
+    std::sort(candidates.begin(), candidates.end());
+
+    size_t bridge = candidates.front().second;
+    for (const auto &candidate : candidates)
+      {
+      size_t i = candidate.second;
+      int to = outer[i];
+      if (!InAngle(points[outer[(i+outer.size()-1) % outer.size()]], points[to],
+                   points[outer[(i+1) % outer.size()]], points[from]) ||
+          Crosses(points, outer, from, to))
+        {
+        continue;
+        }
+      bool blocked = false;
+      for (size_t r=o; r<order.size() && !blocked; r++)
+        {
+        blocked = Crosses(points, holes[order[r].second], from, to);
+        }
+      if (!blocked)
+        {
+        bridge = i;
+        break;
+        }
+      }
+
+    std::vector<int> merged(outer.begin(), outer.begin()+bridge+1);
+    merged.insert(merged.end(), hole.begin(), hole.end());
+    merged.push_back(from);
+    merged.insert(merged.end(), outer.begin()+bridge, outer.end());
+    outer.swap(merged);
+    }
+}
+
+//------------------------------------------------------------------------------
+// Ear clipping of a (counterclockwise) polygon. When no ear is left (invalid
+// geometry), the most convex vertex is clipped so the result stays closed.
+void ClipEars(const std::vector<CapPoint> &points, const std::vector<int> &polygon,
+              std::vector<std::array<int, 3> > &triangles)
+{
+  int size = static_cast<int>(polygon.size());
+  if (size < 3)
+    {
+    return;
+    }
+
+  std::vector<int> previous(size), next(size);
+  for (int i=0; i<size; i++)
+    {
+    previous[i] = (i+size-1) % size;
+    next[i] = (i+1) % size;
+    }
+
+  auto isEar = [&](int i)
+    {
+    int a = polygon[previous[i]], b = polygon[i], c = polygon[next[i]];
+    if (Orientation(points[a], points[b], points[c]) <= 0.0)
+      {
+      return false;
+      }
+    for (int j=next[next[i]]; j!=previous[i]; j=next[j])
+      {
+      int p = polygon[j];
+      if (p != a && p != b && p != c &&
+          Orientation(points[a], points[b], points[p]) >= 0.0 &&
+          Orientation(points[b], points[c], points[p]) >= 0.0 &&
+          Orientation(points[c], points[a], points[p]) >= 0.0)
+        {
+        return false;
+        }
+      }
+    return true;
+    };
+
+  int remaining = size;
+  int i = 0;
+  int tried = 0;
+  while (remaining > 3)
+    {
+    if (tried == remaining)
+      {
+      double maximum = -VTK_DOUBLE_MAX;
+      for (int j=next[i], k=0; k<remaining; j=next[j], k++)
+        {
+        double orientation = Orientation(points[polygon[previous[j]]], points[polygon[j]],
+                                         points[polygon[next[j]]]);
+        if (orientation > maximum)
+          {
+          maximum = orientation;
+          i = j;
+          }
+        }
+      }
+    else if (!isEar(i))
+      {
+      i = next[i];
+      tried++;
+      continue;
+      }
+
+    triangles.push_back({{polygon[previous[i]], polygon[i], polygon[next[i]]}});
+    next[previous[i]] = next[i];
+    previous[next[i]] = previous[i];
+    i = previous[i];
+    remaining--;
+    tried = 0;
+    }
+  triangles.push_back({{polygon[previous[i]], polygon[i], polygon[next[i]]}});
+}
+
+//------------------------------------------------------------------------------
+// Triangulation of the cap in the parameter domain of the surface
+class CapTriangulator
+{
+public:
+  CapTriangulator(const std::vector<vtkSmartPointer<vtkBezierSurfaceSource> > &patches,
+                  const int patchGridSize[2], const int resolution[2], vtkPoints *points)
+    :Patches(patches), Points(points)
+  {
+    std::copy(patchGridSize, patchGridSize+2, this->PatchGridSize);
+    std::copy(resolution, resolution+2, this->Resolution);
+    this->GridSize[0] = patchGridSize[0]*resolution[0] + 1;
+    this->GridSize[1] = patchGridSize[1]*resolution[1] + 1;
+  }
+
+  /// Adds the cut loops, projected onto the closest patch
+  void AddLoops(const std::vector<std::vector<vtkIdType> > &loops)
+  {
+    for (const auto &loop : loops)
+      {
+      std::vector<int> capLoop;
+      for (vtkIdType pointId : loop)
+        {
+        capLoop.push_back(static_cast<int>(this->CapPoints.size()));
+        this->CapPoints.push_back({pointId, 0.0, 0.0});
+        }
+      this->Loops.push_back(capLoop);
+      }
+
+    vtkSMPTools::For(0, static_cast<vtkIdType>(this->CapPoints.size()),
+      [&](vtkIdType begin, vtkIdType end)
+      {
+      for (vtkIdType index=begin; index<end; index++)
+        {
+        CapPoint &capPoint = this->CapPoints[index];
+        double point[3];
+        this->Points->GetPoint(capPoint.PointId, point);
+
+        double closestDistance = VTK_DOUBLE_MAX;
+        for (int p=0; p<this->PatchGridSize[0]; p++)
+          {
+          for (int q=0; q<this->PatchGridSize[1]; q++)
+            {
+            double closestPoint[3], parametricCoordinates[2];
+            double distance = this->Patches[p*this->PatchGridSize[1]+q]->ProjectPoint(
+              point, closestPoint, parametricCoordinates);
+            if (distance < closestDistance)
+              {
+              closestDistance = distance;
+              capPoint.S = (p + parametricCoordinates[0])*this->Resolution[0];
+              capPoint.T = (q + parametricCoordinates[1])*this->Resolution[1];
+              }
+            }
+          }
+        }
+      });
+  }
+
+  /// Selects the grid points inside the loops, away from them and inside the
+  /// mesh, and keeps the grid cells whose corners are all selected
+  void SelectGrid(vtkAbstractCellLocator *locator, const PseudoNormals &pseudoNormals)
+  {
+    int numberOfGridPoints = this->GridSize[0]*this->GridSize[1];
+    std::vector<char> candidates(numberOfGridPoints, 0);
+
+    // Even-odd test row by row, against all the loops
+    for (int j=0; j<this->GridSize[1]; j++)
+      {
+      std::vector<double> crossings;
+      for (const auto &loop : this->Loops)
+        {
+        for (size_t i=0; i<loop.size(); i++)
+          {
+          const CapPoint &a = this->CapPoints[loop[i]];
+          const CapPoint &b = this->CapPoints[loop[(i+1) % loop.size()]];
+          if ((a.T > j) != (b.T > j))
+            {
+            crossings.push_back(a.S + (j - a.T)*(b.S - a.S)/(b.T - a.T));
+            }
+          }
+        }
+      std::sort(crossings.begin(), crossings.end());
+      for (size_t c=0; c+1<crossings.size(); c+=2)
+        {
+        int first = std::max(0, static_cast<int>(std::ceil(crossings[c])));
+        int last = std::min(this->GridSize[0]-1, static_cast<int>(std::floor(crossings[c+1])));
+        for (int i=first; i<=last; i++)
+          {
+          candidates[j*this->GridSize[0]+i] = 1;
+          }
+        }
+      }
+
+    // Grid points close to the loops
+    for (const auto &loop : this->Loops)
+      {
+      for (size_t l=0; l<loop.size(); l++)
+        {
+        const CapPoint &a = this->CapPoints[loop[l]];
+        const CapPoint &b = this->CapPoints[loop[(l+1) % loop.size()]];
+        int firstI = std::max(0, static_cast<int>(std::ceil(std::min(a.S, b.S) - LoopMargin)));
+        int lastI = std::min(this->GridSize[0]-1, static_cast<int>(std::floor(std::max(a.S, b.S) + LoopMargin)));
+        int firstJ = std::max(0, static_cast<int>(std::ceil(std::min(a.T, b.T) - LoopMargin)));
+        int lastJ = std::min(this->GridSize[1]-1, static_cast<int>(std::floor(std::max(a.T, b.T) + LoopMargin)));
+        double ds = b.S - a.S, dt = b.T - a.T;
+        double length2 = ds*ds + dt*dt;
+        for (int j=firstJ; j<=lastJ; j++)
+          {
+          for (int i=firstI; i<=lastI; i++)
+            {
+            double t = length2 > 0.0 ? ((i - a.S)*ds + (j - a.T)*dt) / length2 : 0.0;
+            t = std::max(0.0, std::min(1.0, t));
+            double s = a.S + t*ds - i;
+            double u = a.T + t*dt - j;
+            if (s*s + u*u <= LoopMargin*LoopMargin)
+              {
+              candidates[j*this->GridSize[0]+i] = 0;
+              }
+            }
+          }
+        }
+      }
+
+    // Evaluation on the surface and inside test of the remaining ones
+    std::vector<int> candidateIds;
+    for (int index=0; index<numberOfGridPoints; index++)
+      {
+      if (candidates[index])
+        {
+        candidateIds.push_back(index);
+        }
+      }
+    this->GridPoints.assign(3*numberOfGridPoints, 0.0);
+    vtkSMPThreadLocalObject<vtkGenericCell> cells;
+    vtkSMPTools::For(0, static_cast<vtkIdType>(candidateIds.size()),
+      [&](vtkIdType begin, vtkIdType end)
+      {
+      vtkGenericCell *cell = cells.Local();
+      for (vtkIdType c=begin; c<end; c++)
+        {
+        int index = candidateIds[c];
+        double *point = &this->GridPoints[3*index];
+        this->EvaluateGridPoint(index % this->GridSize[0], index / this->GridSize[0], point);
+
+        double closestPoint[3], distance2;
+        vtkIdType cellId;
+        int subId;
+        locator->FindClosestPoint(point, closestPoint, cell, cellId, subId, distance2);
+        candidates[index] = cellId >= 0 && pseudoNormals.IsInside(point, closestPoint, cellId);
+        }
+      });
+
+    // Cells whose corners are all kept, without cells touching only by a
+    // corner, which would make the boundary of the grid pass twice there
+    int numberOfCells[2] = {this->GridSize[0]-1, this->GridSize[1]-1};
+    this->Cells.assign(numberOfCells[0]*numberOfCells[1], 0);
+    for (int j=0; j<numberOfCells[1]; j++)
+      {
+      for (int i=0; i<numberOfCells[0]; i++)
+        {
+        int corner = j*this->GridSize[0]+i;
+        this->Cells[j*numberOfCells[0]+i] = candidates[corner] && candidates[corner+1] &&
+          candidates[corner+this->GridSize[0]] && candidates[corner+this->GridSize[0]+1];
+        }
+      }
+
+    bool changed = true;
+    while (changed)
+      {
+      changed = false;
+      for (int j=1; j<numberOfCells[1]; j++)
+        {
+        for (int i=1; i<numberOfCells[0]; i++)
+          {
+          char &lowerLeft = this->Cells[(j-1)*numberOfCells[0]+i-1];
+          char &lowerRight = this->Cells[(j-1)*numberOfCells[0]+i];
+          char &upperLeft = this->Cells[j*numberOfCells[0]+i-1];
+          char &upperRight = this->Cells[j*numberOfCells[0]+i];
+          if (lowerLeft && upperRight && !lowerRight && !upperLeft)
+            {
+            upperRight = 0;
+            changed = true;
+            }
+          else if (lowerRight && upperLeft && !lowerLeft && !upperRight)
+            {
+            upperLeft = 0;
+            changed = true;
+            }
+          }
+        }
+      }
+  }
+
+  /// Triangles of the cap, oriented along the surface normal. The grid
+  /// points used are added to the points.
+  void Triangulate(std::vector<Triangle> &cap)
+  {
+    int numberOfCells[2] = {this->GridSize[0]-1, this->GridSize[1]-1};
+    std::vector<int> gridCapPoints(this->GridSize[0]*this->GridSize[1], -1);
+    auto gridCapPoint = [&](int i, int j)
+      {
+      int index = j*this->GridSize[0]+i;
+      if (gridCapPoints[index] < 0)
+        {
+        gridCapPoints[index] = static_cast<int>(this->CapPoints.size());
+        vtkIdType pointId = this->Points->InsertNextPoint(&this->GridPoints[3*index]);
+        this->CapPoints.push_back({pointId, static_cast<double>(i), static_cast<double>(j)});
+        }
+      return gridCapPoints[index];
+      };
+    auto kept = [&](int i, int j)
+      {
+      return i >= 0 && j >= 0 && i < numberOfCells[0] && j < numberOfCells[1] &&
+        this->Cells[j*numberOfCells[0]+i];
+      };
+
+    // Grid cells, and the boundary of the band between the loops and the grid:
+    // the loops and the boundary of the grid cells reversed
+    std::vector<std::array<int, 3> > triangles;
+    std::vector<std::pair<int, int> > bandEdges;
+    for (const auto &loop : this->Loops)
+      {
+      for (size_t i=0; i<loop.size(); i++)
+        {
+        bandEdges.emplace_back(loop[i], loop[(i+1) % loop.size()]);
+        }
+      }
+    for (int j=0; j<numberOfCells[1]; j++)
+      {
+      for (int i=0; i<numberOfCells[0]; i++)
+        {
+        if (!kept(i, j))
+          {
+          continue;
+          }
+        int corners[4] = {gridCapPoint(i, j), gridCapPoint(i+1, j),
+                          gridCapPoint(i+1, j+1), gridCapPoint(i, j+1)};
+        triangles.push_back({{corners[0], corners[1], corners[2]}});
+        triangles.push_back({{corners[0], corners[2], corners[3]}});
+
+        int neighbors[4][2] = {{i, j-1}, {i+1, j}, {i, j+1}, {i-1, j}};
+        for (int k=0; k<4; k++)
+          {
+          if (!kept(neighbors[k][0], neighbors[k][1]))
+            {
+            bandEdges.emplace_back(corners[(k+1)%4], corners[k]);
+            }
+          }
+        }
+      }
+
+    // Closed polygons of the band: counterclockwise ones are the outer
+    // boundaries, clockwise ones the holes of the smallest outer boundary
+    // containing them
+    std::vector<int> next(this->CapPoints.size(), -1);
+    for (const auto &edge : bandEdges)
+      {
+      next[edge.first] = edge.second;
+      }
+    std::vector<std::vector<int> > outers, holes;
+    std::vector<double> outerAreas;
+    std::vector<char> visited(this->CapPoints.size(), 0);
+    for (const auto &edge : bandEdges)
+      {
+      std::vector<int> polygon;
+      for (int index=edge.first; index>=0 && !visited[index]; index=next[index])
+        {
+        visited[index] = 1;
+        polygon.push_back(index);
+        }
+      if (polygon.size() < 3)
+        {
+        continue;
+        }
+      double area = SignedArea(this->CapPoints, polygon);
+      if (area >= 0.0)
+        {
+        outers.push_back(polygon);
+        outerAreas.push_back(area);
+        }
+      else
+        {
+        holes.push_back(polygon);
+        }
+      }
+
+    std::vector<std::vector<std::vector<int> > > outerHoles(outers.size());
+    for (auto &hole : holes)
+      {
+      int container = -1;
+      for (size_t o=0; o<outers.size(); o++)
+        {
+        if ((container < 0 || outerAreas[o] < outerAreas[container]) &&
+            Contains(this->CapPoints, outers[o], this->CapPoints[hole[0]]))
+          {
+          container = static_cast<int>(o);
+          }
+        }
+      if (container >= 0)
+        {
+        outerHoles[container].push_back(hole);
+        continue;
+        }
+
+      // Invalid geometry: closed by the reversed triangulation of the hole
+      std::reverse(hole.begin(), hole.end());
+      std::vector<std::array<int, 3> > holeTriangles;
+      ClipEars(this->CapPoints, hole, holeTriangles);
+      for (const auto &triangle : holeTriangles)
+        {
+        triangles.push_back({{triangle[0], triangle[2], triangle[1]}});
+        }
+      }
+
+    for (size_t o=0; o<outers.size(); o++)
+      {
+      BridgeHoles(this->CapPoints, outers[o], outerHoles[o]);
+      ClipEars(this->CapPoints, outers[o], triangles);
+      }
+
+    for (const auto &triangle : triangles)
+      {
+      cap.push_back({{this->CapPoints[triangle[0]].PointId,
+                      this->CapPoints[triangle[1]].PointId,
+                      this->CapPoints[triangle[2]].PointId}});
+      }
+  }
+
+private:
+  // Surface point at a grid point
+  void EvaluateGridPoint(int i, int j, double point[3]) const
+  {
+    int p = std::min(i / this->Resolution[0], this->PatchGridSize[0]-1);
+    int q = std::min(j / this->Resolution[1], this->PatchGridSize[1]-1);
+    double u = static_cast<double>(i - p*this->Resolution[0]) / this->Resolution[0];
+    double v = static_cast<double>(j - q*this->Resolution[1]) / this->Resolution[1];
+    this->Patches[p*this->PatchGridSize[1]+q]->EvaluatePoint(u, v, point);
+  }
+
+private:
+  const std::vector<vtkSmartPointer<vtkBezierSurfaceSource> > &Patches;
+  int PatchGridSize[2];
+  int Resolution[2];
+  int GridSize[2];
+  vtkPoints *Points;
+  std::vector<CapPoint> CapPoints;
+  std::vector<std::vector<int> > Loops;
+  std::vector<double> GridPoints;
+  std::vector<char> Cells;
+};
+
+//------------------------------------------------------------------------------
+// Polydata made of some triangles, with only the points they use
+void SetTriangles(vtkPolyData *polyData, vtkPoints *points, const std::vector<Triangle> &triangles,
+                  const std::vector<Triangle> &cap, bool reverseCap)
+{
+  std::vector<vtkIdType> pointIds(points->GetNumberOfPoints(), -1);
+  vtkNew<vtkPoints> usedPoints;
+  usedPoints->SetDataTypeToDouble();
+  vtkNew<vtkCellArray> polys;
+  polys->AllocateEstimate(triangles.size() + cap.size(), 3);
+
+  auto insertTriangle = [&](vtkIdType a, vtkIdType b, vtkIdType c)
+    {
+    vtkIdType triangle[3] = {a, b, c};
+    for (vtkIdType &pointId : triangle)
+      {
+      if (pointIds[pointId] < 0)
+        {
+        double point[3];
+        points->GetPoint(pointId, point);
+        pointIds[pointId] = usedPoints->InsertNextPoint(point);
+        }
+      pointId = pointIds[pointId];
+      }
+    polys->InsertNextCell(3, triangle);
+    };
+
+  for (const auto &triangle : triangles)
+    {
+    insertTriangle(triangle[0], triangle[1], triangle[2]);
+    }
+  for (const auto &triangle : cap)
+    {
+    if (reverseCap)
+      {
+      insertTriangle(triangle[0], triangle[2], triangle[1]);
+      }
+    else
+      {
+      insertTriangle(triangle[0], triangle[1], triangle[2]);
+      }
+    }
+
+  polyData->SetPoints(usedPoints);
+  polyData->SetPolys(polys);
+}
+
+} // end of anonymous namespace
+
+//------------------------------------------------------------------------------
+class vtkResectionSplitFilter::vtkInternal
+{
+public:
+  std::vector<vtkSmartPointer<vtkBezierSurfaceSource> > Patches;
+  vtkSmartPointer<vtkAbstractCellLocator> Locator;
+};
+
+//------------------------------------------------------------------------------
+vtkStandardNewMacro(vtkResectionSplitFilter);
+
+//------------------------------------------------------------------------------
+vtkResectionSplitFilter::vtkResectionSplitFilter()
+  :Internal(new vtkInternal)
+{
+  this->PatchGridSize[0] = this->PatchGridSize[1] = 1;
+  this->Resolution[0] = this->Resolution[1] = 50;
+  this->SetNumberOfOutputPorts(2);
+}
+
+//------------------------------------------------------------------------------
+vtkResectionSplitFilter::~vtkResectionSplitFilter()
+{
+  delete this->Internal;
+}
+
+//------------------------------------------------------------------------------
+void vtkResectionSplitFilter::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "Number Of Patches: " << this->GetNumberOfPatches() << "\n";
+  os << indent << "Patch Grid Size: " << this->PatchGridSize[0] << "x" << this->PatchGridSize[1] << "\n";
+  os << indent << "Resolution: " << this->Resolution[0] << "x" << this->Resolution[1] << "\n";
+  os << indent << "Locator: " << this->Internal->Locator.GetPointer() << "\n";
+}
+
+//------------------------------------------------------------------------------
+void vtkResectionSplitFilter::AddPatch(vtkBezierSurfaceSource *patch)
+{
+  if (!patch)
+    {
+    return;
+    }
+
+  this->Internal->Patches.push_back(patch);
+  this->Modified();
+}
+
+//------------------------------------------------------------------------------
+void vtkResectionSplitFilter::RemoveAllPatches()
+{
+  if (this->Internal->Patches.empty())
+    {
+    return;
+    }
+
+  this->Internal->Patches.clear();
+  this->Modified();
+}
+
+//------------------------------------------------------------------------------
+int vtkResectionSplitFilter::GetNumberOfPatches() const
+{
+  return static_cast<int>(this->Internal->Patches.size());
+}
+
+//------------------------------------------------------------------------------
+void vtkResectionSplitFilter::SetLocator(vtkAbstractCellLocator *locator)
+{
+  if (this->Internal->Locator == locator)
+    {
+    return;
+    }
+
+  this->Internal->Locator = locator;
+  this->Modified();
+}
+
+//------------------------------------------------------------------------------
+vtkAbstractCellLocator* vtkResectionSplitFilter::GetLocator() const
+{
+  return this->Internal->Locator;
+}
+
+//------------------------------------------------------------------------------
+vtkPolyData* vtkResectionSplitFilter::GetResectedOutput()
+{
+  return this->GetOutput(0);
+}
+
+//------------------------------------------------------------------------------
+vtkPolyData* vtkResectionSplitFilter::GetRemnantOutput()
+{
+  return this->GetOutput(1);
+}
+
+//------------------------------------------------------------------------------
+int vtkResectionSplitFilter::RequestData(vtkInformation *vtkNotUsed(request),
+                                         vtkInformationVector **inputVector,
+                                         vtkInformationVector *outputVector)
+{
+  vtkPolyData *input = vtkPolyData::GetData(inputVector[0]);
+  vtkPolyData *resected = vtkPolyData::GetData(outputVector, 0);
+  vtkPolyData *remnant = vtkPolyData::GetData(outputVector, 1);
+  if (!input || !resected || !remnant || !input->GetPoints())
+    {
+    return 1;
+    }
+
+  vtkInternal *internal = this->Internal;
+  if (this->PatchGridSize[0] < 1 || this->PatchGridSize[1] < 1 ||
+      internal->Patches.size() != static_cast<size_t>(this->PatchGridSize[0]*this->PatchGridSize[1]))
+    {
+    vtkErrorMacro("RequestData: " << internal->Patches.size() << " patches for a "
+                  << this->PatchGridSize[0] << "x" << this->PatchGridSize[1] << " grid.");
+    return 0;
+    }
+  if (this->Resolution[0] < 1 || this->Resolution[1] < 1)
+    {
+    vtkErrorMacro("RequestData: invalid resolution.");
+    return 0;
+    }
+
+  vtkIdType numberOfPoints = input->GetNumberOfPoints();
+  vtkDataArray *signedDistances = input->GetPointData()->GetScalars();
+  if (!signedDistances || signedDistances->GetNumberOfTuples() != numberOfPoints)
+    {
+    vtkErrorMacro("RequestData: the input has no signed distance scalars.");
+    return 0;
+    }
+
+  std::vector<Triangle> triangles;
+  if (!GetTriangles(input, triangles))
+    {
+    vtkErrorMacro("RequestData: the input is not a triangle mesh.");
+    return 0;
+    }
+
+  // Clipping, the cut points being added to the input points
+  vtkNew<vtkPoints> points;
+  points->SetDataTypeToDouble();
+  points->SetNumberOfPoints(numberOfPoints);
+  for (vtkIdType pointId=0; pointId<numberOfPoints; pointId++)
+    {
+    double point[3];
+    input->GetPoint(pointId, point);
+    points->SetPoint(pointId, point);
+    }
+
+  std::vector<Triangle> sides[2];
+  std::map<vtkIdType, vtkIdType> cutSegments;
+  ClipTriangles(signedDistances, triangles, points, sides, cutSegments);
+
+  std::vector<std::vector<vtkIdType> > loops;
+  GetCutLoops(cutSegments, loops);
+
+  // Capping of the closed loops
+  std::vector<Triangle> cap;
+  if (!loops.empty())
+    {
+    vtkSmartPointer<vtkAbstractCellLocator> locator = internal->Locator;
+    if (!locator)
+      {
+      locator = vtkSmartPointer<vtkStaticCellLocator>::New();
+      locator->SetDataSet(input);
+      locator->BuildLocator();
+      }
+    PseudoNormals pseudoNormals(input->GetPoints(), triangles);
+
+    CapTriangulator triangulator(internal->Patches, this->PatchGridSize, this->Resolution, points);
+    triangulator.AddLoops(loops);
+    triangulator.SelectGrid(locator, pseudoNormals);
+    triangulator.Triangulate(cap);
+    }
+
+  SetTriangles(resected, points, sides[0], cap, true);
+  SetTriangles(remnant, points, sides[1], cap, false);
+
+  return 1;
+}
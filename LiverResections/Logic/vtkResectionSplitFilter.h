@@ -0,0 +1,125 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (The Intervention Centre,
+  Oslo University Hospital) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#ifndef __vtkresectionsplitfilter_h_
+#define __vtkresectionsplitfilter_h_
+
+#include "vtkSlicerLiverResectionsModuleLogicExport.h"
+
+// VTK includes
+#include <vtkPolyDataAlgorithm.h>
+
+//------------------------------------------------------------------------------
+class vtkAbstractCellLocator;
+class vtkBezierSurfaceSource;
+
+//------------------------------------------------------------------------------
+/// Split of a closed triangle mesh (e.g. the parenchyma) by a single or
+/// multi-patch Bezier resection surface into two closed meshes: the resected
+/// part (output 0, on the side the surface normal points to) and the remnant
+/// part (output 1).
+///
+/// The active point scalars of the input are the signed distances of the
+/// vertices to the surface. The triangles straddling the zero level are
+/// clipped, every cut edge getting a single new point that is shared by both
+/// parts and by the cap, so the cut is closed without gaps or T-junctions.
+///
+/// The cap is triangulated in the parameter domain of the surface: the closed
+/// cut loops, projected onto the surface, bound a grid of surface points
+/// (Resolution per patch), which are kept when they lie inside the loops, away
+/// from them and inside the input. The inside test uses the angle-weighted
+/// pseudo-normal at the closest point of the input, which gives the correct
+/// side also when the closest point is on an edge or a vertex. The band
+/// between the loops and the grid is triangulated by ear clipping.
+///
+/// NOTE: Cut loops that are not closed (the input has holes there) are left
+/// open. The cap follows the surface only where the surface spans the cut;
+/// beyond its border, the loop points project onto the border.
+class VTK_SLICER_LIVERRESECTIONS_MODULE_LOGIC_EXPORT vtkResectionSplitFilter
+: public vtkPolyDataAlgorithm
+{
+public:
+  static vtkResectionSplitFilter* New();
+  vtkTypeMacro(vtkResectionSplitFilter, vtkPolyDataAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Patches of the resection surface, patch (p,q) of a grid of P x Q patches
+  /// being added at index pQ+q (see vtkMultiPatchBezierSurfaceSource)
+  void AddPatch(vtkBezierSurfaceSource *patch);
+  void RemoveAllPatches();
+  int GetNumberOfPatches() const;
+
+  /// Layout of the patches in the parametric u and v directions (1x1 by default)
+  vtkSetVector2Macro(PatchGridSize, int);
+  vtkGetVector2Macro(PatchGridSize, int);
+
+  /// Resolution of the grid of cap points in every patch (50x50 by default)
+  vtkSetVector2Macro(Resolution, int);
+  vtkGetVector2Macro(Resolution, int);
+
+  /// Index of the cells of the input for the inside test of the cap points
+  /// (optional, e.g. one shared with other queries). It is built on every
+  /// update when not set.
+  void SetLocator(vtkAbstractCellLocator *locator);
+  vtkAbstractCellLocator* GetLocator() const;
+
+  /// Resected and remnant parts
+  vtkPolyData* GetResectedOutput();
+  vtkPolyData* GetRemnantOutput();
+
+protected:
+  vtkResectionSplitFilter();
+  ~vtkResectionSplitFilter() override;
+
+  int RequestData(vtkInformation *, vtkInformationVector **, vtkInformationVector *) override;
+
+protected:
+  int PatchGridSize[2];
+  int Resolution[2];
+
+private:
+  class vtkInternal;
+  vtkInternal* Internal;
+
+private:
+  vtkResectionSplitFilter(const vtkResectionSplitFilter&) = delete;
+  void operator=(const vtkResectionSplitFilter&) = delete;
+};
+
+#endif // __vtkresectionsplitfilter_h_
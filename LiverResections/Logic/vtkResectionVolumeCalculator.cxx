@@ -0,0 +1,995 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (The Intervention Centre,
+  Oslo University Hospital) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#include "vtkResectionVolumeCalculator.h"
+
+// Liver Markups VTKAlgorithms includes
+#include <vtkBezierSurfaceSource.h>
+#include <vtkMultiPatchBezierSurfaceSource.h>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkSMPTools.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+// Size (in voxels) of the blocks and sub-blocks the labelmap is packed into.
+// A sub-block of 4x4x4 voxels is stored as a 64-bit mask.
+const int BlockSize = 8;
+const int SubBlockSize = 4;
+const int NumberOfSubBlocks = 8;
+
+//------------------------------------------------------------------------------
+// Block of 8x8x8 voxels of the labelmap with the cached classification
+struct VoxelBlock
+{
+  int Origin[3];
+  double Value;
+  int Label;
+  uint64_t Masks[NumberOfSubBlocks];
+  int SubCounts[NumberOfSubBlocks];
+  int Count;
+
+  // Classification cache: the margin is the distance the boundary can move
+  // (since the accumulated displacement Reference) before the
+  // classification may change. A negative margin forces re-evaluation.
+  int Resected;
+  double Margin;
+  double Reference;
+  int SubResected[NumberOfSubBlocks];
+  double SubMargins[NumberOfSubBlocks];
+  double SubReferences[NumberOfSubBlocks];
+};
+
+//------------------------------------------------------------------------------
+// Resection boundary: closest point, unit normal and offset along the normal
+// of a point (positive on the resected side). The closest point is interior
+// when it is not on the border of an open boundary: beyond the border the
+// side is the one of the normal there, which may change (e.g. when the
+// boundary rotates) without the boundary moving across the point, so the
+// distance does not bound the classification.
+class ResectionBoundary
+{
+public:
+  virtual ~ResectionBoundary() = default;
+
+  /// Whether the evaluation is cheap enough to classify the voxels crossed
+  /// by the boundary exactly rather than against the tangent plane
+  virtual bool IsAnalytic() const {return false;}
+
+  virtual double Evaluate(const double x[3], double closestPoint[3], double normal[3],
+                          bool &interior) const = 0;
+};
+
+//------------------------------------------------------------------------------
+class PlaneBoundary : public ResectionBoundary
+{
+public:
+  double Origin[3];
+  double Normal[3];
+
+  bool IsAnalytic() const override {return true;}
+
+  double Evaluate(const double x[3], double closestPoint[3], double normal[3],
+                  bool &interior) const override
+  {
+    interior = true;
+    double offset[3];
+    vtkMath::Subtract(x, this->Origin, offset);
+    double distance = vtkMath::Dot(offset, this->Normal);
+    for (int k=0; k<3; k++)
+      {
+      closestPoint[k] = x[k] - distance*this->Normal[k];
+      normal[k] = this->Normal[k];
+      }
+    return distance;
+  }
+};
+
+//------------------------------------------------------------------------------
+class SphereBoundary : public ResectionBoundary
+{
+public:
+  double Center[3];
+  double Radius;
+
+  bool IsAnalytic() const override {return true;}
+
+  double Evaluate(const double x[3], double closestPoint[3], double normal[3],
+                  bool &interior) const override
+  {
+    interior = true;
+    double radial[3];
+    vtkMath::Subtract(x, this->Center, radial);
+    double distance = vtkMath::Normalize(radial);
+    if (distance == 0.0)
+      {
+      radial[0] = 1.0;
+      }
+    for (int k=0; k<3; k++)
+      {
+      closestPoint[k] = this->Center[k] + this->Radius*radial[k];
+      normal[k] = -radial[k];
+      }
+    return this->Radius - distance;
+  }
+};
+
+//------------------------------------------------------------------------------
+class BezierBoundary : public ResectionBoundary
+{
+public:
+  BezierBoundary()
+  {
+    this->BezierSurfaceSource = vtkSmartPointer<vtkBezierSurfaceSource>::New();
+    this->MultiPatchBezierSurfaceSource = vtkSmartPointer<vtkMultiPatchBezierSurfaceSource>::New();
+    this->NumberOfPatches[0] = 1;
+    this->NumberOfPatches[1] = 1;
+  }
+
+  vtkSmartPointer<vtkBezierSurfaceSource> BezierSurfaceSource;
+  vtkSmartPointer<vtkMultiPatchBezierSurfaceSource> MultiPatchBezierSurfaceSource;
+
+  // Patches in row-major order of the p x q patch grid
+  std::vector<vtkBezierSurfaceSource*> Patches;
+  unsigned int NumberOfPatches[2];
+
+  double Evaluate(const double x[3], double closestPoint[3], double normal[3],
+                  bool &interior) const override
+  {
+    const double borderTolerance = 1e-6;
+    double closestDistance = VTK_DOUBLE_MAX;
+    double offset = 0.0;
+    interior = true;
+    for (size_t index=0; index<this->Patches.size(); index++)
+      {
+      vtkBezierSurfaceSource *patch = this->Patches[index];
+      double patchClosestPoint[3], parametricCoordinates[2];
+      double distance = patch->ProjectPoint(x, patchClosestPoint, parametricCoordinates);
+      if (distance >= closestDistance)
+        {
+        continue;
+        }
+
+      // Only the outer border of the patch grid is a border of the surface
+      unsigned int patchIndex[2] = {static_cast<unsigned int>(index) / this->NumberOfPatches[1],
+                                    static_cast<unsigned int>(index) % this->NumberOfPatches[1]};
+      interior = true;
+      for (int d=0; d<2; d++)
+        {
+        if ((patchIndex[d] == 0 && parametricCoordinates[d] <= borderTolerance) ||
+            (patchIndex[d] == this->NumberOfPatches[d]-1 && parametricCoordinates[d] >= 1.0-borderTolerance))
+          {
+          interior = false;
+          }
+        }
+
+      double surfacePoint[3], derivativeU[3], derivativeV[3], difference[3];
+      patch->EvaluatePoint(parametricCoordinates[0], parametricCoordinates[1],
+                           surfacePoint, derivativeU, derivativeV);
+      vtkMath::Cross(derivativeU, derivativeV, normal);
+      vtkMath::Normalize(normal);
+      vtkMath::Subtract(x, patchClosestPoint, difference);
+
+      closestDistance = distance;
+      offset = vtkMath::Dot(difference, normal);
+      std::copy(patchClosestPoint, patchClosestPoint+3, closestPoint);
+      }
+    return offset;
+  }
+};
+
+//------------------------------------------------------------------------------
+inline int CountBits(uint64_t mask)
+{
+  return static_cast<int>(std::bitset<64>(mask).count());
+}
+
+//------------------------------------------------------------------------------
+// Packing of the labelmap into blocks, in parallel over slabs of blocks.
+// When the labels are separated, there is one block per label present in
+// each 8x8x8 region.
+template <class T>
+class PackBlocksFunctor
+{
+public:
+  PackBlocksFunctor(const T *scalars, const int extent[6], int numberOfComponents,
+                    int labelValue, bool separateLabels, const int numberOfBlocks[3],
+                    std::vector<std::vector<VoxelBlock> > *slabs)
+    :Scalars(scalars), NumberOfComponents(numberOfComponents),
+     LabelValue(labelValue), SeparateLabels(separateLabels), Slabs(slabs)
+  {
+    for (int d=0; d<3; d++)
+      {
+      this->Extent[2*d] = extent[2*d];
+      this->Extent[2*d+1] = extent[2*d+1];
+      this->Dimensions[d] = extent[2*d+1] - extent[2*d] + 1;
+      this->NumberOfBlocks[d] = numberOfBlocks[d];
+      }
+  }
+
+  const T *Scalars;
+  int Dimensions[3];
+  int Extent[6];
+  int NumberOfComponents;
+  int LabelValue;
+  bool SeparateLabels;
+  int NumberOfBlocks[3];
+  std::vector<std::vector<VoxelBlock> > *Slabs;
+
+  void operator()(vtkIdType begin, vtkIdType end)
+  {
+    std::vector<VoxelBlock> blocks;
+    for (vtkIdType bk=begin; bk<end; bk++)
+      {
+      std::vector<VoxelBlock> &slab = (*this->Slabs)[bk];
+      for (int bj=0; bj<this->NumberOfBlocks[1]; bj++)
+        {
+        for (int bi=0; bi<this->NumberOfBlocks[0]; bi++)
+          {
+          blocks.clear();
+          size_t current = 0;
+          int start[3] = {bi*BlockSize, bj*BlockSize, static_cast<int>(bk)*BlockSize};
+          int stop[3];
+          for (int d=0; d<3; d++)
+            {
+            stop[d] = std::min(start[d] + BlockSize, this->Dimensions[d]);
+            }
+
+          for (int z=start[2]; z<stop[2]; z++)
+            {
+            for (int y=start[1]; y<stop[1]; y++)
+              {
+              const T *row = this->Scalars +
+                (static_cast<vtkIdType>(z)*this->Dimensions[1] + y)*this->Dimensions[0]*this->NumberOfComponents;
+              for (int x=start[0]; x<stop[0]; x++)
+                {
+                T value = row[x*this->NumberOfComponents];
+                if (this->SeparateLabels || this->LabelValue == 0 ?
+                    value == 0 : value != static_cast<T>(this->LabelValue))
+                  {
+                  continue;
+                  }
+
+                // Block of the label (most regions contain a single label)
+                double label = this->SeparateLabels ? static_cast<double>(value) : this->LabelValue;
+                if (current >= blocks.size() || blocks[current].Value != label)
+                  {
+                  current = 0;
+                  while (current < blocks.size() && blocks[current].Value != label)
+                    {
+                    current++;
+                    }
+                  if (current == blocks.size())
+                    {
+                    VoxelBlock block = {};
+                    for (int d=0; d<3; d++)
+                      {
+                      block.Origin[d] = this->Extent[2*d] + start[d];
+                      }
+                    block.Value = label;
+                    blocks.push_back(block);
+                    }
+                  }
+                VoxelBlock &block = blocks[current];
+
+                int bx = x-start[0], by = y-start[1], bz = z-start[2];
+                int subBlock = bx/SubBlockSize + 2*(by/SubBlockSize) + 4*(bz/SubBlockSize);
+                int bit = bx%SubBlockSize + SubBlockSize*(by%SubBlockSize) +
+                  SubBlockSize*SubBlockSize*(bz%SubBlockSize);
+                block.Masks[subBlock] |= (uint64_t(1) << bit);
+                }
+              }
+            }
+
+          for (auto &block : blocks)
+            {
+            for (int s=0; s<NumberOfSubBlocks; s++)
+              {
+              block.SubCounts[s] = CountBits(block.Masks[s]);
+              block.Count += block.SubCounts[s];
+              }
+            slab.push_back(block);
+            }
+          }
+        }
+      }
+  }
+};
+
+//------------------------------------------------------------------------------
+template <class T>
+void PackBlocks(const T *scalars, const int extent[6], int numberOfComponents, int labelValue,
+                bool separateLabels, const int numberOfBlocks[3],
+                std::vector<std::vector<VoxelBlock> > &slabs)
+{
+  PackBlocksFunctor<T> functor(scalars, extent, numberOfComponents, labelValue, separateLabels,
+                               numberOfBlocks, &slabs);
+  vtkSMPTools::For(0, numberOfBlocks[2], functor);
+}
+
+}
+
+//------------------------------------------------------------------------------
+class vtkResectionVolumeCalculator::vtkInternal
+{
+public:
+  enum BoundaryTypes
+  {
+    NoBoundary,
+    Plane,
+    Sphere,
+    BezierSurface,
+    MultiPatchBezierSurface
+  };
+
+  vtkInternal()
+    :BlocksValid(false), LabelMapTime(0), BuiltLabelValue(0), BuiltSeparateLabels(false), VoxelVolume(0.0),
+     BlockHalfDiagonal(0.0), SubBlockHalfDiagonal(0.0),
+     BoundaryType(NoBoundary), Displacement(0.0), FullUpdate(true)
+  {
+    std::fill(this->IJKToRAS, this->IJKToRAS+16, 0.0);
+    std::fill(this->Corners, this->Corners+24, 0.0);
+  }
+
+  /// Voxel (IJK) to world (RAS) coordinates
+  void ToWorld(const double ijk[3], double ras[3]) const
+  {
+    for (int r=0; r<3; r++)
+      {
+      ras[r] = this->IJKToRAS[4*r+3];
+      for (int c=0; c<3; c++)
+        {
+        ras[r] += this->IJKToRAS[4*r+c]*ijk[c];
+        }
+      }
+  }
+
+  /// Largest distance between the center of a box of voxel centers and its
+  /// corners, for a box of the given size (in voxels)
+  double HalfDiagonal(double size) const
+  {
+    double halfDiagonal = 0.0;
+    for (int corner=0; corner<4; corner++)
+      {
+      double ijk[3] = {0.5*(size-1), (corner & 1 ? -0.5 : 0.5)*(size-1), (corner & 2 ? -0.5 : 0.5)*(size-1)};
+      double offset[3] = {0.0, 0.0, 0.0};
+      for (int r=0; r<3; r++)
+        {
+        for (int c=0; c<3; c++)
+          {
+          offset[r] += this->IJKToRAS[4*r+c]*ijk[c];
+          }
+        }
+      halfDiagonal = std::max(halfDiagonal, vtkMath::Norm(offset));
+      }
+    return halfDiagonal;
+  }
+
+  /// Setting of a new boundary. The displacement bound is accumulated when
+  /// the boundary type does not change, otherwise a full update is required.
+  void SetBoundary(int type, double displacement)
+  {
+    if (type != this->BoundaryType || displacement < 0.0)
+      {
+      this->FullUpdate = true;
+      }
+    else
+      {
+      this->Displacement += displacement;
+      }
+    this->BoundaryType = type;
+  }
+
+  void EvaluateBlock(VoxelBlock &block) const;
+
+public:
+  vtkSmartPointer<vtkImageData> LabelMap;
+  bool BlocksValid;
+  vtkMTimeType LabelMapTime;
+  int BuiltLabelValue;
+  bool BuiltSeparateLabels;
+  double IJKToRAS[16];
+  double VoxelVolume;
+  double BlockHalfDiagonal;
+  double SubBlockHalfDiagonal;
+  double Corners[24];
+  std::vector<VoxelBlock> Blocks;
+
+  // Label values (sorted) and their counts
+  std::vector<double> LabelValues;
+  std::vector<vtkIdType> ResectedCounts;
+  std::vector<vtkIdType> TotalCounts;
+
+  int BoundaryType;
+  std::unique_ptr<ResectionBoundary> Boundary;
+  std::vector<double> BoundaryParameters;
+  double Displacement;
+  bool FullUpdate;
+};
+
+//------------------------------------------------------------------------------
+void vtkResectionVolumeCalculator::vtkInternal::EvaluateBlock(VoxelBlock &block) const
+{
+  if (!this->FullUpdate && block.Margin > this->Displacement - block.Reference)
+    {
+    return;
+    }
+
+  double center[3], closestPoint[3], normal[3];
+  double centerIJK[3] = {block.Origin[0] + 0.5*(BlockSize-1),
+                         block.Origin[1] + 0.5*(BlockSize-1),
+                         block.Origin[2] + 0.5*(BlockSize-1)};
+  this->ToWorld(centerIJK, center);
+  bool interior;
+  double offset = this->Boundary->Evaluate(center, closestPoint, normal, interior);
+
+  // The whole block is on one side of the boundary
+  if (interior && std::fabs(offset) > this->BlockHalfDiagonal)
+    {
+    block.Margin = std::fabs(offset) - this->BlockHalfDiagonal;
+    block.Reference = this->Displacement;
+    block.Resected = offset > 0.0 ? block.Count : 0;
+    for (int s=0; s<NumberOfSubBlocks; s++)
+      {
+      block.SubMargins[s] = block.Margin;
+      block.SubReferences[s] = block.Reference;
+      block.SubResected[s] = offset > 0.0 ? block.SubCounts[s] : 0;
+      }
+    return;
+    }
+
+  block.Margin = -1.0;
+  block.Resected = 0;
+  for (int s=0; s<NumberOfSubBlocks; s++)
+    {
+    if (block.SubCounts[s] == 0 ||
+        (!this->FullUpdate && block.SubMargins[s] > this->Displacement - block.SubReferences[s]))
+      {
+      block.Resected += block.SubResected[s];
+      continue;
+      }
+
+    double subOrigin[3] = {static_cast<double>(block.Origin[0] + (s & 1)*SubBlockSize),
+                           static_cast<double>(block.Origin[1] + ((s >> 1) & 1)*SubBlockSize),
+                           static_cast<double>(block.Origin[2] + ((s >> 2) & 1)*SubBlockSize)};
+    double subCenterIJK[3] = {subOrigin[0] + 0.5*(SubBlockSize-1),
+                              subOrigin[1] + 0.5*(SubBlockSize-1),
+                              subOrigin[2] + 0.5*(SubBlockSize-1)};
+    double subCenter[3];
+    this->ToWorld(subCenterIJK, subCenter);
+    double subOffset = this->Boundary->Evaluate(subCenter, closestPoint, normal, interior);
+
+    block.SubReferences[s] = this->Displacement;
+    if (interior && std::fabs(subOffset) > this->SubBlockHalfDiagonal)
+      {
+      block.SubMargins[s] = std::fabs(subOffset) - this->SubBlockHalfDiagonal;
+      block.SubResected[s] = subOffset > 0.0 ? block.SubCounts[s] : 0;
+      block.Resected += block.SubResected[s];
+      continue;
+      }
+
+    // The boundary crosses the sub-block: the voxels are classified against
+    // the tangent plane at the closest point of the boundary, the offset
+    // being linear in the voxel indices. Analytic boundaries, and the
+    // sub-blocks classified through the border, are evaluated at every voxel.
+    block.SubMargins[s] = -1.0;
+    bool exact = this->Boundary->IsAnalytic() || !interior;
+    double origin[3], difference[3];
+    this->ToWorld(subOrigin, origin);
+    vtkMath::Subtract(origin, closestPoint, difference);
+    double originOffset = vtkMath::Dot(normal, difference);
+    double step[3];
+    for (int c=0; c<3; c++)
+      {
+      step[c] = normal[0]*this->IJKToRAS[c] + normal[1]*this->IJKToRAS[4+c] + normal[2]*this->IJKToRAS[8+c];
+      }
+
+    int resected = 0;
+    uint64_t mask = block.Masks[s];
+    for (int bit=0; bit<64; bit++)
+      {
+      if (!(mask & (uint64_t(1) << bit)))
+        {
+        continue;
+        }
+      int x = bit % SubBlockSize;
+      int y = (bit / SubBlockSize) % SubBlockSize;
+      int z = bit / (SubBlockSize*SubBlockSize);
+      double voxelOffset;
+      if (exact)
+        {
+        double voxelIJK[3] = {subOrigin[0] + x, subOrigin[1] + y, subOrigin[2] + z};
+        double voxel[3], voxelClosestPoint[3], voxelNormal[3];
+        this->ToWorld(voxelIJK, voxel);
+        bool voxelInterior;
+        voxelOffset = this->Boundary->Evaluate(voxel, voxelClosestPoint, voxelNormal, voxelInterior);
+        }
+      else
+        {
+        voxelOffset = originOffset + x*step[0] + y*step[1] + z*step[2];
+        }
+      if (voxelOffset > 0.0)
+        {
+        resected++;
+        }
+      }
+    block.SubResected[s] = resected;
+    block.Resected += resected;
+    }
+}
+
+//------------------------------------------------------------------------------
+vtkStandardNewMacro(vtkResectionVolumeCalculator);
+
+//------------------------------------------------------------------------------
+vtkResectionVolumeCalculator::vtkResectionVolumeCalculator()
+  :LabelValue(0), SeparateLabels(false), NumberOfResectedVoxels(0),
+   NumberOfRemnantVoxels(0), Internal(new vtkInternal)
+{
+}
+
+//------------------------------------------------------------------------------
+vtkResectionVolumeCalculator::~vtkResectionVolumeCalculator()
+{
+  delete this->Internal;
+}
+
+//------------------------------------------------------------------------------
+void vtkResectionVolumeCalculator::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "Label Value: " << this->LabelValue << "\n";
+  os << indent << "Separate Labels: " << this->SeparateLabels << "\n";
+  os << indent << "Number Of Labels: " << this->GetNumberOfLabels() << "\n";
+  os << indent << "Number Of Blocks: " << this->Internal->Blocks.size() << "\n";
+  os << indent << "Number Of Resected Voxels: " << this->NumberOfResectedVoxels << "\n";
+  os << indent << "Number Of Remnant Voxels: " << this->NumberOfRemnantVoxels << "\n";
+  os << indent << "Resected Volume: " << this->GetResectedVolume() << "\n";
+  os << indent << "Remnant Volume: " << this->GetRemnantVolume() << "\n";
+}
+
+//------------------------------------------------------------------------------
+void vtkResectionVolumeCalculator::SetLabelMap(vtkImageData *labelMap, vtkMatrix4x4 *ijkToRAS)
+{
+  double elements[16];
+  vtkMatrix4x4::DeepCopy(elements, ijkToRAS);
+
+  if (labelMap == this->Internal->LabelMap &&
+      std::equal(elements, elements+16, this->Internal->IJKToRAS))
+    {
+    return;
+    }
+
+  this->Internal->LabelMap = labelMap;
+  std::copy(elements, elements+16, this->Internal->IJKToRAS);
+  this->Internal->BlocksValid = false;
+  this->Modified();
+}
+
+//------------------------------------------------------------------------------
+void vtkResectionVolumeCalculator::SetPlane(const double origin[3], const double normal[3])
+{
+  auto plane = new PlaneBoundary;
+  std::copy(origin, origin+3, plane->Origin);
+  std::copy(normal, normal+3, plane->Normal);
+  if (vtkMath::Normalize(plane->Normal) == 0.0)
+    {
+    vtkErrorMacro("SetPlane: invalid plane normal.");
+    delete plane;
+    return;
+    }
+
+  // The change of the offset is affine, so it is bounded by its value at
+  // the corners of the labelmap
+  double displacement = -1.0;
+  if (this->Internal->BoundaryType == vtkInternal::Plane)
+    {
+    displacement = 0.0;
+    for (int corner=0; corner<8; corner++)
+      {
+      double closestPoint[3], unused[3];
+      bool interior;
+      const double *x = this->Internal->Corners + 3*corner;
+      double offset = plane->Evaluate(x, closestPoint, unused, interior);
+      double previousOffset = this->Internal->Boundary->Evaluate(x, closestPoint, unused, interior);
+      displacement = std::max(displacement, std::fabs(offset - previousOffset));
+      }
+    }
+
+  this->Internal->Boundary.reset(plane);
+  this->Internal->SetBoundary(vtkInternal::Plane, displacement);
+  this->Modified();
+}
+
+//------------------------------------------------------------------------------
+void vtkResectionVolumeCalculator::SetSphere(const double center[3], double radius)
+{
+  auto sphere = new SphereBoundary;
+  std::copy(center, center+3, sphere->Center);
+  sphere->Radius = radius;
+
+  double displacement = -1.0;
+  if (this->Internal->BoundaryType == vtkInternal::Sphere)
+    {
+    auto previous = static_cast<SphereBoundary*>(this->Internal->Boundary.get());
+    displacement = std::sqrt(vtkMath::Distance2BetweenPoints(center, previous->Center)) +
+      std::fabs(radius - previous->Radius);
+    }
+
+  this->Internal->Boundary.reset(sphere);
+  this->Internal->SetBoundary(vtkInternal::Sphere, displacement);
+  this->Modified();
+}
+
+//------------------------------------------------------------------------------
+void vtkResectionVolumeCalculator::SetBezierSurface(vtkPoints *controlPoints, unsigned int m, unsigned int n)
+{
+  if (!controlPoints || controlPoints->GetNumberOfPoints() < static_cast<vtkIdType>(m*n))
+    {
+    vtkErrorMacro("SetBezierSurface: not enough control points.");
+    return;
+    }
+
+  if (this->Internal->BoundaryType != vtkInternal::BezierSurface)
+    {
+    this->Internal->Boundary.reset(new BezierBoundary);
+    }
+  auto bezier = static_cast<BezierBoundary*>(this->Internal->Boundary.get());
+  unsigned int numberOfControlPoints[2];
+  bezier->BezierSurfaceSource->GetNumberOfControlPoints(numberOfControlPoints);
+
+  // By the convex hull property, the surface moves at most as much as its
+  // control points
+  double displacement = -1.0;
+  if (this->Internal->BoundaryType == vtkInternal::BezierSurface &&
+      numberOfControlPoints[0] == m && numberOfControlPoints[1] == n &&
+      this->Internal->BoundaryParameters.size() == m*n*3)
+    {
+    displacement = 0.0;
+    for (unsigned int i=0; i<m*n; i++)
+      {
+      double point[3];
+      controlPoints->GetPoint(i, point);
+      displacement = std::max(displacement,
+        vtkMath::Distance2BetweenPoints(point, &this->Internal->BoundaryParameters[3*i]));
+      }
+    displacement = std::sqrt(displacement);
+    }
+
+  this->Internal->BoundaryParameters.resize(m*n*3);
+  for (unsigned int i=0; i<m*n; i++)
+    {
+    controlPoints->GetPoint(i, &this->Internal->BoundaryParameters[3*i]);
+    }
+
+  bezier->BezierSurfaceSource->SetNumberOfControlPoints(m, n);
+  bezier->BezierSurfaceSource->SetControlPoints(controlPoints);
+  bezier->Patches.assign(1, bezier->BezierSurfaceSource.GetPointer());
+  bezier->NumberOfPatches[0] = 1;
+  bezier->NumberOfPatches[1] = 1;
+
+  this->Internal->SetBoundary(vtkInternal::BezierSurface, displacement);
+  this->Modified();
+}
+
+//------------------------------------------------------------------------------
+void vtkResectionVolumeCalculator::SetMultiPatchBezierSurface(vtkPoints *controlPoints,
+                                                              unsigned int p, unsigned int q)
+{
+  unsigned int numberOfControlPoints = (3*p+1)*(3*q+1);
+  if (!controlPoints || controlPoints->GetNumberOfPoints() < static_cast<vtkIdType>(numberOfControlPoints))
+    {
+    vtkErrorMacro("SetMultiPatchBezierSurface: not enough control points.");
+    return;
+    }
+
+  if (this->Internal->BoundaryType != vtkInternal::MultiPatchBezierSurface)
+    {
+    this->Internal->Boundary.reset(new BezierBoundary);
+    }
+  auto bezier = static_cast<BezierBoundary*>(this->Internal->Boundary.get());
+  unsigned int numberOfPatches[2];
+  bezier->MultiPatchBezierSurfaceSource->GetNumberOfPatches(numberOfPatches);
+
+  double displacement = -1.0;
+  if (this->Internal->BoundaryType == vtkInternal::MultiPatchBezierSurface &&
+      numberOfPatches[0] == p && numberOfPatches[1] == q &&
+      this->Internal->BoundaryParameters.size() == numberOfControlPoints*3)
+    {
+    displacement = 0.0;
+    for (unsigned int i=0; i<numberOfControlPoints; i++)
+      {
+      double point[3];
+      controlPoints->GetPoint(i, point);
+      displacement = std::max(displacement,
+        vtkMath::Distance2BetweenPoints(point, &this->Internal->BoundaryParameters[3*i]));
+      }
+    displacement = std::sqrt(displacement);
+    }
+
+  this->Internal->BoundaryParameters.resize(numberOfControlPoints*3);
+  for (unsigned int i=0; i<numberOfControlPoints; i++)
+    {
+    controlPoints->GetPoint(i, &this->Internal->BoundaryParameters[3*i]);
+    }
+
+  bezier->MultiPatchBezierSurfaceSource->SetNumberOfPatches(p, q);
+  bezier->MultiPatchBezierSurfaceSource->SetControlPoints(controlPoints);
+  bezier->Patches.clear();
+  for (unsigned int i=0; i<p; i++)
+    {
+    for (unsigned int j=0; j<q; j++)
+      {
+      bezier->Patches.push_back(bezier->MultiPatchBezierSurfaceSource->GetPatch(i, j));
+      }
+    }
+  bezier->NumberOfPatches[0] = p;
+  bezier->NumberOfPatches[1] = q;
+
+  this->Internal->SetBoundary(vtkInternal::MultiPatchBezierSurface, displacement);
+  this->Modified();
+}
+
+//------------------------------------------------------------------------------
+void vtkResectionVolumeCalculator::BuildBlocks()
+{
+  vtkImageData *labelMap = this->Internal->LabelMap;
+
+  int extent[6];
+  labelMap->GetExtent(extent);
+  int dimensions[3] = {extent[1]-extent[0]+1, extent[3]-extent[2]+1, extent[5]-extent[4]+1};
+  int numberOfBlocks[3];
+  for (int d=0; d<3; d++)
+    {
+    numberOfBlocks[d] = std::max(0, (dimensions[d] + BlockSize - 1) / BlockSize);
+    }
+
+  std::vector<std::vector<VoxelBlock> > slabs(numberOfBlocks[2]);
+  if (labelMap->GetPointData()->GetScalars() && numberOfBlocks[0]*numberOfBlocks[1]*numberOfBlocks[2] > 0)
+    {
+    switch (labelMap->GetScalarType())
+      {
+      vtkTemplateMacro(PackBlocks(static_cast<const VTK_TT*>(labelMap->GetScalarPointer()), extent,
+                                  labelMap->GetNumberOfScalarComponents(), this->LabelValue,
+                                  this->SeparateLabels, numberOfBlocks, slabs));
+      default:
+        vtkErrorMacro("BuildBlocks: unsupported labelmap scalar type.");
+        break;
+      }
+    }
+
+  this->Internal->Blocks.clear();
+  for (auto &slab : slabs)
+    {
+    this->Internal->Blocks.insert(this->Internal->Blocks.end(), slab.begin(), slab.end());
+    }
+
+  // Index of the label of each block
+  std::vector<double> &labelValues = this->Internal->LabelValues;
+  labelValues.clear();
+  if (!this->SeparateLabels)
+    {
+    labelValues.push_back(this->LabelValue);
+    }
+  for (const auto &block : this->Internal->Blocks)
+    {
+    if (labelValues.empty() || labelValues.back() != block.Value)
+      {
+      labelValues.push_back(block.Value);
+      }
+    }
+  std::sort(labelValues.begin(), labelValues.end());
+  labelValues.erase(std::unique(labelValues.begin(), labelValues.end()), labelValues.end());
+  for (auto &block : this->Internal->Blocks)
+    {
+    block.Label = static_cast<int>(
+      std::lower_bound(labelValues.begin(), labelValues.end(), block.Value) - labelValues.begin());
+    }
+  this->Internal->ResectedCounts.assign(labelValues.size(), 0);
+  this->Internal->TotalCounts.assign(labelValues.size(), 0);
+
+  // Geometry of the blocks in world coordinates
+  const double *m = this->Internal->IJKToRAS;
+  this->Internal->VoxelVolume = std::fabs(
+    m[0]*(m[5]*m[10] - m[6]*m[9]) - m[1]*(m[4]*m[10] - m[6]*m[8]) + m[2]*(m[4]*m[9] - m[5]*m[8]));
+  this->Internal->BlockHalfDiagonal = this->Internal->HalfDiagonal(BlockSize);
+  this->Internal->SubBlockHalfDiagonal = this->Internal->HalfDiagonal(SubBlockSize);
+  for (int corner=0; corner<8; corner++)
+    {
+    double ijk[3];
+    for (int d=0; d<3; d++)
+      {
+      ijk[d] = (corner >> d) & 1 ? extent[2*d] + numberOfBlocks[d]*BlockSize - 1 : extent[2*d];
+      }
+    this->Internal->ToWorld(ijk, this->Internal->Corners + 3*corner);
+    }
+
+  this->Internal->BlocksValid = true;
+  this->Internal->LabelMapTime = labelMap->GetMTime();
+  this->Internal->BuiltLabelValue = this->LabelValue;
+  this->Internal->BuiltSeparateLabels = this->SeparateLabels;
+  this->Internal->FullUpdate = true;
+}
+
+//------------------------------------------------------------------------------
+void vtkResectionVolumeCalculator::Update()
+{
+  if (!this->Internal->LabelMap)
+    {
+    vtkErrorMacro("Update: no labelmap set.");
+    return;
+    }
+
+  if (!this->Internal->Boundary)
+    {
+    vtkErrorMacro("Update: no resection boundary set.");
+    return;
+    }
+
+  if (!this->Internal->BlocksValid ||
+      this->Internal->LabelMapTime != this->Internal->LabelMap->GetMTime() ||
+      this->Internal->BuiltLabelValue != this->LabelValue ||
+      this->Internal->BuiltSeparateLabels != this->SeparateLabels)
+    {
+    this->BuildBlocks();
+    }
+
+  if (this->Internal->FullUpdate)
+    {
+    this->Internal->Displacement = 0.0;
+    }
+
+  vtkInternal *internal = this->Internal;
+  vtkSMPTools::For(0, static_cast<vtkIdType>(internal->Blocks.size()),
+    [internal](vtkIdType begin, vtkIdType end)
+    {
+    for (vtkIdType index=begin; index<end; index++)
+      {
+      internal->EvaluateBlock(internal->Blocks[index]);
+      }
+    });
+
+  std::vector<vtkIdType> &resectedCounts = this->Internal->ResectedCounts;
+  std::vector<vtkIdType> &totalCounts = this->Internal->TotalCounts;
+  std::fill(resectedCounts.begin(), resectedCounts.end(), 0);
+  std::fill(totalCounts.begin(), totalCounts.end(), 0);
+  vtkIdType resected = 0;
+  vtkIdType total = 0;
+  for (const auto &block : this->Internal->Blocks)
+    {
+    resectedCounts[block.Label] += block.Resected;
+    totalCounts[block.Label] += block.Count;
+    resected += block.Resected;
+    total += block.Count;
+    }
+
+  this->NumberOfResectedVoxels = resected;
+  this->NumberOfRemnantVoxels = total - resected;
+  this->Internal->FullUpdate = false;
+}
+
+//------------------------------------------------------------------------------
+double vtkResectionVolumeCalculator::GetResectedVolume() const
+{
+  return this->NumberOfResectedVoxels * this->Internal->VoxelVolume;
+}
+
+//------------------------------------------------------------------------------
+double vtkResectionVolumeCalculator::GetRemnantVolume() const
+{
+  return this->NumberOfRemnantVoxels * this->Internal->VoxelVolume;
+}
+
+//------------------------------------------------------------------------------
+int vtkResectionVolumeCalculator::GetNumberOfLabels() const
+{
+  return static_cast<int>(this->Internal->LabelValues.size());
+}
+
+//------------------------------------------------------------------------------
+double vtkResectionVolumeCalculator::GetNthLabelValue(int n) const
+{
+  if (n < 0 || n >= this->GetNumberOfLabels())
+    {
+    return 0.0;
+    }
+  return this->Internal->LabelValues[n];
+}
+
+//------------------------------------------------------------------------------
+int vtkResectionVolumeCalculator::GetLabelIndex(double labelValue) const
+{
+  const std::vector<double> &labelValues = this->Internal->LabelValues;
+  auto it = std::lower_bound(labelValues.begin(), labelValues.end(), labelValue);
+  if (it == labelValues.end() || *it != labelValue)
+    {
+    return -1;
+    }
+  return static_cast<int>(it - labelValues.begin());
+}
+
+//------------------------------------------------------------------------------
+vtkIdType vtkResectionVolumeCalculator::GetNthNumberOfResectedVoxels(int n) const
+{
+  if (n < 0 || n >= this->GetNumberOfLabels())
+    {
+    return 0;
+    }
+  return this->Internal->ResectedCounts[n];
+}
+
+//------------------------------------------------------------------------------
+vtkIdType vtkResectionVolumeCalculator::GetNthNumberOfRemnantVoxels(int n) const
+{
+  if (n < 0 || n >= this->GetNumberOfLabels())
+    {
+    return 0;
+    }
+  return this->Internal->TotalCounts[n] - this->Internal->ResectedCounts[n];
+}
+
+//------------------------------------------------------------------------------
+double vtkResectionVolumeCalculator::GetNthResectedVolume(int n) const
+{
+  return this->GetNthNumberOfResectedVoxels(n) * this->Internal->VoxelVolume;
+}
+
+//------------------------------------------------------------------------------
+double vtkResectionVolumeCalculator::GetNthRemnantVolume(int n) const
+{
+  return this->GetNthNumberOfRemnantVoxels(n) * this->Internal->VoxelVolume;
+}
@@ -0,0 +1,159 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (The Intervention Centre,
+  Oslo University Hospital) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+#ifndef __vtkresectionvolumecalculator_h_
+#define __vtkresectionvolumecalculator_h_
+
+#include "vtkSlicerLiverResectionsModuleLogicExport.h"
+
+// VTK includes
+#include <vtkObject.h>
+
+//------------------------------------------------------------------------------
+class vtkImageData;
+class vtkMatrix4x4;
+class vtkPoints;
+
+//------------------------------------------------------------------------------
+/// Computation of the resected and remnant volumes of a labelmap for a
+/// resection boundary (plane, sphere or single/multi-patch Bezier surface).
+///
+/// The labelmap is packed once into blocks of 8x8x8 voxels made of 4x4x4
+/// sub-blocks stored as bit masks. A block is classified as a whole when its
+/// center is farther from the boundary than its half diagonal; otherwise its
+/// sub-blocks are classified the same way and the sub-blocks crossed by the
+/// boundary are classified voxel by voxel against the tangent plane at the
+/// closest boundary point. The resected side is the side the boundary normal
+/// points to (the inside for spheres).
+///
+/// Updates are incremental: every change of the boundary carries a bound of
+/// how far the boundary moved (e.g. the largest control point displacement
+/// for Bezier surfaces, by the convex hull property) and only the blocks
+/// whose classification margin is smaller than the accumulated displacement
+/// are re-evaluated. Beyond the border of a Bezier surface the side is the
+/// one of the normal at the border, which the displacement does not bound:
+/// the blocks whose closest point is on the border are re-evaluated at every
+/// update and their voxels are classified one by one.
+///
+/// With SeparateLabels on, the voxels of every label value are counted
+/// separately in the same pass (e.g. the segments of a segmentation sharing
+/// a labelmap), blocks holding several labels being split by label.
+class VTK_SLICER_LIVERRESECTIONS_MODULE_LOGIC_EXPORT vtkResectionVolumeCalculator
+: public vtkObject
+{
+public:
+  static vtkResectionVolumeCalculator* New();
+  vtkTypeMacro(vtkResectionVolumeCalculator, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Set the labelmap and its voxel (IJK) to world (RAS) transform. The
+  /// labelmap is only packed again when it (or the transform) changes.
+  void SetLabelMap(vtkImageData *labelMap, vtkMatrix4x4 *ijkToRAS);
+
+  /// Label of the voxels to count (0, the default, counts every non-zero voxel)
+  vtkSetMacro(LabelValue, int);
+  vtkGetMacro(LabelValue, int);
+
+  /// Count the voxels of every non-zero label separately (off by default).
+  /// LabelValue is ignored when on.
+  vtkSetMacro(SeparateLabels, bool);
+  vtkGetMacro(SeparateLabels, bool);
+  vtkBooleanMacro(SeparateLabels, bool);
+
+  /// Set a plane boundary. The resected side is the one the normal points to.
+  void SetPlane(const double origin[3], const double normal[3]);
+
+  /// Set a sphere boundary. The inside of the sphere is resected.
+  void SetSphere(const double center[3], double radius);
+
+  /// Set a Bezier surface boundary with a m x n grid of control points
+  /// (control point (i,j) at index i*n+j).
+  void SetBezierSurface(vtkPoints *controlPoints, unsigned int m, unsigned int n);
+
+  /// Set a C1 multi-patch Bezier surface boundary with p x q bicubic patches
+  /// (see vtkMultiPatchBezierSurfaceSource for the control point layout).
+  void SetMultiPatchBezierSurface(vtkPoints *controlPoints, unsigned int p, unsigned int q);
+
+  /// Classify the voxels of the labelmap against the current boundary
+  void Update();
+
+  /// Number of resected and remnant voxels computed by the last update
+  vtkGetMacro(NumberOfResectedVoxels, vtkIdType);
+  vtkGetMacro(NumberOfRemnantVoxels, vtkIdType);
+
+  /// Resected and remnant volumes (in mm^3) computed by the last update
+  double GetResectedVolume() const;
+  double GetRemnantVolume() const;
+
+  /// Labels counted by the last update (in increasing order of label value)
+  /// and their counts and volumes. Without SeparateLabels, there is a single
+  /// label (LabelValue).
+  int GetNumberOfLabels() const;
+  double GetNthLabelValue(int n) const;
+  vtkIdType GetNthNumberOfResectedVoxels(int n) const;
+  vtkIdType GetNthNumberOfRemnantVoxels(int n) const;
+  double GetNthResectedVolume(int n) const;
+  double GetNthRemnantVolume(int n) const;
+
+  /// Index of a label value (-1 if not present in the labelmap)
+  int GetLabelIndex(double labelValue) const;
+
+protected:
+  vtkResectionVolumeCalculator();
+  ~vtkResectionVolumeCalculator() override;
+
+  /// Packing of the labelmap into blocks of bit masks
+  void BuildBlocks();
+
+protected:
+  int LabelValue;
+  bool SeparateLabels;
+  vtkIdType NumberOfResectedVoxels;
+  vtkIdType NumberOfRemnantVoxels;
+
+private:
+  class vtkInternal;
+  vtkInternal* Internal;
+
+private:
+  vtkResectionVolumeCalculator(const vtkResectionVolumeCalculator&) = delete;
+  void operator=(const vtkResectionVolumeCalculator&) = delete;
+};
+
+#endif // __vtkresectionvolumecalculator_h_
@@ -37,34 +37,379 @@
 
 ==============================================================================*/
 #include "vtkSlicerLiverResectionsLogic.h"
+#include "vtkResectionMarginFilter.h"
+#include "vtkResectionSplitFilter.h"
+#include "vtkResectionVolumeCalculator.h"
 
 #include <vtkMRMLMarkupsSlicingContourNode.h>
 #include <vtkMRMLMarkupsDistanceContourNode.h>
+#include <vtkMRMLMarkupsBezierSurfaceNode.h>
+#include <vtkMRMLMarkupsMultiPatchBezierSurfaceNode.h>
 #include <vtkMRMLMarkupsDisplayNode.h>
 
+// Liver Markups VTKAlgorithms includes
+#include <vtkBezierSurfaceSource.h>
+#include <vtkMultiPatchBezierSurfaceSource.h>
+
 // MRML includes
+#include <vtkMRMLLabelMapVolumeNode.h>
+#include <vtkMRMLModelDisplayNode.h>
+#include <vtkMRMLModelNode.h>
 #include <vtkMRMLScene.h>
 #include <vtkMRMLSelectionNode.h>
 
+// Segmentations includes
+#include <vtkMRMLSegmentationNode.h>
+#include <vtkOrientedImageData.h>
+#include <vtkSegment.h>
+#include <vtkSegmentation.h>
+#include <vtkSegmentationConverter.h>
+
 // VTK includes
+#include <vtkCellArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkImageData.h>
+#include <vtkIntArray.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
 #include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkPolyDataNormals.h>
+#include <vtkSMPTools.h>
+#include <vtkSmartPointer.h>
+#include <vtkStaticCellLocator.h>
+#include <vtkStaticPointLocator.h>
+#include <vtkStringArray.h>
+#include <vtkTable.h>
+#include <vtkTimerLog.h>
+#include <vtkTriangleFilter.h>
+
+// STD includes
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+// Signed distance of the parenchyma vertices to the resection surface. The
+// sign is given by the side of the surface normal at the closest point of the
+// closest patch.
+//
+// NOTE: The surface is open. Beyond its border the closest point lies on the
+// border and the sign is the side of the normal there, which only extends the
+// surface sensibly when it is nearly flat at the border. The classification
+// is thus only meaningful when the surface spans the whole parenchyma.
+class SignedDistanceFunctor
+{
+public:
+  SignedDistanceFunctor(vtkPoints *points,
+                        const std::vector<vtkBezierSurfaceSource*> &patches,
+                        vtkDoubleArray *signedDistances)
+    :Points(points), Patches(patches), SignedDistances(signedDistances)
+  {}
+
+  void operator()(vtkIdType begin, vtkIdType end)
+  {
+    for (vtkIdType pointId=begin; pointId<end; pointId++)
+      {
+      double point[3];
+      this->Points->GetPoint(pointId, point);
+
+      double closestDistance = VTK_DOUBLE_MAX;
+      double signedDistance = 0.0;
+      for (auto patch : this->Patches)
+        {
+        double closestPoint[3], parametricCoordinates[2];
+        double distance = patch->ProjectPoint(point, closestPoint, parametricCoordinates);
+        if (distance >= closestDistance)
+          {
+          continue;
+          }
+
+        double surfacePoint[3], derivativeU[3], derivativeV[3], normal[3], offset[3];
+        patch->EvaluatePoint(parametricCoordinates[0], parametricCoordinates[1],
+                             surfacePoint, derivativeU, derivativeV);
+        vtkMath::Cross(derivativeU, derivativeV, normal);
+        vtkMath::Subtract(point, closestPoint, offset);
+
+        closestDistance = distance;
+        signedDistance = vtkMath::Dot(offset, normal) < 0.0 ? -distance : distance;
+        }
+
+      this->SignedDistances->SetValue(pointId, signedDistance);
+      }
+  }
+
+private:
+  vtkPoints *Points;
+  const std::vector<vtkBezierSurfaceSource*> &Patches;
+  vtkDoubleArray *SignedDistances;
+};
+
+//------------------------------------------------------------------------------
+// Connected components of a graph by union-find
+class DisjointSets
+{
+public:
+  explicit DisjointSets(vtkIdType size)
+    :Parents(size)
+  {
+    for (vtkIdType i=0; i<size; i++)
+      {
+      this->Parents[i] = i;
+      }
+  }
+
+  vtkIdType Find(vtkIdType i)
+  {
+    while (this->Parents[i] != i)
+      {
+      this->Parents[i] = this->Parents[this->Parents[i]];
+      i = this->Parents[i];
+      }
+    return i;
+  }
+
+  void Union(vtkIdType i, vtkIdType j)
+  {
+    i = this->Find(i);
+    j = this->Find(j);
+    if (i != j)
+      {
+      this->Parents[std::max(i, j)] = std::min(i, j);
+      }
+  }
+
+private:
+  std::vector<vtkIdType> Parents;
+};
+
+//------------------------------------------------------------------------------
+// Edges of the polygons (each shared side once) and polylines of a polydata
+void GetEdges(vtkPolyData *polyData, std::vector<std::pair<vtkIdType, vtkIdType> > &edges)
+{
+  vtkIdType numberOfPoints;
+  const vtkIdType *pointIds;
+
+  vtkCellArray *polys = polyData->GetPolys();
+  for (polys->InitTraversal(); polys->GetNextCell(numberOfPoints, pointIds);)
+    {
+    for (vtkIdType i=0; i<numberOfPoints; i++)
+      {
+      vtkIdType first = pointIds[i];
+      vtkIdType second = pointIds[(i+1) % numberOfPoints];
+      if (first < second)
+        {
+        edges.emplace_back(first, second);
+        }
+      }
+    }
+
+  vtkCellArray *lines = polyData->GetLines();
+  for (lines->InitTraversal(); lines->GetNextCell(numberOfPoints, pointIds);)
+    {
+    for (vtkIdType i=0; i+1<numberOfPoints; i++)
+      {
+      edges.emplace_back(pointIds[i], pointIds[i+1]);
+      }
+    }
+}
+
+//------------------------------------------------------------------------------
+// NOTE: The builds run on detached threads rather than std::async, whose
+// futures block in their destructor: an entry dropped with its target (or
+// with the logic) releases a build in progress without waiting for it.
+std::future<vtkSmartPointer<vtkStaticCellLocator> > BuildLocatorInBackground(vtkSmartPointer<vtkPolyData> polyData)
+{
+  std::packaged_task<vtkSmartPointer<vtkStaticCellLocator>()> build([polyData]()
+    {
+    auto locator = vtkSmartPointer<vtkStaticCellLocator>::New();
+    locator->SetDataSet(polyData);
+    locator->BuildLocator();
+    return locator;
+    });
+  auto locator = build.get_future();
+  std::thread(std::move(build)).detach();
+  return locator;
+}
+
+}
+
+
+//------------------------------------------------------------------------------
+// Exact representation of a Bezier resection surface (one source per patch),
+// cached per resection node. The sources are only updated when the control
+// points change: moving them invokes PointModifiedEvent but does not
+// necessarily modify the node, so the positions themselves are the key.
+class vtkSlicerLiverResectionsLogic::ResectionSurface
+{
+public:
+  ResectionSurface()
+  {
+    this->BezierSurfaceSource->SetResolution(vtkBezierSurfaceSource::DisplayResolution,
+                                             vtkBezierSurfaceSource::DisplayResolution);
+    this->MultiPatchBezierSurfaceSource->SetResolution(vtkMultiPatchBezierSurfaceSource::DisplayResolution,
+                                                       vtkMultiPatchBezierSurfaceSource::DisplayResolution);
+  }
+
+  /// Returns false if the surface is incomplete. The projection seeds of
+  /// every patch are built, so the patches can be queried concurrently.
+  bool SetSurface(vtkMRMLMarkupsBezierSurfaceNode *resectionSurfaceNode)
+  {
+    int gridSize[2];
+    resectionSurfaceNode->GetControlPointGridSize(gridSize);
+    int numberOfControlPoints = gridSize[0]*gridSize[1];
+    if (resectionSurfaceNode->GetNumberOfControlPoints() != numberOfControlPoints)
+      {
+      return false;
+      }
+
+    auto multiPatchNode = vtkMRMLMarkupsMultiPatchBezierSurfaceNode::SafeDownCast(resectionSurfaceNode);
+    int numberOfPatches[2] = {1, 1};
+    if (multiPatchNode)
+      {
+      multiPatchNode->GetNumberOfPatches(numberOfPatches);
+      }
+
+    std::vector<double> positions(3*numberOfControlPoints);
+    for (int i=0; i<numberOfControlPoints; i++)
+      {
+      resectionSurfaceNode->GetNthControlPointPosition(i, &positions[3*i]);
+      }
+    if (!this->Patches.empty() && this->MultiPatch == (multiPatchNode != nullptr) &&
+        std::equal(gridSize, gridSize+2, this->GridSize) &&
+        std::equal(numberOfPatches, numberOfPatches+2, this->NumberOfPatches) &&
+        positions == this->Positions)
+      {
+      return true;
+      }
+
+    vtkNew<vtkPoints> controlPoints;
+    controlPoints->SetDataTypeToDouble();
+    controlPoints->SetNumberOfPoints(numberOfControlPoints);
+    for (int i=0; i<numberOfControlPoints; i++)
+      {
+      controlPoints->SetPoint(i, &positions[3*i]);
+      }
+    controlPoints->GetBounds(this->Bounds);
+
+    this->Patches.clear();
+    this->MultiPatch = multiPatchNode != nullptr;
+    std::copy(gridSize, gridSize+2, this->GridSize);
+    std::copy(numberOfPatches, numberOfPatches+2, this->NumberOfPatches);
+    this->Positions.swap(positions);
+    if (multiPatchNode)
+      {
+      this->MultiPatchBezierSurfaceSource->SetNumberOfPatches(numberOfPatches[0], numberOfPatches[1]);
+      this->MultiPatchBezierSurfaceSource->SetControlPoints(controlPoints);
+      for (int p=0; p<numberOfPatches[0]; p++)
+        {
+        for (int q=0; q<numberOfPatches[1]; q++)
+          {
+          this->Patches.push_back(this->MultiPatchBezierSurfaceSource->GetPatch(p, q));
+          }
+        }
+      }
+    else
+      {
+      this->BezierSurfaceSource->SetNumberOfControlPoints(gridSize[0], gridSize[1]);
+      this->BezierSurfaceSource->SetControlPoints(controlPoints);
+      this->Patches.push_back(this->BezierSurfaceSource.GetPointer());
+      }
+
+    return true;
+  }
+
+  /// Whether the segment p1-p2 crosses the surface (at x)
+  bool IntersectWithLine(const double p1[3], const double p2[3], double x[3]) const
+  {
+    for (auto patch : this->Patches)
+      {
+      double t;
+      if (patch->IntersectWithLine(p1, p2, 1e-6, t, x))
+        {
+        return true;
+        }
+      }
+    return false;
+  }
+
+  /// Tessellation of the surface, at the resolution it is displayed with
+  vtkPolyData* GetTessellation()
+  {
+    if (this->MultiPatch)
+      {
+      this->MultiPatchBezierSurfaceSource->Update();
+      return this->MultiPatchBezierSurfaceSource->GetOutput();
+      }
+    this->BezierSurfaceSource->Update();
+    return this->BezierSurfaceSource->GetOutput();
+  }
+
+  /// Bounds of the control points, which contain the surface
+  double Bounds[6];
+  std::vector<vtkBezierSurfaceSource*> Patches;
+  /// Layout of the patches, in the parametric u and v directions
+  int NumberOfPatches[2] = {0, 0};
+
+private:
+  bool MultiPatch = false;
+  int GridSize[2] = {0, 0};
+  std::vector<double> Positions;
+  vtkNew<vtkBezierSurfaceSource> BezierSurfaceSource;
+  vtkNew<vtkMultiPatchBezierSurfaceSource> MultiPatchBezierSurfaceSource;
+};
+
+//------------------------------------------------------------------------------
+// Spatial index of a target parenchyma: the locator of the current polydata
+// and the one being built in the background, with the modification times of
+// the polydata they index
+struct vtkSlicerLiverResectionsLogic::TargetParenchymaLocator
+{
+  vtkSmartPointer<vtkStaticCellLocator> Locator;
+  vtkMTimeType LocatorTime = 0;
+  std::future<vtkSmartPointer<vtkStaticCellLocator> > PendingLocator;
+  vtkMTimeType PendingLocatorTime = 0;
+};
 
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerLiverResectionsLogic);
 
 //---------------------------------------------------------------------------
 vtkSlicerLiverResectionsLogic::vtkSlicerLiverResectionsLogic()
+  :ResectionVolumesNode(nullptr), ResectionVolumesUpdateInterval(1.0/30.0),
+   LastResectionVolumesUpdateTime(0.0), ResectionVolumesUpdatePending(false),
+   ResectionVolumesInteracting(false)
 {
-
+  this->ResectionVolumeCalculator = vtkSmartPointer<vtkResectionVolumeCalculator>::New();
+  this->ResectionMarginFilter = vtkSmartPointer<vtkResectionMarginFilter>::New();
 }
 
 //---------------------------------------------------------------------------
-vtkSlicerLiverResectionsLogic::~vtkSlicerLiverResectionsLogic() = default;
+vtkSlicerLiverResectionsLogic::~vtkSlicerLiverResectionsLogic()
+{
+  vtkSetAndObserveMRMLNodeMacro(this->ResectionVolumesNode, nullptr);
+}
 
 //---------------------------------------------------------------------------
 void vtkSlicerLiverResectionsLogic::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "Resection Volumes Update Interval: " << this->ResectionVolumesUpdateInterval << "\n";
+  os << indent << "Resected Volume: " << this->GetResectedVolume() << "\n";
+  os << indent << "Remnant Volume: " << this->GetRemnantVolume() << "\n";
 }
 
 //---------------------------------------------------------------------------
@@ -78,10 +423,87 @@ void vtkSlicerLiverResectionsLogic::ObserveMRMLScene()
  this->Superclass::ObserveMRMLScene();
 }
 
+//---------------------------------------------------------------------------
+void vtkSlicerLiverResectionsLogic::SetMRMLSceneInternal(vtkMRMLScene* newScene)
+{
+  vtkNew<vtkIntArray> events;
+  events->InsertNextValue(vtkMRMLScene::NodeAddedEvent);
+  events->InsertNextValue(vtkMRMLScene::NodeRemovedEvent);
+  this->SetAndObserveMRMLSceneEventsInternal(newScene, events.GetPointer());
+}
+
 //---------------------------------------------------------------------------
 void vtkSlicerLiverResectionsLogic::OnMRMLSceneNodeAdded(vtkMRMLNode* node)
 {
   Superclass::OnMRMLSceneNodeAdded(node);
+
+  // The resections of a target share its spatial index, which is built as
+  // soon as the first of them is added
+  vtkMRMLModelNode *targetParenchymaModelNode = nullptr;
+  if (auto slicingContourNode = vtkMRMLMarkupsSlicingContourNode::SafeDownCast(node))
+    {
+    targetParenchymaModelNode = slicingContourNode->GetTarget();
+    }
+  else if (auto distanceContourNode = vtkMRMLMarkupsDistanceContourNode::SafeDownCast(node))
+    {
+    targetParenchymaModelNode = distanceContourNode->GetTarget();
+    }
+  else if (auto bezierSurfaceNode = vtkMRMLMarkupsBezierSurfaceNode::SafeDownCast(node))
+    {
+    targetParenchymaModelNode = bezierSurfaceNode->GetTarget();
+    }
+  this->UpdateTargetParenchymaLocator(targetParenchymaModelNode);
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerLiverResectionsLogic::OnMRMLSceneNodeRemoved(vtkMRMLNode* node)
+{
+  Superclass::OnMRMLSceneNodeRemoved(node);
+
+  if (node == this->ResectionVolumesNode)
+    {
+    vtkSetAndObserveMRMLNodeMacro(this->ResectionVolumesNode, nullptr);
+    }
+
+  this->ResectionSurfaces.erase(vtkMRMLMarkupsBezierSurfaceNode::SafeDownCast(node));
+
+  this->TargetParenchymaLocators.erase(vtkMRMLModelNode::SafeDownCast(node));
+}
+
+//---------------------------------------------------------------------------
+void vtkSlicerLiverResectionsLogic::ProcessMRMLNodesEvents(vtkObject* caller, unsigned long event, void* callData)
+{
+  if (caller != nullptr && caller == this->ResectionVolumesNode)
+    {
+    // Updates are throttled while the control points are dragged, the last
+    // pending one is done when the interaction ends. Changes outside an
+    // interaction have no end event to flush them, so they update at once.
+    double time = vtkTimerLog::GetUniversalTime();
+    if (event == vtkMRMLMarkupsNode::PointStartInteractionEvent)
+      {
+      this->ResectionVolumesInteracting = true;
+      }
+    else if (event == vtkMRMLMarkupsNode::PointEndInteractionEvent)
+      {
+      this->ResectionVolumesInteracting = false;
+      if (this->ResectionVolumesUpdatePending)
+        {
+        this->UpdateResectionVolumes();
+        }
+      }
+    else if (!this->ResectionVolumesInteracting ||
+             time - this->LastResectionVolumesUpdateTime >= this->ResectionVolumesUpdateInterval)
+      {
+      this->UpdateResectionVolumes();
+      }
+    else
+      {
+      this->ResectionVolumesUpdatePending = true;
+      }
+    return;
+    }
+
+  this->Superclass::ProcessMRMLNodesEvents(caller, event, callData);
 }
 
 //---------------------------------------------------------------------------
@@ -194,4 +616,780 @@ void vtkSlicerLiverResectionsLogic::SetTargetParenchyma(vtkMRMLModelNode *target
     }
 
   this->TargetParenchymaModelNode = targetParenchymaModelNode;
+  this->UpdateTargetParenchymaLocator(targetParenchymaModelNode);
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerLiverResectionsLogic::SplitParenchyma(vtkMRMLMarkupsBezierSurfaceNode *resectionSurfaceNode,
+                                                    vtkMRMLModelNode *targetParenchymaModelNode,
+                                                    vtkMRMLModelNode *resectedModelNode,
+                                                    vtkMRMLModelNode *remnantModelNode)
+{
+  if (!resectionSurfaceNode)
+    {
+    vtkErrorMacro("Error in SplitParenchyma: no resection surface provided.");
+    return false;
+    }
+
+  if (!resectedModelNode || !remnantModelNode)
+    {
+    vtkErrorMacro("Error in SplitParenchyma: no output models provided.");
+    return false;
+    }
+
+  if (!targetParenchymaModelNode)
+    {
+    targetParenchymaModelNode = resectionSurfaceNode->GetTarget() ?
+      resectionSurfaceNode->GetTarget() : this->TargetParenchymaModelNode.GetPointer();
+    }
+  if (!targetParenchymaModelNode || !targetParenchymaModelNode->GetPolyData() ||
+      !targetParenchymaModelNode->GetPolyData()->GetPoints())
+    {
+    vtkErrorMacro("Error in SplitParenchyma: target liver model does not contain valid polydata.");
+    return false;
+    }
+  vtkPolyData *targetParenchymaPolyData = targetParenchymaModelNode->GetPolyData();
+
+  // Exact representation of the resection surface (one source per patch)
+  ResectionSurface *resectionSurface = this->GetResectionSurface(resectionSurfaceNode);
+  if (!resectionSurface)
+    {
+    vtkErrorMacro("Error in SplitParenchyma: the resection surface is incomplete.");
+    return false;
+    }
+
+  // Classification of the vertices by their signed distance to the surface
+  vtkPoints *points = targetParenchymaPolyData->GetPoints();
+  vtkNew<vtkDoubleArray> signedDistances;
+  signedDistances->SetName("ResectionSignedDistance");
+  signedDistances->SetNumberOfComponents(1);
+  signedDistances->SetNumberOfTuples(points->GetNumberOfPoints());
+
+  SignedDistanceFunctor signedDistanceFunctor(points, resectionSurface->Patches, signedDistances);
+  vtkSMPTools::For(0, points->GetNumberOfPoints(), signedDistanceFunctor);
+
+  vtkNew<vtkPolyData> classifiedPolyData;
+  classifiedPolyData->ShallowCopy(targetParenchymaPolyData);
+  classifiedPolyData->GetPointData()->SetScalars(signedDistances);
+
+  // The split works on triangles: other meshes are triangulated first, and
+  // the shared index, whose cell ids are the ones of the target, is not used
+  vtkAbstractCellLocator *parenchymaLocator = nullptr;
+  vtkNew<vtkTriangleFilter> triangleFilter;
+  vtkNew<vtkResectionSplitFilter> splitFilter;
+  if (targetParenchymaPolyData->GetNumberOfCells() == targetParenchymaPolyData->GetNumberOfPolys() &&
+      targetParenchymaPolyData->GetPolys()->GetMaxCellSize() == 3)
+    {
+    parenchymaLocator = this->GetTargetParenchymaLocator(targetParenchymaModelNode);
+    if (!parenchymaLocator)
+      {
+      vtkErrorMacro("Error in SplitParenchyma: target liver model does not contain valid polydata.");
+      return false;
+      }
+    splitFilter->SetInputData(classifiedPolyData);
+    }
+  else
+    {
+    triangleFilter->SetInputData(classifiedPolyData);
+    triangleFilter->PassLinesOff();
+    triangleFilter->PassVertsOff();
+    splitFilter->SetInputConnection(triangleFilter->GetOutputPort());
+    }
+
+  // Clipping of the straddling triangles at the zero level of the distance
+  // and capping of the cut with the part of the surface it bounds
+  for (vtkBezierSurfaceSource *patch : resectionSurface->Patches)
+    {
+    splitFilter->AddPatch(patch);
+    }
+  splitFilter->SetPatchGridSize(resectionSurface->NumberOfPatches);
+  if (resectionSurface->Patches.size() > 1)
+    {
+    splitFilter->SetResolution(vtkMultiPatchBezierSurfaceSource::DisplayResolution,
+                               vtkMultiPatchBezierSurfaceSource::DisplayResolution);
+    }
+  else
+    {
+    splitFilter->SetResolution(vtkBezierSurfaceSource::DisplayResolution,
+                               vtkBezierSurfaceSource::DisplayResolution);
+    }
+  splitFilter->SetLocator(parenchymaLocator);
+  splitFilter->Update();
+  if (splitFilter->GetResectedOutput()->GetNumberOfPoints() == 0 &&
+      splitFilter->GetRemnantOutput()->GetNumberOfPoints() == 0)
+    {
+    vtkErrorMacro("Error in SplitParenchyma: the target liver model could not be split.");
+    return false;
+    }
+
+  // Point normals for the display, not split at sharp edges so that the
+  // models stay closed
+  vtkNew<vtkPolyDataNormals> resectedNormals;
+  resectedNormals->SetInputConnection(splitFilter->GetOutputPort(0));
+  resectedNormals->ConsistencyOff();
+  resectedNormals->SplittingOff();
+  resectedNormals->Update();
+
+  vtkNew<vtkPolyDataNormals> remnantNormals;
+  remnantNormals->SetInputConnection(splitFilter->GetOutputPort(1));
+  remnantNormals->ConsistencyOff();
+  remnantNormals->SplittingOff();
+  remnantNormals->Update();
+
+  resectedModelNode->SetAndObservePolyData(resectedNormals->GetOutput());
+  remnantModelNode->SetAndObservePolyData(remnantNormals->GetOutput());
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerLiverResectionsLogic::SetResectionVolumesLabelMap(vtkMRMLLabelMapVolumeNode *labelMapNode)
+{
+  this->ResectionVolumesLabelMapNode = labelMapNode;
+
+  // The resection may have been set first
+  if (this->ResectionVolumesNode && this->ResectionVolumesLabelMapNode)
+    {
+    this->UpdateResectionVolumes();
+    }
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerLiverResectionsLogic::SetResectionVolumesNode(vtkMRMLMarkupsNode *resectionNode)
+{
+  vtkNew<vtkIntArray> events;
+  events->InsertNextValue(vtkMRMLMarkupsNode::PointAddedEvent);
+  events->InsertNextValue(vtkMRMLMarkupsNode::PointRemovedEvent);
+  events->InsertNextValue(vtkMRMLMarkupsNode::PointModifiedEvent);
+  events->InsertNextValue(vtkMRMLMarkupsNode::PointStartInteractionEvent);
+  events->InsertNextValue(vtkMRMLMarkupsNode::PointEndInteractionEvent);
+  vtkSetAndObserveMRMLNodeEventsMacro(this->ResectionVolumesNode, resectionNode, events.GetPointer());
+
+  this->ResectionVolumesUpdatePending = false;
+  this->ResectionVolumesInteracting = false;
+  if (this->ResectionVolumesNode && this->ResectionVolumesLabelMapNode)
+    {
+    this->UpdateResectionVolumes();
+    }
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerLiverResectionsLogic::UpdateResectionVolumes()
+{
+  this->ResectionVolumesUpdatePending = false;
+
+  if (!this->ResectionVolumesNode)
+    {
+    vtkErrorMacro("Error in UpdateResectionVolumes: no resection provided.");
+    return false;
+    }
+
+  if (!this->ResectionVolumesLabelMapNode || !this->ResectionVolumesLabelMapNode->GetImageData())
+    {
+    vtkErrorMacro("Error in UpdateResectionVolumes: no valid liver labelmap provided.");
+    return false;
+    }
+
+  vtkNew<vtkMatrix4x4> ijkToRAS;
+  this->ResectionVolumesLabelMapNode->GetIJKToRASMatrix(ijkToRAS);
+  this->ResectionVolumeCalculator->SetLabelMap(this->ResectionVolumesLabelMapNode->GetImageData(), ijkToRAS);
+
+  if (!this->SetResectionBoundary(this->ResectionVolumeCalculator, this->ResectionVolumesNode))
+    {
+    return false;
+    }
+
+  this->ResectionVolumeCalculator->Update();
+  this->LastResectionVolumesUpdateTime = vtkTimerLog::GetUniversalTime();
+
+  this->InvokeEvent(ResectionVolumesModifiedEvent);
+  return true;
+}
+
+//------------------------------------------------------------------------------
+double vtkSlicerLiverResectionsLogic::GetResectedVolume() const
+{
+  return this->ResectionVolumeCalculator->GetResectedVolume();
+}
+
+//------------------------------------------------------------------------------
+double vtkSlicerLiverResectionsLogic::GetRemnantVolume() const
+{
+  return this->ResectionVolumeCalculator->GetRemnantVolume();
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerLiverResectionsLogic::SetResectionBoundary(vtkResectionVolumeCalculator *calculator,
+                                                         vtkMRMLMarkupsNode *resectionNode)
+{
+  int numberOfControlPoints = resectionNode->GetNumberOfControlPoints();
+  vtkNew<vtkPoints> controlPoints;
+  controlPoints->SetDataTypeToDouble();
+  controlPoints->SetNumberOfPoints(numberOfControlPoints);
+  for (int i=0; i<numberOfControlPoints; i++)
+    {
+    double point[3];
+    resectionNode->GetNthControlPointPosition(i, point);
+    controlPoints->SetPoint(i, point);
+    }
+
+  auto multiPatchNode = vtkMRMLMarkupsMultiPatchBezierSurfaceNode::SafeDownCast(resectionNode);
+  auto bezierSurfaceNode = vtkMRMLMarkupsBezierSurfaceNode::SafeDownCast(resectionNode);
+  if (bezierSurfaceNode)
+    {
+    // The surface is not complete while it is being placed
+    int gridSize[2];
+    bezierSurfaceNode->GetControlPointGridSize(gridSize);
+    if (numberOfControlPoints != gridSize[0]*gridSize[1])
+      {
+      return false;
+      }
+
+    if (multiPatchNode)
+      {
+      int numberOfPatches[2];
+      multiPatchNode->GetNumberOfPatches(numberOfPatches);
+      calculator->SetMultiPatchBezierSurface(controlPoints, numberOfPatches[0], numberOfPatches[1]);
+      }
+    else
+      {
+      calculator->SetBezierSurface(controlPoints, gridSize[0], gridSize[1]);
+      }
+    }
+  else if (vtkMRMLMarkupsSlicingContourNode::SafeDownCast(resectionNode) ||
+           vtkMRMLMarkupsDistanceContourNode::SafeDownCast(resectionNode))
+    {
+    if (numberOfControlPoints != 2)
+      {
+      return false;
+      }
+
+    double point1[3], point2[3];
+    controlPoints->GetPoint(0, point1);
+    controlPoints->GetPoint(1, point2);
+    if (vtkMRMLMarkupsSlicingContourNode::SafeDownCast(resectionNode))
+      {
+      // Plane through the middle point, the side of the second point is resected
+      double origin[3], normal[3];
+      for (int k=0; k<3; k++)
+        {
+        origin[k] = 0.5*(point1[k] + point2[k]);
+        normal[k] = point2[k] - point1[k];
+        }
+      calculator->SetPlane(origin, normal);
+      }
+    else
+      {
+      // Sphere centered at the reference (second) point through the first one
+      double radius = std::sqrt(vtkMath::Distance2BetweenPoints(point1, point2));
+      calculator->SetSphere(point2, radius);
+      }
+    }
+  else
+    {
+    vtkErrorMacro("Error in SetResectionBoundary: unsupported resection type.");
+    return false;
+    }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerLiverResectionsLogic::ComputeSegmentResectionVolumes(vtkMRMLSegmentationNode *segmentationNode,
+                                                                   vtkMRMLMarkupsNode *resectionNode,
+                                                                   vtkTable *volumes)
+{
+  if (!segmentationNode || !segmentationNode->GetSegmentation() || !resectionNode || !volumes)
+    {
+    vtkErrorMacro("Error in ComputeSegmentResectionVolumes: invalid input.");
+    return false;
+    }
+
+  vtkSegmentation *segmentation = segmentationNode->GetSegmentation();
+  if (!segmentation->ContainsRepresentation(vtkSegmentationConverter::GetBinaryLabelmapRepresentationName()))
+    {
+    vtkErrorMacro("Error in ComputeSegmentResectionVolumes: the segmentation has no binary labelmap representation.");
+    return false;
+    }
+
+  vtkNew<vtkStringArray> segmentIDs;
+  segmentIDs->SetName("Segment ID");
+  vtkNew<vtkStringArray> segmentNames;
+  segmentNames->SetName("Segment");
+  vtkNew<vtkDoubleArray> resectedVolumes;
+  resectedVolumes->SetName("Resected volume (mm3)");
+  vtkNew<vtkDoubleArray> remnantVolumes;
+  remnantVolumes->SetName("Remnant volume (mm3)");
+
+  // Segments sharing a labelmap (layer) are counted in a single pass over it
+  vtkNew<vtkResectionVolumeCalculator> calculator;
+  calculator->SeparateLabelsOn();
+  for (int layer=0; layer<segmentation->GetNumberOfLayers(); layer++)
+    {
+    auto labelMap = vtkOrientedImageData::SafeDownCast(segmentation->GetLayerObject(layer));
+    if (!labelMap || !labelMap->GetPointData()->GetScalars())
+      {
+      continue;
+      }
+
+    vtkNew<vtkMatrix4x4> ijkToRAS;
+    labelMap->GetImageToWorldMatrix(ijkToRAS);
+    calculator->SetLabelMap(labelMap, ijkToRAS);
+    if (!this->SetResectionBoundary(calculator, resectionNode))
+      {
+      vtkErrorMacro("Error in ComputeSegmentResectionVolumes: the resection is not complete.");
+      return false;
+      }
+    calculator->Update();
+
+    std::vector<std::string> layerSegmentIDs;
+    segmentation->GetSegmentIDsForLayer(layer, layerSegmentIDs);
+    for (const auto &segmentID : layerSegmentIDs)
+      {
+      vtkSegment *segment = segmentation->GetSegment(segmentID);
+      int label = calculator->GetLabelIndex(segment->GetLabelValue());
+      segmentIDs->InsertNextValue(segmentID);
+      segmentNames->InsertNextValue(segment->GetName() ? segment->GetName() : "");
+      resectedVolumes->InsertNextValue(calculator->GetNthResectedVolume(label));
+      remnantVolumes->InsertNextValue(calculator->GetNthRemnantVolume(label));
+      }
+    }
+
+  volumes->Initialize();
+  volumes->AddColumn(segmentIDs);
+  volumes->AddColumn(segmentNames);
+  volumes->AddColumn(resectedVolumes);
+  volumes->AddColumn(remnantVolumes);
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerLiverResectionsLogic::ComputeVascularImpact(vtkMRMLMarkupsBezierSurfaceNode *resectionSurfaceNode,
+                                                          vtkMRMLModelNode *vesselModelNode,
+                                                          vtkMRMLLabelMapVolumeNode *parenchymaLabelMapNode,
+                                                          vtkTable *impact,
+                                                          const double rootPoint[3])
+{
+  if (!resectionSurfaceNode || !impact)
+    {
+    vtkErrorMacro("Error in ComputeVascularImpact: invalid input.");
+    return false;
+    }
+
+  if (!vesselModelNode || !vesselModelNode->GetPolyData() ||
+      vesselModelNode->GetPolyData()->GetNumberOfPoints() == 0)
+    {
+    vtkErrorMacro("Error in ComputeVascularImpact: vessel model does not contain valid polydata.");
+    return false;
+    }
+  vtkPolyData *vesselPolyData = vesselModelNode->GetPolyData();
+  vtkPoints *vesselPoints = vesselPolyData->GetPoints();
+  vtkIdType numberOfVesselPoints = vesselPolyData->GetNumberOfPoints();
+
+  if (!parenchymaLabelMapNode || !parenchymaLabelMapNode->GetImageData() ||
+      !parenchymaLabelMapNode->GetImageData()->GetPointData()->GetScalars())
+    {
+    vtkErrorMacro("Error in ComputeVascularImpact: no valid parenchyma labelmap provided.");
+    return false;
+    }
+
+  ResectionSurface *resectionSurface = this->GetResectionSurface(resectionSurfaceNode);
+  if (!resectionSurface)
+    {
+    vtkErrorMacro("Error in ComputeVascularImpact: the resection surface is incomplete.");
+    return false;
+    }
+
+  // Only the edges overlapping the bounds of the control points can cross
+  // the surface (convex hull property)
+  std::vector<std::pair<vtkIdType, vtkIdType> > edges;
+  GetEdges(vesselPolyData, edges);
+
+  const double *bounds = resectionSurface->Bounds;
+  std::vector<vtkIdType> candidateEdges;
+  std::vector<vtkIdType> candidatePointIndices(numberOfVesselPoints, -1);
+  vtkNew<vtkPoints> candidatePoints;
+  candidatePoints->SetDataTypeToDouble();
+  for (vtkIdType e=0; e<static_cast<vtkIdType>(edges.size()); e++)
+    {
+    double p1[3], p2[3];
+    vesselPoints->GetPoint(edges[e].first, p1);
+    vesselPoints->GetPoint(edges[e].second, p2);
+    bool overlaps = true;
+    for (int d=0; d<3 && overlaps; d++)
+      {
+      overlaps = std::max(p1[d], p2[d]) >= bounds[2*d] && std::min(p1[d], p2[d]) <= bounds[2*d+1];
+      }
+    if (!overlaps)
+      {
+      continue;
+      }
+
+    candidateEdges.push_back(e);
+    for (vtkIdType pointId : {edges[e].first, edges[e].second})
+      {
+      if (candidatePointIndices[pointId] < 0)
+        {
+        candidatePointIndices[pointId] = candidatePoints->InsertNextPoint(vesselPoints->GetPoint(pointId));
+        }
+      }
+    }
+
+  // The candidate edges whose end points are on different sides of the
+  // surface are checked for an exact intersection (the side is not
+  // meaningful beyond the border of the surface)
+  vtkNew<vtkDoubleArray> signedDistances;
+  signedDistances->SetNumberOfComponents(1);
+  signedDistances->SetNumberOfTuples(candidatePoints->GetNumberOfPoints());
+  SignedDistanceFunctor signedDistanceFunctor(candidatePoints, resectionSurface->Patches, signedDistances);
+  vtkSMPTools::For(0, candidatePoints->GetNumberOfPoints(), signedDistanceFunctor);
+
+  std::vector<vtkIdType> crossingEdges;
+  for (vtkIdType e : candidateEdges)
+    {
+    double d1 = signedDistances->GetValue(candidatePointIndices[edges[e].first]);
+    double d2 = signedDistances->GetValue(candidatePointIndices[edges[e].second]);
+    if ((d1 > 0.0) != (d2 > 0.0))
+      {
+      crossingEdges.push_back(e);
+      }
+    }
+
+  std::vector<char> cut(crossingEdges.size(), 0);
+  std::vector<double> cutPoints(3*crossingEdges.size(), 0.0);
+  vtkSMPTools::For(0, static_cast<vtkIdType>(crossingEdges.size()),
+    [&](vtkIdType begin, vtkIdType end)
+    {
+    for (vtkIdType c=begin; c<end; c++)
+      {
+      const auto &edge = edges[crossingEdges[c]];
+      double p1[3], p2[3];
+      vesselPoints->GetPoint(edge.first, p1);
+      vesselPoints->GetPoint(edge.second, p2);
+      cut[c] = resectionSurface->IntersectWithLine(p1, p2, &cutPoints[3*c]) ? 1 : 0;
+      }
+    });
+
+  // Parts of the vessel tree once the cut edges are removed
+  std::vector<char> isCutEdge(edges.size(), 0);
+  for (size_t c=0; c<crossingEdges.size(); c++)
+    {
+    isCutEdge[crossingEdges[c]] = cut[c];
+    }
+
+  DisjointSets parts(numberOfVesselPoints);
+  for (size_t e=0; e<edges.size(); e++)
+    {
+    if (!isCutEdge[e])
+      {
+      parts.Union(edges[e].first, edges[e].second);
+      }
+    }
+
+  std::vector<vtkIdType> partSizes(numberOfVesselPoints, 0);
+  for (vtkIdType pointId=0; pointId<numberOfVesselPoints; pointId++)
+    {
+    partSizes[parts.Find(pointId)]++;
+    }
+
+  // The root part feeds the tree (the part closest to the root point, or the
+  // largest one)
+  vtkNew<vtkStaticPointLocator> vesselLocator;
+  vesselLocator->SetDataSet(vesselPolyData);
+  vesselLocator->BuildLocator();
+
+  vtkIdType rootPart;
+  if (rootPoint)
+    {
+    rootPart = parts.Find(vesselLocator->FindClosestPoint(rootPoint));
+    }
+  else
+    {
+    rootPart = std::max_element(partSizes.begin(), partSizes.end()) - partSizes.begin();
+    }
+
+  // Severed branches: the other parts touched by the cut
+  std::vector<int> partBranches(numberOfVesselPoints, -1);
+  std::vector<vtkIdType> branchSizes;
+  std::vector<double> branchCutPoints;
+  std::vector<int> branchNumberOfCuts;
+  for (size_t c=0; c<crossingEdges.size(); c++)
+    {
+    if (!cut[c])
+      {
+      continue;
+      }
+
+    const auto &edge = edges[crossingEdges[c]];
+    for (vtkIdType pointId : {edge.first, edge.second})
+      {
+      vtkIdType part = parts.Find(pointId);
+      if (part == rootPart)
+        {
+        continue;
+        }
+      if (partBranches[part] < 0)
+        {
+        partBranches[part] = static_cast<int>(branchSizes.size());
+        branchSizes.push_back(partSizes[part]);
+        branchCutPoints.insert(branchCutPoints.end(), 3, 0.0);
+        branchNumberOfCuts.push_back(0);
+        }
+      int branch = partBranches[part];
+      for (int k=0; k<3; k++)
+        {
+        branchCutPoints[3*branch+k] += cutPoints[3*c+k];
+        }
+      branchNumberOfCuts[branch]++;
+      }
+    }
+  int numberOfBranches = static_cast<int>(branchSizes.size());
+
+  std::vector<int> pointBranches(numberOfVesselPoints);
+  for (vtkIdType pointId=0; pointId<numberOfVesselPoints; pointId++)
+    {
+    pointBranches[pointId] = partBranches[parts.Find(pointId)];
+    }
+
+  // Territories: the parenchyma voxels are supplied by their closest vessel
+  vtkImageData *labelMap = parenchymaLabelMapNode->GetImageData();
+  vtkDataArray *scalars = labelMap->GetPointData()->GetScalars();
+  vtkNew<vtkMatrix4x4> ijkToRAS;
+  parenchymaLabelMapNode->GetIJKToRASMatrix(ijkToRAS);
+  int extent[6];
+  labelMap->GetExtent(extent);
+  int dimensions[3] = {extent[1]-extent[0]+1, extent[3]-extent[2]+1, extent[5]-extent[4]+1};
+
+  std::vector<vtkIdType> slabCounts;
+  if (numberOfBranches > 0)
+    {
+    slabCounts.assign(static_cast<size_t>(dimensions[2])*numberOfBranches, 0);
+    vtkSMPTools::For(0, dimensions[2],
+      [&](vtkIdType begin, vtkIdType end)
+      {
+      for (vtkIdType k=begin; k<end; k++)
+        {
+        vtkIdType *counts = &slabCounts[k*numberOfBranches];
+        for (int j=0; j<dimensions[1]; j++)
+          {
+          vtkIdType index = (k*dimensions[1] + j)*dimensions[0];
+          for (int i=0; i<dimensions[0]; i++, index++)
+            {
+            if (scalars->GetComponent(index, 0) == 0.0)
+              {
+              continue;
+              }
+
+            double ijk[4] = {static_cast<double>(extent[0]+i), static_cast<double>(extent[2]+j),
+                             static_cast<double>(extent[4]+k), 1.0};
+            double ras[4];
+            ijkToRAS->MultiplyPoint(ijk, ras);
+            int branch = pointBranches[vesselLocator->FindClosestPoint(ras)];
+            if (branch >= 0)
+              {
+              counts[branch]++;
+              }
+            }
+          }
+        }
+      });
+    }
+
+  double voxelVolume = std::fabs(ijkToRAS->Determinant());
+
+  vtkNew<vtkIntArray> branchIds;
+  branchIds->SetName("Branch");
+  vtkNew<vtkIdTypeArray> numberOfPoints;
+  numberOfPoints->SetName("Number of vessel points");
+  vtkNew<vtkDoubleArray> cutPositions;
+  cutPositions->SetName("Cut position");
+  cutPositions->SetNumberOfComponents(3);
+  vtkNew<vtkDoubleArray> territoryVolumes;
+  territoryVolumes->SetName("Territory volume (mm3)");
+  for (int branch=0; branch<numberOfBranches; branch++)
+    {
+    vtkIdType count = 0;
+    for (int k=0; k<dimensions[2]; k++)
+      {
+      count += slabCounts[static_cast<size_t>(k)*numberOfBranches + branch];
+      }
+
+    double cutPosition[3];
+    for (int k=0; k<3; k++)
+      {
+      cutPosition[k] = branchCutPoints[3*branch+k] / branchNumberOfCuts[branch];
+      }
+
+    branchIds->InsertNextValue(branch);
+    numberOfPoints->InsertNextValue(branchSizes[branch]);
+    cutPositions->InsertNextTuple(cutPosition);
+    territoryVolumes->InsertNextValue(count*voxelVolume);
+    }
+
+  impact->Initialize();
+  impact->AddColumn(branchIds);
+  impact->AddColumn(numberOfPoints);
+  impact->AddColumn(cutPositions);
+  impact->AddColumn(territoryVolumes);
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerLiverResectionsLogic::AddResectionMarginTumor(vtkMRMLModelNode *tumorModelNode)
+{
+  if (!tumorModelNode)
+    {
+    vtkErrorMacro("Error in AddResectionMarginTumor: no tumor model provided.");
+    return;
+    }
+
+  this->ResectionMarginTumors.push_back(tumorModelNode);
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerLiverResectionsLogic::RemoveAllResectionMarginTumors()
+{
+  this->ResectionMarginTumors.clear();
+}
+
+//------------------------------------------------------------------------------
+bool vtkSlicerLiverResectionsLogic::UpdateResectionMargins(vtkMRMLMarkupsBezierSurfaceNode *resectionSurfaceNode,
+                                                           vtkMRMLModelNode *marginModelNode)
+{
+  if (!resectionSurfaceNode || !marginModelNode)
+    {
+    vtkErrorMacro("Error in UpdateResectionMargins: invalid input.");
+    return false;
+    }
+
+  ResectionSurface *resectionSurface = this->GetResectionSurface(resectionSurfaceNode);
+  if (!resectionSurface)
+    {
+    vtkErrorMacro("Error in UpdateResectionMargins: the resection surface is incomplete.");
+    return false;
+    }
+
+  // The tumor polydata may have been replaced since the last update; the
+  // filter reuses the locators of the unchanged ones
+  this->ResectionMarginFilter->RemoveAllTumors();
+  for (const auto &tumorModelNode : this->ResectionMarginTumors)
+    {
+    if (tumorModelNode && tumorModelNode->GetPolyData() &&
+        tumorModelNode->GetPolyData()->GetNumberOfCells() > 0)
+      {
+      this->ResectionMarginFilter->AddTumor(tumorModelNode->GetPolyData());
+      }
+    }
+  if (this->ResectionMarginFilter->GetNumberOfTumors() == 0)
+    {
+    vtkErrorMacro("Error in UpdateResectionMargins: no valid tumor models provided.");
+    return false;
+    }
+
+  this->ResectionMarginFilter->SetInputData(resectionSurface->GetTessellation());
+  this->ResectionMarginFilter->Update();
+
+  vtkNew<vtkPolyData> margins;
+  margins->ShallowCopy(this->ResectionMarginFilter->GetOutput());
+  marginModelNode->SetAndObservePolyData(margins);
+
+  auto displayNode = vtkMRMLModelDisplayNode::SafeDownCast(marginModelNode->GetDisplayNode());
+  if (displayNode)
+    {
+    displayNode->SetActiveScalarName("ResectionMargin");
+    displayNode->ScalarVisibilityOn();
+    }
+
+  return true;
+}
+
+//------------------------------------------------------------------------------
+double vtkSlicerLiverResectionsLogic::GetMinimumResectionMargin() const
+{
+  return this->ResectionMarginFilter->GetMinimumMargin();
+}
+
+//------------------------------------------------------------------------------
+void vtkSlicerLiverResectionsLogic::UpdateTargetParenchymaLocator(vtkMRMLModelNode *targetParenchymaModelNode)
+{
+  if (!targetParenchymaModelNode)
+    {
+    return;
+    }
+
+  auto &entry = this->TargetParenchymaLocators[targetParenchymaModelNode];
+  if (!entry)
+    {
+    entry.reset(new TargetParenchymaLocator);
+    }
+
+  vtkPolyData *polyData = targetParenchymaModelNode->GetPolyData();
+  if (!polyData || polyData->GetNumberOfCells() == 0)
+    {
+    return;
+    }
+
+  // A build in progress is checked again against the model once finished
+  if (entry->PendingLocator.valid())
+    {
+    if (entry->PendingLocator.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+      {
+      return;
+      }
+    entry->Locator = entry->PendingLocator.get();
+    entry->LocatorTime = entry->PendingLocatorTime;
+    }
+
+  // Only the geometry matters: point data (e.g. scalars attached for
+  // visualization) may change without invalidating the index
+  vtkMTimeType polyDataTime = polyData->GetPoints() ? polyData->GetPoints()->GetMTime() : 0;
+  polyDataTime = std::max(polyDataTime, polyData->GetPolys()->GetMTime());
+  if (entry->Locator && entry->LocatorTime == polyDataTime)
+    {
+    return;
+    }
+
+  // The index is built on a snapshot, so the model can be modified meanwhile
+  auto snapshot = vtkSmartPointer<vtkPolyData>::New();
+  snapshot->DeepCopy(polyData);
+  entry->PendingLocatorTime = polyDataTime;
+  entry->PendingLocator = BuildLocatorInBackground(snapshot);
+}
+
+//------------------------------------------------------------------------------
+vtkAbstractCellLocator* vtkSlicerLiverResectionsLogic::GetTargetParenchymaLocator(vtkMRMLModelNode *targetParenchymaModelNode)
+{
+  if (!targetParenchymaModelNode || !targetParenchymaModelNode->GetPolyData() ||
+      targetParenchymaModelNode->GetPolyData()->GetNumberOfCells() == 0)
+    {
+    return nullptr;
+    }
+
+  this->UpdateTargetParenchymaLocator(targetParenchymaModelNode);
+
+  // The model may have changed again during the build
+  auto &entry = this->TargetParenchymaLocators[targetParenchymaModelNode];
+  while (entry->PendingLocator.valid())
+    {
+    entry->Locator = entry->PendingLocator.get();
+    entry->LocatorTime = entry->PendingLocatorTime;
+    this->UpdateTargetParenchymaLocator(targetParenchymaModelNode);
+    }
+
+  return entry->Locator;
+}
+
+//------------------------------------------------------------------------------
+vtkSlicerLiverResectionsLogic::ResectionSurface*
+vtkSlicerLiverResectionsLogic::GetResectionSurface(vtkMRMLMarkupsBezierSurfaceNode *resectionSurfaceNode)
+{
+  auto &resectionSurface = this->ResectionSurfaces[resectionSurfaceNode];
+  if (!resectionSurface)
+    {
+    resectionSurface.reset(new ResectionSurface);
+    }
+
+  return resectionSurface->SetSurface(resectionSurfaceNode) ? resectionSurface.get() : nullptr;
 }
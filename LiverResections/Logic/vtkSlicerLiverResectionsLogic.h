@@ -42,12 +42,27 @@
 
 #include <vtkSlicerModuleLogic.h>
 
+#include <vtkCommand.h>
+#include <vtkSmartPointer.h>
 #include <vtkWeakPointer.h>
 
 #include "vtkSlicerLiverResectionsModuleLogicExport.h"
 
+// STD includes
+#include <map>
+#include <memory>
+#include <vector>
+
 //------------------------------------------------------------------------------
+class vtkAbstractCellLocator;
+class vtkMRMLLabelMapVolumeNode;
+class vtkMRMLMarkupsBezierSurfaceNode;
+class vtkMRMLMarkupsNode;
 class vtkMRMLModelNode;
+class vtkMRMLSegmentationNode;
+class vtkResectionMarginFilter;
+class vtkResectionVolumeCalculator;
+class vtkTable;
 
 //------------------------------------------------------------------------------
 class VTK_SLICER_LIVERRESECTIONS_MODULE_LOGIC_EXPORT vtkSlicerLiverResectionsLogic:
@@ -75,6 +90,12 @@ public:
     DistanceContour
   };
 
+  /// Events
+  enum
+  {
+    ResectionVolumesModifiedEvent = vtkCommand::UserEvent + 1
+  };
+
   /// Adds a new resection (Initialization state) using slicing contours initialization
   /// NOTE: Probably we prefer passing the target directly instead of keeping an internal target
   void AddResectionSlicingContour(vtkMRMLModelNode *targetParenchyma);
@@ -83,6 +104,88 @@ public:
   /// Sets the internal target parenchyma
   void SetTargetParenchyma(vtkMRMLModelNode *targetParenchymaModelNode);
 
+  /// Splits the target parenchyma by a Bezier (single or multi-patch)
+  /// resection surface. Every vertex is classified by the signed distance to
+  /// the exact surface (closest-point projection, computed in parallel),
+  /// straddling triangles are clipped and the cut is capped with the part of
+  /// the surface bounded by the cut, sharing its points, producing closed
+  /// resected (positive side of the surface normal) and remnant models (see
+  /// vtkResectionSplitFilter).
+  /// If no target is given, the target of the surface node or the internal
+  /// target parenchyma is used. Returns false on failure.
+  bool SplitParenchyma(vtkMRMLMarkupsBezierSurfaceNode *resectionSurfaceNode,
+                       vtkMRMLModelNode *targetParenchymaModelNode,
+                       vtkMRMLModelNode *resectedModelNode,
+                       vtkMRMLModelNode *remnantModelNode);
+
+  /// Live computation of the resected and remnant volumes of a resection
+  /// (Bezier surface, slicing contour plane or distance contour sphere)
+  /// within a liver labelmap. The volumes are updated as the control points
+  /// of the resection move: while they are dragged, at most once every
+  /// ResectionVolumesUpdateInterval seconds (and once more when the
+  /// interaction ends), otherwise (e.g. scripted edits or undo) on every
+  /// change. ResectionVolumesModifiedEvent is invoked after every update.
+  void SetResectionVolumesLabelMap(vtkMRMLLabelMapVolumeNode *labelMapNode);
+  void SetResectionVolumesNode(vtkMRMLMarkupsNode *resectionNode);
+
+  /// Computes the resected and remnant volumes immediately
+  bool UpdateResectionVolumes();
+
+  /// Resected and remnant volumes (in mm^3) of the last update
+  double GetResectedVolume() const;
+  double GetRemnantVolume() const;
+
+  /// Minimum time (in seconds) between two updates of the volumes while the
+  /// resection is being edited (by default, 1/30 s to follow the render rate)
+  vtkSetMacro(ResectionVolumesUpdateInterval, double);
+  vtkGetMacro(ResectionVolumesUpdateInterval, double);
+
+  /// Computes the resected and remnant volumes of every segment of a
+  /// segmentation directly from its binary labelmap representation (no
+  /// surface is extracted). The table gets one row per segment with the
+  /// columns "Segment ID", "Segment", "Resected volume (mm3)" and
+  /// "Remnant volume (mm3)".
+  bool ComputeSegmentResectionVolumes(vtkMRMLSegmentationNode *segmentationNode,
+                                      vtkMRMLMarkupsNode *resectionNode,
+                                      vtkTable *volumes);
+
+  /// Vascular territory impact of a resection surface. The vessel model
+  /// (surface or centerline polylines) is cut where its edges cross the
+  /// surface; the parts disconnected from the root part (the one closest to
+  /// rootPoint, or the largest one if not given) by the cut are the severed
+  /// branches. Each parenchyma voxel belongs to the territory of its closest
+  /// vessel point. The table gets one row per severed branch with the
+  /// columns "Branch", "Number of vessel points", "Cut position" (mean of
+  /// the crossings) and "Territory volume (mm3)".
+  bool ComputeVascularImpact(vtkMRMLMarkupsBezierSurfaceNode *resectionSurfaceNode,
+                             vtkMRMLModelNode *vesselModelNode,
+                             vtkMRMLLabelMapVolumeNode *parenchymaLabelMapNode,
+                             vtkTable *impact,
+                             const double rootPoint[3] = nullptr);
+
+  /// Resection margin map: distance from every vertex of the tessellated
+  /// resection surface to the closest tumor, stored as the "ResectionMargin"
+  /// point scalars of the margin model. Updates while the surface is edited
+  /// only recompute the vertices that moved.
+  void AddResectionMarginTumor(vtkMRMLModelNode *tumorModelNode);
+  void RemoveAllResectionMarginTumors();
+  bool UpdateResectionMargins(vtkMRMLMarkupsBezierSurfaceNode *resectionSurfaceNode,
+                              vtkMRMLModelNode *marginModelNode);
+
+  /// Smallest resection margin (in mm) of the last update
+  double GetMinimumResectionMargin() const;
+
+  /// Persistent spatial index (static cell locator) of a target parenchyma
+  /// model, shared by all the resections of that target and used to split
+  /// the parenchyma. The index is keyed on the modification time of the
+  /// model polydata. It is built in the background when a resection of the
+  /// target is added, and rebuilt when next requested after the model
+  /// changes, so that a burst of modifications costs a single rebuild.
+  /// Returns the up-to-date locator (waiting for a build in progress), or
+  /// nullptr if the model has no polydata. The locator indexes a snapshot of
+  /// the polydata, available through its GetDataSet().
+  vtkAbstractCellLocator* GetTargetParenchymaLocator(vtkMRMLModelNode *targetParenchymaModelNode);
+
   /// Sets the target parenchyma
   /// NOTE: This is something we want to probably change
 protected:
@@ -91,12 +194,48 @@ protected:
 
   void ObserveMRMLScene() override;
 
+  void SetMRMLSceneInternal(vtkMRMLScene* newScene) override;
+
   void OnMRMLSceneNodeAdded(vtkMRMLNode* node) override;
 
+  void OnMRMLSceneNodeRemoved(vtkMRMLNode* node) override;
+
+  void ProcessMRMLNodesEvents(vtkObject* caller, unsigned long event, void* callData) override;
+
+  /// Sets the boundary of the calculator from a resection node (returns
+  /// false if the resection is not complete)
+  bool SetResectionBoundary(vtkResectionVolumeCalculator *calculator,
+                            vtkMRMLMarkupsNode *resectionNode);
+
+  /// Starts the background build of the spatial index of a target when it
+  /// is missing or out of date
+  void UpdateTargetParenchymaLocator(vtkMRMLModelNode *targetParenchymaModelNode);
+
+  /// Exact representation of a resection surface, cached per node and
+  /// updated when its control points change (nullptr if it is incomplete)
+  class ResectionSurface;
+  ResectionSurface* GetResectionSurface(vtkMRMLMarkupsBezierSurfaceNode *resectionSurfaceNode);
+
 private:
 
   vtkWeakPointer<vtkMRMLModelNode> TargetParenchymaModelNode;
 
+  vtkSmartPointer<vtkResectionVolumeCalculator> ResectionVolumeCalculator;
+  vtkWeakPointer<vtkMRMLLabelMapVolumeNode> ResectionVolumesLabelMapNode;
+  vtkMRMLMarkupsNode* ResectionVolumesNode;
+  double ResectionVolumesUpdateInterval;
+  double LastResectionVolumesUpdateTime;
+  bool ResectionVolumesUpdatePending;
+  bool ResectionVolumesInteracting;
+
+  vtkSmartPointer<vtkResectionMarginFilter> ResectionMarginFilter;
+  std::vector<vtkWeakPointer<vtkMRMLModelNode> > ResectionMarginTumors;
+
+  struct TargetParenchymaLocator;
+  std::map<vtkMRMLModelNode*, std::unique_ptr<TargetParenchymaLocator> > TargetParenchymaLocators;
+
+  std::map<vtkMRMLMarkupsBezierSurfaceNode*, std::unique_ptr<ResectionSurface> > ResectionSurfaces;
+
 private:
   vtkSlicerLiverResectionsLogic(const vtkSlicerLiverResectionsLogic&) = delete;
   void operator=(const vtkSlicerLiverResectionsLogic&) = delete;
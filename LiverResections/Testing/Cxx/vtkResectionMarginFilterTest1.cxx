@@ -0,0 +1,177 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (The Intervention Centre,
+  Oslo University Hospital) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+// Known-answer tests of vtkResectionMarginFilter: margins of a planar grid
+// to a parallel tumor plane, after full and incremental updates.
+
+#include "vtkResectionMarginFilter.h"
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkDataArray.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+const int GridSize = 5;
+
+//------------------------------------------------------------------------------
+// Square [-size, size]^2 in the plane z = height, made of triangles
+void CreateSquare(vtkPolyData *square, int resolution, double size, double height)
+{
+  vtkNew<vtkPoints> points;
+  points->SetDataTypeToDouble();
+  for (int j=0; j<resolution; j++)
+    {
+    for (int i=0; i<resolution; i++)
+      {
+      points->InsertNextPoint(-size + 2.0*size*i/(resolution-1),
+                              -size + 2.0*size*j/(resolution-1), height);
+      }
+    }
+
+  vtkNew<vtkCellArray> triangles;
+  for (int j=0; j<resolution-1; j++)
+    {
+    for (int i=0; i<resolution-1; i++)
+      {
+      vtkIdType corner = j*resolution + i;
+      vtkIdType first[3] = {corner, corner+1, corner+resolution+1};
+      vtkIdType second[3] = {corner, corner+resolution+1, corner+resolution};
+      triangles->InsertNextCell(3, first);
+      triangles->InsertNextCell(3, second);
+      }
+    }
+
+  square->SetPoints(points);
+  square->SetPolys(triangles);
+}
+
+//------------------------------------------------------------------------------
+// Check the margin of every vertex of the output and the minimum margin
+bool CheckMargins(const char *name, vtkResectionMarginFilter *filter,
+                  double expected, vtkIdType pointId = -1, double pointExpected = 0.0)
+{
+  filter->Update();
+  vtkDataArray *margins = filter->GetOutput()->GetPointData()->GetArray("ResectionMargin");
+  if (!margins || margins->GetNumberOfTuples() != GridSize*GridSize)
+    {
+    std::cerr << name << ": missing ResectionMargin array" << std::endl;
+    return false;
+    }
+
+  double minimum = expected;
+  for (vtkIdType id=0; id<margins->GetNumberOfTuples(); id++)
+    {
+    double value = id == pointId ? pointExpected : expected;
+    minimum = std::min(minimum, value);
+    if (std::fabs(margins->GetTuple1(id) - value) > 1e-9)
+      {
+      std::cerr << name << ": margin " << margins->GetTuple1(id) << " at vertex " << id
+                << " instead of " << value << std::endl;
+      return false;
+      }
+    }
+  if (std::fabs(filter->GetMinimumMargin() - minimum) > 1e-9)
+    {
+    std::cerr << name << ": minimum margin " << filter->GetMinimumMargin()
+              << " instead of " << minimum << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//------------------------------------------------------------------------------
+int vtkResectionMarginFilterTest1(int vtkNotUsed(argc), char *vtkNotUsed(argv)[])
+{
+  vtkNew<vtkPolyData> tumor;
+  CreateSquare(tumor, 3, 20.0, 5.0);
+  vtkNew<vtkPolyData> surface;
+  CreateSquare(surface, GridSize, 4.0, 0.0);
+
+  vtkNew<vtkResectionMarginFilter> filter;
+  filter->SetInputData(surface);
+  filter->Update();
+  if (filter->GetMinimumMargin() != VTK_DOUBLE_MAX)
+    {
+    std::cerr << "No tumor: the minimum margin should be VTK_DOUBLE_MAX" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  filter->AddTumor(tumor);
+  bool success = CheckMargins("Full update", filter, 5.0);
+
+  // Incremental update: every vertex moves towards the tumor
+  vtkPoints *points = surface->GetPoints();
+  for (vtkIdType pointId=0; pointId<points->GetNumberOfPoints(); pointId++)
+    {
+    double point[3];
+    points->GetPoint(pointId, point);
+    points->SetPoint(pointId, point[0], point[1], point[2] + 1.0);
+    }
+  points->Modified();
+  success &= CheckMargins("Incremental update", filter, 4.0);
+
+  // Incremental update: a single vertex moves away from the tumor
+  double point[3];
+  points->GetPoint(7, point);
+  points->SetPoint(7, point[0] + 0.5, point[1], point[2] - 3.0);
+  points->Modified();
+  success &= CheckMargins("Single vertex update", filter, 4.0, 7, 7.0);
+
+  // A second tumor closer to the surface
+  vtkNew<vtkPolyData> closerTumor;
+  CreateSquare(closerTumor, 2, 20.0, 3.0);
+  filter->AddTumor(closerTumor);
+  success &= CheckMargins("Two tumors", filter, 2.0, 7, 5.0);
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,451 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (The Intervention Centre,
+  Oslo University Hospital) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+// Tests of vtkResectionSplitFilter: a torus split by flat and curved
+// surfaces gives two closed, manifold and consistently oriented parts of the
+// expected topology, whose volumes add up to the volume of the torus.
+
+#include "vtkResectionSplitFilter.h"
+
+// Liver Markups VTKAlgorithms includes
+#include <vtkBezierSurfaceSource.h>
+#include <vtkMultiPatchBezierSurfaceSource.h>
+
+// VTK includes
+#include <vtkCellArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkFeatureEdges.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkStaticCellLocator.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+const double MajorRadius = 2.0;
+const double MinorRadius = 0.8;
+const double SurfaceSize = 3.5;
+
+//------------------------------------------------------------------------------
+// Torus around the z axis, made of outward oriented triangles
+void CreateTorus(vtkPolyData *torus, int resolutionU, int resolutionV)
+{
+  vtkNew<vtkPoints> points;
+  points->SetDataTypeToDouble();
+  for (int j=0; j<resolutionV; j++)
+    {
+    // Shifted so no vertex is on the surfaces of the tests
+    double v = 2.0*vtkMath::Pi()*(j + 0.3)/resolutionV;
+    for (int i=0; i<resolutionU; i++)
+      {
+      double u = 2.0*vtkMath::Pi()*(i + 0.3)/resolutionU;
+      double radius = MajorRadius + MinorRadius*std::cos(v);
+      points->InsertNextPoint(radius*std::cos(u), radius*std::sin(u), MinorRadius*std::sin(v));
+      }
+    }
+
+  vtkNew<vtkCellArray> triangles;
+  for (int j=0; j<resolutionV; j++)
+    {
+    for (int i=0; i<resolutionU; i++)
+      {
+      vtkIdType corners[4] = {j*resolutionU + i, j*resolutionU + (i+1)%resolutionU,
+                              ((j+1)%resolutionV)*resolutionU + (i+1)%resolutionU,
+                              ((j+1)%resolutionV)*resolutionU + i};
+      vtkIdType first[3] = {corners[0], corners[1], corners[2]};
+      vtkIdType second[3] = {corners[0], corners[2], corners[3]};
+      triangles->InsertNextCell(3, first);
+      triangles->InsertNextCell(3, second);
+      }
+    }
+
+  torus->SetPoints(points);
+  torus->SetPolys(triangles);
+}
+
+//------------------------------------------------------------------------------
+// Single square patch of half side size on the plane through origin spanned
+// by the parametric directions u and v (the normal being u x v)
+void CreatePlane(vtkBezierSurfaceSource *patch, const double origin[3],
+                 const double u[3], const double v[3], double size = SurfaceSize)
+{
+  vtkNew<vtkPoints> controlPoints;
+  controlPoints->SetDataTypeToDouble();
+  for (int i=0; i<4; i++)
+    {
+    for (int j=0; j<4; j++)
+      {
+      double s = size*(2.0*i/3.0 - 1.0);
+      double t = size*(2.0*j/3.0 - 1.0);
+      controlPoints->InsertNextPoint(origin[0] + s*u[0] + t*v[0],
+                                     origin[1] + s*u[1] + t*v[1],
+                                     origin[2] + s*u[2] + t*v[2]);
+      }
+    }
+  patch->SetNumberOfControlPoints(4, 4);
+  patch->SetControlPoints(controlPoints);
+}
+
+//------------------------------------------------------------------------------
+// 2x2 patches over the xy plane, waving around z = height
+void CreateWave(vtkMultiPatchBezierSurfaceSource *surface, double height)
+{
+  vtkNew<vtkPoints> controlPoints;
+  controlPoints->SetDataTypeToDouble();
+  for (int i=0; i<7; i++)
+    {
+    for (int j=0; j<7; j++)
+      {
+      double x = SurfaceSize*(i/3.0 - 1.0);
+      double y = SurfaceSize*(j/3.0 - 1.0);
+      controlPoints->InsertNextPoint(x, y, height + 0.2*std::sin(x)*std::cos(y));
+      }
+    }
+  surface->SetNumberOfPatches(2, 2);
+  surface->SetControlPoints(controlPoints);
+}
+
+//------------------------------------------------------------------------------
+// Signed distance to the patches: the distance to the closest point,
+// positive on the side of the normal there (optionally returned)
+double SignedDistance(const std::vector<vtkBezierSurfaceSource*> &patches, const double point[3],
+                      double surfaceNormal[3] = nullptr)
+{
+  double closestDistance = VTK_DOUBLE_MAX;
+  double signedDistance = 0.0;
+  for (auto patch : patches)
+    {
+    double closestPoint[3], parametricCoordinates[2];
+    double distance = patch->ProjectPoint(point, closestPoint, parametricCoordinates);
+    if (distance >= closestDistance)
+      {
+      continue;
+      }
+
+    double surfacePoint[3], derivativeU[3], derivativeV[3], normal[3], offset[3];
+    patch->EvaluatePoint(parametricCoordinates[0], parametricCoordinates[1],
+                         surfacePoint, derivativeU, derivativeV);
+    vtkMath::Cross(derivativeU, derivativeV, normal);
+    vtkMath::Subtract(point, closestPoint, offset);
+    closestDistance = distance;
+    signedDistance = vtkMath::Dot(offset, normal) < 0.0 ? -distance : distance;
+    if (surfaceNormal)
+      {
+      vtkMath::Normalize(normal);
+      std::copy(normal, normal+3, surfaceNormal);
+      }
+    }
+  return signedDistance;
+}
+
+//------------------------------------------------------------------------------
+// Signed volume enclosed by a triangle mesh (positive if outward oriented)
+double SignedVolume(vtkPolyData *polyData)
+{
+  double volume = 0.0;
+  vtkCellArray *polys = polyData->GetPolys();
+  vtkIdType numberOfPoints;
+  const vtkIdType *pointIds;
+  for (polys->InitTraversal(); polys->GetNextCell(numberOfPoints, pointIds);)
+    {
+    double a[3], b[3], c[3], cross[3];
+    polyData->GetPoint(pointIds[0], a);
+    polyData->GetPoint(pointIds[1], b);
+    polyData->GetPoint(pointIds[2], c);
+    vtkMath::Cross(b, c, cross);
+    volume += vtkMath::Dot(a, cross)/6.0;
+    }
+  return volume;
+}
+
+//------------------------------------------------------------------------------
+// Whether some points are well inside the torus (the torus vertices and the
+// cut points are on its tessellation)
+bool HasInteriorPoints(vtkPolyData *part)
+{
+  for (vtkIdType pointId=0; pointId<part->GetNumberOfPoints(); pointId++)
+    {
+    double point[3];
+    part->GetPoint(pointId, point);
+    double radius = std::sqrt(point[0]*point[0] + point[1]*point[1]) - MajorRadius;
+    if (radius*radius + point[2]*point[2] < 0.81*MinorRadius*MinorRadius)
+      {
+      return true;
+      }
+    }
+  return false;
+}
+
+//------------------------------------------------------------------------------
+// Check that a part is closed and manifold (no boundary nor non-manifold
+// edges), of the expected Euler characteristic, on the expected side (1 for
+// the resected part, -1 for the remnant one, 0 to skip) and that its cap (the
+// triangles on the surface) faces the other side
+bool CheckPart(const char *name, vtkPolyData *part, int eulerCharacteristic, double side,
+               const std::vector<vtkBezierSurfaceSource*> &patches)
+{
+  vtkNew<vtkFeatureEdges> edges;
+  edges->SetInputData(part);
+  edges->BoundaryEdgesOn();
+  edges->NonManifoldEdgesOn();
+  edges->FeatureEdgesOff();
+  edges->ManifoldEdgesOff();
+  edges->Update();
+  if (edges->GetOutput()->GetNumberOfLines() != 0)
+    {
+    std::cerr << name << ": " << edges->GetOutput()->GetNumberOfLines()
+              << " boundary or non-manifold edges" << std::endl;
+    return false;
+    }
+
+  std::set<std::pair<vtkIdType, vtkIdType> > uniqueEdges;
+  vtkCellArray *polys = part->GetPolys();
+  vtkIdType numberOfPoints;
+  const vtkIdType *pointIds;
+  for (polys->InitTraversal(); polys->GetNextCell(numberOfPoints, pointIds);)
+    {
+    for (vtkIdType i=0; i<numberOfPoints; i++)
+      {
+      vtkIdType first = pointIds[i], second = pointIds[(i+1) % numberOfPoints];
+      uniqueEdges.insert(std::make_pair(std::min(first, second), std::max(first, second)));
+      }
+    }
+  vtkIdType euler = part->GetNumberOfPoints() - static_cast<vtkIdType>(uniqueEdges.size()) +
+    polys->GetNumberOfCells();
+  if (euler != eulerCharacteristic)
+    {
+    std::cerr << name << ": Euler characteristic " << euler << " instead of "
+              << eulerCharacteristic << std::endl;
+    return false;
+    }
+
+  for (vtkIdType pointId=0; pointId<part->GetNumberOfPoints(); pointId++)
+    {
+    double point[3];
+    part->GetPoint(pointId, point);
+    if (side*SignedDistance(patches, point) < -1e-2)
+      {
+      std::cerr << name << ": vertex " << pointId << " on the wrong side" << std::endl;
+      return false;
+      }
+    }
+
+  for (polys->InitTraversal(); polys->GetNextCell(numberOfPoints, pointIds);)
+    {
+    double corners[3][3], centroid[3] = {0.0, 0.0, 0.0};
+    bool onSurface = true;
+    for (int k=0; k<3; k++)
+      {
+      part->GetPoint(pointIds[k], corners[k]);
+      vtkMath::Add(centroid, corners[k], centroid);
+      onSurface = onSurface && std::fabs(SignedDistance(patches, corners[k])) < 1e-6;
+      }
+    if (!onSurface)
+      {
+      continue;
+      }
+
+    double first[3], second[3], normal[3], surfaceNormal[3];
+    vtkMath::Subtract(corners[1], corners[0], first);
+    vtkMath::Subtract(corners[2], corners[0], second);
+    vtkMath::Cross(first, second, normal);
+    vtkMath::MultiplyScalar(centroid, 1.0/3.0);
+    SignedDistance(patches, centroid, surfaceNormal);
+    if (side*vtkMath::Dot(normal, surfaceNormal) > 1e-12)
+      {
+      std::cerr << name << ": cap triangle (" << pointIds[0] << ", " << pointIds[1] << ", "
+                << pointIds[2] << ") flipped" << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// Split of the torus by the patches of the filter, and check of both parts.
+// The sides are only checked when the surface spans the torus, otherwise the
+// signed distances are not continuous across the surface extension.
+bool CheckSplit(const char *name, vtkResectionSplitFilter *filter, vtkPolyData *torus,
+                const std::vector<vtkBezierSurfaceSource*> &patches,
+                int resectedEulerCharacteristic, int remnantEulerCharacteristic,
+                bool spanning = true)
+{
+  vtkNew<vtkDoubleArray> signedDistances;
+  signedDistances->SetNumberOfComponents(1);
+  signedDistances->SetNumberOfTuples(torus->GetNumberOfPoints());
+  for (vtkIdType pointId=0; pointId<torus->GetNumberOfPoints(); pointId++)
+    {
+    double point[3];
+    torus->GetPoint(pointId, point);
+    signedDistances->SetValue(pointId, SignedDistance(patches, point));
+    }
+  torus->GetPointData()->SetScalars(signedDistances);
+  torus->Modified();
+
+  filter->SetInputData(torus);
+  filter->Update();
+
+  std::string resectedName = std::string(name) + " resected";
+  std::string remnantName = std::string(name) + " remnant";
+  vtkPolyData *resected = filter->GetResectedOutput();
+  vtkPolyData *remnant = filter->GetRemnantOutput();
+  double side = spanning ? 1.0 : 0.0;
+  if (!CheckPart(resectedName.c_str(), resected, resectedEulerCharacteristic, side, patches) ||
+      !CheckPart(remnantName.c_str(), remnant, remnantEulerCharacteristic, -side, patches))
+    {
+    return false;
+    }
+
+  // The caps follow the surface inside the torus, where only their grid
+  // points can be
+  if (resected->GetNumberOfCells() > 0 && remnant->GetNumberOfCells() > 0 &&
+      (!HasInteriorPoints(resected) || !HasInteriorPoints(remnant)))
+    {
+    std::cerr << name << ": caps without interior points" << std::endl;
+    return false;
+    }
+
+  double resectedVolume = SignedVolume(resected);
+  double remnantVolume = SignedVolume(remnant);
+  double torusVolume = SignedVolume(torus);
+  if (resectedVolume < 0.0 || remnantVolume < 0.0 ||
+      std::fabs(resectedVolume + remnantVolume - torusVolume) > 1e-9*torusVolume)
+    {
+    std::cerr << name << ": volumes " << resectedVolume << " + " << remnantVolume
+              << " instead of " << torusVolume << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//------------------------------------------------------------------------------
+int vtkResectionSplitFilterTest1(int vtkNotUsed(argc), char *vtkNotUsed(argv)[])
+{
+  vtkNew<vtkPolyData> torus;
+  CreateTorus(torus, 64, 32);
+
+  vtkNew<vtkResectionSplitFilter> filter;
+  vtkNew<vtkBezierSurfaceSource> patch;
+  filter->AddPatch(patch);
+  std::vector<vtkBezierSurfaceSource*> patches(1, patch.GetPointer());
+
+  // Horizontal plane: two solid tori, capped by an annulus
+  const double x[3] = {1.0, 0.0, 0.0};
+  const double y[3] = {0.0, 1.0, 0.0};
+  const double z[3] = {0.0, 0.0, 1.0};
+  const double horizontal[3] = {0.0, 0.0, 0.1};
+  CreatePlane(patch, horizontal, x, y);
+  if (!CheckSplit("Horizontal plane", filter, torus, patches, 0, 0))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Vertical plane: two bent cylinders, each capped by two disks. The
+  // locator of the torus is given.
+  vtkNew<vtkStaticCellLocator> locator;
+  locator->SetDataSet(torus);
+  locator->BuildLocator();
+  filter->SetLocator(locator);
+  const double vertical[3] = {0.3, 0.0, 0.0};
+  CreatePlane(patch, vertical, y, z);
+  if (!CheckSplit("Vertical plane", filter, torus, patches, 2, 2))
+    {
+    return EXIT_FAILURE;
+    }
+  filter->SetLocator(nullptr);
+
+  // Plane smaller than the torus, the outer loop projecting onto its border
+  CreatePlane(patch, horizontal, x, y, 1.5);
+  if (!CheckSplit("Small plane", filter, torus, patches, 0, 0, false))
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Plane missing the torus: nothing resected
+  const double above[3] = {0.0, 0.0, 2.0};
+  CreatePlane(patch, above, x, y);
+  if (!CheckSplit("Plane above", filter, torus, patches, 0, 0))
+    {
+    return EXIT_FAILURE;
+    }
+  if (filter->GetResectedOutput()->GetNumberOfCells() != 0)
+    {
+    std::cerr << "Plane above: " << filter->GetResectedOutput()->GetNumberOfCells()
+              << " cells resected" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Curved multi-patch surface
+  vtkNew<vtkMultiPatchBezierSurfaceSource> wave;
+  CreateWave(wave, -0.2);
+  filter->RemoveAllPatches();
+  patches.clear();
+  for (unsigned int p=0; p<2; p++)
+    {
+    for (unsigned int q=0; q<2; q++)
+      {
+      filter->AddPatch(wave->GetPatch(p, q));
+      patches.push_back(wave->GetPatch(p, q));
+      }
+    }
+  filter->SetPatchGridSize(2, 2);
+  filter->SetResolution(25, 25);
+  if (!CheckSplit("Wave", filter, torus, patches, 0, 0))
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,219 @@
+/*==============================================================================
+
+ Distributed under the OSI-approved BSD 3-Clause License.
+
+  Copyright (c) Oslo University Hospital. All rights reserved.
+
+  Redistribution and use in source and binary forms, with or without
+  modification, are permitted provided that the following conditions
+  are met:
+
+  * Redistributions of source code must retain the above copyright
+    notice, this list of conditions and the following disclaimer.
+
+  * Redistributions in binary form must reproduce the above copyright
+    notice, this list of conditions and the following disclaimer in the
+    documentation and/or other materials provided with the distribution.
+
+  * Neither the name of Oslo University Hospital nor the names
+    of Contributors may be used to endorse or promote products derived
+    from this software without specific prior written permission.
+
+  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+  LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+  A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+  HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+  SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+  LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+  DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+  THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+  (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+  OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+  This file was originally developed by Rafael Palomar (The Intervention Centre,
+  Oslo University Hospital) and was supported by The Research Council of Norway
+  through the ALive project (grant nr. 311393).
+
+==============================================================================*/
+
+// Known-answer tests of vtkResectionVolumeCalculator on a labelmap of two
+// labels: plane, flat Bezier surface and sphere boundaries, checked against
+// voxel counts computed in closed form or by brute force.
+
+#include "vtkResectionVolumeCalculator.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+
+// STD includes
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+namespace
+{
+
+//------------------------------------------------------------------------------
+const int Dimension = 24;
+const double Spacing = 0.5;
+
+//------------------------------------------------------------------------------
+// Cubic labelmap of label 2 in the lowest slices and label 1 elsewhere
+void CreateLabelMap(vtkImageData *labelMap, vtkMatrix4x4 *ijkToRAS)
+{
+  labelMap->SetExtent(0, Dimension-1, 0, Dimension-1, 0, Dimension-1);
+  labelMap->AllocateScalars(VTK_SHORT, 1);
+  short *scalars = static_cast<short*>(labelMap->GetScalarPointer());
+  for (int k=0; k<Dimension; k++)
+    {
+    for (int j=0; j<Dimension; j++)
+      {
+      for (int i=0; i<Dimension; i++)
+        {
+        scalars[(k*Dimension + j)*Dimension + i] = k < 8 ? 2 : 1;
+        }
+      }
+    }
+
+  for (int d=0; d<3; d++)
+    {
+    ijkToRAS->SetElement(d, d, Spacing);
+    }
+}
+
+//------------------------------------------------------------------------------
+bool CheckCount(const char *name, vtkIdType value, vtkIdType expected)
+{
+  if (value != expected)
+    {
+    std::cerr << name << ": " << value << " voxels instead of " << expected << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//------------------------------------------------------------------------------
+int vtkResectionVolumeCalculatorTest1(int vtkNotUsed(argc), char *vtkNotUsed(argv)[])
+{
+  vtkNew<vtkImageData> labelMap;
+  vtkNew<vtkMatrix4x4> ijkToRAS;
+  CreateLabelMap(labelMap, ijkToRAS);
+
+  vtkNew<vtkResectionVolumeCalculator> calculator;
+  calculator->SetLabelMap(labelMap, ijkToRAS);
+  bool success = true;
+
+  // The plane x = 5.1 resects the voxels from i = 11 on
+  const vtkIdType slice = Dimension*Dimension;
+  const vtkIdType resected = (Dimension-11)*slice;
+  double origin[3] = {5.1, 0.0, 0.0};
+  double normal[3] = {1.0, 0.0, 0.0};
+  calculator->SetPlane(origin, normal);
+  calculator->Update();
+  success &= CheckCount("Plane resected", calculator->GetNumberOfResectedVoxels(), resected);
+  success &= CheckCount("Plane remnant", calculator->GetNumberOfRemnantVoxels(),
+                        Dimension*slice - resected);
+  double voxelVolume = Spacing*Spacing*Spacing;
+  if (std::fabs(calculator->GetResectedVolume() - resected*voxelVolume) > 1e-9)
+    {
+    std::cerr << "Plane resected volume: " << calculator->GetResectedVolume()
+              << " instead of " << resected*voxelVolume << std::endl;
+    success = false;
+    }
+
+  // Separate labels: label 2 fills the first 8 slices
+  calculator->SeparateLabelsOn();
+  calculator->Update();
+  if (calculator->GetNumberOfLabels() != 2 ||
+      calculator->GetNthLabelValue(0) != 1.0 || calculator->GetNthLabelValue(1) != 2.0)
+    {
+    std::cerr << "Separate labels: expected labels 1 and 2" << std::endl;
+    success = false;
+    }
+  else
+    {
+    success &= CheckCount("Label 1 resected", calculator->GetNthNumberOfResectedVoxels(0),
+                          resected*(Dimension-8)/Dimension);
+    success &= CheckCount("Label 2 resected", calculator->GetNthNumberOfResectedVoxels(1),
+                          resected*8/Dimension);
+    success &= CheckCount("Label 2 remnant", calculator->GetNthNumberOfRemnantVoxels(1),
+                          (slice - resected/Dimension)*8);
+    }
+  calculator->SeparateLabelsOff();
+
+  // Flat Bezier surface on the same plane, with the normal (Su x Sv) along x
+  vtkNew<vtkPoints> controlPoints;
+  controlPoints->SetDataTypeToDouble();
+  for (int i=0; i<4; i++)
+    {
+    for (int j=0; j<4; j++)
+      {
+      controlPoints->InsertNextPoint(origin[0], -5.0 + 22.0*i/3.0, -5.0 + 22.0*j/3.0);
+      }
+    }
+  calculator->SetBezierSurface(controlPoints, 4, 4);
+  calculator->Update();
+  success &= CheckCount("Bezier resected", calculator->GetNumberOfResectedVoxels(), resected);
+
+  // Sphere, against the count of the voxel centers inside it
+  double center[3] = {6.1, 5.3, 4.7};
+  double radius = 4.3;
+  calculator->SetSphere(center, radius);
+  calculator->Update();
+  vtkIdType inside = 0;
+  for (int k=0; k<Dimension; k++)
+    {
+    for (int j=0; j<Dimension; j++)
+      {
+      for (int i=0; i<Dimension; i++)
+        {
+        double voxel[3] = {Spacing*i, Spacing*j, Spacing*k};
+        if (vtkMath::Distance2BetweenPoints(voxel, center) < radius*radius)
+          {
+          inside++;
+          }
+        }
+      }
+    }
+  success &= CheckCount("Sphere resected", calculator->GetNumberOfResectedVoxels(), inside);
+
+  // Incremental updates of a curved Bezier surface smaller than the labelmap,
+  // rotating about its center, against full updates of a new calculator
+  vtkNew<vtkPoints> rotatedPoints;
+  rotatedPoints->SetDataTypeToDouble();
+  rotatedPoints->SetNumberOfPoints(16);
+  for (int step=0; step<8; step++)
+    {
+    double angle = vtkMath::RadiansFromDegrees(7.0*step);
+    for (int i=0; i<4; i++)
+      {
+      for (int j=0; j<4; j++)
+        {
+        double u = -3.5 + 7.0*i/3.0;
+        double v = -3.5 + 7.0*j/3.0;
+        double x = 0.1*u*v;
+        rotatedPoints->SetPoint(4*i+j, 5.9 + x*std::cos(angle) - u*std::sin(angle),
+                                5.7 + x*std::sin(angle) + u*std::cos(angle), 5.6 + v);
+        }
+      }
+    rotatedPoints->Modified();
+    calculator->SetBezierSurface(rotatedPoints, 4, 4);
+    calculator->Update();
+
+    vtkNew<vtkResectionVolumeCalculator> fullCalculator;
+    fullCalculator->SetLabelMap(labelMap, ijkToRAS);
+    fullCalculator->SetBezierSurface(rotatedPoints, 4, 4);
+    fullCalculator->Update();
+    success &= CheckCount("Incremental Bezier resected", calculator->GetNumberOfResectedVoxels(),
+                          fullCalculator->GetNumberOfResectedVoxels());
+    }
+
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}